@@ -43,6 +43,8 @@ char const* tcmplxA_api_version(void);
 /* BEGIN error codes */
 /** @brief Library error codes. */
 enum tcmplxA_api_error {
+  /** Stream needs more memory than the state's cap allows */
+  tcmplxA_ErrMemoryCap = -14,
   /** An expected insert-copy code is missing */
   tcmplxA_ErrInsCopyMissing = -13,
   /** Expecting a ZLIB dictionary */
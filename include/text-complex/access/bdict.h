@@ -41,6 +41,22 @@ unsigned char const* tcmplxA_bdict_get_word(unsigned int j, unsigned int i);
 TCMPLX_A_API
 int tcmplxA_bdict_transform
   (unsigned char* buf, unsigned int* len, unsigned int k);
+
+/**
+ * @brief Transform a word into a separate buffer.
+ * @param[out] dst buffer to receive the result (at least 38 chars)
+ * @param[out] dstlen length of the result in bytes
+ * @param word the word to transform
+ * @param len length of word in bytes
+ * @param k transform selector (in range `[0,121)`)
+ * @return tcmplxA_Success on success, tcmplxA_ErrParam on unrecognized
+ *   transform, tcmplxA_ErrMemory if the word is too long
+ * @note Bytes of `dst` past the result are left as is.
+ */
+TCMPLX_A_API
+int tcmplxA_bdict_transform_copy
+  ( unsigned char* dst, unsigned int* dstlen,
+    unsigned char const* word, unsigned int len, unsigned int k);
 /* END   built-in dictionary */
 
 #ifdef __cplusplus
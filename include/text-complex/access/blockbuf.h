@@ -7,6 +7,8 @@
 
 #include "api.h"
 
+struct tcmplxA_allocator;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /*__cplusplus*/
@@ -16,6 +18,40 @@ extern "C" {
  */
 struct tcmplxA_blockbuf;
 
+enum tcmplxA_blockbuf_flag {
+  /**
+   * @brief Marks a command distance as a built-in dictionary reference.
+   * @note The filter sits in bits 16 through 22 and the word index
+   *   in bits 0 through 15. The word length is the copy length.
+   */
+  tcmplxA_BlockBuf_BDictRef = 0x40000000
+};
+
+/**
+ * @brief Command stream of a block buffer, as parallel arrays.
+ * @note Command `i` inserts `insert_lens[i]` literals starting at
+ *   `literals + literal_offsets[i]`, then copies `copy_lens[i]` bytes.
+ *   A copy length of zero marks a final command with no copy.
+ */
+struct tcmplxA_blockcmds {
+  /** @brief Number of literals to insert, per command. */
+  tcmplxA_uint32 const* insert_lens;
+  /** @brief Number of bytes to copy, per command. */
+  tcmplxA_uint32 const* copy_lens;
+  /**
+   * @brief Backward distance, per command; zero is the most recent byte.
+   * @note Values with `tcmplxA_BlockBuf_BDictRef` set are dictionary
+   *   references instead.
+   */
+  tcmplxA_uint32 const* distances;
+  /** @brief Offset of the first literal, per command. */
+  tcmplxA_uint32 const* literal_offsets;
+  /** @brief Literal bytes of all commands. */
+  unsigned char const* literals;
+  /** @brief Number of commands. */
+  size_t count;
+};
+
 /* BEGIN block buffer */
 /**
  * @brief Construct a new block buffer.
@@ -24,12 +60,30 @@ struct tcmplxA_blockbuf;
  * @param chain_length run-time parameter limiting hash chain length
  * @param bdict_tf whether to use the built-in dictionary
  * @return a pointer to the block buffer on success, NULL otherwise
+ * @note Windows of 64 KiB or more also get a long-distance matcher,
+ *   which fingerprints 64-byte runs across the whole window.
  */
 TCMPLX_A_API
 struct tcmplxA_blockbuf* tcmplxA_blockbuf_new
   ( tcmplxA_uint32 block_size, tcmplxA_uint32 n, size_t chain_length,
     int bdict_tf);
 
+/**
+ * @brief Construct a new block buffer using an allocator.
+ * @param block_size amount of input data to process at once
+ * @param n maximum sliding window size
+ * @param chain_length run-time parameter limiting hash chain length
+ * @param bdict_tf whether to use the built-in dictionary
+ * @param alloc (nullable) allocator for the buffer; NULL for the heap
+ * @return a pointer to the block buffer on success, NULL otherwise
+ * @note Windows of 64 KiB or more also get a long-distance matcher,
+ *   which fingerprints 64-byte runs across the whole window.
+ */
+TCMPLX_A_API
+struct tcmplxA_blockbuf* tcmplxA_blockbuf_new_alloc
+  ( tcmplxA_uint32 block_size, tcmplxA_uint32 n, size_t chain_length,
+    int bdict_tf, struct tcmplxA_allocator const* alloc);
+
 /**
  * @brief Destroy a block buffer.
  * @param x (nullable) the block buffer to destroy
@@ -55,6 +109,44 @@ int tcmplxA_blockbuf_gen_block(struct tcmplxA_blockbuf* x);
 TCMPLX_A_API
 int tcmplxA_blockbuf_try_block(struct tcmplxA_blockbuf* x);
 
+/**
+ * @brief Process the current block of input bytes into commands only.
+ * @param x the block buffer to do the processing
+ * @return tcmplxA_Success on success, nonzero otherwise
+ * @note The input buffer is retained, and the output buffer is left
+ *   as is. Use @link tcmplxA_blockbuf_commands @endlink to walk
+ *   the result.
+ */
+TCMPLX_A_API
+int tcmplxA_blockbuf_try_commands(struct tcmplxA_blockbuf* x);
+
+/**
+ * @brief Start to process the current block of input bytes into
+ *   commands, a few bytes at a time.
+ * @param x the block buffer to do the processing
+ * @return tcmplxA_Success on success, nonzero otherwise
+ * @note The suffix array search, when enabled, runs to the end of
+ *   the block here. Otherwise, use
+ *   @link tcmplxA_blockbuf_step_commands @endlink to search the rest.
+ */
+TCMPLX_A_API
+int tcmplxA_blockbuf_start_commands(struct tcmplxA_blockbuf* x);
+
+/**
+ * @brief Continue the search started by
+ *   @link tcmplxA_blockbuf_start_commands @endlink.
+ * @param x the block buffer to do the processing
+ * @param n number of input bytes to search, give or take a match
+ * @return tcmplxA_Success once the block is done, tcmplxA_ErrPartial
+ *   while input bytes remain, other nonzero on error
+ * @note While the search runs, @link tcmplxA_blockbuf_commands @endlink
+ *   leaves out the last command if it may still gain literals, so
+ *   the commands it shows stay as they are.
+ */
+TCMPLX_A_API
+int tcmplxA_blockbuf_step_commands
+  (struct tcmplxA_blockbuf* x, tcmplxA_uint32 n);
+
 /**
  * @brief Copy input bytes to output without processing.
  * @param x the block buffer to do the processing
@@ -68,6 +160,16 @@ int tcmplxA_blockbuf_try_block(struct tcmplxA_blockbuf* x);
 TCMPLX_A_API
 int tcmplxA_blockbuf_noconv_block(struct tcmplxA_blockbuf* x);
 
+/**
+ * @brief Check a sample of the input for signs of compressibility.
+ * @param x the block buffer to inspect
+ * @return nonzero if the sampled bytes are close to uniform and
+ *   rarely repeat, suggesting the block is best stored as is
+ * @note Blocks too short to sample well always report zero.
+ */
+TCMPLX_A_API
+int tcmplxA_blockbuf_probe_flat(struct tcmplxA_blockbuf const* x);
+
 /**
  * @brief Look at the output.
  * @param x the block buffer to do the processing
@@ -134,6 +236,18 @@ TCMPLX_A_API
 unsigned char const* tcmplxA_blockbuf_output_data
   (struct tcmplxA_blockbuf const* x);
 
+/**
+ * @brief Look at the command stream.
+ * @param x the block buffer to inspect
+ * @return parallel arrays of the commands produced since the output
+ *   was last cleared
+ * @note The arrays are valid until the next call to a function
+ *   that modifies the block buffer.
+ */
+TCMPLX_A_API
+struct tcmplxA_blockcmds tcmplxA_blockbuf_commands
+  (struct tcmplxA_blockbuf const* x);
+
 /**
  * @brief Inspect the input data.
  * @param x block buffer
@@ -144,7 +258,7 @@ unsigned char const* tcmplxA_blockbuf_input_data
   (struct tcmplxA_blockbuf const* x);
 
 /**
- * @brief Clear the output buffer.
+ * @brief Clear the output buffer and the command stream.
  * @param x the block buffer to edit
  */
 TCMPLX_A_API
@@ -216,9 +330,138 @@ tcmplxA_uint32 tcmplxA_blockbuf_ring_size(struct tcmplxA_blockbuf const* x);
 /**
  * @brief Clear the input buffer.
  * @param x the block buffer to edit
+ * @note Input set aside by @link tcmplxA_blockbuf_hold_input @endlink
+ *   becomes the new input.
  */
 TCMPLX_A_API
 void tcmplxA_blockbuf_clear_input(struct tcmplxA_blockbuf* x);
+
+/**
+ * @brief Set aside the end of the input for the next block.
+ * @param x the block buffer to edit
+ * @param n number of input bytes to keep in the current block
+ * @return tcmplxA_Success on success, tcmplxA_ErrParam if `n` exceeds
+ *   the input size
+ * @note Writes fail until the next call to
+ *   @link tcmplxA_blockbuf_clear_input @endlink.
+ */
+TCMPLX_A_API
+int tcmplxA_blockbuf_hold_input(struct tcmplxA_blockbuf* x, tcmplxA_uint32 n);
+
+/**
+ * @brief Empty the input, output and sliding window, keeping storage.
+ * @param x the block buffer to reset
+ */
+TCMPLX_A_API
+void tcmplxA_blockbuf_reset(struct tcmplxA_blockbuf* x);
+
+/**
+ * @brief Choose whether to probe recent copy distances for matches.
+ * @param x the block buffer to configure
+ * @param recent_tf nonzero to try the last four copy distances, and
+ *   near misses of the last two, before the hash chain
+ * @note Recent distances are cheap to encode in Brotli (RFC 7932
+ *   Section 4), so shorter matches there may win over longer ones
+ *   found by the hash chain.
+ */
+TCMPLX_A_API
+void tcmplxA_blockbuf_set_recent(struct tcmplxA_blockbuf* x, int recent_tf);
+
+/**
+ * @brief Choose whether to match greedily for speed.
+ * @param x the block buffer to configure
+ * @param greedy_tf nonzero to check only the newest hash chain entry
+ *   and the exact recent distances, and to take each match without
+ *   looking ahead one byte for a longer one
+ */
+TCMPLX_A_API
+void tcmplxA_blockbuf_set_greedy(struct tcmplxA_blockbuf* x, int greedy_tf);
+
+/**
+ * @brief Choose whether to skip ahead through runs of literals.
+ * @param x the block buffer to configure
+ * @param skip_tf nonzero to search for matches less often the longer
+ *   a run of literals grows, searching at every byte again after
+ *   the next match
+ * @note Bytes passed over still enter the sliding window and the hash
+ *   chain; only the searches at them are skipped.
+ */
+TCMPLX_A_API
+void tcmplxA_blockbuf_set_skip(struct tcmplxA_blockbuf* x, int skip_tf);
+
+/**
+ * @brief Choose whether to find matches with a suffix array.
+ * @param x the block buffer to configure
+ * @param suffix_tf nonzero to sort the suffixes of each input block,
+ *   together with recent window history, and to parse the block along
+ *   the cheapest estimated path over several earlier matches at each
+ *   byte
+ * @note This trades speed for ratio. The history indexed is up to four
+ *   times the block size, at most 64 KiB; long-distance matches reach
+ *   farther in windows wide enough to track them.
+ * @note Scratch space of about sixteen bytes per indexed byte, plus
+ *   thirty-two per input byte, is taken from the allocator for each
+ *   block and given back before the block is done; without it, the
+ *   block falls back to the hash chain. See
+ *   @link tcmplxA_blockbuf_set_scratch_cap @endlink to bound it.
+ */
+TCMPLX_A_API
+void tcmplxA_blockbuf_set_suffix(struct tcmplxA_blockbuf* x, int suffix_tf);
+
+/**
+ * @brief Limit the length of each copy command.
+ * @param x the block buffer to configure
+ * @param copy_max longest copy to emit, clamped to the range 3-16447;
+ *   the default is 16447 for Brotli, and DEFLATE needs 258
+ */
+TCMPLX_A_API
+void tcmplxA_blockbuf_set_copy_max
+  (struct tcmplxA_blockbuf* x, tcmplxA_uint32 copy_max);
+
+/**
+ * @brief Limit the scratch space of the suffix array search.
+ * @param x the block buffer to configure
+ * @param scratch_cap most bytes to take from the allocator for each
+ *   block's search, or `(size_t)-1` (the default) for no limit
+ * @note Under a tighter limit the search indexes less of the window
+ *   history. A block that does not fit on its own uses the hash chain.
+ */
+TCMPLX_A_API
+void tcmplxA_blockbuf_set_scratch_cap
+  (struct tcmplxA_blockbuf* x, size_t scratch_cap);
+
+/**
+ * @brief Copy the sliding window and hash chain of another block buffer.
+ * @param dst the block buffer to overwrite
+ * @param src the block buffer to copy
+ * @return tcmplxA_Success on success, nonzero otherwise
+ * @note The input and output buffers of `dst` are cleared.
+ */
+TCMPLX_A_API
+int tcmplxA_blockbuf_copy_ring
+  (struct tcmplxA_blockbuf* dst, struct tcmplxA_blockbuf const* src);
+
+/**
+ * @brief Measure the memory held by a block buffer.
+ * @param x the block buffer to inspect
+ * @return the number of bytes held, including the block buffer itself
+ */
+TCMPLX_A_API
+size_t tcmplxA_blockbuf_memory_usage(struct tcmplxA_blockbuf const* x);
+
+/**
+ * @brief Estimate the most memory a block buffer may hold.
+ * @param block_size amount of input data to process at once
+ * @param n maximum sliding window size
+ * @param chain_length run-time parameter limiting hash chain length
+ * @return the number of bytes a full block buffer holds, or `(size_t)-1`
+ *   if no such block buffer can exist
+ * @note The output block can need up to twice the input block size,
+ *   and the command stream up to one command per two input bytes.
+ */
+TCMPLX_A_API
+size_t tcmplxA_blockbuf_memory_bound
+  (tcmplxA_uint32 block_size, tcmplxA_uint32 n, size_t chain_length);
 /* END   block buffer */
 
 #ifdef __cplusplus
@@ -7,6 +7,8 @@
 
 #include "api.h"
 
+struct tcmplxA_allocator;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /*__cplusplus*/
@@ -31,6 +33,48 @@ struct tcmplxA_brcvt* tcmplxA_brcvt_new
   ( tcmplxA_uint32 block_size,
     tcmplxA_uint32 n, size_t chain_length);
 
+/**
+ * @brief Construct a new Brotli conversion state using an allocator.
+ * @param block_size amount of input data to process at once
+ * @param n maximum sliding window size (use 16777200 for Brotli default)
+ * @param chain_length run-time parameter limiting hash chain length
+ * @param alloc (nullable) allocator for the state and all of its
+ *   internal buffers; NULL for the heap
+ * @return a pointer to the Brotli conversion state on success, NULL otherwise
+ * @note The allocator must outlive the state.
+ */
+TCMPLX_A_API
+struct tcmplxA_brcvt* tcmplxA_brcvt_new_alloc
+  ( tcmplxA_uint32 block_size,
+    tcmplxA_uint32 n, size_t chain_length,
+    struct tcmplxA_allocator const* alloc);
+
+/**
+ * @brief Construct a new Brotli conversion state within a memory cap.
+ * @param block_size largest amount of input data to process at once
+ * @param n largest sliding window size
+ * @param chain_length largest hash chain length
+ * @param memory_cap most bytes the state may hold
+ * @param alloc (nullable) allocator for the state and all of its
+ *   internal buffers; NULL for the heap
+ * @return a pointer to the Brotli conversion state on success, NULL
+ *   if no state fits the cap or on allocation failure
+ * @note The window, chain length and block size are reduced as needed
+ *   to keep @link tcmplxA_brcvt_memory_bound @endlink within the cap.
+ *   If even the smallest state's bound is too large, the state is built
+ *   as long as its starting buffers fit; its prefix trees and context
+ *   maps then count against the cap as they grow.
+ * @note The capped state refuses, with tcmplxA_ErrMemoryCap, streams
+ *   whose window (WBITS) exceeds its own, and streams whose prefix
+ *   trees, context maps or metadata would take it past the cap.
+ *   When compressing, blocks whose trees would not fit are stored.
+ */
+TCMPLX_A_API
+struct tcmplxA_brcvt* tcmplxA_brcvt_new_capped
+  ( tcmplxA_uint32 block_size,
+    tcmplxA_uint32 n, size_t chain_length, size_t memory_cap,
+    struct tcmplxA_allocator const* alloc);
+
 /**
  * @brief Destroy a Brotli conversion state.
  * @param x (nullable) the Brotli conversion state to destroy
@@ -39,16 +83,87 @@ TCMPLX_A_API
 void tcmplxA_brcvt_destroy(struct tcmplxA_brcvt* x);
 
 /**
- * @brief Add metadata outside of the input stream.
+ * @brief Return a Brotli conversion state to the start of a stream.
+ * @param x the Brotli conversion state to reset
+ * @note The state keeps its allocations, so a reset state can
+ *   begin a new stream (in either direction) without the cost
+ *   of @link tcmplxA_brcvt_new @endlink.
+ * @note Any stored metadata is removed.
+ */
+TCMPLX_A_API
+void tcmplxA_brcvt_reset(struct tcmplxA_brcvt* x);
+
+/**
+ * @brief Add dictionary data outside of the input stream.
  * @param x the conversion state to configure
  * @param buf buffer of bytes to add
  * @param sz size of the buffer in bytes
  * @return count of bytes added
+ * @note The dictionary must be added before the start of the stream,
+ *   and the same dictionary must be given to both the compressor
+ *   and the decompressor.
  */
 TCMPLX_A_API
 size_t tcmplxA_brcvt_bypass
   (struct tcmplxA_brcvt* x, unsigned char const* buf, size_t sz);
 
+/**
+ * @brief Copy dictionary data from another conversion state.
+ * @param dst the conversion state to configure
+ * @param src a conversion state primed only by
+ *   @link tcmplxA_brcvt_bypass @endlink
+ * @return tcmplxA_Success on success, nonzero otherwise
+ * @note Use this to prime a dictionary once, then start any number
+ *   of streams from it without hashing the dictionary again.
+ *   Both states must be at the start of a stream.
+ */
+TCMPLX_A_API
+int tcmplxA_brcvt_bypass_copy
+  (struct tcmplxA_brcvt* dst, struct tcmplxA_brcvt const* src);
+
+/**
+ * @brief Choose whether to trade compression ratio for speed.
+ * @param x the conversion state to configure
+ * @param quick_tf nonzero to trade compression ratio for speed
+ * @note Quick mode takes the first hash chain hit for each match,
+ *   searches less often along runs of literals,
+ *   closes meta-blocks at 64 KiB, and skips the searches for
+ *   distance parameters, literal block splits and context clusters.
+ *   The change applies from the next meta-block on.
+ * @note Quick mode writes each meta-block's commands while the match
+ *   search runs. Its prefix trees come from the codes of the previous
+ *   meta-block plus those of the first eighth of the current one, so
+ *   input whose statistics shift from block to block compresses a few
+ *   percent worse than with trees counted over the whole block.
+ */
+TCMPLX_A_API
+void tcmplxA_brcvt_set_quick(struct tcmplxA_brcvt* x, int quick_tf);
+
+/**
+ * @brief Choose whether to search for matches with a suffix array.
+ * @param x the conversion state to configure
+ * @param suffix_tf nonzero to weigh several earlier matches at every
+ *   input byte, for a better ratio at a much lower speed
+ * @note Quick mode's match search settings do not apply while this
+ *   is on. The search's scratch space counts against the memory cap:
+ *   under a tight cap it indexes less history, or falls back to the
+ *   hash chain. See @link tcmplxA_blockbuf_set_suffix @endlink.
+ */
+TCMPLX_A_API
+void tcmplxA_brcvt_set_suffix(struct tcmplxA_brcvt* x, int suffix_tf);
+
+/**
+ * @brief Bound the input held back for each meta-block.
+ * @param x the conversion state to configure
+ * @param latency most input bytes per meta-block, or zero to use
+ *   the block size given at creation
+ * @note Meta-blocks also end early where the input statistics shift
+ *   enough to pay for a new meta-block header.
+ */
+TCMPLX_A_API
+void tcmplxA_brcvt_set_latency
+  (struct tcmplxA_brcvt* x, tcmplxA_uint32 latency);
+
 /**
  * @brief Convert a Brotli stream to a byte stream.
  * @param ps the Brotli conversion state to use
@@ -138,6 +253,28 @@ struct tcmplxA_brmeta* tcmplxA_brcvt_metadata(struct tcmplxA_brcvt* ps);
 TCMPLX_A_API
 struct tcmplxA_brmeta const* tcmplxA_brcvt_metadata_c
   (struct tcmplxA_brcvt const* ps);
+
+/**
+ * @brief Measure the memory held by a Brotli conversion state.
+ * @param x the Brotli conversion state to inspect
+ * @return the number of bytes held, including the state itself
+ */
+TCMPLX_A_API
+size_t tcmplxA_brcvt_memory_usage(struct tcmplxA_brcvt const* x);
+
+/**
+ * @brief Estimate the memory a Brotli conversion state may hold.
+ * @param block_size amount of input data to process at once
+ * @param n maximum sliding window size
+ * @param chain_length run-time parameter limiting hash chain length
+ * @return the number of bytes such a state holds when encoding, or
+ *   when decoding a stream with one prefix tree per alphabet and no
+ *   metadata; `(size_t)-1` if no such state can exist
+ */
+TCMPLX_A_API
+size_t tcmplxA_brcvt_memory_bound
+  ( tcmplxA_uint32 block_size,
+    tcmplxA_uint32 n, size_t chain_length);
 /* END   brcvt state */
 
 #ifdef __cplusplus
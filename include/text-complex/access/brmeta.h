@@ -8,6 +8,8 @@
 #include "api.h"
 #include <stddef.h>
 
+struct tcmplxA_allocator;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /*__cplusplus*/
@@ -26,6 +28,16 @@ struct tcmplxA_brmeta;
 TCMPLX_A_API
 struct tcmplxA_brmeta* tcmplxA_brmeta_new(size_t cap);
 
+/**
+ * @brief Allocate and initialize a metadata store using an allocator.
+ * @param cap initial capacity (or zero for fully empty)
+ * @param alloc (nullable) allocator for the store; NULL for the heap
+ * @return a metadata store on success, `NULL` otherwise
+ */
+TCMPLX_A_API
+struct tcmplxA_brmeta* tcmplxA_brmeta_new_alloc
+  (size_t cap, struct tcmplxA_allocator const* alloc);
+
 /**
  * @brief Emplace a metadata line at the end of a storage.
  * @param b storage to update
@@ -74,12 +86,36 @@ TCMPLX_A_API
 unsigned char* tcmplxA_brmeta_itemdata
     (struct tcmplxA_brmeta const* b, size_t i);
 
+/**
+ * @brief Remove all lines from a storage, keeping its capacity.
+ * @param b storage to clear
+ */
+TCMPLX_A_API
+void tcmplxA_brmeta_clear(struct tcmplxA_brmeta* b);
+
 /**
  * @brief Destroy a metadata store.
  * @param p (optional) a metadata store to destroy
  */
 TCMPLX_A_API
 void tcmplxA_brmeta_destroy(struct tcmplxA_brmeta* p);
+
+/**
+ * @brief Measure the memory held by a metadata storage.
+ * @param b the storage to inspect
+ * @return the number of bytes held, including the storage itself
+ */
+TCMPLX_A_API
+size_t tcmplxA_brmeta_memory_usage(struct tcmplxA_brmeta const* b);
+
+/**
+ * @brief Estimate the most memory a metadata storage may hold.
+ * @param n number of metadata items
+ * @param total sum of the item sizes in bytes
+ * @return the number of bytes such a storage holds at most
+ */
+TCMPLX_A_API
+size_t tcmplxA_brmeta_memory_bound(size_t n, size_t total);
 /* END   brmeta */
 
 #ifdef __cplusplus
@@ -8,6 +8,8 @@
 
 #include "api.h"
 
+struct tcmplxA_allocator;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /*__cplusplus*/
@@ -39,6 +41,17 @@ enum tcmplxA_ctxtmap_mode {
 TCMPLX_A_API
 struct tcmplxA_ctxtmap* tcmplxA_ctxtmap_new(size_t btypes, size_t ctxts);
 
+/**
+ * @brief Construct a new context map using an allocator.
+ * @param btypes number of block types
+ * @param ctxts number of contexts
+ * @param alloc (nullable) allocator for the map; NULL for the heap
+ * @return a pointer to the context map on success, NULL otherwise
+ */
+TCMPLX_A_API
+struct tcmplxA_ctxtmap* tcmplxA_ctxtmap_new_alloc
+  (size_t btypes, size_t ctxts, struct tcmplxA_allocator const* alloc);
+
 /**
  * @brief Destroy a context map.
  * @param x (nullable) the context map to destroy
@@ -94,6 +107,16 @@ int tcmplxA_ctxtmap_get(struct tcmplxA_ctxtmap const* x, size_t i, size_t j);
 TCMPLX_A_API
 void tcmplxA_ctxtmap_set(struct tcmplxA_ctxtmap* x, size_t i, size_t j, int v);
 
+/**
+ * @brief Access the prefix code identifiers of one block type.
+ * @param x the context map to inspect
+ * @param i row (block type) selector
+ * @return a pointer to the row of identifiers, indexed by context
+ */
+TCMPLX_A_API
+unsigned char const* tcmplxA_ctxtmap_row
+  (struct tcmplxA_ctxtmap const* x, size_t i);
+
 /**
  * @brief Inspect the context mode for a block type in a context map.
  * @param x the context map to inspect
@@ -130,6 +153,17 @@ TCMPLX_A_API
 int tcmplxA_ctxtmap_literal_context
   (int mode, unsigned int p1, unsigned int p2);
 
+/**
+ * @brief Access the literal context lookup table for a mode.
+ * @param mode a context map mode
+ * @return a table of 512 entries on success, NULL otherwise
+ * @note The literal context is `lut[p1] | lut[256+p2]`, where `p1`
+ *   is the most recent byte and `p2` the byte before it.
+ * @see RFC 7932 section 7.1.
+ */
+TCMPLX_A_API
+unsigned char const* tcmplxA_ctxtmap_literal_lut(int mode);
+
 /**
  * @brief Apply a move-to-front transform to the map.
  * @param x the map to modify
@@ -145,6 +179,23 @@ void tcmplxA_ctxtmap_apply_movetofront(struct tcmplxA_ctxtmap* x);
  */
 TCMPLX_A_API
 void tcmplxA_ctxtmap_revert_movetofront(struct tcmplxA_ctxtmap* x);
+
+/**
+ * @brief Measure the memory held by a context map.
+ * @param x the context map to inspect
+ * @return the number of bytes held, including the context map itself
+ */
+TCMPLX_A_API
+size_t tcmplxA_ctxtmap_memory_usage(struct tcmplxA_ctxtmap const* x);
+
+/**
+ * @brief Estimate the memory held by a context map.
+ * @param btypes number of block types
+ * @param ctxts number of contexts
+ * @return the number of bytes such a context map holds
+ */
+TCMPLX_A_API
+size_t tcmplxA_ctxtmap_memory_bound(size_t btypes, size_t ctxts);
 /* END   context map */
 
 #ifdef __cplusplus
@@ -8,6 +8,8 @@
 
 #include "api.h"
 
+struct tcmplxA_allocator;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /*__cplusplus*/
@@ -95,6 +97,16 @@ struct tcmplxA_fixlist;
 TCMPLX_A_API
 struct tcmplxA_fixlist* tcmplxA_fixlist_new(size_t n);
 
+/**
+ * @brief Construct a new prefix list using an allocator.
+ * @param n desired number of lines in the table
+ * @param alloc (nullable) allocator for the list; NULL for the heap
+ * @return a pointer to the prefix list on success, NULL otherwise
+ */
+TCMPLX_A_API
+struct tcmplxA_fixlist* tcmplxA_fixlist_new_alloc
+  (size_t n, struct tcmplxA_allocator const* alloc);
+
 /**
  * @brief Destroy a prefix list.
  * @param x (nullable) the prefix list to destroy
@@ -160,6 +172,16 @@ int tcmplxA_fixlist_gen_codes(struct tcmplxA_fixlist* dst);
 TCMPLX_A_API
 int tcmplxA_fixlist_preset(struct tcmplxA_fixlist* dst, unsigned int i);
 
+/**
+ * @brief Access a read-only preset list shared by all callers.
+ * @param i preset identifier
+ * @return a pointer to the list on success, NULL if the preset
+ *   is unknown or has no static form
+ * @note The list is static; do not destroy it.
+ */
+TCMPLX_A_API
+struct tcmplxA_fixlist const* tcmplxA_fixlist_preset_c(unsigned int i);
+
 /**
  * @brief Generate prefix code lengths given a prefix list and
  *   histogram of code frequencies.
@@ -210,6 +232,9 @@ int tcmplxA_fixlist_valuesort(struct tcmplxA_fixlist* dst);
  * @param value alphabet value
  * @return index if found, SIZE_MAX otherwise
  * @note Useful for encoding to a compressed stream.
+ * @note A list holding every value from zero up, as made by
+ *   @link tcmplxA_fixlist_gen_lengths @endlink on a histogram,
+ *   resolves in one direct lookup without searching.
  */
 TCMPLX_A_API
 size_t tcmplxA_fixlist_valuebsearch
@@ -228,6 +253,22 @@ size_t tcmplxA_fixlist_valuebsearch
  */
 TCMPLX_A_API int tcmplxA_fixlist_match_preset(struct tcmplxA_fixlist* dst,
   int zero_force_tf);
+
+/**
+ * @brief Measure the memory held by a prefix list.
+ * @param x the prefix list to inspect
+ * @return the number of bytes held, including the prefix list itself
+ */
+TCMPLX_A_API
+size_t tcmplxA_fixlist_memory_usage(struct tcmplxA_fixlist const* x);
+
+/**
+ * @brief Estimate the memory held by a prefix list.
+ * @param n number of lines in the list
+ * @return the number of bytes such a list holds
+ */
+TCMPLX_A_API
+size_t tcmplxA_fixlist_memory_bound(size_t n);
 /* END   prefix list */
 
 #ifdef __cplusplus
@@ -7,6 +7,8 @@
 
 #include "api.h"
 
+struct tcmplxA_allocator;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /*__cplusplus*/
@@ -24,6 +26,16 @@ struct tcmplxA_gaspvec;
 TCMPLX_A_API
 struct tcmplxA_gaspvec* tcmplxA_gaspvec_new(size_t n);
 
+/**
+ * @brief Construct a new prefix gasp vector using an allocator.
+ * @param n desired number of lines in the table
+ * @param alloc (nullable) allocator for the vector; NULL for the heap
+ * @return a pointer to the prefix gasp vector on success, NULL otherwise
+ */
+TCMPLX_A_API
+struct tcmplxA_gaspvec* tcmplxA_gaspvec_new_alloc
+  (size_t n, struct tcmplxA_allocator const* alloc);
+
 /**
  * @brief Destroy a prefix gasp vector.
  * @param x (nullable) the prefix  gasp vector to destroy
@@ -78,6 +90,58 @@ unsigned short tcmplxA_gaspvec_get_skip(struct tcmplxA_gaspvec const* x, size_t
 TCMPLX_A_API
 void tcmplxA_gaspvec_set_skip(struct tcmplxA_gaspvec const* x, size_t i, unsigned short noskip);
 
+/**
+ * @brief Build lookup tables for all prefix trees in a gasp vector.
+ * @param x the vector to compile
+ * @return tcmplxA_Success on success, nonzero otherwise
+ * @note Each tree gets an 8-bit root table, with second-level tables
+ *   for longer codes, all kept in one allocation. Writing to a tree
+ *   through @link tcmplxA_gaspvec_at @endlink discards the tables.
+ */
+TCMPLX_A_API
+int tcmplxA_gaspvec_compile(struct tcmplxA_gaspvec* x);
+/**
+ * @brief Match a partial prefix code against a tree in a gasp vector.
+ * @param x the vector to read
+ * @param i an array index
+ * @param n number of code bits read so far
+ * @param bits code bits read so far, first bit most significant
+ * @return the alphabet symbol on a match, UINT_MAX otherwise
+ */
+TCMPLX_A_API
+unsigned tcmplxA_gaspvec_decode
+  (struct tcmplxA_gaspvec const* x, size_t i, unsigned n, unsigned bits);
+/**
+ * @brief Match the front of a bit window against a tree in a gasp vector.
+ * @param x the vector to read
+ * @param i an array index
+ * @param bits next fifteen code bits, first bit most significant
+ * @param[out] len length of the matched code in bits
+ * @return the alphabet symbol on a match, UINT_MAX otherwise
+ * @note Only succeeds while the lookup tables are current; see
+ *   @link tcmplxA_gaspvec_compile @endlink.
+ */
+TCMPLX_A_API
+unsigned tcmplxA_gaspvec_peek
+  ( struct tcmplxA_gaspvec const* x, size_t i, unsigned bits,
+    unsigned* len);
+/**
+ * @brief Measure the memory held by a gasp vector.
+ * @param x the vector to inspect
+ * @return the number of bytes held, including the vector itself
+ */
+TCMPLX_A_API
+size_t tcmplxA_gaspvec_memory_usage(struct tcmplxA_gaspvec const* x);
+
+/**
+ * @brief Estimate the most memory a gasp vector may hold.
+ * @param n number of trees in the vector
+ * @param alphabet largest number of symbols in any one tree
+ * @return the number of bytes such a vector holds at most
+ */
+TCMPLX_A_API
+size_t tcmplxA_gaspvec_memory_bound(size_t n, size_t alphabet);
+
 #ifdef __cplusplus
 };
 #endif /*__cplusplus*/
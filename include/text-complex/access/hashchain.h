@@ -7,6 +7,8 @@
 
 #include "api.h"
 
+struct tcmplxA_allocator;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /*__cplusplus*/
@@ -22,11 +24,25 @@ struct tcmplxA_hashchain;
  * @param n maximum sliding window size
  * @param chain_length run-time parameter limiting hash chain length
  * @return a pointer to the hash chain on success, NULL otherwise
+ * @note Windows of 32768 bytes or less get 16-bit chain links,
+ *   half the size of the links for larger windows.
  */
 TCMPLX_A_API
 struct tcmplxA_hashchain* tcmplxA_hashchain_new
   (tcmplxA_uint32 n, size_t chain_length);
 
+/**
+ * @brief Construct a new hash chain using an allocator.
+ * @param n maximum sliding window size
+ * @param chain_length run-time parameter limiting hash chain length
+ * @param alloc (nullable) allocator for the chain; NULL for the heap
+ * @return a pointer to the hash chain on success, NULL otherwise
+ */
+TCMPLX_A_API
+struct tcmplxA_hashchain* tcmplxA_hashchain_new_alloc
+  ( tcmplxA_uint32 n, size_t chain_length,
+    struct tcmplxA_allocator const* alloc);
+
 /**
  * @brief Destroy a hash chain.
  * @param x (nullable) the hash chain to destroy
@@ -81,6 +97,59 @@ TCMPLX_A_API
 tcmplxA_uint32 tcmplxA_hashchain_find
   ( struct tcmplxA_hashchain const* x, unsigned char const* b,
     tcmplxA_uint32 pos);
+
+/**
+ * @brief Search for a byte sequence, probing fewer chain entries.
+ * @param x the slide ring to inspect
+ * @param b three byte sequence for which to look
+ * @param pos number of bytes to go back; zero is most recent
+ * @param limit most chain entries to check, newest first
+ * @return a backward distance where to find the three-byte
+ *   sequence, or `(tcmplxA_uint32)-1` if not found
+ */
+TCMPLX_A_API
+tcmplxA_uint32 tcmplxA_hashchain_find_limit
+  ( struct tcmplxA_hashchain const* x, unsigned char const* b,
+    tcmplxA_uint32 pos, size_t limit);
+
+/**
+ * @brief Empty a hash chain, keeping its storage.
+ * @param x the hash chain to reset
+ * @note Searches after a reset behave as in a new hash chain.
+ */
+TCMPLX_A_API
+void tcmplxA_hashchain_reset(struct tcmplxA_hashchain* x);
+
+/**
+ * @brief Copy a hash chain, including its sliding window.
+ * @param dst destination hash chain
+ * @param src source hash chain
+ * @return tcmplxA_Success on success, nonzero otherwise
+ * @note The destination takes on the window size and chain length
+ *   of the source. Useful for starting many streams from a single
+ *   primed dictionary.
+ */
+TCMPLX_A_API
+int tcmplxA_hashchain_copy
+  (struct tcmplxA_hashchain* dst, struct tcmplxA_hashchain const* src);
+
+/**
+ * @brief Measure the memory held by a hash chain.
+ * @param x the hash chain to inspect
+ * @return the number of bytes held, including the hash chain itself
+ */
+TCMPLX_A_API
+size_t tcmplxA_hashchain_memory_usage(struct tcmplxA_hashchain const* x);
+
+/**
+ * @brief Estimate the most memory a hash chain may hold.
+ * @param n maximum sliding window size
+ * @param chain_length run-time parameter limiting hash chain length
+ * @return the number of bytes a full hash chain holds, or `(size_t)-1`
+ *   if no such hash chain can exist
+ */
+TCMPLX_A_API
+size_t tcmplxA_hashchain_memory_bound(tcmplxA_uint32 n, size_t chain_length);
 /* END   hash chain */
 
 #ifdef __cplusplus
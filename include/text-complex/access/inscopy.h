@@ -8,6 +8,8 @@
 
 #include "api.h"
 
+struct tcmplxA_allocator;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /*__cplusplus*/
@@ -115,6 +117,16 @@ struct tcmplxA_inscopy;
 TCMPLX_A_API
 struct tcmplxA_inscopy* tcmplxA_inscopy_new(size_t n);
 
+/**
+ * @brief Construct a new insert copy table using an allocator.
+ * @param n table row count
+ * @param alloc (nullable) allocator for the table; NULL for the heap
+ * @return a pointer to the insert copy table on success, NULL otherwise
+ */
+TCMPLX_A_API
+struct tcmplxA_inscopy* tcmplxA_inscopy_new_alloc
+  (size_t n, struct tcmplxA_allocator const* alloc);
+
 /**
  * @brief Destroy a insert copy table.
  * @param x (nullable) the insert copy table to destroy
@@ -168,6 +180,16 @@ int tcmplxA_inscopy_copy
 TCMPLX_A_API
 int tcmplxA_inscopy_preset(struct tcmplxA_inscopy* dst, int i);
 
+/**
+ * @brief Access a read-only preset table shared by all callers.
+ * @param i a @link tcmplxA_inscp_preset @endlink value
+ * @return a pointer to the table in code order on success,
+ *   NULL otherwise
+ * @note The table is static; do not destroy it.
+ */
+TCMPLX_A_API
+struct tcmplxA_inscopy const* tcmplxA_inscopy_preset_c(int i);
+
 /**
  * @brief Sort an insert-copy table by alphabet code.
  * @param ict list to sort
@@ -189,7 +211,7 @@ int tcmplxA_inscopy_lengthsort(struct tcmplxA_inscopy* ict);
 
 /**
  * @brief Encode a pair of insert and copy lengths using a table.
- * @param ict the table to read (sorted for length)
+ * @param ict the table to read (preset code order, or sorted for length)
  * @param i insert length
  * @param c copy length, or zero if unused
  * @param z_tf nonzero to select the zero distance variation,
@@ -201,12 +223,30 @@ int tcmplxA_inscopy_lengthsort(struct tcmplxA_inscopy* ict);
  *   variation instead.
  * @note Failure of this function does not necessarily constitute an
  *   error, since selection of a zero distance variation may result
- *   in a compatible code not being found.
+ *   in a compatible code not being found. * @note For preset tables kept in code order, the code is computed
+ *   directly from the lengths without a search. Other tables fall back
+ *   to a binary search and must be sorted for length.
  */
 TCMPLX_A_API
 size_t tcmplxA_inscopy_encode
   ( struct tcmplxA_inscopy const* ict, unsigned long int i,
     unsigned long int c, int z_tf);
+
+/**
+ * @brief Measure the memory held by an insert copy table.
+ * @param x the table to inspect
+ * @return the number of bytes held, including the table itself
+ */
+TCMPLX_A_API
+size_t tcmplxA_inscopy_memory_usage(struct tcmplxA_inscopy const* x);
+
+/**
+ * @brief Estimate the memory held by an insert copy table.
+ * @param n number of rows in the table
+ * @return the number of bytes such a table holds
+ */
+TCMPLX_A_API
+size_t tcmplxA_inscopy_memory_bound(size_t n);
 /* END   insert copy table */
 
 #ifdef __cplusplus
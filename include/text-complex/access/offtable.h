@@ -8,6 +8,8 @@
 
 #include "api.h"
 
+struct tcmplxA_allocator;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /*__cplusplus*/
@@ -51,6 +53,16 @@ struct tcmplxA_offline {
 TCMPLX_A_API
 struct tcmplxA_offtable* tcmplxA_offtable_new(size_t n);
 
+/**
+ * \brief Construct a new offset table using an allocator.
+ * \param n desired number of lines in the table
+ * \param alloc (nullable) allocator for the table; NULL for the heap
+ * \return a pointer to the table on success, NULL otherwise
+ */
+TCMPLX_A_API
+struct tcmplxA_offtable* tcmplxA_offtable_new_alloc
+  (size_t n, struct tcmplxA_allocator const* alloc);
+
 /**
  * \brief Destroy an offset table.
  * \param x (nullable) the table to destroy
@@ -8,6 +8,8 @@
 
 #include "api.h"
 
+struct tcmplxA_allocator;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /*__cplusplus*/
@@ -30,6 +32,19 @@ TCMPLX_A_API
 struct tcmplxA_ringdist* tcmplxA_ringdist_new
   (int special_tf, unsigned int direct, unsigned int postfix);
 
+/**
+ * @brief Construct a new distance ring using an allocator.
+ * @param special_tf nonzero to support Brotli distance codes
+ * @param direct number of direct codes (0..120)
+ * @param postfix postfix bit count (0..3)
+ * @param alloc (nullable) allocator for the ring; NULL for the heap
+ * @return a pointer to the distance ring on success, NULL otherwise
+ */
+TCMPLX_A_API
+struct tcmplxA_ringdist* tcmplxA_ringdist_new_alloc
+  ( int special_tf, unsigned int direct, unsigned int postfix,
+    struct tcmplxA_allocator const* alloc);
+
 /**
  * @brief Destroy a distance ring.
  * @param x (nullable) the distance ring to destroy
@@ -117,6 +132,33 @@ unsigned int tcmplxA_ringdist_get_postfix(struct tcmplxA_ringdist const* x);
 TCMPLX_A_API
 int tcmplxA_ringdist_reconfigure
   (struct tcmplxA_ringdist* ring, int special_tf, unsigned int direct, unsigned int postfix);
+
+/**
+ * @brief Configure an existing distance ring and reset its history
+ *   to the initial distances.
+ * @param special_tf nonzero to support Brotli distance codes
+ * @param direct number of direct codes (0..120)
+ * @param postfix postfix bit count (0..3)
+ * @return Success on success, nonzero otherwise
+ */
+TCMPLX_A_API
+int tcmplxA_ringdist_reset
+  (struct tcmplxA_ringdist* ring, int special_tf, unsigned int direct, unsigned int postfix);
+
+/**
+ * @brief Measure the memory held by a distance ring.
+ * @param x the distance ring to inspect
+ * @return the number of bytes held, including the distance ring itself
+ */
+TCMPLX_A_API
+size_t tcmplxA_ringdist_memory_usage(struct tcmplxA_ringdist const* x);
+
+/**
+ * @brief Estimate the memory held by a distance ring.
+ * @return the number of bytes any distance ring holds
+ */
+TCMPLX_A_API
+size_t tcmplxA_ringdist_memory_bound(void);
 /* END   distance ring */
 
 #ifdef __cplusplus
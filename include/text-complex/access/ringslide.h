@@ -7,6 +7,8 @@
 
 #include "api.h"
 
+struct tcmplxA_allocator;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /*__cplusplus*/
@@ -25,6 +27,16 @@ struct tcmplxA_ringslide;
 TCMPLX_A_API
 struct tcmplxA_ringslide* tcmplxA_ringslide_new(tcmplxA_uint32 n);
 
+/**
+ * @brief Construct a new slide ring using an allocator.
+ * @param n size of sliding window in bytes
+ * @param alloc (nullable) allocator for the ring; NULL for the heap
+ * @return a pointer to the slide ring on success, NULL otherwise
+ */
+TCMPLX_A_API
+struct tcmplxA_ringslide* tcmplxA_ringslide_new_alloc
+  (tcmplxA_uint32 n, struct tcmplxA_allocator const* alloc);
+
 /**
  * @brief Destroy a slide ring.
  * @param x (nullable) the slide ring to destroy
@@ -66,6 +78,14 @@ tcmplxA_uint32 tcmplxA_ringslide_size(struct tcmplxA_ringslide const* x);
 TCMPLX_A_API
 unsigned int tcmplxA_ringslide_peek
   (struct tcmplxA_ringslide const* x, tcmplxA_uint32 i);
+
+/**
+ * @brief Measure the memory held by a slide ring.
+ * @param x the slide ring to inspect
+ * @return the number of bytes held, including the slide ring itself
+ */
+TCMPLX_A_API
+size_t tcmplxA_ringslide_memory_usage(struct tcmplxA_ringslide const* x);
 /* END   slide ring */
 
 #ifdef __cplusplus
@@ -8,6 +8,38 @@
 
 #include "api.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif /*__cplusplus*/
+
+/**
+ * @brief Memory allocator interface.
+ * @note Objects constructed with an allocator keep a pointer to it,
+ *   so the allocator must outlive those objects.
+ */
+struct tcmplxA_allocator {
+  /**
+   * @brief Allocate some bytes.
+   * @param userdata the allocator's callback data
+   * @param sz number of bytes to allocate (never zero)
+   * @return a pointer to suitably aligned bytes on success, NULL otherwise
+   */
+  void* (*allocate)(void* userdata, size_t sz);
+  /**
+   * @brief Free some bytes.
+   * @param userdata the allocator's callback data
+   * @param x (nullable) pointer from `allocate` to free
+   */
+  void (*deallocate)(void* userdata, void* x);
+  /** @brief Callback data for this allocator. */
+  void* userdata;
+};
+
+/**
+ * @brief Bump allocator over one contiguous slab.
+ */
+struct tcmplxA_util_arena;
+
 /* BEGIN allocation */
 /**
  * \brief Allocate some bytes on the heap.
@@ -23,6 +55,23 @@ void* tcmplxA_util_malloc(size_t sz);
 TCMPLX_A_API
 void tcmplxA_util_free(void* x);
 
+/**
+ * \brief Allocate some bytes from an allocator.
+ * \param a (nullable) allocator to use; NULL for the heap
+ * \param sz number of bytes to allocate
+ * \return a pointer to the bytes on success, NULL otherwise
+ */
+TCMPLX_A_API
+void* tcmplxA_util_allocate(struct tcmplxA_allocator const* a, size_t sz);
+
+/**
+ * \brief Free some bytes back to an allocator.
+ * \param a (nullable) allocator used to allocate the bytes
+ * \param x (nullable) pointer to bytes to free
+ */
+TCMPLX_A_API
+void tcmplxA_util_deallocate(struct tcmplxA_allocator const* a, void* x);
+
 /**
  * @brief Calculate the minimum number of bits needed to store a value.
  * @param x value to check
@@ -32,4 +81,56 @@ TCMPLX_A_API
 unsigned tcmplxA_util_bitwidth(unsigned int x);
 /* END   allocation */
 
+/* BEGIN arena */
+/**
+ * @brief Construct a new arena.
+ * @param cap size of the slab in bytes
+ * @param backing (nullable) allocator for the slab and for any
+ *   allocations that overflow it; NULL for the heap
+ * @return a pointer to the arena on success, NULL otherwise
+ */
+TCMPLX_A_API
+struct tcmplxA_util_arena* tcmplxA_util_arena_new
+  (size_t cap, struct tcmplxA_allocator const* backing);
+
+/**
+ * @brief Destroy an arena.
+ * @param x (nullable) the arena to destroy
+ * @note Any object allocated from the arena must be destroyed first.
+ */
+TCMPLX_A_API
+void tcmplxA_util_arena_destroy(struct tcmplxA_util_arena* x);
+
+/**
+ * @brief Get the allocator interface for an arena.
+ * @param x the arena to use
+ * @return an allocator valid for the life of the arena
+ * @note Frees inside the slab only give back space when they release
+ *   the most recent allocation.
+ */
+TCMPLX_A_API
+struct tcmplxA_allocator const* tcmplxA_util_arena_allocator
+  (struct tcmplxA_util_arena* x);
+
+/**
+ * @brief Query the number of slab bytes in use.
+ * @param x the arena to inspect
+ * @return a byte count, including alignment padding
+ */
+TCMPLX_A_API
+size_t tcmplxA_util_arena_size(struct tcmplxA_util_arena const* x);
+
+/**
+ * @brief Query the size of an arena's slab.
+ * @param x the arena to inspect
+ * @return the slab's size in bytes
+ */
+TCMPLX_A_API
+size_t tcmplxA_util_arena_capacity(struct tcmplxA_util_arena const* x);
+/* END   arena */
+
+#ifdef __cplusplus
+};
+#endif /*__cplusplus*/
+
 #endif /*hg_TextComplexAccess_Util_H_*/
@@ -7,6 +7,8 @@
 
 #include "api.h"
 
+struct tcmplxA_allocator;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /*__cplusplus*/
@@ -29,6 +31,43 @@ struct tcmplxA_zcvt* tcmplxA_zcvt_new
   ( tcmplxA_uint32 block_size,
     tcmplxA_uint32 n, size_t chain_length);
 
+/**
+ * @brief Construct a new zlib conversion state using an allocator.
+ * @param block_size amount of input data to process at once
+ * @param n maximum sliding window size
+ * @param chain_length run-time parameter limiting hash chain length
+ * @param alloc (nullable) allocator for the state and all of its
+ *   internal buffers; NULL for the heap
+ * @return a pointer to the zlib conversion state on success, NULL otherwise
+ * @note The allocator must outlive the state.
+ */
+TCMPLX_A_API
+struct tcmplxA_zcvt* tcmplxA_zcvt_new_alloc
+  ( tcmplxA_uint32 block_size,
+    tcmplxA_uint32 n, size_t chain_length,
+    struct tcmplxA_allocator const* alloc);
+
+/**
+ * @brief Construct a new zlib conversion state within a memory cap.
+ * @param block_size largest amount of input data to process at once
+ * @param n largest sliding window size
+ * @param chain_length largest hash chain length
+ * @param memory_cap most bytes the state may hold
+ * @param alloc (nullable) allocator for the state and all of its
+ *   internal buffers; NULL for the heap
+ * @return a pointer to the zlib conversion state on success, NULL
+ *   if no state fits the cap or on allocation failure
+ * @note The window, chain length and block size are reduced as needed
+ *   to keep @link tcmplxA_zcvt_memory_bound @endlink within the cap.
+ * @note The capped state refuses to inflate streams whose window (CINFO)
+ *   exceeds its own, with tcmplxA_ErrMemoryCap.
+ */
+TCMPLX_A_API
+struct tcmplxA_zcvt* tcmplxA_zcvt_new_capped
+  ( tcmplxA_uint32 block_size,
+    tcmplxA_uint32 n, size_t chain_length, size_t memory_cap,
+    struct tcmplxA_allocator const* alloc);
+
 /**
  * @brief Destroy a zlib conversion state.
  * @param x (nullable) the zlib conversion state to destroy
@@ -36,6 +75,29 @@ struct tcmplxA_zcvt* tcmplxA_zcvt_new
 TCMPLX_A_API
 void tcmplxA_zcvt_destroy(struct tcmplxA_zcvt* x);
 
+/**
+ * @brief Return a zlib conversion state to the start of a stream.
+ * @param x the zlib conversion state to reset
+ * @note The state keeps its allocations, so a reset state can
+ *   begin a new stream (in either direction) without the cost
+ *   of @link tcmplxA_zcvt_new @endlink.
+ */
+TCMPLX_A_API
+void tcmplxA_zcvt_reset(struct tcmplxA_zcvt* x);
+
+/**
+ * @brief Choose whether to search for matches with a suffix array.
+ * @param x the zlib conversion state to configure
+ * @param suffix_tf nonzero to weigh several earlier matches at every
+ *   input byte, for a better ratio at a much lower speed
+ * @note The search's scratch space counts against the memory cap
+ *   (see @link tcmplxA_zcvt_new_capped @endlink): under a tight cap
+ *   it indexes less history, or falls back to the hash chain.
+ *   See @link tcmplxA_blockbuf_set_suffix @endlink.
+ */
+TCMPLX_A_API
+void tcmplxA_zcvt_set_suffix(struct tcmplxA_zcvt* x, int suffix_tf);
+
 /**
  * @brief Convert a zlib stream to a byte stream.
  * @param ps the zlib conversion state to use
@@ -78,6 +140,20 @@ TCMPLX_A_API
 size_t tcmplxA_zcvt_bypass
   (struct tcmplxA_zcvt* x, unsigned char const* buf, size_t sz);
 
+/**
+ * @brief Copy dictionary data from another conversion state.
+ * @param dst the conversion state to configure
+ * @param src a conversion state primed only by
+ *   @link tcmplxA_zcvt_bypass @endlink
+ * @return tcmplxA_Success on success, nonzero otherwise
+ * @note Use this to prime a dictionary once, then start any number
+ *   of streams from it without hashing the dictionary again.
+ *   Both states must be at the start of a stream.
+ */
+TCMPLX_A_API
+int tcmplxA_zcvt_bypass_copy
+  (struct tcmplxA_zcvt* dst, struct tcmplxA_zcvt const* src);
+
 /**
  * @brief Convert a byte stream to a zlib stream.
  * @param ps the zlib conversion state to use
@@ -112,6 +188,27 @@ int tcmplxA_zcvt_strrtozs
 TCMPLX_A_API
 int tcmplxA_zcvt_delimrtozs
   (struct tcmplxA_zcvt* ps, size_t* ret, unsigned char* dst, size_t dstsz);
+
+/**
+ * @brief Measure the memory held by a zlib conversion state.
+ * @param x the zlib conversion state to inspect
+ * @return the number of bytes held, including the state itself
+ */
+TCMPLX_A_API
+size_t tcmplxA_zcvt_memory_usage(struct tcmplxA_zcvt const* x);
+
+/**
+ * @brief Estimate the most memory a zlib conversion state may hold.
+ * @param block_size amount of input data to process at once
+ * @param n maximum sliding window size
+ * @param chain_length run-time parameter limiting hash chain length
+ * @return the number of bytes such a state holds at most, or `(size_t)-1`
+ *   if no such state can exist
+ */
+TCMPLX_A_API
+size_t tcmplxA_zcvt_memory_bound
+  ( tcmplxA_uint32 block_size,
+    tcmplxA_uint32 n, size_t chain_length);
 /* END   zcvt state */
 
 #ifdef __cplusplus
@@ -16,6 +16,8 @@ char const* tcmplxA_api_version(void) {
 /* BEGIN error codes */
 char const* tcmplxA_api_error_toa(int v) {
   switch (v) {
+  case tcmplxA_ErrMemoryCap:
+    return "Stream needs more memory than the state's cap allows";
   case tcmplxA_ErrInsCopyMissing:
     return "An expected insert-copy code is missing";
   case tcmplxA_ErrPartial:
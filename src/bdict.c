@@ -476,21 +476,38 @@ int tcmplxA_bdict_transform
   else if (*len > 24u)
     return tcmplxA_ErrMemory;
   else {
-    unsigned char out[38];
+    unsigned char word[24];
     unsigned int outlen = 0u;
+    memcpy(word, buf, *len);
+    tcmplxA_bdict_transform_copy(buf, &outlen, word, *len, k);
+    memset(buf+outlen, 0, 38u-outlen);
+    *len = outlen;
+    return tcmplxA_Success;
+  }
+}
+
+int tcmplxA_bdict_transform_copy
+  ( unsigned char* dst, unsigned int* dstlen,
+    unsigned char const* word, unsigned int len, unsigned int k)
+{
+  if (k >= 121u)
+    return tcmplxA_ErrParam;
+  else if (len > 24u)
+    return tcmplxA_ErrMemory;
+  else if (k == 0u) {
+    /* identity without affixes */
+    memcpy(dst, word, len);
+    *dstlen = len;
+    return tcmplxA_Success;
+  } else {
     /* index the arrays */
     struct tcmplxA_bdict_formula const* const formula =
       tcmplxA_bdict_formulas+k;
-    tcmplxA_bdict_cb_do
-      ( out, &outlen, formula->front.p, formula->front.len,
-        tcmplxA_BDict_Identity);
-    tcmplxA_bdict_cb_do(out, &outlen, buf, *len, formula->cb);
-    tcmplxA_bdict_cb_do
-      ( out, &outlen, formula->back.p, formula->back.len,
-        tcmplxA_BDict_Identity);
-    memset(out+outlen, 0, 38u-outlen);
-    memcpy(buf, out, 38);
-    *len = outlen;
+    unsigned int outlen = formula->front.len;
+    memcpy(dst, formula->front.p, outlen);
+    tcmplxA_bdict_cb_do(dst, &outlen, word, len, formula->cb);
+    memcpy(dst+outlen, formula->back.p, formula->back.len);
+    *dstlen = outlen + formula->back.len;
     return tcmplxA_Success;
   }
 }
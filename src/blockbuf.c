@@ -9,6 +9,7 @@
 #include "text-complex/access/api.h"
 #include "text-complex/access/util.h"
 #include <string.h>
+#include <assert.h>
 
 
 /**
@@ -67,44 +68,584 @@ enum tcmplxA_blockstr_uconst {
    * @internal
    * @brief Maximum number to encode as an insert or copy length.
    */
-  tcmplxA_BlockBuf_MaxOutCode = 16447u
+  tcmplxA_BlockBuf_MaxOutCode = 16447u,
+  /**
+   * @internal
+   * @brief Longest match to measure when comparing match candidates.
+   */
+  tcmplxA_BlockBuf_ProbeMax = 64u,
+  /**
+   * @internal
+   * @brief Estimated bits per byte covered by a match.
+   */
+  tcmplxA_BlockBuf_ByteBits = 6u,
+  /**
+   * @internal
+   * @brief Shortest input block worth probing for compressibility.
+   */
+  tcmplxA_BlockBuf_ProbeMin = 1024u,
+  /**
+   * @internal
+   * @brief Number of evenly spaced slices to sample per probe.
+   */
+  tcmplxA_BlockBuf_ProbeSlices = 32u,
+  /**
+   * @internal
+   * @brief Longest slice to sample per probe.
+   */
+  tcmplxA_BlockBuf_ProbeSlice = 256u,
+  /**
+   * @internal
+   * @brief Bit count of the repeat table used by the probe.
+   */
+  tcmplxA_BlockBuf_ProbeHashBits = 12u,
+  /**
+   * @internal
+   * @brief Distance between window lookups in a probe slice.
+   */
+  tcmplxA_BlockBuf_ProbeStep = 8u,
+  /**
+   * @internal
+   * @brief Missed searches per extra byte skipped between searches.
+   */
+  tcmplxA_BlockBuf_SkipShift = 5u,
+  /**
+   * @internal
+   * @brief Smallest window to scan for long-distance matches.
+   * @note DEFLATE windows stay below this size.
+   */
+  tcmplxA_BlockBuf_FarWindow = 65536u,
+  /**
+   * @internal
+   * @brief Fingerprint length for long-distance matches.
+   * @note Also the shortest such match, and the least spacing
+   *   between two of them.
+   */
+  tcmplxA_BlockBuf_FarMin = 64u,
+  /**
+   * @internal
+   * @brief One in `1<<FarRateBits` fingerprints enters the table.
+   */
+  tcmplxA_BlockBuf_FarRateBits = 5u,
+  /**
+   * @internal
+   * @brief Smallest number of bits to index the fingerprint table.
+   */
+  tcmplxA_BlockBuf_FarBitsMin = 10u,
+  /**
+   * @internal
+   * @brief Most window history to index ahead of each block
+   *   in suffix array mode.
+   */
+  tcmplxA_BlockBuf_SuffixHistory = 65536u,
+  /**
+   * @internal
+   * @brief Window history to index per input byte in suffix array mode.
+   */
+  tcmplxA_BlockBuf_SuffixSpan = 4u,
+  /**
+   * @internal
+   * @brief Match candidates to keep per input byte in suffix array mode.
+   */
+  tcmplxA_BlockBuf_SuffixCandidates = 4u,
+  /**
+   * @internal
+   * @brief Neighbors to visit on either side of a suffix for
+   *   shorter, nearer matches.
+   */
+  tcmplxA_BlockBuf_SuffixSteps = 8u,
+  /**
+   * @internal
+   * @brief Copy length past which the parse tries no shorter lengths
+   *   of the same candidate.
+   */
+  tcmplxA_BlockBuf_SuffixNice = 128u
+};
+
+/**
+ * @internal
+ * @brief Long-distance match found ahead of a parse.
+ */
+struct tcmplxA_blockbuf_far {
+  /** @brief Position of the match in the input block. */
+  tcmplxA_uint32 pos;
+  /** @brief Backward distance at that position; zero is the previous byte. */
+  tcmplxA_uint32 v;
+};
+
+/**
+ * @internal
+ * @brief Hash chain search paused between input bytes.
+ */
+struct tcmplxA_blockbuf_parse {
+  /** @brief Index of the first command of the block. */
+  size_t first;
+  /** @brief Next input position to search. */
+  tcmplxA_uint32 i;
+  /** @brief Distance of the current match. */
+  tcmplxA_uint32 v;
+  /** @brief Distance of the match one byte later. */
+  tcmplxA_uint32 other_v;
+  tcmplxA_uint32 match_size;
+  tcmplxA_uint32 other_match_size;
+  /** @brief Searches missed since the last match. */
+  tcmplxA_uint32 misses;
+  /** @brief Bytes left to pass over without a search. */
+  tcmplxA_uint32 skip_left;
+  /** @brief Next long-distance match to consider. */
+  size_t far_i;
+  /** @brief Zero between matches, else the number of matches in play. */
+  unsigned char state;
+  /** @brief Byte before the match one byte later. */
+  unsigned char skipped_byte;
+  /** @brief Whether the search has input left to parse. */
+  unsigned char active;
 };
 
 struct tcmplxA_blockbuf {
   struct tcmplxA_hashchain* chain;
   struct tcmplxA_blockstr input;
   struct tcmplxA_blockstr output;
+  struct tcmplxA_blockstr literals;
+  /** @brief Command fields, `cmd_cap` apiece: insert, copy, distance, offset. */
+  tcmplxA_uint32* cmds;
+  size_t cmd_count;
+  size_t cmd_cap;
   int bdict_tf;
   tcmplxA_uint32 input_block_size;
+  /** @brief Input bytes set aside past `input.sz` for the next block. */
+  tcmplxA_uint32 held;
+  /** @brief Recent copy distances, most recent at `recent_i`. */
+  tcmplxA_uint32 recent[4];
+  unsigned char recent_i;
+  /** @brief Whether to probe recent distances before the hash chain. */
+  unsigned char recent_tf;
+  /** @brief Whether to take the first hash hit without lookahead. */
+  unsigned char greedy_tf;
+  /** @brief Whether to search less often along runs of literals. */
+  unsigned char skip_tf;
+  /**
+   * @brief Fingerprint table for long-distance matches, one past each
+   *   fingerprint's start position; NULL for small windows.
+   */
+  tcmplxA_uint32* far_table;
+  /** @brief Number of bits to index the fingerprint table. */
+  unsigned int far_bits;
+  /** @brief Number of bytes to enter the window so far, wrapping. */
+  tcmplxA_uint32 far_total;
+  /** @brief Rolling hash of the last `FarMin` bytes to enter the window. */
+  unsigned long long int far_hash;
+  /** @brief Long-distance matches for the current input block. */
+  struct tcmplxA_blockbuf_far* far_hits;
+  size_t far_count;
+  size_t far_cap;
+  /** @brief Whether to find matches with a suffix array. */
+  unsigned char suffix_tf;
+  /** @brief Longest copy to emit. */
+  tcmplxA_uint32 copy_max;
+  /** @brief Most scratch bytes for each suffix array search. */
+  size_t scratch_cap;
+  /** @brief Search in progress over the current input block. */
+  struct tcmplxA_blockbuf_parse parse;
 };
 
+/**
+ * @internal
+ * @brief Rolling hash terms, one per byte value.
+ */
+static unsigned long long int const tcmplxA_blockbuf_gear[256] = {
+  0x5f9c71ef600104b9ull, 0xe8c29c34c123f869ull, 0x3ace08333b675514ull,
+  0x987b5f753b6e15dcull, 0x9890d66637673135ull, 0x7834a1dfded538daull,
+  0xe1135dd2af325bcbull, 0x1f160a7307a8a317ull, 0x532aaaea6b1ad958ull,
+  0xc9ef35b039a07112ull, 0x9f85b76c7b403b6bull, 0xc56a4aea7a2248c1ull,
+  0xa6b26357943de2d0ull, 0xbe19467b94b5662full, 0xc3bf2e960f50666cull,
+  0x7d5e3444ba7b66afull, 0x73ddca4233ace521ull, 0xcaf04bb311e602b7ull,
+  0x25145ff253e56db6ull, 0xec946e3b454db9bfull, 0x5f2259f1ab4853acull,
+  0x753029b0d6749f3aull, 0x12b501566e4b16bfull, 0xe26b994c5a097bfcull,
+  0x48ec7644f5730a3cull, 0x3089aa5bea13b870ull, 0x570ef24448894f27ull,
+  0x1970c81732ba542cull, 0xe2d427e48d9599b5ull, 0xe2bdd00d7810afc0ull,
+  0xc35e3dac12643b0bull, 0x43e120b383281a1full, 0x8de1e67dd835bd9eull,
+  0x9f1280e7195ccce6ull, 0x2640fe4b29c1ac2full, 0x2ac5662f0957e05full,
+  0x90e63eb48f1fba89ull, 0x65d561f5dd5d4693ull, 0xf5bff56f9ed624c1ull,
+  0x1f0218b7ab4ab5c2ull, 0xeecf63f043b8ef6cull, 0xec7ff32b0d609388ull,
+  0x550dd89be3e01248ull, 0xbd3e44ac36f66d6bull, 0x4d40e60f2fa07a5cull,
+  0x7649b04d82e737e5ull, 0x6e6fca27d7b8dc7eull, 0x56238602ed4ed168ull,
+  0x14ebab73a2a0fcb6ull, 0xdc3561303e8b2d20ull, 0x7f683c438e73761dull,
+  0x3f70f57e02af240cull, 0x93034e24ef6c5efcull, 0xf8ee7b1eb0efdf9full,
+  0x32bc0e4a36b9ef28ull, 0x235d7f399c66e5b2ull, 0x24c6e0c60928ec46ull,
+  0x5825d4ae74de701aull, 0x8e09be25a2daaeedull, 0x693268a3b9c5a60bull,
+  0xa3e25c5d58631fe6ull, 0x5531df65a5291214ull, 0x84a1c075a265a4ddull,
+  0xb8d23a12d97550fcull, 0x3c9f64f6cf5b6e44ull, 0xcca5c388044c4ba2ull,
+  0x10fa7305bb32a167ull, 0x0f533e4918948997ull, 0x1a038b6b89ad3eb6ull,
+  0xf4b2c40bf7bcf915ull, 0x2bc360678497d0bbull, 0x6dae85240dda8493ull,
+  0xad1f34920bbfef4cull, 0x68f9e97da9943268ull, 0x01d46ac88a539104ull,
+  0x9a52f80786906b00ull, 0xa1bec16ab134388bull, 0xeb81bb46242ae177ull,
+  0x2df6e70b8b42d1a0ull, 0xb2935943ae0ac906ull, 0x3c48fe963d2d0a8dull,
+  0xca2a07fe0743b14cull, 0x2302fe761ff02a5dull, 0x138e1cd24d679190ull,
+  0x1946a7d0a0dd58acull, 0x33132e20c08bd96eull, 0x3a415adb35f1d3f5ull,
+  0x059ac6857346c324ull, 0xaa1f42a7caec6087ull, 0x10c62c710b77e40eull,
+  0xf2ae70a59ad4c8ceull, 0x024dd741f8a51450ull, 0xe5608f7dd8c09ba8ull,
+  0xf92ab0d92c3e7eabull, 0xc0b20fa270f6634cull, 0x68af0f63200f3784ull,
+  0xdf64d5899573ccd7ull, 0x5e004d6275b31235ull, 0xbe0c49c65c8762abull,
+  0x1fb076bcf54b16b3ull, 0xdc8c50f4e0a53f1dull, 0xd5198dac10df3476ull,
+  0xa22dd631d292969dull, 0x890c860e27052799ull, 0xc407e2bbf8429b39ull,
+  0xa95352f52ff1e420ull, 0x29a8f0c51196e71full, 0x873ace7b0bdf2393ull,
+  0xf8c7133a75724f63ull, 0x2f70447794baabf7ull, 0xbe60416d54b98e9eull,
+  0x7191ae2b661a811full, 0x634c93da2567491dull, 0x481d852cef3fdaf1ull,
+  0x9fa619f7b5424041ull, 0xbc516b59940217afull, 0xe4d273a6e1728539ull,
+  0x29b51d9029266504ull, 0x472ffdb1e716e5c4ull, 0x57ed5ac0b3c481f3ull,
+  0xf7abca5ae7d1af81ull, 0xc7e3e2cffd0730a6ull, 0xb744716189b57504ull,
+  0x8ad5b2bfbbdb81c0ull, 0x1b659e7feb52d367ull, 0x82fb531ab4f0b2b9ull,
+  0xa643facd99fc6a59ull, 0x3a3845dfc8c6cc99ull, 0xfaff7d081de23d90ull,
+  0x6d3be694849c6754ull, 0x7b942d77df07656full, 0xfb109da46ac455aaull,
+  0xa8051b47bf10b909ull, 0x97112d52dd59619eull, 0xd005628afa598728ull,
+  0x261d805ec4cb0cf0ull, 0x5efa9e665c7f0bfcull, 0xedd25cf1d0359580ull,
+  0x5eb5c533ee68c7b4ull, 0xfe660ba927036ce8ull, 0x22ef0ac15c6d608bull,
+  0x6b5f2795d7e1347cull, 0xf056e17a9cc4aca5ull, 0x5a230a2a20a5e3c2ull,
+  0x35747eff44e5cd51ull, 0x08032c6cffc89584ull, 0xea5865ddde0e33c6ull,
+  0x22f89b3ec82929d2ull, 0x039a2c9494f3f4c6ull, 0x550ea805d13ffb4full,
+  0xb0a6aebbd61a4682ull, 0x3ef85d7c3b02c103ull, 0x560441eae29ef900ull,
+  0x88e65fdfcd70d8e8ull, 0x749bbafe2bca13d7ull, 0x58e581e7fce8c857ull,
+  0xe985957567173296ull, 0x605a8cce50a8b202ull, 0xcecffb45452f3423ull,
+  0xbd6aff9bc95ffbebull, 0xe34487ed20278a48ull, 0x3b669948fa1529b6ull,
+  0x4241c21b944439f8ull, 0x179475f954a98f56ull, 0x23d836fd0a07b4bbull,
+  0xea4ce4dfa7927710ull, 0x644281efeea4152cull, 0x8549689a0fd58330ull,
+  0x310f2c20b20449cfull, 0x34bec04171aab1d6ull, 0xa7c8f344af95222cull,
+  0x2e53f4c8ddf87983ull, 0x7cac90d75a538a1cull, 0x921803044c2cacc9ull,
+  0x13d74fa8319244a1ull, 0xb97f637d98d22d85ull, 0x34d052ca66371df3ull,
+  0xe257bad3b386b7bdull, 0x32424a7c2bcea8deull, 0x3f363701e77370c3ull,
+  0xd61c9fd15c3206a5ull, 0xed5e0abaa2f7e29eull, 0x05e289c3bf1bc1c8ull,
+  0x5fbafe2cb5408eeaull, 0x5524da21c9da7584ull, 0x5d01ec82b7f577deull,
+  0x0acd2743d1b4c100ull, 0xe82529cd35e35d38ull, 0x4dacc121b03e4e01ull,
+  0x37c0aae79cdedc64ull, 0x0dc4c86d67b39d34ull, 0x2a55b7ae9237098eull,
+  0xb296f92615a25232ull, 0x331aadcfdbda3c7aull, 0x556c13927de1c893ull,
+  0x0770778f0d0de959ull, 0x3cbf24226a9203c6ull, 0x56eb753a9e13b186ull,
+  0x31e4c51c8ad12046ull, 0xd91514366b39ab8aull, 0x23dc9ee265381e8bull,
+  0x8d8f7ceb3dfb1c1dull, 0xfbb7df2263380b54ull, 0x4de17a6df9929185ull,
+  0x5fcc1441f2b457afull, 0x83d2a4f0cc788944ull, 0xfd574caa6ad7acedull,
+  0xaab6be87176f7ec3ull, 0xeb83d158ed1342c3ull, 0xb4091f750e1384ccull,
+  0x3507d03b8196c784ull, 0xec94cf263b5b152cull, 0x199028b2ea1e0b9dull,
+  0x09dd8a826e29ba76ull, 0x89341d7157375d40ull, 0x61e228a58b3329c1ull,
+  0xae963607fdb75e2dull, 0x1fdc2311053c94c6ull, 0xc41113235e5f3618ull,
+  0xe9071163d85c75e4ull, 0x4a358e3f6fb6dc94ull, 0xbcb45bbd85de8f9eull,
+  0x7297ae18ab257b8aull, 0x9c342a5262a2a73full, 0x5279633cb6c74840ull,
+  0xcb1ff8b1d5d19d55ull, 0x6459171abc68c971ull, 0xedb7233f3ccb2be5ull,
+  0x67cb84766c7f3ddbull, 0x558291a4e099bfafull, 0x0c93628898c3318aull,
+  0x041ec35f1662da8eull, 0x9e0cf7c561c53834ull, 0x6743159088e37c11ull,
+  0xcc7182545b41a529ull, 0x204868b3285121f6ull, 0x6bc619290871bd94ull,
+  0x2ba70e1f5b7442c0ull, 0xb416ff445ef9d66aull, 0x0a1f0aafe3ad71f0ull,
+  0xf26748be1591cd2aull, 0x16155f48121caee3ull, 0x4214281321d5998full,
+  0x0dc97a219e30b644ull, 0xfea6a0b04488a702ull, 0xa9e42d33f86827c7ull,
+  0xfd1f02438f9e9a96ull, 0x6ea70869262e13b1ull, 0xcb2ee59fd05c2b1bull,
+  0x902225f14d48e01full, 0xf74e79c1065d26aaull, 0xd164b5003bdf6840ull,
+  0xe8695f2e80381f67ull, 0x64f3931f8dca0d26ull, 0x54a67e875c3cb425ull,
+  0xad3a368b0fa63c90ull
+};
+
+/**
+ * @brief Add an insert command to an output buffer.
+ * @param x the output buffer
+ * @param buf literal bytes to insert
+ * @param n number of literals, at most `tcmplxA_BlockBuf_MaxOutCode`
+ * @return tcmplxA_Success on success
+ */
+static int tcmplxA_blockstr_add_insert
+  (struct tcmplxA_blockstr* x, unsigned char const* buf, tcmplxA_uint32 n);
 /**
  * @brief Add a copy command to an output buffer.
  * @param x the output buffer
  * @param match_size the copy length
- * @param v backward distance
+ * @param v backward distance, or a flagged bdict reference
  * @return tcmplxA_Success on success
  */
 static int tcmplxA_blockstr_add_copy
   (struct tcmplxA_blockstr* x, tcmplxA_uint32 match_size, tcmplxA_uint32 v);
+
 /**
- * @brief Update an insert command in an output buffer.
- * @param x the output buffer
+ * @brief Make room for more commands.
+ * @param x the block buffer to extend
+ * @param n new command capacity
+ * @return tcmplxA_Success on success
+ */
+static int tcmplxA_blockbuf_cmd_reserve(struct tcmplxA_blockbuf* x, size_t n);
+/**
+ * @brief Start a new command.
+ * @param x the block buffer to update
+ * @note Capacity must be reserved beforehand.
+ */
+static void tcmplxA_blockbuf_cmd_open(struct tcmplxA_blockbuf* x);
+/**
+ * @brief Add a literal to the command stream.
+ * @param x the block buffer to update
  * @param b the byte to add
- * @param[in,out] j location of insert command
+ * @param first index of the first command of the current block
+ */
+static void tcmplxA_blockbuf_cmd_literal
+  (struct tcmplxA_blockbuf* x, unsigned int b, size_t first);
+/**
+ * @brief Add a copy to the command stream.
+ * @param x the block buffer to update
+ * @param match_size the copy length
+ * @param v backward distance
+ * @param first index of the first command of the current block
+ */
+static void tcmplxA_blockbuf_cmd_copy
+  ( struct tcmplxA_blockbuf* x, tcmplxA_uint32 match_size, tcmplxA_uint32 v,
+    size_t first);
+/**
+ * @brief Reset the recent distances to the Brotli initial values.
+ * @param x the block buffer to update
+ */
+static void tcmplxA_blockbuf_recent_reset(struct tcmplxA_blockbuf* x);
+/**
+ * @brief Note the distance of a new copy.
+ * @param x the block buffer to update
+ * @param v backward distance
+ */
+static void tcmplxA_blockbuf_recent_add
+  (struct tcmplxA_blockbuf* x, tcmplxA_uint32 v);
+/**
+ * @brief Measure a match against the sliding window.
+ * @param x the block buffer to inspect
+ * @param i position of the match in the input block
+ * @param v backward distance; zero is the most recent byte
+ * @param max longest length to measure
+ * @return the match length, up to `max`
+ */
+static tcmplxA_uint32 tcmplxA_blockbuf_match_length
+  ( struct tcmplxA_blockbuf const* x, tcmplxA_uint32 i, tcmplxA_uint32 v,
+    tcmplxA_uint32 max);
+/**
+ * @brief Find the best match among the recent distances.
+ * @param x the block buffer to inspect
+ * @param i position of the match in the input block
+ * @param[out] length the match length, up to `tcmplxA_BlockBuf_ProbeMax`
+ * @return a backward distance, or `tcmplxA_BlockBuf_NPos` if none
+ *   matches at least three bytes
+ */
+static tcmplxA_uint32 tcmplxA_blockbuf_recent_find
+  ( struct tcmplxA_blockbuf const* x, tcmplxA_uint32 i,
+    tcmplxA_uint32* length);
+/**
+ * @brief Hash four bytes for the compressibility probe.
+ * @param b the bytes to hash
+ * @return an index into the probe's repeat table
+ */
+static unsigned int tcmplxA_blockbuf_probe_hash(unsigned char const* b);
+/**
+ * @brief Look up sampled input positions in the sliding window.
+ * @param x the block buffer to inspect
+ * @param stride distance between slice starts
+ * @param slice length of each slice
+ * @return nonzero if enough of the sampled positions start a match
+ *   of four bytes or more in the window
+ */
+static int tcmplxA_blockbuf_window_probe
+  ( struct tcmplxA_blockbuf const* x, tcmplxA_uint32 stride,
+    tcmplxA_uint32 slice);
+/**
+ * @brief Size the fingerprint table for a window.
+ * @param n maximum sliding window size
+ * @return the number of bits to index the table
+ */
+static unsigned int tcmplxA_blockbuf_far_bits(tcmplxA_uint32 n);
+/**
+ * @brief Make room for long-distance matches.
+ * @param x the block buffer to update
+ * @param n number of matches to hold
+ * @return tcmplxA_Success on success
+ */
+static int tcmplxA_blockbuf_far_reserve(struct tcmplxA_blockbuf* x, size_t n);
+/**
+ * @brief Check a fingerprint hit against the window and input block.
+ * @param x the block buffer to inspect
+ * @param pos position of the fingerprint in the input block
+ * @param d distance back to the earlier fingerprint, at least one
+ * @return nonzero if the first `FarMin` bytes match
+ */
+static int tcmplxA_blockbuf_far_check
+  (struct tcmplxA_blockbuf const* x, tcmplxA_uint32 pos, tcmplxA_uint32 d);
+/**
+ * @brief Fingerprint bytes about to enter the window.
+ * @param x the block buffer to update
+ * @param buf the bytes
+ * @param n number of bytes
+ * @param find_tf nonzero to note long-distance matches, in which case
+ *   `buf` must be the input block
+ */
+static void tcmplxA_blockbuf_far_scan
+  ( struct tcmplxA_blockbuf* x, unsigned char const* buf, tcmplxA_uint32 n,
+    int find_tf);
+/**
+ * @brief Look for a long-distance match without updating the table.
+ * @param x the block buffer to inspect
+ * @return nonzero if some fingerprint in the input block has a
+ *   checked match farther back
+ */
+static int tcmplxA_blockbuf_far_probe(struct tcmplxA_blockbuf const* x);
+/**
+ * @brief Check whether a suffix is an S-type suffix.
+ * @param t suffix types, one bit each
+ * @param i suffix position
+ * @return nonzero for S-type, zero for L-type
+ */
+static int tcmplxA_blockbuf_sais_type(unsigned char const* t, tcmplxA_uint32 i);
+/**
+ * @brief Check whether a suffix is a leftmost S-type suffix.
+ * @param t suffix types, one bit each
+ * @param i suffix position
+ * @return nonzero for an LMS suffix
+ */
+static int tcmplxA_blockbuf_sais_lms(unsigned char const* t, tcmplxA_uint32 i);
+/**
+ * @brief Compute suffix array bucket bounds.
+ * @param s the text
+ * @param n text length
+ * @param k largest symbol in the text
+ * @param[out] bkt bucket bounds, one per symbol up to `k`
+ * @param end_tf nonzero for bucket ends, zero for bucket starts
+ */
+static void tcmplxA_blockbuf_sais_buckets
+  ( tcmplxA_uint32 const* s, tcmplxA_uint32 n, tcmplxA_uint32 k,
+    tcmplxA_uint32* bkt, int end_tf);
+/**
+ * @brief Induce L-type then S-type suffixes from sorted seeds.
+ * @param s the text
+ * @param sa suffix array under construction
+ * @param n text length
+ * @param k largest symbol in the text
+ * @param t suffix types, one bit each
+ * @param bkt scratch for bucket bounds
+ */
+static void tcmplxA_blockbuf_sais_induce
+  ( tcmplxA_uint32 const* s, tcmplxA_uint32* sa, tcmplxA_uint32 n,
+    tcmplxA_uint32 k, unsigned char const* t, tcmplxA_uint32* bkt);
+/**
+ * @brief Sort the suffixes of a text by induced sorting (SA-IS).
+ * @param alloc (nullable) allocator for scratch space
+ * @param s the text, ending in a unique smallest symbol
+ * @param[out] sa the suffix array
+ * @param n text length, at least two
+ * @param k largest symbol in the text
+ * @return tcmplxA_Success on success
+ */
+static int tcmplxA_blockbuf_sais
+  ( struct tcmplxA_allocator const* alloc, tcmplxA_uint32 const* s,
+    tcmplxA_uint32* sa, tcmplxA_uint32 n, tcmplxA_uint32 k);
+/**
+ * @brief Estimate the bits to encode a copy.
+ * @param len copy length
+ * @param v backward distance
+ * @return the estimate
+ */
+static tcmplxA_uint32 tcmplxA_blockbuf_suffix_cost
+  (tcmplxA_uint32 len, tcmplxA_uint32 v);
+/**
+ * @brief Keep a match candidate unless a kept one is as long and nearer.
+ * @param x the block buffer to inspect
+ * @param i input position of the match
+ * @param v backward distance
+ * @param len match length
+ * @param[in,out] lens `SuffixCandidates` match lengths per input byte,
+ *   longest first, ending early at a zero
+ * @param[in,out] dists backward distance of each length in `lens`
+ */
+static void tcmplxA_blockbuf_suffix_keep
+  ( struct tcmplxA_blockbuf const* x, tcmplxA_uint32 i, tcmplxA_uint32 v,
+    tcmplxA_uint32 len, tcmplxA_uint32* lens, tcmplxA_uint32* dists);
+/**
+ * @brief Keep a match candidate found in the suffix array.
+ * @param x the block buffer to inspect
+ * @param h number of window bytes indexed ahead of the input block
+ * @param at text position of the match
+ * @param from earlier text position matched
+ * @param len match length
+ * @param[in,out] lens match lengths per input byte
+ * @param[in,out] dists backward distances per input byte
+ */
+static void tcmplxA_blockbuf_suffix_note
+  ( struct tcmplxA_blockbuf const* x, tcmplxA_uint32 h, tcmplxA_uint32 at,
+    tcmplxA_uint32 from, tcmplxA_uint32 len,
+    tcmplxA_uint32* lens, tcmplxA_uint32* dists);
+/**
+ * @brief Find match candidates at each input byte.
+ * @param x the block buffer to inspect
+ * @param h number of window bytes to index ahead of the input block
+ * @param s scratch for the text, one past the indexed length
+ * @param sa scratch for the suffix array, same length as `s`
+ * @param rank scratch for the inverse suffix array, same length as `s`
+ * @param lcp scratch for the LCP array, same length as `s`
+ * @param[out] lens `SuffixCandidates` match lengths per input byte
+ * @param[out] dists backward distance of each length in `lens`
+ * @return tcmplxA_Success on success
+ * @note The candidates include the longest earlier match in the
+ *   indexed text, and shorter matches at smaller distances found
+ *   among its neighbors in the suffix array.
+ */
+static int tcmplxA_blockbuf_suffix_match
+  ( struct tcmplxA_blockbuf const* x, tcmplxA_uint32 h,
+    tcmplxA_uint32* s, tcmplxA_uint32* sa, tcmplxA_uint32* rank,
+    tcmplxA_uint32* lcp, tcmplxA_uint32* lens, tcmplxA_uint32* dists);
+/**
+ * @brief Measure a match against the window as of the block start.
+ * @param x the block buffer to inspect
+ * @param i input position of the match
+ * @param v backward distance
+ * @return the match length, at most the longest copy to emit
+ */
+static tcmplxA_uint32 tcmplxA_blockbuf_suffix_far_length
+  (struct tcmplxA_blockbuf const* x, tcmplxA_uint32 i, tcmplxA_uint32 v);
+/**
+ * @brief Choose the cheapest path of literals and copies.
+ * @param x the block buffer to inspect
+ * @param lens match lengths per input byte
+ * @param dists backward distances per input byte
+ * @param[out] cost estimated bits to reach each input position,
+ *   one past the input size
+ * @param[out] step_len length of the last literal or copy on the
+ *   way to each input position
+ * @param[out] step_dist distance of that copy, or `NPos` for a literal
+ */
+static void tcmplxA_blockbuf_suffix_parse
+  ( struct tcmplxA_blockbuf const* x, tcmplxA_uint32 const* lens,
+    tcmplxA_uint32 const* dists, tcmplxA_uint32* cost,
+    tcmplxA_uint32* step_len, tcmplxA_uint32* step_dist);
+/**
+ * @brief Bound the scratch space of a suffix array search.
+ * @param h number of window history bytes to index
+ * @param input_sz size of the input block
+ * @return the most bytes the search takes from the allocator at once
+ */
+static size_t tcmplxA_blockbuf_suffix_scratch
+  (tcmplxA_uint32 h, tcmplxA_uint32 input_sz);
+/**
+ * @brief Parse the input block with a suffix array.
+ * @param x the block buffer to update
+ * @param first index of the first command of the current block
+ * @return tcmplxA_Success on success, or tcmplxA_ErrMemory with
+ *   the block buffer untouched if the scratch space is unavailable
+ */
+static int tcmplxA_blockbuf_suffix_commands
+  (struct tcmplxA_blockbuf* x, size_t first);
+/**
+ * @brief Write commands to the output buffer in byte format.
+ * @param x the block buffer to update
+ * @param first index of the first command to write
  * @return tcmplxA_Success on success
  */
-static int tcmplxA_blockstr_update_literal
-  (struct tcmplxA_blockstr* x, unsigned int b, tcmplxA_uint32* j);
+static int tcmplxA_blockbuf_cmd_serialize
+  (struct tcmplxA_blockbuf* x, size_t first);
 
 /**
  * @brief Initialize a block buffer.
  * @param x the block buffer to initialize
+ * @param alloc (nullable) allocator for the buffer; NULL for the heap
  * @return zero on success, nonzero otherwise
  */
 static int tcmplxA_blockbuf_init
   ( struct tcmplxA_blockbuf* x, tcmplxA_uint32 block_size,
-    tcmplxA_uint32 n, size_t chain_length, int bdict_tf);
+    tcmplxA_uint32 n, size_t chain_length, int bdict_tf,
+    struct tcmplxA_allocator const* alloc);
 /**
  * @brief Close a block buffer.
  * @param x the block buffer to close
@@ -113,8 +654,10 @@ static void tcmplxA_blockbuf_close(struct tcmplxA_blockbuf* x);
 
 /* BEGIN block buffer / static */
 int tcmplxA_blockstr_init
-  (struct tcmplxA_blockstr* x, tcmplxA_uint32 cap)
+  ( struct tcmplxA_blockstr* x, tcmplxA_uint32 cap,
+    struct tcmplxA_allocator const* alloc)
 {
+  x->alloc = alloc;
   x->cap = 0u;
   x->sz = 0u;
   x->p = NULL;
@@ -127,7 +670,7 @@ int tcmplxA_blockstr_init
 }
 
 void tcmplxA_blockstr_close(struct tcmplxA_blockstr* x) {
-  tcmplxA_util_free(x->p);
+  tcmplxA_util_deallocate(x->alloc, x->p);
   x->p = NULL;
   x->sz = 0u;
   x->cap = 0u;
@@ -141,11 +684,11 @@ int tcmplxA_blockstr_reserve
     return tcmplxA_Success;
   else {
     unsigned char* const input_data =
-      (unsigned char*)tcmplxA_util_malloc
-          ((size_t)(sz)*sizeof(unsigned char));
+      (unsigned char*)tcmplxA_util_allocate
+          (x->alloc, (size_t)(sz)*sizeof(unsigned char));
     if (input_data != NULL) {
       memcpy(input_data, x->p, x->sz);
-      tcmplxA_util_free(x->p);
+      tcmplxA_util_deallocate(x->alloc, x->p);
       x->cap = sz;
       x->p = input_data;
       return tcmplxA_Success;
@@ -175,6 +718,27 @@ int tcmplxA_blockstr_append
   return tcmplxA_Success;
 }
 
+int tcmplxA_blockstr_add_insert
+  (struct tcmplxA_blockstr* x, unsigned char const* buf, tcmplxA_uint32 n)
+{
+  unsigned char len[2];
+  unsigned int i;
+  int res;
+  if (n >= 64u) {
+    tcmplxA_uint32 const t = n-64u;
+    len[0] = (unsigned char)(((t>>8)&63u) | 64u);
+    len[1] = (unsigned char)(t&255u);
+    i = 2u;
+  } else {
+    len[0] = (unsigned char)n;
+    i = 1u;
+  }
+  res = tcmplxA_blockstr_append(x, len, i);
+  if (res != tcmplxA_Success)
+    return res;
+  return tcmplxA_blockstr_append(x, buf, n);
+}
+
 int tcmplxA_blockstr_add_copy
   (struct tcmplxA_blockstr* x, tcmplxA_uint32 match_size, tcmplxA_uint32 v)
 {
@@ -182,14 +746,18 @@ int tcmplxA_blockstr_add_copy
   unsigned int i;
   if (match_size >= 64u) {
     tcmplxA_uint32 const t = match_size-64u;
-    buf[0] = (unsigned char)((t&63u)>>8)|192u;
+    buf[0] = (unsigned char)(((t>>8)&63u) | 192u);
     buf[1] = (unsigned char)(t&255u);
     i = 2u;
   } else {
     buf[0] = (unsigned char)(match_size | 128u);
     i = 1u;
   }
-  if (v >= 16384u) {
+  if (v & tcmplxA_BlockBuf_BDictRef) {
+    buf[i++] = (unsigned char)((v>>16)&127u);
+    buf[i++] = (unsigned char)((v>>8)&255u);
+    buf[i++] = (unsigned char)(v&255u);
+  } else if (v >= 16384u) {
     tcmplxA_uint32 const t = v-16384u;
     buf[i++] = (unsigned char)(((t>>24)&63u) | 192u);
     buf[i++] = (unsigned char)((t>>16)&255u);
@@ -201,47 +769,839 @@ int tcmplxA_blockstr_add_copy
   }
   return tcmplxA_blockstr_append(x, buf, i);
 }
-int tcmplxA_blockstr_update_literal
-  (struct tcmplxA_blockstr* x, unsigned int b, tcmplxA_uint32* jptr)
+
+int tcmplxA_blockbuf_cmd_reserve(struct tcmplxA_blockbuf* x, size_t n) {
+  tcmplxA_uint32* ptr;
+  unsigned int k;
+  if (n <= x->cmd_cap)
+    return tcmplxA_Success;
+  else if (n > tcmplxA_BlockBuf_SizeMax/(4u*sizeof(tcmplxA_uint32)))
+    return tcmplxA_ErrMemory;
+  ptr = (tcmplxA_uint32*)tcmplxA_util_allocate
+      (x->input.alloc, n*4u*sizeof(tcmplxA_uint32));
+  if (ptr == NULL)
+    return tcmplxA_ErrMemory;
+  for (k = 0u; k < 4u && x->cmd_count > 0u; ++k) {
+    memcpy(ptr+k*n, x->cmds+k*x->cmd_cap,
+        x->cmd_count*sizeof(tcmplxA_uint32));
+  }
+  tcmplxA_util_deallocate(x->input.alloc, x->cmds);
+  x->cmds = ptr;
+  x->cmd_cap = n;
+  return tcmplxA_Success;
+}
+
+void tcmplxA_blockbuf_cmd_open(struct tcmplxA_blockbuf* x) {
+  size_t const i = x->cmd_count;
+  assert(i < x->cmd_cap);
+  x->cmds[i] = 0u;
+  x->cmds[x->cmd_cap+i] = 0u;
+  x->cmds[x->cmd_cap*2u+i] = 0u;
+  x->cmds[x->cmd_cap*3u+i] = x->literals.sz;
+  x->cmd_count = i+1u;
+  return;
+}
+
+void tcmplxA_blockbuf_cmd_literal
+  (struct tcmplxA_blockbuf* x, unsigned int b, size_t first)
 {
-  tcmplxA_uint32 const j = *jptr;
-  int res;
-  unsigned char bytes[2];
-  bytes[0] = 1u;
-  bytes[1] = (unsigned char)b;
-  if (j == x->sz) {
-    /* add a new literal */
-    res = tcmplxA_blockstr_append(x, bytes, 2u);
-  } else if (x->p[j] == 63u) {
-    /* expand */
-    res = tcmplxA_blockstr_append(x, bytes, 2u);
+  if (x->cmd_count == first || x->cmds[x->cmd_cap+x->cmd_count-1u] != 0u)
+    tcmplxA_blockbuf_cmd_open(x);
+  assert(x->literals.sz < x->literals.cap);
+  x->literals.p[x->literals.sz++] = (unsigned char)b;
+  x->cmds[x->cmd_count-1u] += 1u;
+  return;
+}
+
+void tcmplxA_blockbuf_cmd_copy
+  ( struct tcmplxA_blockbuf* x, tcmplxA_uint32 match_size, tcmplxA_uint32 v,
+    size_t first)
+{
+  if (x->cmd_count == first || x->cmds[x->cmd_cap+x->cmd_count-1u] != 0u)
+    tcmplxA_blockbuf_cmd_open(x);
+  x->cmds[x->cmd_cap+x->cmd_count-1u] = match_size;
+  x->cmds[x->cmd_cap*2u+x->cmd_count-1u] = v;
+  tcmplxA_blockbuf_recent_add(x, v);
+  return;
+}
+
+void tcmplxA_blockbuf_recent_reset(struct tcmplxA_blockbuf* x) {
+  /* RFC 7932 Section 4: distances 16, 15, 11 and 4, less one */
+  x->recent[0] = 15u;
+  x->recent[1] = 14u;
+  x->recent[2] = 10u;
+  x->recent[3] = 3u;
+  x->recent_i = 3u;
+  return;
+}
+
+void tcmplxA_blockbuf_recent_add
+  (struct tcmplxA_blockbuf* x, tcmplxA_uint32 v)
+{
+  if (x->recent[x->recent_i] == v)
+    return;
+  x->recent_i = (unsigned char)((x->recent_i+1u)&3u);
+  x->recent[x->recent_i] = v;
+  return;
+}
+
+tcmplxA_uint32 tcmplxA_blockbuf_match_length
+  ( struct tcmplxA_blockbuf const* x, tcmplxA_uint32 i, tcmplxA_uint32 v,
+    tcmplxA_uint32 max)
+{
+  tcmplxA_uint32 k;
+  if (v >= tcmplxA_hashchain_size(x->chain))
+    return 0u;
+  if (max > x->input.sz - i)
+    max = x->input.sz - i;
+  for (k = 0u; k < max; ++k) {
+    /* past the window, the match overlaps its own input */
+    unsigned int const q = (k <= v)
+      ? tcmplxA_hashchain_peek(x->chain, v-k)
+      : x->input.p[i+k-v-1u];
+    if (q != x->input.p[i+k])
+      break;
+  }
+  return k;
+}
+
+tcmplxA_uint32 tcmplxA_blockbuf_recent_find
+  ( struct tcmplxA_blockbuf const* x, tcmplxA_uint32 i,
+    tcmplxA_uint32* length)
+{
+  tcmplxA_uint32 best_v = tcmplxA_BlockBuf_NPos;
+  tcmplxA_uint32 best_len = 2u;
+  unsigned int const probes = x->greedy_tf ? 4u : 16u;
+  unsigned int j;
+  /* the four recent distances, then near misses of the last two */
+  for (j = 0u; j < probes; ++j) {
+    tcmplxA_uint32 v;
+    tcmplxA_uint32 len;
+    if (j < 4u)
+      v = x->recent[(x->recent_i+4u-j)&3u];
+    else {
+      tcmplxA_uint32 const base = x->recent[(x->recent_i+4u-(j-4u)/6u)&3u];
+      tcmplxA_uint32 const delta = (j-4u)%6u/2u + 1u;
+      if (j&1u)
+        v = base + delta;
+      else if (base >= delta)
+        v = base - delta;
+      else continue;
+    }
+    len = tcmplxA_blockbuf_match_length(x, i, v, tcmplxA_BlockBuf_ProbeMax);
+    if (len > best_len) {
+      best_len = len;
+      best_v = v;
+    }
+  }
+  *length = best_len;
+  return best_v;
+}
+
+unsigned int tcmplxA_blockbuf_probe_hash(unsigned char const* b) {
+  tcmplxA_uint32 const v = (tcmplxA_uint32)b[0] | ((tcmplxA_uint32)b[1]<<8)
+    | ((tcmplxA_uint32)b[2]<<16) | ((tcmplxA_uint32)b[3]<<24);
+  return (unsigned int)(((v * 0x9E3779B1u) & 0xFFffFFffu)
+    >> (32u-tcmplxA_BlockBuf_ProbeHashBits));
+}
+
+int tcmplxA_blockbuf_window_probe
+  ( struct tcmplxA_blockbuf const* x, tcmplxA_uint32 stride,
+    tcmplxA_uint32 slice)
+{
+  tcmplxA_uint32 probes = 0u;
+  tcmplxA_uint32 hits = 0u;
+  unsigned int s;
+  for (s = 0u; s < tcmplxA_BlockBuf_ProbeSlices; ++s) {
+    tcmplxA_uint32 j;
+    for (j = 0u; j+4u <= slice; j += tcmplxA_BlockBuf_ProbeStep) {
+      tcmplxA_uint32 const pos = s*stride+j;
+      tcmplxA_uint32 const v =
+        tcmplxA_hashchain_find(x->chain, x->input.p+pos, 0);
+      if (tcmplxA_blockbuf_match_length(x, pos, v, 4u) == 4u)
+        hits += 1u;
+      probes += 1u;
+    }
+  }
+  return hits*64u >= probes;
+}
+
+unsigned int tcmplxA_blockbuf_far_bits(tcmplxA_uint32 n) {
+  unsigned int bits = tcmplxA_BlockBuf_FarBitsMin;
+  while ((n >> (tcmplxA_BlockBuf_FarRateBits+bits)) > 0u)
+    bits += 1u;
+  return bits;
+}
+
+int tcmplxA_blockbuf_far_reserve(struct tcmplxA_blockbuf* x, size_t n) {
+  struct tcmplxA_blockbuf_far* ptr;
+  if (n <= x->far_cap)
+    return tcmplxA_Success;
+  else if (n > tcmplxA_BlockBuf_SizeMax/sizeof(struct tcmplxA_blockbuf_far))
+    return tcmplxA_ErrMemory;
+  ptr = (struct tcmplxA_blockbuf_far*)tcmplxA_util_allocate
+      (x->input.alloc, n*sizeof(struct tcmplxA_blockbuf_far));
+  if (ptr == NULL)
+    return tcmplxA_ErrMemory;
+  tcmplxA_util_deallocate(x->input.alloc, x->far_hits);
+  x->far_hits = ptr;
+  x->far_cap = n;
+  x->far_count = 0u;
+  return tcmplxA_Success;
+}
+
+int tcmplxA_blockbuf_far_check
+  (struct tcmplxA_blockbuf const* x, tcmplxA_uint32 pos, tcmplxA_uint32 d)
+{
+  tcmplxA_uint32 const window = tcmplxA_hashchain_size(x->chain);
+  tcmplxA_uint32 k;
+  /* the earlier fingerprint may start before the block */
+  if (d > pos && d-pos > window)
+    return 0;
+  for (k = 0u; k < tcmplxA_BlockBuf_FarMin; ++k) {
+    unsigned int const q = (d > pos+k)
+      ? tcmplxA_hashchain_peek(x->chain, d-pos-k-1u)
+      : x->input.p[pos+k-d];
+    if (q != x->input.p[pos+k])
+      return 0;
+  }
+  return 1;
+}
+
+void tcmplxA_blockbuf_far_scan
+  ( struct tcmplxA_blockbuf* x, unsigned char const* buf, tcmplxA_uint32 n,
+    int find_tf)
+{
+  unsigned int const index_shift =
+    64u - tcmplxA_BlockBuf_FarRateBits - x->far_bits;
+  tcmplxA_uint32 const index_mask = (1ul<<x->far_bits)-1u;
+  tcmplxA_uint32 const base = x->far_total;
+  unsigned long long int hash = x->far_hash;
+  tcmplxA_uint32 next_pos = 0u;
+  tcmplxA_uint32 i;
+  x->far_count = 0u;
+  if (x->far_table == NULL)
+    return;
+  for (i = 0u; i < n; ++i) {
+    /* each term shifts out after `FarMin` bytes */
+    hash = (hash<<1) + tcmplxA_blockbuf_gear[buf[i]];
+    if ((hash >> (64u-tcmplxA_BlockBuf_FarRateBits)) == 0u) {
+      tcmplxA_uint32* const slot =
+        x->far_table + ((tcmplxA_uint32)(hash>>index_shift) & index_mask);
+      /* fingerprint of bytes [i+1-FarMin, i], in absolute terms */
+      tcmplxA_uint32 const start = base + i + 1u - tcmplxA_BlockBuf_FarMin;
+      if (find_tf && *slot != 0u && i+1u >= tcmplxA_BlockBuf_FarMin) {
+        tcmplxA_uint32 const pos = i + 1u - tcmplxA_BlockBuf_FarMin;
+        tcmplxA_uint32 const d = start - (*slot - 1u);
+        if (pos >= next_pos && d > 0u && x->far_count < x->far_cap
+          && tcmplxA_blockbuf_far_check(x, pos, d))
+        {
+          x->far_hits[x->far_count].pos = pos;
+          x->far_hits[x->far_count].v = d-1u;
+          x->far_count += 1u;
+          next_pos = pos + tcmplxA_BlockBuf_FarMin;
+        }
+      }
+      *slot = start + 1u;
+    }
+  }
+  x->far_hash = hash;
+  x->far_total = base + n;
+  return;
+}
+
+int tcmplxA_blockbuf_far_probe(struct tcmplxA_blockbuf const* x) {
+  unsigned int const index_shift =
+    64u - tcmplxA_BlockBuf_FarRateBits - x->far_bits;
+  tcmplxA_uint32 const index_mask = (1ul<<x->far_bits)-1u;
+  unsigned long long int hash = x->far_hash;
+  tcmplxA_uint32 i;
+  if (x->far_table == NULL)
+    return 0;
+  for (i = 0u; i < x->input.sz; ++i) {
+    hash = (hash<<1) + tcmplxA_blockbuf_gear[x->input.p[i]];
+    if ((hash >> (64u-tcmplxA_BlockBuf_FarRateBits)) == 0u
+    &&  i+1u >= tcmplxA_BlockBuf_FarMin)
+    {
+      tcmplxA_uint32 const slot =
+        x->far_table[(tcmplxA_uint32)(hash>>index_shift) & index_mask];
+      tcmplxA_uint32 const pos = i + 1u - tcmplxA_BlockBuf_FarMin;
+      tcmplxA_uint32 const d = x->far_total + pos - (slot - 1u);
+      if (slot != 0u && d > 0u && tcmplxA_blockbuf_far_check(x, pos, d))
+        return 1;
+    }
+  }
+  return 0;
+}
+
+int tcmplxA_blockbuf_sais_type(unsigned char const* t, tcmplxA_uint32 i) {
+  return (t[i>>3]>>(i&7u))&1u;
+}
+
+int tcmplxA_blockbuf_sais_lms(unsigned char const* t, tcmplxA_uint32 i) {
+  return i > 0u && i != tcmplxA_BlockBuf_NPos
+    && tcmplxA_blockbuf_sais_type(t, i)
+    && !tcmplxA_blockbuf_sais_type(t, i-1u);
+}
+
+void tcmplxA_blockbuf_sais_buckets
+  ( tcmplxA_uint32 const* s, tcmplxA_uint32 n, tcmplxA_uint32 k,
+    tcmplxA_uint32* bkt, int end_tf)
+{
+  tcmplxA_uint32 i;
+  tcmplxA_uint32 sum = 0u;
+  memset(bkt, 0, ((size_t)k+1u)*sizeof(tcmplxA_uint32));
+  for (i = 0u; i < n; ++i)
+    bkt[s[i]] += 1u;
+  for (i = 0u; i <= k; ++i) {
+    sum += bkt[i];
+    bkt[i] = end_tf ? sum : sum - bkt[i];
+  }
+  return;
+}
+
+void tcmplxA_blockbuf_sais_induce
+  ( tcmplxA_uint32 const* s, tcmplxA_uint32* sa, tcmplxA_uint32 n,
+    tcmplxA_uint32 k, unsigned char const* t, tcmplxA_uint32* bkt)
+{
+  tcmplxA_uint32 i;
+  tcmplxA_blockbuf_sais_buckets(s, n, k, bkt, 0);
+  for (i = 0u; i < n; ++i) {
+    tcmplxA_uint32 const j = sa[i];
+    if (j != tcmplxA_BlockBuf_NPos && j > 0u
+    &&  !tcmplxA_blockbuf_sais_type(t, j-1u))
+    {
+      sa[bkt[s[j-1u]]++] = j-1u;
+    }
+  }
+  tcmplxA_blockbuf_sais_buckets(s, n, k, bkt, 1);
+  for (i = n; i > 0u; --i) {
+    tcmplxA_uint32 const j = sa[i-1u];
+    if (j != tcmplxA_BlockBuf_NPos && j > 0u
+    &&  tcmplxA_blockbuf_sais_type(t, j-1u))
+    {
+      sa[--bkt[s[j-1u]]] = j-1u;
+    }
+  }
+  return;
+}
+
+int tcmplxA_blockbuf_sais
+  ( struct tcmplxA_allocator const* alloc, tcmplxA_uint32 const* s,
+    tcmplxA_uint32* sa, tcmplxA_uint32 n, tcmplxA_uint32 k)
+{
+  int res = tcmplxA_Success;
+  unsigned char* const t = (unsigned char*)tcmplxA_util_allocate
+    (alloc, n/8u+1u);
+  tcmplxA_uint32* const bkt = (tcmplxA_uint32*)tcmplxA_util_allocate
+    (alloc, ((size_t)k+1u)*sizeof(tcmplxA_uint32));
+  tcmplxA_uint32 i;
+  tcmplxA_uint32 j;
+  tcmplxA_uint32 n1 = 0u;
+  tcmplxA_uint32 name = 0u;
+  tcmplxA_uint32 prev = tcmplxA_BlockBuf_NPos;
+  if (t == NULL || bkt == NULL) {
+    tcmplxA_util_deallocate(alloc, bkt);
+    tcmplxA_util_deallocate(alloc, t);
+    return tcmplxA_ErrMemory;
+  }
+  /* classify the suffixes; the sentinel is S-type, the one before it L-type */{
+    memset(t, 0, n/8u+1u);
+    t[(n-1u)>>3] |= (unsigned char)(1u<<((n-1u)&7u));
+    for (i = n-2u; i > 0u; --i) {
+      j = i-1u;
+      if (s[j] < s[j+1u]
+      ||  (s[j] == s[j+1u] && tcmplxA_blockbuf_sais_type(t, j+1u)))
+      {
+        t[j>>3] |= (unsigned char)(1u<<(j&7u));
+      }
+    }
+  }
+  /* sort the LMS substrings */{
+    tcmplxA_blockbuf_sais_buckets(s, n, k, bkt, 1);
+    for (i = 0u; i < n; ++i)
+      sa[i] = tcmplxA_BlockBuf_NPos;
+    for (i = 1u; i < n; ++i) {
+      if (tcmplxA_blockbuf_sais_lms(t, i))
+        sa[--bkt[s[i]]] = i;
+    }
+    tcmplxA_blockbuf_sais_induce(s, sa, n, k, t, bkt);
+  }
+  /* name the LMS substrings, packing the names at the end of `sa` */{
+    for (i = 0u; i < n; ++i) {
+      if (tcmplxA_blockbuf_sais_lms(t, sa[i]))
+        sa[n1++] = sa[i];
+    }
+    for (i = n1; i < n; ++i)
+      sa[i] = tcmplxA_BlockBuf_NPos;
+    for (i = 0u; i < n1; ++i) {
+      tcmplxA_uint32 const pos = sa[i];
+      int diff = 0;
+      tcmplxA_uint32 d;
+      for (d = 0u; d < n; ++d) {
+        if (prev == tcmplxA_BlockBuf_NPos || s[pos+d] != s[prev+d]
+        ||  tcmplxA_blockbuf_sais_type(t, pos+d)
+              != tcmplxA_blockbuf_sais_type(t, prev+d))
+        {
+          diff = 1;
+          break;
+        } else if (d > 0u && (tcmplxA_blockbuf_sais_lms(t, pos+d)
+              || tcmplxA_blockbuf_sais_lms(t, prev+d)))
+        {
+          break;
+        }
+      }
+      if (diff) {
+        name += 1u;
+        prev = pos;
+      }
+      sa[n1 + pos/2u] = name-1u;
+    }
+    for (i = n, j = n; i > n1; --i) {
+      if (sa[i-1u] != tcmplxA_BlockBuf_NPos)
+        sa[--j] = sa[i-1u];
+    }
+  }
+  /* sort the LMS suffixes, recursing while names repeat */{
+    tcmplxA_uint32* const s1 = sa + n - n1;
+    if (name < n1)
+      res = tcmplxA_blockbuf_sais(alloc, s1, sa, n1, name-1u);
+    else for (i = 0u; i < n1; ++i)
+      sa[s1[i]] = i;
+    if (res == tcmplxA_Success) {
+      for (i = 1u, j = 0u; i < n; ++i) {
+        if (tcmplxA_blockbuf_sais_lms(t, i))
+          s1[j++] = i;
+      }
+      for (i = 0u; i < n1; ++i)
+        sa[i] = s1[sa[i]];
+      for (i = n1; i < n; ++i)
+        sa[i] = tcmplxA_BlockBuf_NPos;
+    }
+  }
+  /* induce the full order from the sorted LMS suffixes */if (res == tcmplxA_Success) {
+    tcmplxA_blockbuf_sais_buckets(s, n, k, bkt, 1);
+    for (i = n1; i > 0u; --i) {
+      j = sa[i-1u];
+      sa[i-1u] = tcmplxA_BlockBuf_NPos;
+      sa[--bkt[s[j]]] = j;
+    }
+    tcmplxA_blockbuf_sais_induce(s, sa, n, k, t, bkt);
+  }
+  tcmplxA_util_deallocate(alloc, bkt);
+  tcmplxA_util_deallocate(alloc, t);
+  return res;
+}
+
+tcmplxA_uint32 tcmplxA_blockbuf_suffix_cost
+  (tcmplxA_uint32 len, tcmplxA_uint32 v)
+{
+  /* a code for the pair, the distance bits, and about as many length
+   * extra bits as DEFLATE and Brotli spend */
+  return tcmplxA_BlockBuf_ByteBits
+    + tcmplxA_util_bitwidth((unsigned int)v+1u)
+    + tcmplxA_util_bitwidth((unsigned int)(len>>3));
+}
+
+void tcmplxA_blockbuf_suffix_keep
+  ( struct tcmplxA_blockbuf const* x, tcmplxA_uint32 i, tcmplxA_uint32 v,
+    tcmplxA_uint32 len, tcmplxA_uint32* lens, tcmplxA_uint32* dists)
+{
+  tcmplxA_uint32 const size = tcmplxA_hashchain_size(x->chain);
+  tcmplxA_uint32 const extent = tcmplxA_hashchain_extent(x->chain);
+  size_t const base = (size_t)i*tcmplxA_BlockBuf_SuffixCandidates;
+  tcmplxA_uint32* const lp = lens + base;
+  tcmplxA_uint32* const dp = dists + base;
+  tcmplxA_uint32 keep_lens[tcmplxA_BlockBuf_SuffixCandidates+1u];
+  tcmplxA_uint32 keep_dists[tcmplxA_BlockBuf_SuffixCandidates+1u];
+  unsigned int count = 0u;
+  unsigned int k;
+  int placed_tf = 0;
+  if (len < 3u)
+    return;
+  /* the window grows by one byte per input byte until full */
+  if (v >= ((i < extent && size < extent - i) ? size + i : extent))
+    return;
+  /*
+   * Lengths fall as distances fall. A candidate neither longer nor
+   * nearer than one already kept adds nothing, and the new one
+   * replaces those it outdoes on both counts.
+   */
+  for (k = 0u; k < tcmplxA_BlockBuf_SuffixCandidates && lp[k] > 0u; ++k) {
+    if (lp[k] >= len && dp[k] <= v)
+      return;
+  }
+  for (k = 0u; k < tcmplxA_BlockBuf_SuffixCandidates && lp[k] > 0u; ++k) {
+    if (!placed_tf && lp[k] < len) {
+      keep_lens[count] = len;
+      keep_dists[count] = v;
+      count += 1u;
+      placed_tf = 1;
+    }
+    if (lp[k] <= len && dp[k] >= v)
+      continue;
+    keep_lens[count] = lp[k];
+    keep_dists[count] = dp[k];
+    count += 1u;
+  }
+  if (!placed_tf) {
+    keep_lens[count] = len;
+    keep_dists[count] = v;
+    count += 1u;
+  }
+  /* when full, drop the shortest */
+  for (k = 0u; k < tcmplxA_BlockBuf_SuffixCandidates; ++k) {
+    lp[k] = (k < count) ? keep_lens[k] : 0u;
+    dp[k] = (k < count) ? keep_dists[k] : 0u;
+  }
+  return;
+}
+
+void tcmplxA_blockbuf_suffix_note
+  ( struct tcmplxA_blockbuf const* x, tcmplxA_uint32 h, tcmplxA_uint32 at,
+    tcmplxA_uint32 from, tcmplxA_uint32 len,
+    tcmplxA_uint32* lens, tcmplxA_uint32* dists)
+{
+  if (at < h || at - h >= x->input.sz)
+    return;
+  tcmplxA_blockbuf_suffix_keep(x, at - h, at - from - 1u, len, lens, dists);
+  return;
+}
+
+int tcmplxA_blockbuf_suffix_match
+  ( struct tcmplxA_blockbuf const* x, tcmplxA_uint32 h,
+    tcmplxA_uint32* s, tcmplxA_uint32* sa, tcmplxA_uint32* rank,
+    tcmplxA_uint32* lcp, tcmplxA_uint32* lens, tcmplxA_uint32* dists)
+{
+  tcmplxA_uint32 const input_sz = x->input.sz;
+  tcmplxA_uint32 const n = h + input_sz + 1u;
+  tcmplxA_uint32 i;
+  /* window history then input, shifted up one for a zero sentinel */{
+    for (i = 0u; i < h; ++i)
+      s[i] = tcmplxA_hashchain_peek(x->chain, h-1u-i) + 1u;
+    for (i = 0u; i < input_sz; ++i)
+      s[h+i] = x->input.p[i] + 1u;
+    s[n-1u] = 0u;
+  }
+  /* */{
+    int const res = tcmplxA_blockbuf_sais(x->input.alloc, s, sa, n, 256u);
     if (res != tcmplxA_Success)
       return res;
-    memmove(x->p+j+2, x->p+j+1, 63u*sizeof(unsigned char));
-    x->p[j] = 64u;
-    x->p[j+1u] = 0u;
-  } else if (x->p[j] >= 64u) {
-    /* long sequence */
-    unsigned short int len = (x->p[j]<<8)|x->p[j+1];
-    res = tcmplxA_blockstr_append(x, bytes+1u, 1u);
-    len += 1u;
-    x->p[j] = (unsigned char)(len>>8);
-    x->p[j+1u] = (unsigned char)(len&255u);
-    if (len == 0x7Fff)
-      *jptr = x->sz;
-  } else {
-    res = tcmplxA_blockstr_append(x, bytes+1u, 1u);
-    x->p[j] += 1u;
+  }
+  /* LCP of each suffix with its predecessor in `sa` (Kasai) */{
+    tcmplxA_uint32 len = 0u;
+    for (i = 0u; i < n; ++i)
+      rank[sa[i]] = i;
+    for (i = 0u; i < n; ++i) {
+      tcmplxA_uint32 const r = rank[i];
+      if (r == 0u) {
+        lcp[0] = 0u;
+        len = 0u;
+        continue;
+      }
+      /* the sentinel stops the scan */
+      while (s[i+len] == s[sa[r-1u]+len])
+        len += 1u;
+      lcp[r] = len;
+      if (len > 0u)
+        len -= 1u;
+    }
+  }
+  memset(lens, 0,
+    (size_t)input_sz*tcmplxA_BlockBuf_SuffixCandidates*sizeof(tcmplxA_uint32));
+  memset(dists, 0,
+    (size_t)input_sz*tcmplxA_BlockBuf_SuffixCandidates*sizeof(tcmplxA_uint32));
+  /*
+   * Shorter, nearer matches lie among the nearby suffixes in `sa`.
+   * Matches only shorten away from a suffix, so each side offers
+   * only those nearer than any it offered before.
+   */
+  for (i = 0u; i < input_sz; ++i) {
+    tcmplxA_uint32 const pos = h + i;
+    tcmplxA_uint32 const r = rank[pos];
+    tcmplxA_uint32 len = tcmplxA_BlockBuf_NPos;
+    tcmplxA_uint32 nearest = 0u;
+    tcmplxA_uint32 j;
+    unsigned int steps;
+    for (j = r, steps = 0u;
+        j > 0u && steps < tcmplxA_BlockBuf_SuffixSteps; --j, ++steps)
+    {
+      tcmplxA_uint32 const from = sa[j-1u];
+      if (lcp[j] < len)
+        len = lcp[j];
+      if (len < 3u)
+        break;
+      if (from < pos && from+1u > nearest) {
+        tcmplxA_blockbuf_suffix_note(x, h, pos, from, len, lens, dists);
+        nearest = from+1u;
+      }
+    }
+    len = tcmplxA_BlockBuf_NPos;
+    nearest = 0u;
+    for (j = r+1u, steps = 0u;
+        j < n && steps < tcmplxA_BlockBuf_SuffixSteps; ++j, ++steps)
+    {
+      tcmplxA_uint32 const from = sa[j];
+      if (lcp[j] < len)
+        len = lcp[j];
+      if (len < 3u)
+        break;
+      if (from < pos && from+1u > nearest) {
+        tcmplxA_blockbuf_suffix_note(x, h, pos, from, len, lens, dists);
+        nearest = from+1u;
+      }
+    }
+  }
+  /*
+   * The longest earlier match for a suffix lies with the nearest
+   * earlier-starting suffix on either side of it in `sa`. One pass with
+   * a stack finds both, reusing `rank` for the stack and `s` for the
+   * LCP of each stack entry with the entry above it.
+   */{
+    tcmplxA_uint32* const stack = rank;
+    tcmplxA_uint32* const stack_lcp = s;
+    tcmplxA_uint32 top = 0u;
+    for (i = 0u; i < n; ++i) {
+      tcmplxA_uint32 const pos = sa[i];
+      tcmplxA_uint32 len = lcp[i];
+      /* this suffix is the next earlier-starting one for those it pops */
+      while (top > 0u && stack[top-1u] > pos) {
+        top -= 1u;
+        if (stack_lcp[top] < len)
+          len = stack_lcp[top];
+        tcmplxA_blockbuf_suffix_note(x, h, stack[top], pos, len, lens, dists);
+      }
+      /* and the one below it is its previous earlier-starting one */
+      if (top > 0u) {
+        if (stack_lcp[top-1u] < len)
+          len = stack_lcp[top-1u];
+        stack_lcp[top-1u] = len;
+        tcmplxA_blockbuf_suffix_note
+          (x, h, pos, stack[top-1u], len, lens, dists);
+      }
+      stack[top] = pos;
+      stack_lcp[top] = tcmplxA_BlockBuf_NPos;
+      top += 1u;
+    }
+  }
+  return tcmplxA_Success;
+}
+
+tcmplxA_uint32 tcmplxA_blockbuf_suffix_far_length
+  (struct tcmplxA_blockbuf const* x, tcmplxA_uint32 i, tcmplxA_uint32 v)
+{
+  tcmplxA_uint32 const d = v + 1u;
+  tcmplxA_uint32 max = x->input.sz - i;
+  tcmplxA_uint32 k;
+  if (v >= i && v - i >= tcmplxA_hashchain_size(x->chain))
+    return 0u;
+  if (max > x->copy_max)
+    max = x->copy_max;
+  for (k = 0u; k < max; ++k) {
+    /* the earlier bytes may start before the block */
+    unsigned int const q = (d > i+k)
+      ? tcmplxA_hashchain_peek(x->chain, d-i-k-1u)
+      : x->input.p[i+k-d];
+    if (q != x->input.p[i+k])
+      break;
+  }
+  return k;
+}
+
+void tcmplxA_blockbuf_suffix_parse
+  ( struct tcmplxA_blockbuf const* x, tcmplxA_uint32 const* lens,
+    tcmplxA_uint32 const* dists, tcmplxA_uint32* cost,
+    tcmplxA_uint32* step_len, tcmplxA_uint32* step_dist)
+{
+  tcmplxA_uint32 const input_sz = x->input.sz;
+  tcmplxA_uint32 i;
+  cost[0] = 0u;
+  for (i = 1u; i <= input_sz; ++i)
+    cost[i] = tcmplxA_BlockBuf_NPos;
+  for (i = 0u; i < input_sz; ++i) {
+    tcmplxA_uint32 const* const lp =
+      lens + (size_t)i*tcmplxA_BlockBuf_SuffixCandidates;
+    tcmplxA_uint32 const* const dp =
+      dists + (size_t)i*tcmplxA_BlockBuf_SuffixCandidates;
+    tcmplxA_uint32 lo = 3u;
+    unsigned int k;
+    /* each candidate is the nearest for lengths past the next shorter */
+    for (k = tcmplxA_BlockBuf_SuffixCandidates; k > 0u; --k) {
+      tcmplxA_uint32 const hi =
+        lp[k-1u] < x->copy_max ? lp[k-1u] : x->copy_max;
+      tcmplxA_uint32 len;
+      if (lp[k-1u] == 0u)
+        continue;
+      /* past `SuffixNice`, try the whole copy alone */
+      for (len = (hi > tcmplxA_BlockBuf_SuffixNice ? hi : lo);
+          len <= hi; ++len)
+      {
+        tcmplxA_uint32 const c =
+          cost[i] + tcmplxA_blockbuf_suffix_cost(len, dp[k-1u]);
+        if (c < cost[i+len]) {
+          cost[i+len] = c;
+          step_len[i+len] = len;
+          step_dist[i+len] = dp[k-1u];
+        }
+      }
+      lo = lp[k-1u] + 1u;
+    }
+    if (cost[i] + tcmplxA_BlockBuf_ByteBits < cost[i+1u]) {
+      cost[i+1u] = cost[i] + tcmplxA_BlockBuf_ByteBits;
+      step_len[i+1u] = 1u;
+      step_dist[i+1u] = tcmplxA_BlockBuf_NPos;
+    }
+  }
+  return;
+}
+
+size_t tcmplxA_blockbuf_suffix_scratch
+  (tcmplxA_uint32 h, tcmplxA_uint32 input_sz)
+{
+  size_t const n = (size_t)h + input_sz + 1u;
+  return (n*4u + (size_t)input_sz*2u*tcmplxA_BlockBuf_SuffixCandidates)
+      * sizeof(tcmplxA_uint32)
+    /* SA-IS type bits and buckets, summed over its recursion */
+    + n/4u + n*sizeof(tcmplxA_uint32) + 1100u;
+}
+
+int tcmplxA_blockbuf_suffix_commands(struct tcmplxA_blockbuf* x, size_t first) {
+  int res = tcmplxA_Success;
+  tcmplxA_uint32 const input_sz = x->input.sz;
+  tcmplxA_uint32 const size = tcmplxA_hashchain_size(x->chain);
+  /* history in proportion to the block, so small blocks stay quick */
+  tcmplxA_uint32 const span = input_sz < tcmplxA_BlockBuf_SuffixHistory
+    / tcmplxA_BlockBuf_SuffixSpan
+    ? input_sz*tcmplxA_BlockBuf_SuffixSpan : tcmplxA_BlockBuf_SuffixHistory;
+  tcmplxA_uint32 h = size < span ? size : span;
+  size_t n;
+  tcmplxA_uint32* scratch;
+  tcmplxA_uint32* lens;
+  tcmplxA_uint32* dists;
+  tcmplxA_uint32 i;
+  if (input_sz == 0u)
+    return tcmplxA_Success;
+  if (tcmplxA_blockbuf_suffix_scratch(h, input_sz) > x->scratch_cap) {
+    /* index as much recent history as the cap allows */
+    tcmplxA_uint32 lo = 0u;
+    if (tcmplxA_blockbuf_suffix_scratch(0u, input_sz) > x->scratch_cap)
+      return tcmplxA_ErrMemory;
+    while (lo < h) {
+      tcmplxA_uint32 const mid = h - (h-lo)/2u;
+      if (tcmplxA_blockbuf_suffix_scratch(mid, input_sz) <= x->scratch_cap)
+        lo = mid;
+      else h = mid-1u;
+    }
+  }
+  n = (size_t)h + input_sz + 1u;
+  /* text, suffix array, rank and LCP, then the match candidates */
+  if (n > tcmplxA_BlockBuf_SizeMax/((4u+2u*tcmplxA_BlockBuf_SuffixCandidates)
+      *sizeof(tcmplxA_uint32)))
+  {
+    return tcmplxA_ErrMemory;
+  }
+  scratch = (tcmplxA_uint32*)tcmplxA_util_allocate(x->input.alloc,
+    (n*4u + (size_t)input_sz*2u*tcmplxA_BlockBuf_SuffixCandidates)
+      * sizeof(tcmplxA_uint32));
+  if (scratch == NULL)
+    return tcmplxA_ErrMemory;
+  lens = scratch + n*4u;
+  dists = lens + (size_t)input_sz*tcmplxA_BlockBuf_SuffixCandidates;
+  res = tcmplxA_blockbuf_suffix_match
+    (x, h, scratch, scratch+n, scratch+n*2u, scratch+n*3u, lens, dists);
+  if (res != tcmplxA_Success) {
+    tcmplxA_util_deallocate(x->input.alloc, scratch);
+    return res;
+  }
+  /* long-distance matches reach past the indexed history */
+  if (x->far_table != NULL) {
+    size_t k;
+    res = tcmplxA_blockbuf_far_reserve
+      (x, input_sz/tcmplxA_BlockBuf_FarMin + 1u);
+    if (res != tcmplxA_Success) {
+      tcmplxA_util_deallocate(x->input.alloc, scratch);
+      return res;
+    }
+    tcmplxA_blockbuf_far_scan(x, x->input.p, input_sz, 1);
+    for (k = 0u; k < x->far_count; ++k) {
+      tcmplxA_uint32 const pos = x->far_hits[k].pos;
+      tcmplxA_uint32 const v = x->far_hits[k].v;
+      tcmplxA_blockbuf_suffix_keep(x, pos, v,
+        tcmplxA_blockbuf_suffix_far_length(x, pos, v), lens, dists);
+    }
+  }
+  /* the suffix array scratch is free again for the parse */{
+    tcmplxA_uint32* const cost = scratch;
+    tcmplxA_uint32* const step_len = scratch + n;
+    tcmplxA_uint32* const step_dist = scratch + n*2u;
+    tcmplxA_uint32* const next_len = scratch + n*3u;
+    tcmplxA_blockbuf_suffix_parse(x, lens, dists, cost, step_len, step_dist);
+    /* trace the path back, then emit it forward */
+    for (i = input_sz; i > 0u; i -= step_len[i])
+      next_len[i - step_len[i]] = step_len[i];
+    for (i = 0u; i < input_sz && res == tcmplxA_Success; ) {
+      tcmplxA_uint32 const len = next_len[i];
+      tcmplxA_uint32 j;
+      if (step_dist[i+len] == tcmplxA_BlockBuf_NPos)
+        tcmplxA_blockbuf_cmd_literal(x, x->input.p[i], first);
+      else tcmplxA_blockbuf_cmd_copy(x, len, step_dist[i+len], first);
+      for (j = 0u; j < len && res == tcmplxA_Success; ++j)
+        res = tcmplxA_hashchain_add(x->chain, x->input.p[i+j]);
+      i += len;
+    }
+  }
+  tcmplxA_util_deallocate(x->input.alloc, scratch);
+  return res;
+}
+
+int tcmplxA_blockbuf_cmd_serialize(struct tcmplxA_blockbuf* x, size_t first) {
+  int res = tcmplxA_Success;
+  size_t i;
+  for (i = first; i < x->cmd_count && res == tcmplxA_Success; ++i) {
+    tcmplxA_uint32 insert_len = x->cmds[i];
+    tcmplxA_uint32 const copy_len = x->cmds[x->cmd_cap+i];
+    unsigned char const* literal = x->literals.p + x->cmds[x->cmd_cap*3u+i];
+    while (insert_len > 0u && res == tcmplxA_Success) {
+      tcmplxA_uint32 const n = (insert_len > tcmplxA_BlockBuf_MaxOutCode)
+        ? tcmplxA_BlockBuf_MaxOutCode : insert_len;
+      res = tcmplxA_blockstr_add_insert(&x->output, literal, n);
+      literal += n;
+      insert_len -= n;
+    }
+    if (copy_len > 0u && res == tcmplxA_Success) {
+      res = tcmplxA_blockstr_add_copy
+        (&x->output, copy_len, x->cmds[x->cmd_cap*2u+i]);
+    }
   }
   return res;
 }
 
 int tcmplxA_blockbuf_init
   ( struct tcmplxA_blockbuf* x, tcmplxA_uint32 block_size,
-    tcmplxA_uint32 n, size_t chain_length, int bdict_tf)
+    tcmplxA_uint32 n, size_t chain_length, int bdict_tf,
+    struct tcmplxA_allocator const* alloc)
 {
   x->chain = NULL;
+  x->cmds = NULL;
+  x->cmd_count = 0u;
+  x->cmd_cap = 0u;
   x->bdict_tf = bdict_tf;
+  x->held = 0u;
+  x->recent_tf = 0u;
+  x->greedy_tf = 0u;
+  x->skip_tf = 0u;
+  x->far_table = NULL;
+  x->far_bits = 0u;
+  x->far_total = 0u;
+  x->far_hash = 0u;
+  x->far_hits = NULL;
+  x->far_count = 0u;
+  x->far_cap = 0u;
+  x->suffix_tf = 0u;
+  x->copy_max = tcmplxA_BlockBuf_MaxOutCode;
+  x->scratch_cap = (size_t)-1;
+  x->parse.active = 0u;
+  tcmplxA_blockbuf_recent_reset(x);
   /* truncate lengths */{
     if (block_size > tcmplxA_BlockBuf_SizeMax/2u) {
       block_size = (tcmplxA_uint32)(tcmplxA_BlockBuf_SizeMax/2u);
@@ -249,12 +1609,14 @@ int tcmplxA_blockbuf_init
   }
   /* allocate things */{
     struct tcmplxA_hashchain* const chain =
-      tcmplxA_hashchain_new(n, chain_length);
-    int const input_res = tcmplxA_blockstr_init(&x->input, block_size);
-    int const output_res = tcmplxA_blockstr_init(&x->output, block_size);
+      tcmplxA_hashchain_new_alloc(n, chain_length, alloc);
+    int const input_res = tcmplxA_blockstr_init(&x->input, block_size, alloc);
+    int const output_res = tcmplxA_blockstr_init(&x->output, block_size, alloc);
+    int const literals_res = tcmplxA_blockstr_init(&x->literals, 0u, alloc);
     if (chain == NULL || input_res != tcmplxA_Success
-        || output_res != tcmplxA_Success)
+        || output_res != tcmplxA_Success || literals_res != tcmplxA_Success)
     {
+      tcmplxA_blockstr_close(&x->literals);
       tcmplxA_blockstr_close(&x->output);
       tcmplxA_blockstr_close(&x->input);
       tcmplxA_hashchain_destroy(chain);
@@ -264,6 +1626,21 @@ int tcmplxA_blockbuf_init
       x->input_block_size = block_size;
     }
   }
+  /* fingerprint table, one slot per `1<<FarRateBits` window bytes */
+  if (n >= tcmplxA_BlockBuf_FarWindow) {
+    unsigned int const bits = tcmplxA_blockbuf_far_bits(n);
+    x->far_table = (tcmplxA_uint32*)tcmplxA_util_allocate
+      (alloc, ((size_t)1u<<bits)*sizeof(tcmplxA_uint32));
+    if (x->far_table == NULL
+    ||  tcmplxA_blockbuf_far_reserve
+          (x, block_size/tcmplxA_BlockBuf_FarMin+1u) != tcmplxA_Success)
+    {
+      tcmplxA_blockbuf_close(x);
+      return tcmplxA_ErrMemory;
+    }
+    memset(x->far_table, 0, ((size_t)1u<<bits)*sizeof(tcmplxA_uint32));
+    x->far_bits = bits;
+  }
   return tcmplxA_Success;
 }
 
@@ -272,6 +1649,18 @@ void tcmplxA_blockbuf_close(struct tcmplxA_blockbuf* x) {
     tcmplxA_hashchain_destroy(x->chain);
     x->chain = NULL;
   }
+  tcmplxA_util_deallocate(x->input.alloc, x->cmds);
+  x->cmds = NULL;
+  x->cmd_count = 0u;
+  x->cmd_cap = 0u;
+  tcmplxA_util_deallocate(x->input.alloc, x->far_hits);
+  x->far_hits = NULL;
+  x->far_count = 0u;
+  x->far_cap = 0u;
+  tcmplxA_util_deallocate(x->input.alloc, x->far_table);
+  x->far_table = NULL;
+  x->far_bits = 0u;
+  tcmplxA_blockstr_close(&x->literals);
   tcmplxA_blockstr_close(&x->input);
   tcmplxA_blockstr_close(&x->output);
   return;
@@ -282,14 +1671,21 @@ void tcmplxA_blockbuf_close(struct tcmplxA_blockbuf* x) {
 struct tcmplxA_blockbuf* tcmplxA_blockbuf_new
   ( tcmplxA_uint32 block_size, tcmplxA_uint32 n, size_t chain_length,
     int bdict_tf)
+{
+  return tcmplxA_blockbuf_new_alloc(block_size, n, chain_length, bdict_tf, NULL);
+}
+
+struct tcmplxA_blockbuf* tcmplxA_blockbuf_new_alloc
+  ( tcmplxA_uint32 block_size, tcmplxA_uint32 n, size_t chain_length,
+    int bdict_tf, struct tcmplxA_allocator const* alloc)
 {
   struct tcmplxA_blockbuf* out;
-  out = tcmplxA_util_malloc(sizeof(struct tcmplxA_blockbuf));
+  out = tcmplxA_util_allocate(alloc, sizeof(struct tcmplxA_blockbuf));
   if (out != NULL
-  &&  tcmplxA_blockbuf_init(out,block_size,n,chain_length,bdict_tf)
+  &&  tcmplxA_blockbuf_init(out,block_size,n,chain_length,bdict_tf,alloc)
         != tcmplxA_Success)
   {
-    tcmplxA_util_free(out);
+    tcmplxA_util_deallocate(alloc, out);
     return NULL;
   }
   return out;
@@ -297,8 +1693,9 @@ struct tcmplxA_blockbuf* tcmplxA_blockbuf_new
 
 void tcmplxA_blockbuf_destroy(struct tcmplxA_blockbuf* x) {
   if (x != NULL) {
+    struct tcmplxA_allocator const* const alloc = x->input.alloc;
     tcmplxA_blockbuf_close(x);
-    tcmplxA_util_free(x);
+    tcmplxA_util_deallocate(alloc, x);
   }
   return;
 }
@@ -314,31 +1711,148 @@ int tcmplxA_blockbuf_noconv_block(struct tcmplxA_blockbuf* x) {
   return tcmplxA_blockstr_append(&x->output, x->input.p, x->input.sz);
 }
 
+int tcmplxA_blockbuf_probe_flat(struct tcmplxA_blockbuf const* x) {
+  tcmplxA_uint32 histogram[256] = {0};
+  tcmplxA_uint32 last_seen[1u<<tcmplxA_BlockBuf_ProbeHashBits] = {0};
+  unsigned char const* const input = x->input.p;
+  tcmplxA_uint32 const input_sz = x->input.sz;
+  tcmplxA_uint32 const stride = input_sz / tcmplxA_BlockBuf_ProbeSlices;
+  tcmplxA_uint32 const slice = (stride < tcmplxA_BlockBuf_ProbeSlice)
+    ? stride : tcmplxA_BlockBuf_ProbeSlice;
+  tcmplxA_uint32 sample_sz = 0u;
+  tcmplxA_uint32 repeats = 0u;
+  tcmplxA_uint32 collisions = 0u;
+  unsigned int s;
+  if (input_sz < tcmplxA_BlockBuf_ProbeMin)
+    return 0;
+  /*
+   * Byte pairs count twice per collision. Flat bytes collide in about
+   * 1/256 of all pairs; every slice has to stay within three times
+   * that, and the whole sample within 17/16 of it.
+   */
+  for (s = 0u; s < tcmplxA_BlockBuf_ProbeSlices; ++s) {
+    unsigned short slice_histogram[256] = {0};
+    tcmplxA_uint32 const start = s*stride;
+    tcmplxA_uint32 slice_collisions = 0u;
+    tcmplxA_uint32 j;
+    for (j = 0u; j < slice; ++j) {
+      unsigned int const v = input[start+j];
+      slice_collisions += 2u*slice_histogram[v];
+      collisions += 2u*histogram[v];
+      slice_histogram[v] += 1u;
+      histogram[v] += 1u;
+    }
+    if (slice_collisions > slice*(slice-1u)/256u*3u)
+      return 0;
+    /* a repeat of four bytes stands in for a match */
+    for (j = 0u; j+4u <= slice; ++j) {
+      tcmplxA_uint32 const pos = start+j;
+      unsigned int const h = tcmplxA_blockbuf_probe_hash(input+pos);
+      tcmplxA_uint32 const prev = last_seen[h];
+      if (prev > 0u && memcmp(input+prev-1u, input+pos, 4u) == 0)
+        repeats += 1u;
+      last_seen[h] = pos+1u;
+    }
+    sample_sz += slice;
+  }
+  if (repeats*64u >= sample_sz
+  ||  collisions > sample_sz*(sample_sz-1u)/4096u*17u)
+    return 0;
+  /* the window may hold an earlier copy of the noise */
+  return !tcmplxA_blockbuf_window_probe(x, stride, slice)
+    && !tcmplxA_blockbuf_far_probe(x);
+}
+
 int tcmplxA_blockbuf_try_block(struct tcmplxA_blockbuf* x) {
+  size_t const first = x->cmd_count;
+  int const res = tcmplxA_blockbuf_try_commands(x);
+  if (res != tcmplxA_Success)
+    return res;
+  return tcmplxA_blockbuf_cmd_serialize(x, first);
+}
+
+int tcmplxA_blockbuf_try_commands(struct tcmplxA_blockbuf* x) {
+  int const res = tcmplxA_blockbuf_start_commands(x);
+  if (res != tcmplxA_Success)
+    return res;
+  return tcmplxA_blockbuf_step_commands(x, x->input.sz);
+}
+
+int tcmplxA_blockbuf_start_commands(struct tcmplxA_blockbuf* x) {
   int res = tcmplxA_Success;
-  tcmplxA_uint32 const n = 51u;
-  tcmplxA_uint32 j = x->output.sz;
-  tcmplxA_uint32 i;
+  size_t const first = x->cmd_count;
+  tcmplxA_uint32 const input_sz = x->input.sz;
+  x->parse.active = 0u;
+  /* each copy spans at least two input bytes */{
+    res = tcmplxA_blockstr_reserve(&x->literals, x->literals.sz + input_sz);
+    if (res != tcmplxA_Success)
+      return res;
+    res = tcmplxA_blockbuf_cmd_reserve(x, first + input_sz/2u + 1u);
+    if (res != tcmplxA_Success)
+      return res;
+  }
+  /* without scratch space for the suffix array, use the hash chain */if (x->suffix_tf) {
+    res = tcmplxA_blockbuf_suffix_commands(x, first);
+    if (res != tcmplxA_ErrMemory)
+      return res;
+    res = tcmplxA_Success;
+  }
+  /* long-distance matches lie at least `FarMin` bytes apart */if (x->far_table) {
+    res = tcmplxA_blockbuf_far_reserve
+      (x, input_sz/tcmplxA_BlockBuf_FarMin + 1u);
+    if (res != tcmplxA_Success)
+      return res;
+    tcmplxA_blockbuf_far_scan(x, x->input.p, input_sz, 1);
+  }
+  x->parse.first = first;
+  x->parse.i = 0u;
+  x->parse.v = 0u;
+  x->parse.other_v = 0u;
+  x->parse.match_size = 0u;
+  x->parse.other_match_size = 0u;
+  x->parse.misses = 0u;
+  x->parse.skip_left = 0u;
+  x->parse.far_i = 0u;
+  x->parse.state = 0u;
+  x->parse.skipped_byte = 0u;
+  x->parse.active = 1u;
+  return tcmplxA_Success;
+}
+
+int tcmplxA_blockbuf_step_commands
+  (struct tcmplxA_blockbuf* x, tcmplxA_uint32 n)
+{
+  int res = tcmplxA_Success;
+  size_t const first = x->parse.first;
+  tcmplxA_uint32 i = x->parse.i;
   tcmplxA_uint32 const input_sz = x->input.sz;
-  tcmplxA_uint32 other_v = 0u;
-  tcmplxA_uint32 v = 0u;
-  unsigned char state = 0;
-  unsigned char skipped_byte = 0u;
-  tcmplxA_uint32 other_match_size = 0u;
-  tcmplxA_uint32 match_size = 0u;
-  for (i = 0u; i < input_sz && res == tcmplxA_Success; ++i) {
+  tcmplxA_uint32 const end = (n < input_sz - i) ? i + n : input_sz;
+  tcmplxA_uint32 other_v = x->parse.other_v;
+  tcmplxA_uint32 v = x->parse.v;
+  unsigned char state = x->parse.state;
+  unsigned char skipped_byte = x->parse.skipped_byte;
+  tcmplxA_uint32 other_match_size = x->parse.other_match_size;
+  tcmplxA_uint32 match_size = x->parse.match_size;
+  /* searches missed since the last match, and bytes left to pass over */
+  tcmplxA_uint32 misses = x->parse.misses;
+  tcmplxA_uint32 skip_left = x->parse.skip_left;
+  /* next long-distance match to consider */
+  size_t far_i = x->parse.far_i;
+  if (!x->parse.active)
+    return tcmplxA_Success;
+  for (; i < end && res == tcmplxA_Success; ++i) {
     switch (state) {
     case 2:
       /* two things */{
         unsigned int const q = tcmplxA_hashchain_peek(x->chain, v);
         unsigned int const other_q = tcmplxA_hashchain_peek(x->chain, other_v);
         if (q != x->input.p[i]) {
-          res = tcmplxA_blockstr_update_literal(&x->output, skipped_byte, &j);
+          tcmplxA_blockbuf_cmd_literal(x, skipped_byte, first);
           v = other_v;
           match_size = other_match_size;
           state = 1;
         } else if (other_q != x->input.p[i]
-            || match_size >= tcmplxA_BlockBuf_MaxOutCode)
+            || match_size >= x->copy_max)
         {
           state = 1;
         } else {
@@ -354,57 +1868,111 @@ int tcmplxA_blockbuf_try_block(struct tcmplxA_blockbuf* x) {
     case 1: /* one thing */
       {
         unsigned int const q = tcmplxA_hashchain_peek(x->chain, v);
-        if (q == x->input.p[i] && match_size < tcmplxA_BlockBuf_MaxOutCode) {
+        if (q == x->input.p[i] && match_size < x->copy_max) {
           match_size += 1u;
           res = tcmplxA_hashchain_add(x->chain, x->input.p[i]);
           break;
         } else {
           /* close the match */
-          res = tcmplxA_blockstr_add_copy(&x->output, match_size, v);
-          if (res != tcmplxA_Success)
-            break;
-          else j = x->output.sz;
+          tcmplxA_blockbuf_cmd_copy(x, match_size, v, first);
           state = 0;
         }
       }
       /* [[fallthrough]] */;
     case 0:
-      if (i <= input_sz-4u) {
-        v = tcmplxA_hashchain_find(x->chain, x->input.p+i, 0);
-        if (v != tcmplxA_BlockBuf_NPos) {
-          other_v = tcmplxA_hashchain_find(x->chain, x->input.p+i+1, 0);
-          if (other_v != tcmplxA_BlockBuf_NPos) {
-            other_match_size = 2u;
-            state = 2;
-            other_v += 1u;
-          } else {
-            other_match_size = 0u;
-            state = 1;
+      v = tcmplxA_BlockBuf_NPos;
+      other_v = tcmplxA_BlockBuf_NPos;
+      /* long-distance matches come first and need no lookahead */
+      while (far_i < x->far_count && x->far_hits[far_i].pos < i)
+        far_i += 1u;
+      if (far_i < x->far_count && x->far_hits[far_i].pos == i
+        && x->far_hits[far_i].v < tcmplxA_hashchain_size(x->chain))
+      {
+        v = x->far_hits[far_i].v;
+      } else if (skip_left > 0u)
+        skip_left -= 1u;
+      else if (i <= input_sz-4u) {
+        tcmplxA_uint32 recent_len = 0u;
+        tcmplxA_uint32 const recent_v = x->recent_tf
+          ? tcmplxA_blockbuf_recent_find(x, i, &recent_len)
+          : tcmplxA_BlockBuf_NPos;
+        /* a long enough recent match makes the hash chain moot */
+        if (recent_len >= tcmplxA_BlockBuf_ProbeMax)
+          v = tcmplxA_BlockBuf_NPos;
+        else if (x->greedy_tf)
+          v = tcmplxA_hashchain_find_limit(x->chain, x->input.p+i, 0, 1u);
+        else v = tcmplxA_hashchain_find(x->chain, x->input.p+i, 0);
+        if (recent_v == tcmplxA_BlockBuf_NPos)
+          /* keep the hash chain match */;
+        else if (v == tcmplxA_BlockBuf_NPos)
+          v = recent_v;
+        else {
+          /* a recent distance needs no extra bits */
+          tcmplxA_uint32 const hash_len = tcmplxA_blockbuf_match_length
+            (x, i, v, tcmplxA_BlockBuf_ProbeMax);
+          if (recent_len*tcmplxA_BlockBuf_ByteBits
+              + tcmplxA_util_bitwidth((unsigned int)v+1u)
+            >= hash_len*tcmplxA_BlockBuf_ByteBits)
+          {
+            v = recent_v;
           }
-          match_size = 3u;
-          skipped_byte = x->input.p[i];
-          res = tcmplxA_hashchain_add(x->chain, x->input.p[i]);
-          if (res != tcmplxA_Success)
-            break;
-          res = tcmplxA_hashchain_add(x->chain, x->input.p[i+1u]);
-          if (res != tcmplxA_Success)
-            break;
-          res = tcmplxA_hashchain_add(x->chain, x->input.p[i+2u]);
-          i += 2u;
-          break;
+        }
+        if (v != tcmplxA_BlockBuf_NPos) {
+          if (!x->greedy_tf)
+            other_v = tcmplxA_hashchain_find(x->chain, x->input.p+i+1, 0);
+        } else if (x->skip_tf) {
+          misses += 1u;
+          skip_left = misses >> tcmplxA_BlockBuf_SkipShift;
         }
       }
-      /* literal */{
-        res = tcmplxA_blockstr_update_literal(&x->output, x->input.p[i], &j);
+      if (v != tcmplxA_BlockBuf_NPos) {
+        misses = 0u;
+        skip_left = 0u;
+        if (other_v != tcmplxA_BlockBuf_NPos) {
+          other_match_size = 2u;
+          state = 2;
+          other_v += 1u;
+        } else {
+          other_match_size = 0u;
+          state = 1;
+        }
+        match_size = 3u;
+        skipped_byte = x->input.p[i];
+        res = tcmplxA_hashchain_add(x->chain, x->input.p[i]);
+        if (res != tcmplxA_Success)
+          break;
+        res = tcmplxA_hashchain_add(x->chain, x->input.p[i+1u]);
         if (res != tcmplxA_Success)
           break;
+        res = tcmplxA_hashchain_add(x->chain, x->input.p[i+2u]);
+        i += 2u;
+        break;
+      }
+      /* literal */{
+        tcmplxA_blockbuf_cmd_literal(x, x->input.p[i], first);
         res = tcmplxA_hashchain_add(x->chain, x->input.p[i]);
       } break;
     }
   }
-  if (res == tcmplxA_Success && state > 0) {
+  x->parse.i = i;
+  x->parse.v = v;
+  x->parse.other_v = other_v;
+  x->parse.state = state;
+  x->parse.skipped_byte = skipped_byte;
+  x->parse.other_match_size = other_match_size;
+  x->parse.match_size = match_size;
+  x->parse.misses = misses;
+  x->parse.skip_left = skip_left;
+  x->parse.far_i = far_i;
+  if (res != tcmplxA_Success) {
+    x->parse.active = 0u;
+    return res;
+  } else if (i < input_sz)
+    return tcmplxA_ErrPartial;
+  x->parse.active = 0u;
+  if (state > 0) {
     /* close the match */
-    res = tcmplxA_blockstr_add_copy(&x->output, match_size, v);
+    tcmplxA_blockbuf_cmd_copy(x, match_size, v, first);
   }
   return tcmplxA_Success;
 }
@@ -412,7 +1980,7 @@ int tcmplxA_blockbuf_try_block(struct tcmplxA_blockbuf* x) {
 int tcmplxA_blockbuf_write
   (struct tcmplxA_blockbuf* x, unsigned char const* buf, size_t sz)
 {
-  if (sz > x->input_block_size - x->input.sz) {
+  if (x->held > 0u || sz > x->input_block_size - x->input.sz) {
     return tcmplxA_ErrBlockOverflow;
   } else return tcmplxA_blockstr_append(&x->input, buf, sz);
 }
@@ -429,6 +1997,25 @@ tcmplxA_uint32 tcmplxA_blockbuf_output_size(struct tcmplxA_blockbuf const* x) {
   return x->output.sz;
 }
 
+struct tcmplxA_blockcmds tcmplxA_blockbuf_commands
+  (struct tcmplxA_blockbuf const* x)
+{
+  struct tcmplxA_blockcmds out;
+  out.insert_lens = x->cmds;
+  out.copy_lens = x->cmds+x->cmd_cap;
+  out.distances = x->cmds+x->cmd_cap*2u;
+  out.literal_offsets = x->cmds+x->cmd_cap*3u;
+  out.literals = x->literals.p;
+  out.count = x->cmd_count;
+  /* a search in progress may still add literals to the last command */
+  if (x->parse.active && out.count > x->parse.first
+  &&  out.copy_lens[out.count-1u] == 0u)
+  {
+    out.count -= 1u;
+  }
+  return out;
+}
+
 unsigned char const* tcmplxA_blockbuf_input_data
   (struct tcmplxA_blockbuf const* x)
 {
@@ -443,6 +2030,9 @@ unsigned char const* tcmplxA_blockbuf_output_data
 
 void tcmplxA_blockbuf_clear_output(struct tcmplxA_blockbuf* x) {
   x->output.sz = 0u;
+  x->literals.sz = 0u;
+  x->cmd_count = 0u;
+  x->parse.active = 0u;
   return;
 }
 
@@ -454,6 +2044,7 @@ size_t tcmplxA_blockbuf_bypass
   for (i = 0u; i < sz && chain_ae == tcmplxA_Success; ++i) {
     chain_ae = tcmplxA_hashchain_add(x->chain, buf[i]);
   }
+  tcmplxA_blockbuf_far_scan(x, buf, (tcmplxA_uint32)i, 0);
   return i;
 }
 
@@ -472,7 +2063,118 @@ tcmplxA_uint32 tcmplxA_blockbuf_ring_size(struct tcmplxA_blockbuf const* x) {
 }
 
 void tcmplxA_blockbuf_clear_input(struct tcmplxA_blockbuf* x) {
+  if (x->held > 0u)
+    memmove(x->input.p, x->input.p+x->input.sz, x->held);
+  x->input.sz = x->held;
+  x->held = 0u;
+  return;
+}
+
+int tcmplxA_blockbuf_hold_input(struct tcmplxA_blockbuf* x, tcmplxA_uint32 n)
+{
+  if (n > x->input.sz)
+    return tcmplxA_ErrParam;
+  x->held += x->input.sz - n;
+  x->input.sz = n;
+  return tcmplxA_Success;
+}
+
+void tcmplxA_blockbuf_reset(struct tcmplxA_blockbuf* x) {
   x->input.sz = 0u;
+  x->held = 0u;
+  tcmplxA_blockbuf_clear_output(x);
+  tcmplxA_hashchain_reset(x->chain);
+  tcmplxA_blockbuf_recent_reset(x);
+  /* stale fingerprints fail their checks against the empty window */
+  x->far_hash = 0u;
+  x->far_count = 0u;
+  return;
+}
+
+void tcmplxA_blockbuf_set_recent(struct tcmplxA_blockbuf* x, int recent_tf) {
+  x->recent_tf = (recent_tf != 0);
   return;
 }
+
+void tcmplxA_blockbuf_set_greedy(struct tcmplxA_blockbuf* x, int greedy_tf) {
+  x->greedy_tf = (greedy_tf != 0);
+  return;
+}
+
+void tcmplxA_blockbuf_set_skip(struct tcmplxA_blockbuf* x, int skip_tf) {
+  x->skip_tf = (skip_tf != 0);
+  return;
+}
+
+void tcmplxA_blockbuf_set_suffix(struct tcmplxA_blockbuf* x, int suffix_tf) {
+  x->suffix_tf = (suffix_tf != 0);
+  return;
+}
+
+void tcmplxA_blockbuf_set_copy_max
+  (struct tcmplxA_blockbuf* x, tcmplxA_uint32 copy_max)
+{
+  if (copy_max < 3u)
+    copy_max = 3u;
+  else if (copy_max > tcmplxA_BlockBuf_MaxOutCode)
+    copy_max = tcmplxA_BlockBuf_MaxOutCode;
+  x->copy_max = copy_max;
+  return;
+}
+
+void tcmplxA_blockbuf_set_scratch_cap
+  (struct tcmplxA_blockbuf* x, size_t scratch_cap)
+{
+  x->scratch_cap = scratch_cap;
+  return;
+}
+
+int tcmplxA_blockbuf_copy_ring
+  (struct tcmplxA_blockbuf* dst, struct tcmplxA_blockbuf const* src)
+{
+  if (dst == src)
+    return tcmplxA_Success;
+  dst->input.sz = 0u;
+  dst->held = 0u;
+  tcmplxA_blockbuf_clear_output(dst);
+  memcpy(dst->recent, src->recent, sizeof(dst->recent));
+  dst->recent_i = src->recent_i;
+  dst->far_total = src->far_total;
+  dst->far_hash = src->far_hash;
+  dst->far_count = 0u;
+  if (dst->far_table != NULL && dst->far_bits == src->far_bits) {
+    memcpy(dst->far_table, src->far_table,
+      ((size_t)1u<<dst->far_bits)*sizeof(tcmplxA_uint32));
+  }
+  return tcmplxA_hashchain_copy(dst->chain, src->chain);
+}
+
+size_t tcmplxA_blockbuf_memory_usage(struct tcmplxA_blockbuf const* x) {
+  return sizeof(struct tcmplxA_blockbuf)
+    + tcmplxA_hashchain_memory_usage(x->chain)
+    + x->input.cap + x->output.cap + x->literals.cap
+    + x->cmd_cap*4u*sizeof(tcmplxA_uint32)
+    + (x->far_table ? ((size_t)1u<<x->far_bits)*sizeof(tcmplxA_uint32) : 0u)
+    + x->far_cap*sizeof(struct tcmplxA_blockbuf_far);
+}
+
+size_t tcmplxA_blockbuf_memory_bound
+  (tcmplxA_uint32 block_size, tcmplxA_uint32 n, size_t chain_length)
+{
+  size_t const chain = tcmplxA_hashchain_memory_bound(n, chain_length);
+  size_t far = 0u;
+  if (chain == (size_t)-1)
+    return (size_t)-1;
+  if (block_size > tcmplxA_BlockBuf_SizeMax/2u)
+    block_size = (tcmplxA_uint32)(tcmplxA_BlockBuf_SizeMax/2u);
+  if (n >= tcmplxA_BlockBuf_FarWindow) {
+    far = ((size_t)1u<<tcmplxA_blockbuf_far_bits(n))*sizeof(tcmplxA_uint32)
+      + (block_size/tcmplxA_BlockBuf_FarMin+1u)
+        * sizeof(struct tcmplxA_blockbuf_far);
+  }
+  /* input block, then up to two output bytes per input byte,
+   * then literals and one command per two input bytes */
+  return sizeof(struct tcmplxA_blockbuf) + chain + block_size*4u
+    + (block_size/2u+1u)*4u*sizeof(tcmplxA_uint32) + far;
+}
 /* END   block buffer / public */
@@ -7,6 +7,8 @@
 
 #include "text-complex/access/api.h"
 
+struct tcmplxA_allocator;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /*__cplusplus*/
@@ -15,14 +17,19 @@ struct tcmplxA_blockstr {
   unsigned char* p;
   tcmplxA_uint32 sz;
   tcmplxA_uint32 cap;
+  struct tcmplxA_allocator const* alloc;
 };
 
 /**
  * @brief Initialize a block string.
  * @param x the block string to initialize
+ * @param cap initial capacity
+ * @param alloc (nullable) allocator for the string; NULL for the heap
  * @return zero on success, nonzero otherwise
  */
-int tcmplxA_blockstr_init(struct tcmplxA_blockstr* x, tcmplxA_uint32 cap);
+int tcmplxA_blockstr_init
+  ( struct tcmplxA_blockstr* x, tcmplxA_uint32 cap,
+    struct tcmplxA_allocator const* alloc);
 /**
  * @brief Close a block string.
  * @param x the block string to close
@@ -64,11 +64,18 @@ static void tcmplxA_brcvt_skipforward(tcmplxA_uint32 byte_count) { return; }
 
 enum tcmplxA_brcvt_uconst {
   tcmplxA_brcvt_LitHistoSize = 256u,
-  tcmplxA_brcvt_DistHistoSize = 68u,
+  /** @brief Largest distance alphabet: 16 + 120 direct + (48<<3). */
+  tcmplxA_brcvt_DistHistoSize = 520u,
   tcmplxA_brcvt_InsHistoSize = 704u,
-  tcmplxA_brcvt_HistogramSize =
-      tcmplxA_brcvt_LitHistoSize*4u
-    + tcmplxA_brcvt_DistHistoSize
+  /** @brief Insert-and-copy codes that reuse the last distance. */
+  tcmplxA_brcvt_InsZeroCodes = 128u,
+  /** @brief Literal contexts per literal block type. */
+  tcmplxA_brcvt_LitContexts = 64u,
+  /** @brief Distance contexts per distance block type. */
+  tcmplxA_brcvt_DistContexts = 4u,
+  /** @brief Histogram entries ahead of the literal histograms. */
+  tcmplxA_brcvt_CmdHistoSize =
+      tcmplxA_brcvt_DistHistoSize*tcmplxA_brcvt_DistContexts
     + tcmplxA_brcvt_InsHistoSize,
   tcmplxA_brcvt_MetaHeaderLen = 6,
   tcmplxA_brcvt_CLenExtent = 18,
@@ -78,7 +85,50 @@ enum tcmplxA_brcvt_uconst {
   tcmplxA_brcvt_TreetyOutflowMax = 4096,
   tcmplxA_brcvt_RepeatBit = 128,
   tcmplxA_brcvt_ZeroBit = 64,
-  tcmplxA_brcvt_ContextHistogram = 10,
+  /** @brief Run length codes plus one symbol per prefix tree. */
+  tcmplxA_brcvt_ContextHistogram = 16+256,
+  /** @brief Most literal block types in a meta-block. */
+  tcmplxA_brcvt_SplitTypesMax = 256,
+  /** @brief Block size to budget for each literal block type. */
+  tcmplxA_brcvt_SplitTypeBytes = 8192,
+  /** @brief Literals per block splitter chunk. */
+  tcmplxA_brcvt_SplitChunk = 512,
+  /** @brief Bits a chunk must save to open a new block type. */
+  tcmplxA_brcvt_SplitThreshold = 400,
+  /** @brief Bits a chunk must save to switch back a block type. */
+  tcmplxA_brcvt_SplitSwitch = 20,
+  /** @brief Estimated bits to describe one literal code length. */
+  tcmplxA_brcvt_SplitCodeBits = 5,
+  /** @brief Estimated bits to start one prefix tree. */
+  tcmplxA_brcvt_SplitTreeBits = 80,
+  /** @brief Block size to budget for each literal context histogram. */
+  tcmplxA_brcvt_ContextHistoBytes = 32,
+  /** @brief Block size to budget for each literal prefix tree. */
+  tcmplxA_brcvt_LitTreeBytes = 1024,
+  /** @brief Fewest literals to pay for a literal context map. */
+  tcmplxA_brcvt_ContextMinLiterals = 512,
+  /** @brief Most literal prefix trees in a meta-block. */
+  tcmplxA_brcvt_LitTreesMax = 256,
+  /** @brief Input bytes needed to enter the command fast path. */
+  tcmplxA_brcvt_FastInput = 16,
+  /** @brief Output bytes needed to stay in the command fast path. */
+  tcmplxA_brcvt_FastOutput = 64,
+  /** @brief Window bits needed to run one fast path step. */
+  tcmplxA_brcvt_FastStep = 32,
+  /** @brief Most extra bits read by one fast path step. */
+  tcmplxA_brcvt_FastExtraMax = 24,
+  /** @brief Largest meta-block in quick mode. */
+  tcmplxA_brcvt_QuickBlockSize = 65536,
+  /** @brief Input bytes to search per step in quick mode. */
+  tcmplxA_brcvt_QuickStep = 4096,
+  /** @brief Fraction of a block to search before its quick mode trees. */
+  tcmplxA_brcvt_QuickSample = 8,
+  /** @brief Input bytes per chunk when looking for a meta-block end. */
+  tcmplxA_brcvt_MetaChunk = 4096,
+  /** @brief Chunks to compare against the meta-block so far. */
+  tcmplxA_brcvt_MetaLookahead = 8,
+  /** @brief Bits a shift in statistics must save to end a meta-block. */
+  tcmplxA_brcvt_MetaShiftBits = 32000,
 };
 
 enum tcmplxA_brcvt_istate {
@@ -188,6 +238,16 @@ struct tcmplxA_brcvt_token {
   unsigned char state;
 };
 
+/**
+ * @brief Distance code chosen for a command by the trial pass.
+ */
+struct tcmplxA_brcvt_distcode {
+  /** @brief Value of the extra bits after the code. */
+  tcmplxA_uint32 extra;
+  /** @brief Distance alphabet code. */
+  unsigned short code;
+};
+
 /**
  * @brief Demand-driven output bit negotiator.
  * @note This structure allows meta-blocks to emit zero bytes.
@@ -208,9 +268,14 @@ struct tcmplxA_brcvt_forward {
   /**
    * @note Used as temporary storage of zero distance flag.
    */
-  unsigned char ctxt_i;
+  tcmplxA_uint32 ctxt_i;
   unsigned char bstore[38];
   unsigned char literal_ctxt[2];
+  /**
+   * @note Built-in dictionary word to emit as is, or NULL
+   *   to emit the transformed word in `bstore`.
+   */
+  unsigned char const* bword;
 };
 
 struct tcmplxA_brcvt_block {
@@ -218,6 +283,42 @@ struct tcmplxA_brcvt_block {
   unsigned char previous;
 };
 
+/** @brief Literal block split for outflow. */
+struct tcmplxA_brcvt_split {
+  /** @brief Byte offset of each block's first literal. */
+  tcmplxA_uint32* offsets;
+  /** @brief Literal count of each block. */
+  tcmplxA_uint32* lengths;
+  /** @brief Block type of each block. */
+  unsigned char* types;
+  /** @brief Number of blocks in use. */
+  size_t count;
+  /** @brief Number of blocks allocated. */
+  size_t cap;
+};
+
+/** @brief Greedy literal block splitter. */
+struct tcmplxA_brcvt_splitter {
+  /** @brief Literal histogram per block type, then the pending chunk. */
+  tcmplxA_uint32* histograms;
+  /** @brief Context mode tallies per block type. */
+  tcmplxA_uint32* modes;
+  /** @brief Block types in use. */
+  size_t types;
+  /** @brief Most block types allowed. */
+  size_t types_max;
+  /** @brief Literals in the pending chunk. */
+  tcmplxA_uint32 chunk_len;
+  /** @brief Byte offset of the pending chunk's first literal. */
+  tcmplxA_uint32 chunk_offset;
+  /** @brief Context mode tallies for the pending chunk. */
+  tcmplxA_uint32 chunk_modes[tcmplxA_CtxtMap_ModeMax];
+  /** @brief Last and second-to-last block types. */
+  size_t last[2];
+  /** @brief Estimated bit costs of the last two block types. */
+  size_t last_cost[2];
+};
+
 struct tcmplxA_brcvt {
   /**
    * @brief ...
@@ -239,12 +340,12 @@ struct tcmplxA_brcvt {
   struct tcmplxA_fixlist distance_blockcount;
   /** @brief Context transcode prefixes. */
   struct tcmplxA_fixlist context_tree;
-  /** @brief Fixed window size Huffman code table. */
-  struct tcmplxA_fixlist* wbits;
-  /** @brief ... */
-  struct tcmplxA_inscopy* values;
-  /** @brief Block count insert-copy table */
-  struct tcmplxA_inscopy* blockcounts;
+  /** @brief Shared window size Huffman code table, in code order. */
+  struct tcmplxA_fixlist const* wbits;
+  /** @brief Shared insert-and-copy length table. */
+  struct tcmplxA_inscopy const* values;
+  /** @brief Shared block count insert-copy table */
+  struct tcmplxA_inscopy const* blockcounts;
   /** @brief ... */
   struct tcmplxA_ringdist* ring;
   /** @brief ... */
@@ -253,6 +354,10 @@ struct tcmplxA_brcvt {
   struct tcmplxA_ctxtmap* literals_map;
   /** @brief The literals' Huffman forest. */
   struct tcmplxA_gaspvec* literals_forest;
+  /** @brief Context map row for the current literal block type. */
+  unsigned char const* literal_row;
+  /** @brief Literal context lookup table for the current block type. */
+  unsigned char const* literal_lut;
   /** @brief Context map for dancing through the distances' Huffman forest. */
   struct tcmplxA_ctxtmap* distance_map;
   /** @brief The distances' Huffman forest. */
@@ -261,6 +366,18 @@ struct tcmplxA_brcvt {
   struct tcmplxA_gaspvec* insert_forest;
   /** @brief Histogram storage used for generating data trees. */
   tcmplxA_uint32* histogram;
+  /** @brief Literal histograms per block type and literal context. */
+  tcmplxA_uint32* context_histogram;
+  /** @brief Number of literal histograms in `context_histogram`. */
+  size_t context_histogram_cap;
+  /** @brief Cached merge costs for histogram clustering. */
+  long int* cluster_pairs;
+  /** @brief Number of entries in `cluster_pairs`. */
+  size_t cluster_pairs_cap;
+  /** @brief Distance codes from the trial pass, one per command. */
+  struct tcmplxA_brcvt_distcode* distance_codes;
+  /** @brief Number of entries in `distance_codes`. */
+  size_t distance_codes_cap;
   /** @brief ... */
   tcmplxA_uint32 bits;
   /** @brief Read count for bits used after a Huffman code. */
@@ -326,8 +443,23 @@ struct tcmplxA_brcvt {
   unsigned char rlemax;
   /** @brief Field for context map encoding. */
   struct tcmplxA_blockstr context_encode;
-  /** @brief Context span effective lengths for outflow. */
-  tcmplxA_uint32 guess_lengths[tcmplxA_CtxtSpan_Size];
+  /** @brief Allocator for the state and its members; NULL for the heap. */
+  struct tcmplxA_allocator const* alloc;
+  /** @brief Memory cap in bytes; zero for no cap. */
+  size_t memory_cap;
+  /** @brief Whether to trade compression ratio for speed. */
+  unsigned char quick_tf;
+  /**
+   * @brief Whether the current meta-block writes its commands while
+   *   the match search runs, counting them for the next meta-block.
+   */
+  unsigned char stream_tf;
+  /** @brief Most input bytes per meta-block; zero for the block size. */
+  tcmplxA_uint32 latency;
+  /** @brief Literal block split for outflow. */
+  struct tcmplxA_brcvt_split split;
+  /** @brief Most literal block types per meta-block. */
+  size_t literal_types_max;
   /** @brief Remaining items under the current literal blocktype. */
   tcmplxA_uint32 blocktypeL_remaining;
   /** @brief Remaining items under the current insert-and-copy blocktype. */
@@ -346,20 +478,17 @@ struct tcmplxA_brcvt {
   unsigned short blocktypeD_skip;
   /** @brief Distance count skip code. */
   unsigned short blockcountD_skip;
-  /** @brief Skip code for literals. */
-  unsigned short literal_skip;
-  /** @brief Skip code for insert-and-copy. */
-  unsigned short insert_skip;
-  /** @brief Skip code for distances. */
-  unsigned short distance_skip;
   /** @brief Context map prefix tree skip code. */
   unsigned short context_skip;
+  /**
+   * @brief Forests with at least one zero-bit tree.
+   * @note AND 1 = literals; AND 2 = insert-and-copy; AND 4 = distances.
+   */
+  unsigned char data_skips;
   /** @brief Token forwarding. */
   struct tcmplxA_brcvt_forward fwd;
   /** @brief Extended pool of output bits. */
   tcmplxA_uint32 extra_bits[2];
-  /** @brief Map from mode to outflow context index. */
-  unsigned char ctxt_mode_map[4];
 };
 
 unsigned char tcmplxA_brcvt_clen[tcmplxA_brcvt_CLenExtent] =
@@ -386,11 +515,13 @@ static struct tcmplxA_brcvt_block const tcmplxA_brcvt_btype_zero = {0,1};
  * @param block_size amount of input data to process at once
  * @param n maximum sliding window size (use 16777200 for Brotli default)
  * @param chain_length run-time parameter limiting hash chain length
+ * @param alloc (nullable) allocator for the state; NULL for the heap
  * @return zero on success, nonzero otherwise
  */
 static int tcmplxA_brcvt_init
   ( struct tcmplxA_brcvt* x, tcmplxA_uint32 block_size,
-    tcmplxA_uint32 n, size_t chain_length);
+    tcmplxA_uint32 n, size_t chain_length,
+    struct tcmplxA_allocator const* alloc);
 /**
  * @brief Close a zcvt state.
  * @param x the zcvt state to close
@@ -399,7 +530,9 @@ static void tcmplxA_brcvt_close(struct tcmplxA_brcvt* x);
 /**
  * @brief Bit iteration.
  * @param x the zcvt state
- * @param y bits to iterate
+ * @param[in,out] src pointer to the byte of bits to iterate; moves
+ *   past the next byte too when a prefix code ends inside it
+ * @param src_end end of source buffer
  * @param[out] ret number of (inflated) destination bytes written
  * @param dst destination buffer
  * @param dstsz size of destination buffer
@@ -407,7 +540,8 @@ static void tcmplxA_brcvt_close(struct tcmplxA_brcvt* x);
  *   bit sequence
  */
 static int tcmplxA_brcvt_zsrtostr_bits
-  ( struct tcmplxA_brcvt* x, unsigned int y,
+  ( struct tcmplxA_brcvt* x, unsigned char const** src,
+    unsigned char const* src_end,
     size_t* ret, unsigned char* dst, size_t dstsz);
 /**
  * @brief Calculate a compression info value.
@@ -562,6 +696,233 @@ static void tcmplxA_brcvt_accum_remain(struct tcmplxA_brcvt* ps,
  * @return Success to proceed with compression, nonzero to emit uncompressed
  */
 static int tcmplxA_brcvt_check_compress(struct tcmplxA_brcvt* ps);
+/**
+ * @brief Prepare the quick mode histograms before the match search.
+ * @param ps Brotli conversion state with a match search started
+ * @param[in,out] insert_histogram insert-and-copy code counts from
+ *   the previous meta-block
+ * @param[in,out] distance_histogram distance code counts from
+ *   the previous meta-block
+ * @param[in,out] literal_histogram literal counts from the previous
+ *   meta-block
+ * @return Success on success, nonzero otherwise
+ * @note The search first runs over the start of the block, and the
+ *   commands it finds there add to the counts.
+ * @note Every code gets a count of at least one, so that any command
+ *   the search finds has a prefix code.
+ */
+static int tcmplxA_brcvt_quick_histograms(struct tcmplxA_brcvt* ps,
+  tcmplxA_uint32* insert_histogram, tcmplxA_uint32* distance_histogram,
+  tcmplxA_uint32* literal_histogram);
+/**
+ * @brief Find the quick mode literal histogram.
+ * @param ps Brotli conversion state
+ * @return the histogram of literal block type zero
+ */
+static tcmplxA_uint32* tcmplxA_brcvt_quick_literals(struct tcmplxA_brcvt* ps);
+/**
+ * @brief Find the input size at which to close a meta-block.
+ * @param ps Brotli conversion state
+ * @return a byte count
+ */
+static tcmplxA_uint32 tcmplxA_brcvt_block_capacity
+  (struct tcmplxA_brcvt const* ps);
+/**
+ * @brief Find where the input statistics shift enough to pay
+ *   for another meta-block header.
+ * @param ps Brotli conversion state
+ * @param input_len number of input bytes available
+ * @return the input size at which to end the meta-block
+ */
+static tcmplxA_uint32 tcmplxA_brcvt_meta_boundary
+  (struct tcmplxA_brcvt const* ps, tcmplxA_uint32 input_len);
+/**
+ * @brief Estimate a base-2 logarithm.
+ * @param x positive value
+ * @return the logarithm in sixteenths of a bit
+ */
+static unsigned tcmplxA_brcvt_log2q4(tcmplxA_uint32 x);
+/**
+ * @brief Estimate the bits needed to encode a sum of histograms.
+ * @param a histogram
+ * @param b (nullable) histogram to add to the first
+ * @param size number of entries in each histogram
+ * @param with_tree nonzero to include the prefix tree description
+ * @return an estimated bit count
+ */
+static size_t tcmplxA_brcvt_histogram_cost(tcmplxA_uint32 const* a,
+  tcmplxA_uint32 const* b, size_t size, int with_tree);
+/**
+ * @brief Estimate the bits needed to encode a pair of histograms merged.
+ * @param a histogram
+ * @param b histogram to add to the first
+ * @param spans nonzero entry range of each histogram, first then
+ *   one past the last
+ * @return an estimated bit count
+ */
+static size_t tcmplxA_brcvt_pair_cost(tcmplxA_uint32 const* a,
+  tcmplxA_uint32 const* b, unsigned short const* spans);
+/**
+ * @brief Merge histograms while merging saves bits.
+ * @param histograms histograms to merge; each cluster accumulates
+ *   in the histogram of its root
+ * @param n number of histograms, at most `SplitTypesMax`
+ * @param size number of entries in each histogram
+ * @param max most clusters to keep, even if merging costs bits
+ * @param[out] parent root histogram index for each histogram
+ * @param pairs scratch space for `n*(n-1)/2` merge costs
+ * @return the number of clusters left
+ */
+static size_t tcmplxA_brcvt_cluster(tcmplxA_uint32* const* histograms,
+  size_t n, size_t size, size_t max, unsigned short* parent,
+  long int* pairs);
+/**
+ * @brief Set the two most recent bytes from a block of input.
+ * @param[out] ctxt literal context bytes, most recent last
+ * @param data block of input data
+ * @param pos number of bytes of the block already processed
+ */
+static void tcmplxA_brcvt_keep_context(unsigned char* ctxt,
+  unsigned char const* data, tcmplxA_uint32 pos);
+/**
+ * @brief Make room for literal context histograms.
+ * @param ps Brotli conversion state
+ * @param n number of histograms needed
+ * @return Success on success, nonzero otherwise
+ */
+static int tcmplxA_brcvt_reserve_contexts(struct tcmplxA_brcvt* ps, size_t n);
+/**
+ * @brief Make room for the trial pass's distance codes.
+ * @param ps Brotli conversion state
+ * @param n number of commands in the block
+ * @return Success on success, nonzero otherwise
+ */
+static int tcmplxA_brcvt_reserve_distances(struct tcmplxA_brcvt* ps, size_t n);
+/**
+ * @brief Build the literal context map and prefix trees.
+ * @param ps Brotli conversion state with a literal block split
+ *   and a literal context map holding the context modes
+ * @param cmds commands of the current block
+ * @param type_histograms one literal histogram per block type,
+ *   for use when context histograms are unavailable
+ * @param[in,out] bit_count estimated bit count to update
+ * @return Success on success, nonzero otherwise
+ */
+static int tcmplxA_brcvt_context_literals(struct tcmplxA_brcvt* ps,
+  struct tcmplxA_blockcmds const* cmds,
+  tcmplxA_uint32* const* type_histograms, size_t* bit_count);
+/**
+ * @brief Build the distance context map and prefix trees.
+ * @param ps Brotli conversion state
+ * @param histograms one distance histogram per distance context
+ * @param[in,out] bit_count estimated bit count to update
+ * @return Success on success, nonzero otherwise
+ */
+static int tcmplxA_brcvt_context_distances(struct tcmplxA_brcvt* ps,
+  tcmplxA_uint32* histograms, size_t* bit_count);
+/**
+ * @brief Compute the size of the distance alphabet of a ring.
+ * @param ring distance ring to inspect
+ * @return the number of distance codes
+ */
+static size_t tcmplxA_brcvt_distance_alphabet
+  (struct tcmplxA_ringdist const* ring);
+/**
+ * @brief Choose the postfix bit count and direct code count
+ *   for the next meta-block.
+ * @param ps Brotli conversion state; reconfigures the distance ring
+ * @param cmds commands of the current block
+ * @return Success on success, nonzero otherwise
+ */
+static int tcmplxA_brcvt_distance_params(struct tcmplxA_brcvt* ps,
+  struct tcmplxA_blockcmds const* cmds);
+/**
+ * @brief Estimate the bits needed to encode a context map.
+ * @param map context map to encode
+ * @param ntrees number of prefix trees the map selects
+ * @return an estimated bit count
+ */
+static size_t tcmplxA_brcvt_map_cost(struct tcmplxA_ctxtmap const* map,
+  size_t ntrees);
+/**
+ * @brief Close the pending chunk of a literal block splitter.
+ * @param[out] split block split to extend
+ * @param[in,out] sp splitter holding the chunk
+ */
+static void tcmplxA_brcvt_split_chunk(struct tcmplxA_brcvt_split* split,
+  struct tcmplxA_brcvt_splitter* sp);
+/**
+ * @brief Merge the block types of a literal block split.
+ * @param[in,out] split block split to renumber
+ * @param[in,out] sp splitter holding the block type histograms
+ * @param[out] slots histogram index for each final block type
+ * @param pairs scratch space for the cached merge costs
+ * @return the number of block types left
+ */
+static size_t tcmplxA_brcvt_split_cluster(struct tcmplxA_brcvt_split* split,
+  struct tcmplxA_brcvt_splitter* sp, unsigned short* slots, long int* pairs);
+/**
+ * @brief Choose the code for a block type switch.
+ * @param box current and previous block type
+ * @param max_value maximum block type
+ * @param btype block type to switch to
+ * @return a block type code
+ */
+static unsigned tcmplxA_brcvt_blocktype_code(struct tcmplxA_brcvt_block box,
+  unsigned char max_value, unsigned btype);
+/**
+ * @brief Prepare a variable length 8-bit count.
+ * @param value count to encode, less than 256
+ * @param[out] bits bits to emit, low bit first
+ * @return the number of bits to emit
+ */
+static unsigned tcmplxA_brcvt_varlen_uint8(unsigned value, tcmplxA_uint32* bits);
+/**
+ * @brief Budget the literal block types for a block size.
+ * @param block_size amount of input data to process at once
+ * @return the most literal block types per meta-block
+ */
+static size_t tcmplxA_brcvt_literal_types_max(tcmplxA_uint32 block_size);
+/**
+ * @brief Size the histogram scratch space.
+ * @param types_max most literal block types per meta-block
+ * @return a count of histogram entries
+ */
+static size_t tcmplxA_brcvt_histogram_size(size_t types_max);
+/**
+ * @brief Size the literal block split.
+ * @param block_size amount of input data to process at once
+ * @return the most literal blocks per meta-block
+ */
+static size_t tcmplxA_brcvt_split_cap(tcmplxA_uint32 block_size);
+/**
+ * @brief Budget the literal context histograms for a block size.
+ * @param block_size amount of input data to process at once
+ * @return the most literal context histograms to hold
+ */
+static size_t tcmplxA_brcvt_context_histograms_max(tcmplxA_uint32 block_size);
+/**
+ * @brief Budget the literal prefix trees for a block size.
+ * @param block_size amount of input data to process at once
+ * @return the most literal prefix trees per meta-block
+ */
+static size_t tcmplxA_brcvt_literal_trees_max(tcmplxA_uint32 block_size);
+/**
+ * @brief Budget the cached merge costs for a block size.
+ * @param block_size amount of input data to process at once
+ * @return the most merge costs one clustering pass needs
+ */
+static size_t tcmplxA_brcvt_cluster_pairs(tcmplxA_uint32 block_size);
+/**
+ * @brief Estimate the memory a new state holds before it meets a stream.
+ * @param block_size amount of input data to process at once
+ * @param n sliding window size
+ * @param chain_length hash chain length
+ * @return a byte count, or `(size_t)-1` on overflow
+ */
+static size_t tcmplxA_brcvt_memory_floor
+  ( tcmplxA_uint32 block_size,
+    tcmplxA_uint32 n, size_t chain_length);
 /**
  * @brief Encode a nonzero entry in a context map using run-length encoding.
  * @param[out] buffer storage of intermediate encoding
@@ -572,6 +933,11 @@ static int tcmplxA_brcvt_check_compress(struct tcmplxA_brcvt* ps);
  */
 static int tcmplxA_brcvt_encode_map(struct tcmplxA_blockstr* buffer, size_t zeroes,
   int map_datum, unsigned* rlemax_ptr);
+/**
+ * @brief Put a conversion state's scalar fields at the start of a stream.
+ * @param x the conversion state to restart
+ */
+static void tcmplxA_brcvt_restart(struct tcmplxA_brcvt* x);
 /**
  * @brief Prepare for the inflow of a compressed stream.
  * @param ps state to prepare
@@ -604,25 +970,63 @@ static struct tcmplxA_gaspvec* tcmplxA_brcvt_active_forest(struct tcmplxA_brcvt
  */
 static unsigned char tcmplxA_brcvt_next_state(unsigned char state);
 /**
- * @brief Get the active skip code.
+ * @brief Select the literal context row and table of the current block type.
+ * @param ps state to update
+ */
+static void tcmplxA_brcvt_literal_select(struct tcmplxA_brcvt* ps);
+/**
+ * @brief Find the literal prefix tree for the current context.
+ * @param ps state to inspect
+ * @return an index into the literal forest
+ */
+static unsigned tcmplxA_brcvt_literal_tree(struct tcmplxA_brcvt const* ps);
+/**
+ * @brief Find the distance prefix tree for the current copy length.
  * @param ps state to inspect
- * @return a pointer to a skip code if available
+ * @return an index into the distance forest
+ */
+static unsigned tcmplxA_brcvt_distance_tree(struct tcmplxA_brcvt const* ps);
+/**
+ * @brief Get the skip code of the prefix tree for the next data symbol.
+ * @param ps state to inspect
+ * @return a symbol that takes no bits, or `tcmplxA_brcvt_NoSkip`
+ */
+static unsigned short tcmplxA_brcvt_data_skip(struct tcmplxA_brcvt const* ps);
+/**
+ * @brief Convert a command distance to a flat backward distance.
+ * @param distance command distance from the block buffer
+ * @param copy_len copy length of the command
+ * @param accum bytes of output before the copy
+ * @param wbits_select window size bits indirectly selected by user
+ * @return a flat backward distance, or zero for a bad dictionary reference
  */
-static unsigned short* tcmplxA_brcvt_active_skip(struct tcmplxA_brcvt* ps);
+static tcmplxA_uint32 tcmplxA_brcvt_flat_distance(tcmplxA_uint32 distance,
+  unsigned short copy_len, tcmplxA_uint32 accum, unsigned char wbits_select);
 /**
  * @brief Generate a nonzero token to emit to output.
  * @param fwd token forwarding structure
- * @param guesses literal block switch tracker
- * @param data output data in block buffer format
- * @param size length of output data in bytes
+ * @param split literal block split to follow
+ * @param cmds command stream from the block buffer
  * @param wbits_select window size bits indirectly selected by user
  * @param skip set to NoSkip to disable LiteralRestart tokens, other value
  *   to enable
  * @return a token
  */
 struct tcmplxA_brcvt_token tcmplxA_brcvt_next_token
-  (struct tcmplxA_brcvt_forward* fwd, struct tcmplxA_ctxtspan const* guesses,
-    unsigned char const* data, size_t size, unsigned char wbits_select, unsigned short skip);
+  (struct tcmplxA_brcvt_forward* fwd, struct tcmplxA_brcvt_split const* split,
+    struct tcmplxA_blockcmds const* cmds, unsigned char wbits_select,
+    unsigned short skip);
+/**
+ * @brief Emit a built-in dictionary word.
+ * @param ps state to update
+ * @param[in,out] ret write position of output buffer
+ * @param[out] dst start of output buffer
+ * @param[out] dstsz size of output buffer
+ * @return tcmplxA_Success once the whole word is out,
+ *   tcmplxA_ErrPartial if the output buffer fills first
+ */
+static int tcmplxA_brcvt_inflow_bdict(struct tcmplxA_brcvt* ps,
+  size_t* ret, unsigned char* dst, size_t dstsz);
 /**
  * @brief Process skip frameworks.
  * @param ps state to update
@@ -687,6 +1091,29 @@ static int tcmplxA_brcvt_inflow_distextra(struct tcmplxA_brcvt* ps);
  */
 static unsigned tcmplxA_brcvt_inflow_lookup(struct tcmplxA_brcvt* ps,
   struct tcmplxA_fixlist const* tree, unsigned x);
+/**
+ * @brief Try to find a value by bit string in a compiled forest.
+ * @param ps state to update with the new bit for the string
+ * @param forest prefix tree forest to check
+ * @param i index of the tree in the forest
+ * @param x next bit in the string to check
+ * @return a value on success, `UINT_MAX` otherwise
+ */
+static unsigned tcmplxA_brcvt_inflow_gasp(struct tcmplxA_brcvt* ps,
+  struct tcmplxA_gaspvec const* forest, size_t i, unsigned x);
+/**
+ * @brief Try to find a whole value by the bits already buffered.
+ * @param ps state to update with the matched bit string
+ * @param forest prefix tree forest to check
+ * @param i index of the tree in the forest
+ * @param window buffered bits, next bit least significant
+ * @param n number of buffered bits in the window
+ * @return a value on success, `UINT_MAX` if the code runs past
+ *   the buffered bits
+ */
+static unsigned tcmplxA_brcvt_inflow_peek(struct tcmplxA_brcvt* ps,
+  struct tcmplxA_gaspvec const* forest, size_t i, unsigned window,
+  unsigned n);
 /**
  * @brief Apply a block switch command.
  * @param current type of now-ending block
@@ -735,94 +1162,158 @@ static int tcmplxA_brcvt_apply_token_checked(struct tcmplxA_brcvt* ps);
  * @return new output state
  */
 static enum tcmplxA_brcvt_istate tcmplxA_brcvt_outflow_extra(unsigned state);
+/**
+ * @brief Check a planned allocation against the memory cap.
+ * @param ps the Brotli conversion state to check
+ * @param freed bytes to be released before the allocation
+ * @param needed bytes to be held after the allocation
+ * @return tcmplxA_Success if the allocation fits (or the state
+ *   has no cap), tcmplxA_ErrMemoryCap otherwise
+ */
+static int tcmplxA_brcvt_capcheck
+  (struct tcmplxA_brcvt const* ps, size_t freed, size_t needed);
+/**
+ * @brief Check whether the command fast path can pick up the state.
+ * @param ps Brotli state to check
+ * @return nonzero at the start of a command phase code or extra bits
+ */
+static int tcmplxA_brcvt_fast_ready(struct tcmplxA_brcvt const* ps);
+/**
+ * @brief Reverse the next fifteen bits of a bit window.
+ * @param window input bits, first bit least significant
+ * @return the bits, first bit most significant
+ */
+static unsigned tcmplxA_brcvt_fast_reverse(unsigned long long int window);
+/**
+ * @brief Decode and consume a prefix code from a bit window.
+ * @param forest the forest to use
+ * @param i index of the tree in the forest
+ * @param window bit window to read
+ * @param window_bits number of valid bits in the window
+ * @return the alphabet symbol on a match, UINT_MAX otherwise
+ */
+static unsigned tcmplxA_brcvt_fast_code
+  ( struct tcmplxA_gaspvec const* forest, size_t i,
+    unsigned long long int* window, unsigned* window_bits);
+/**
+ * @brief Move pending fast path literals into the slide ring.
+ * @param ps Brotli state to update
+ * @param dst output buffer
+ * @param[in,out] flushed count of output bytes already in the ring
+ * @param ret count of output bytes produced
+ */
+static void tcmplxA_brcvt_fast_flush(struct tcmplxA_brcvt* ps,
+  unsigned char const* dst, size_t* flushed, size_t ret);
+/**
+ * @brief Run the command phase from a 64-bit bit window.
+ * @param ps Brotli state to update
+ * @param[in,out] ret output byte count
+ * @param dst output buffer
+ * @param dstsz output buffer size
+ * @param[in,out] src read position; left at the byte holding the next
+ *   bit for the bit-serial states
+ * @param src_end end of input
+ * @return tcmplxA_Success to continue bit by bit, otherwise the result
+ *   the bit-serial states would give for the same input
+ * @note Stops short of the input and output edges, so the resumable
+ *   states always finish the buffers.
+ */
+static int tcmplxA_brcvt_zsrtostr_fast
+  ( struct tcmplxA_brcvt* ps, size_t* ret, unsigned char* dst, size_t dstsz,
+    unsigned char const** src, unsigned char const* src_end);
 
 
 /* BEGIN brcvt state / static */
 static int tcmplxA_brcvt_init
     ( struct tcmplxA_brcvt* x, tcmplxA_uint32 block_size,
-      tcmplxA_uint32 n, size_t chain_length)
+      tcmplxA_uint32 n, size_t chain_length,
+      struct tcmplxA_allocator const* alloc)
 {
   int res = tcmplxA_Success;
+  x->alloc = alloc;
+  x->memory_cap = 0u;
+  x->quick_tf = 0u;
+  x->stream_tf = 0u;
+  x->latency = 0u;
   if (n > 16777200u)
     n = 16777200u;
-  x->wbits_select = 24;
-  for (unsigned char i = 10; i < 24; ++i) {
-    if (n <= (1ul<<i)-16) {
-      x->wbits_select = i;
-      break;
-    }
-  }
   if (block_size >= 16777200u)
     block_size = 16777200u;
+  x->literal_types_max = tcmplxA_brcvt_literal_types_max(block_size);
   /* buffer */{
-    x->buffer = tcmplxA_blockbuf_new(block_size,n,chain_length, 0);
+    x->buffer =
+      tcmplxA_blockbuf_new_alloc(block_size,n,chain_length, 0, alloc);
     if (x->buffer == NULL)
       res = tcmplxA_ErrMemory;
+    else tcmplxA_blockbuf_set_recent(x->buffer, 1);
   }
   /* window size Huffman codes */{
-    x->wbits = tcmplxA_fixlist_new(15);
-    if (x->wbits == NULL)
-      res = tcmplxA_ErrMemory;
-    else
-      tcmplxA_fixlist_preset(x->wbits, tcmplxA_FixList_BrotliWBits);
+    x->wbits = tcmplxA_fixlist_preset_c(tcmplxA_FixList_BrotliWBits);
   }
   /* metadata storage */{
-    x->metadata = tcmplxA_brmeta_new(0);
+    x->metadata = tcmplxA_brmeta_new_alloc(0, alloc);
     if (x->metadata == NULL)
       res = tcmplxA_ErrMemory;
   }
   /* ring */{
-    x->ring = tcmplxA_ringdist_new(1,4u,0u);
+    x->ring = tcmplxA_ringdist_new_alloc(1,4u,0u, alloc);
     if (x->ring == NULL)
       res = tcmplxA_ErrMemory;
   }
   /* try_ring */{
-    x->try_ring = tcmplxA_ringdist_new(1,4u,0u);
+    x->try_ring = tcmplxA_ringdist_new_alloc(1,4u,0u, alloc);
     if (x->try_ring == NULL)
       res = tcmplxA_ErrMemory;
   }
   /* histogram */{
-    if (tcmplxA_brcvt_HistogramSize < ((size_t)-1)/sizeof(tcmplxA_uint32)) {
-      x->histogram = tcmplxA_util_malloc
-        (tcmplxA_brcvt_HistogramSize*sizeof(tcmplxA_uint32));
+    size_t const size = tcmplxA_brcvt_histogram_size(x->literal_types_max);
+    if (size < ((size_t)-1)/sizeof(tcmplxA_uint32)) {
+      x->histogram = tcmplxA_util_allocate
+        (alloc, size*sizeof(tcmplxA_uint32));
     } else x->histogram = NULL;
     if (x->histogram == NULL)
       res = tcmplxA_ErrMemory;
-  }
-  /* values */{
-    x->values = tcmplxA_inscopy_new(704u);
-    if (x->values == NULL)
+    else memset(x->histogram, 0, size*sizeof(tcmplxA_uint32));
+    x->context_histogram = NULL;
+    x->context_histogram_cap = 0u;
+    x->cluster_pairs_cap = tcmplxA_brcvt_cluster_pairs(block_size);
+    x->cluster_pairs = tcmplxA_util_allocate(alloc,
+      x->cluster_pairs_cap*sizeof(long int));
+    if (x->cluster_pairs == NULL)
       res = tcmplxA_ErrMemory;
-    else {
-      int const preset_ae =
-        tcmplxA_inscopy_preset(x->values, tcmplxA_InsCopy_BrotliIC);
-      if (preset_ae != tcmplxA_Success)
-        res = preset_ae;
-      else tcmplxA_inscopy_codesort(x->values);
-    }
+    x->distance_codes = NULL;
+    x->distance_codes_cap = 0u;
   }
-  /* blockcounts */{
-    x->blockcounts = tcmplxA_inscopy_new(26u);
-    if (x->blockcounts == NULL)
+  /* literal block split */{
+    size_t const cap = tcmplxA_brcvt_split_cap(block_size);
+    x->split.count = 0;
+    x->split.cap = cap;
+    x->split.offsets = tcmplxA_util_allocate(alloc,
+      cap*(2u*sizeof(tcmplxA_uint32)+sizeof(unsigned char)));
+    if (x->split.offsets == NULL) {
+      x->split.lengths = NULL;
+      x->split.types = NULL;
       res = tcmplxA_ErrMemory;
-    else {
-      int const preset_ae =
-        tcmplxA_inscopy_preset(x->blockcounts, tcmplxA_InsCopy_BrotliBlock);
-      if (preset_ae != tcmplxA_Success)
-        res = preset_ae;
-      else tcmplxA_inscopy_codesort(x->blockcounts);
+    } else {
+      x->split.lengths = x->split.offsets + cap;
+      x->split.types = (unsigned char*)(x->split.lengths + cap);
     }
   }
+  /* shared length tables */{
+    x->values = tcmplxA_inscopy_preset_c(tcmplxA_InsCopy_BrotliIC);
+    x->blockcounts = tcmplxA_inscopy_preset_c(tcmplxA_InsCopy_BrotliBlock);
+  }
   /* fixed prefix code ensemble */{
-    int const bltypesl_res = tcmplxA_fixlist_init(&x->literal_blocktype,0);
-    int const blcountl_res = tcmplxA_fixlist_init(&x->literal_blockcount,0);
-    int const bltypesi_res = tcmplxA_fixlist_init(&x->insert_blocktype,0);
-    int const blcounti_res = tcmplxA_fixlist_init(&x->insert_blockcount,0);
-    int const bltypesd_res = tcmplxA_fixlist_init(&x->distance_blocktype,0);
-    int const blcountd_res = tcmplxA_fixlist_init(&x->distance_blockcount,0);
-    int const context_tree_res = tcmplxA_fixlist_init(&x->context_tree,0);
+    int const bltypesl_res = tcmplxA_fixlist_init(&x->literal_blocktype,0,alloc);
+    int const blcountl_res = tcmplxA_fixlist_init(&x->literal_blockcount,0,alloc);
+    int const bltypesi_res = tcmplxA_fixlist_init(&x->insert_blocktype,0,alloc);
+    int const blcounti_res = tcmplxA_fixlist_init(&x->insert_blockcount,0,alloc);
+    int const bltypesd_res = tcmplxA_fixlist_init(&x->distance_blocktype,0,alloc);
+    int const blcountd_res = tcmplxA_fixlist_init(&x->distance_blockcount,0,alloc);
+    int const context_tree_res = tcmplxA_fixlist_init(&x->context_tree,0,alloc);
     x->treety = tcmplxA_brcvt_treety_zero;
-    memset(x->guess_lengths, 0, sizeof(x->guess_lengths));
+    x->treety.nineteen.alloc = alloc;
+    x->treety.sequence_list.alloc = alloc;
     assert(bltypesl_res == tcmplxA_Success);
     assert(blcountl_res == tcmplxA_Success);
     assert(bltypesi_res == tcmplxA_Success);
@@ -832,63 +1323,75 @@ static int tcmplxA_brcvt_init
     assert(context_tree_res == tcmplxA_Success);
   }
   if (res != tcmplxA_Success) {
-    tcmplxA_inscopy_destroy(x->blockcounts);
-    tcmplxA_inscopy_destroy(x->values);
-    tcmplxA_util_free(x->histogram);
+    tcmplxA_util_deallocate(x->alloc, x->split.offsets);
+    tcmplxA_util_deallocate(x->alloc, x->cluster_pairs);
+    tcmplxA_util_deallocate(x->alloc, x->histogram);
     tcmplxA_ringdist_destroy(x->try_ring);
     tcmplxA_ringdist_destroy(x->ring);
     tcmplxA_brmeta_destroy(x->metadata);
-    tcmplxA_fixlist_destroy(x->wbits);
     tcmplxA_blockbuf_destroy(x->buffer);
     return res;
   } else {
-    tcmplxA_blockstr_init(&x->context_encode, 0);
+    tcmplxA_blockstr_init(&x->context_encode, 0, alloc);
     x->literals_map = NULL;
     x->literals_forest = NULL;
+    x->literal_row = NULL;
+    x->literal_lut = NULL;
     x->distance_map = NULL;
     x->distance_forest = NULL;
     x->insert_forest = NULL;
     x->max_len_meta = 1024;
-    x->bits = 0u;
-    x->h_end = 0;
-    x->bit_length = 0u;
-    x->state = tcmplxA_BrCvt_WBits;
-    x->bit_index = 0u;
-    x->backward = 0u;
-    x->metablock_pos = 0u;
-    x->count = 0u;
-    x->write_scratch = 0u;
-    x->bit_cap = 0u;
-    x->emptymeta = 0u;
-    x->meta_index = 0u;
-    x->metatext = NULL;
-    x->blocktypeL_index = tcmplxA_brcvt_btype_zero;
-    x->blocktypeL_max = 0u;
-    x->blocktypeL_remaining = 0u;
-    x->blocktypeI_index = tcmplxA_brcvt_btype_zero;
-    x->blocktypeI_max = 0u;
-    x->blocktypeI_remaining = 0u;
-    x->blocktypeD_index = tcmplxA_brcvt_btype_zero;
-    x->blocktypeD_max = 0u;
-    x->blocktypeD_remaining = 0u;
-    x->rlemax = 0u;
-    x->blocktypeL_skip = tcmplxA_brcvt_NoSkip;
-    x->blockcountL_skip = tcmplxA_brcvt_NoSkip;
-    x->blocktypeI_skip = tcmplxA_brcvt_NoSkip;
-    x->blockcountI_skip = tcmplxA_brcvt_NoSkip;
-    x->blocktypeD_skip = tcmplxA_brcvt_NoSkip;
-    x->blockcountD_skip = tcmplxA_brcvt_NoSkip;
-    x->literal_skip = tcmplxA_brcvt_NoSkip;
-    x->insert_skip = tcmplxA_brcvt_NoSkip;
-    x->distance_skip = tcmplxA_brcvt_NoSkip;
-    x->context_skip = tcmplxA_brcvt_NoSkip;
-    x->fwd = tcmplxA_brcvt_fwd_zero;
-    memset(x->extra_bits, 0, 2*sizeof(tcmplxA_uint32));
-    memset(x->ctxt_mode_map, 0, 4*sizeof(unsigned char));
+    tcmplxA_brcvt_restart(x);
     return tcmplxA_Success;
   }
 }
 
+void tcmplxA_brcvt_restart(struct tcmplxA_brcvt* x) {
+  tcmplxA_uint32 const n = tcmplxA_blockbuf_extent(x->buffer);
+  x->wbits_select = 24;
+  for (unsigned char i = 10; i < 24; ++i) {
+    if (n <= (1ul<<i)-16) {
+      x->wbits_select = i;
+      break;
+    }
+  }
+  x->bits = 0u;
+  x->h_end = 0;
+  x->bit_length = 0u;
+  x->state = tcmplxA_BrCvt_WBits;
+  x->bit_index = 0u;
+  x->backward = 0u;
+  x->metablock_pos = 0u;
+  x->count = 0u;
+  x->write_scratch = 0u;
+  x->bit_cap = 0u;
+  x->emptymeta = 0u;
+  x->meta_index = 0u;
+  x->metatext = NULL;
+  x->blocktypeL_index = tcmplxA_brcvt_btype_zero;
+  x->blocktypeL_max = 0u;
+  x->blocktypeL_remaining = 0u;
+  x->blocktypeI_index = tcmplxA_brcvt_btype_zero;
+  x->blocktypeI_max = 0u;
+  x->blocktypeI_remaining = 0u;
+  x->blocktypeD_index = tcmplxA_brcvt_btype_zero;
+  x->blocktypeD_max = 0u;
+  x->blocktypeD_remaining = 0u;
+  x->rlemax = 0u;
+  x->blocktypeL_skip = tcmplxA_brcvt_NoSkip;
+  x->blockcountL_skip = tcmplxA_brcvt_NoSkip;
+  x->blocktypeI_skip = tcmplxA_brcvt_NoSkip;
+  x->blockcountI_skip = tcmplxA_brcvt_NoSkip;
+  x->blocktypeD_skip = tcmplxA_brcvt_NoSkip;
+  x->blockcountD_skip = tcmplxA_brcvt_NoSkip;
+  x->context_skip = tcmplxA_brcvt_NoSkip;
+  x->data_skips = 0u;
+  x->fwd = tcmplxA_brcvt_fwd_zero;
+  memset(x->extra_bits, 0, 2*sizeof(tcmplxA_uint32));
+  x->split.count = 0u;
+  return;
+}
+
 void tcmplxA_brcvt_close(struct tcmplxA_brcvt* x) {
   tcmplxA_brcvt_close19(&x->treety);
   tcmplxA_fixlist_close(&x->literal_blocktype);
@@ -898,13 +1401,14 @@ void tcmplxA_brcvt_close(struct tcmplxA_brcvt* x) {
   tcmplxA_fixlist_close(&x->distance_blocktype);
   tcmplxA_fixlist_close(&x->distance_blockcount);
   tcmplxA_fixlist_close(&x->context_tree);
-  tcmplxA_util_free(x->histogram);
+  tcmplxA_util_deallocate(x->alloc, x->split.offsets);
+  tcmplxA_util_deallocate(x->alloc, x->context_histogram);
+  tcmplxA_util_deallocate(x->alloc, x->cluster_pairs);
+  tcmplxA_util_deallocate(x->alloc, x->distance_codes);
+  tcmplxA_util_deallocate(x->alloc, x->histogram);
   tcmplxA_ringdist_destroy(x->try_ring);
   tcmplxA_ringdist_destroy(x->ring);
-  tcmplxA_inscopy_destroy(x->values);
-  tcmplxA_inscopy_destroy(x->blockcounts);
   tcmplxA_brmeta_destroy(x->metadata);
-  tcmplxA_fixlist_destroy(x->wbits);
   tcmplxA_blockbuf_destroy(x->buffer);
   tcmplxA_ctxtmap_destroy(x->literals_map);
   tcmplxA_gaspvec_destroy(x->literals_forest);
@@ -931,12 +1435,12 @@ void tcmplxA_brcvt_close(struct tcmplxA_brcvt* x) {
   x->blockcountI_skip = tcmplxA_brcvt_NoSkip;
   x->blocktypeD_skip = tcmplxA_brcvt_NoSkip;
   x->blockcountD_skip = tcmplxA_brcvt_NoSkip;
-  x->literal_skip = tcmplxA_brcvt_NoSkip;
-  x->insert_skip = tcmplxA_brcvt_NoSkip;
-  x->distance_skip = tcmplxA_brcvt_NoSkip;
   x->context_skip = tcmplxA_brcvt_NoSkip;
+  x->data_skips = 0u;
   x->literals_map = NULL;
   x->literals_forest = NULL;
+  x->literal_row = NULL;
+  x->literal_lut = NULL;
   x->distance_map = NULL;
   x->distance_forest = NULL;
   x->insert_forest = NULL;
@@ -972,7 +1476,6 @@ void tcmplxA_brcvt_accum_remain(struct tcmplxA_brcvt* ps, tcmplxA_uint32* sum, u
 }
 
 void tcmplxA_brcvt_reset_compress(struct tcmplxA_brcvt* ps) {
-  tcmplxA_inscopy_codesort(ps->blockcounts);
   ps->state = tcmplxA_BrCvt_BlockTypesL;
   ps->bit_length = 0;
   ps->count = 0;
@@ -983,9 +1486,7 @@ void tcmplxA_brcvt_reset_compress(struct tcmplxA_brcvt* ps) {
   ps->blockcountI_skip = tcmplxA_brcvt_NoSkip;
   ps->blocktypeD_skip = tcmplxA_brcvt_NoSkip;
   ps->blockcountD_skip = tcmplxA_brcvt_NoSkip;
-  ps->literal_skip = tcmplxA_brcvt_NoSkip;
-  ps->insert_skip = tcmplxA_brcvt_NoSkip;
-  ps->distance_skip = tcmplxA_brcvt_NoSkip;
+  ps->data_skips = 0u;
 }
 
 struct tcmplxA_gaspvec* tcmplxA_brcvt_active_forest(struct tcmplxA_brcvt const* ps) {
@@ -1018,13 +1519,52 @@ static enum tcmplxA_brcvt_istate tcmplxA_brcvt_outflow_extra(unsigned state) {
 }
 
 
-unsigned short* tcmplxA_brcvt_active_skip(struct tcmplxA_brcvt* ps) {
+void tcmplxA_brcvt_literal_select(struct tcmplxA_brcvt* ps) {
+  size_t const btype = ps->blocktypeL_index.current;
+  ps->literal_row = tcmplxA_ctxtmap_row(ps->literals_map, btype);
+  ps->literal_lut = tcmplxA_ctxtmap_literal_lut
+    (tcmplxA_ctxtmap_get_mode(ps->literals_map, btype));
+  return;
+}
+
+unsigned tcmplxA_brcvt_literal_tree(struct tcmplxA_brcvt const* ps) {
+  unsigned char const* const lut = ps->literal_lut;
+  return ps->literal_row[lut[ps->fwd.literal_ctxt[1]]
+    | lut[256+ps->fwd.literal_ctxt[0]]];
+}
+
+unsigned tcmplxA_brcvt_distance_tree(struct tcmplxA_brcvt const* ps) {
+  int const column = tcmplxA_ctxtmap_distance_context(ps->fwd.literal_total);
+  return (unsigned)tcmplxA_ctxtmap_get
+    (ps->distance_map, ps->blocktypeD_index.current, column);
+}
+
+unsigned short tcmplxA_brcvt_data_skip(struct tcmplxA_brcvt const* ps) {
+  unsigned short skip;
   switch (ps->state) {
-  case tcmplxA_BrCvt_GaspVectorI: return &ps->insert_skip;
-  case tcmplxA_BrCvt_GaspVectorD: return &ps->distance_skip;
-  case tcmplxA_BrCvt_GaspVectorL:
-  default: return &ps->literal_skip;
+  case tcmplxA_BrCvt_DataInsertCopy:
+    if (!(ps->data_skips & 2u))
+      return tcmplxA_brcvt_NoSkip;
+    skip = tcmplxA_gaspvec_get_skip(ps->insert_forest,
+      ps->blocktypeI_index.current);
+    break;
+  case tcmplxA_BrCvt_Literal:
+    if (!(ps->data_skips & 1u))
+      return tcmplxA_brcvt_NoSkip;
+    skip = tcmplxA_gaspvec_get_skip(ps->literals_forest,
+      tcmplxA_brcvt_literal_tree(ps));
+    break;
+  case tcmplxA_BrCvt_Distance:
+    if (!(ps->data_skips & 4u))
+      return tcmplxA_brcvt_NoSkip;
+    skip = tcmplxA_gaspvec_get_skip(ps->distance_forest,
+      tcmplxA_brcvt_distance_tree(ps));
+    break;
+  default:
+    return tcmplxA_brcvt_NoSkip;
   }
+  /* trees out of range have no symbol to skip to */
+  return skip == USHRT_MAX ? tcmplxA_brcvt_NoSkip : skip;
 }
 
 unsigned tcmplxA_brcvt_inflow_lookup(struct tcmplxA_brcvt* ps,
@@ -1043,6 +1583,33 @@ unsigned tcmplxA_brcvt_inflow_lookup(struct tcmplxA_brcvt* ps,
   return (unsigned)tcmplxA_fixlist_at_c(tree, line_index)->value;
 }
 
+unsigned tcmplxA_brcvt_inflow_gasp(struct tcmplxA_brcvt* ps,
+  struct tcmplxA_gaspvec const* forest, size_t i, unsigned x)
+{
+  if (ps->bit_length >= 15) {
+    ps->state = tcmplxA_BrCvt_BadToken;
+    return UINT_MAX;
+  }
+  ps->bits = (ps->bits<<1)|x;
+  ps->bit_length += 1;
+  return tcmplxA_gaspvec_decode(forest, i, ps->bit_length, ps->bits);
+}
+
+unsigned tcmplxA_brcvt_inflow_peek(struct tcmplxA_brcvt* ps,
+  struct tcmplxA_gaspvec const* forest, size_t i, unsigned window,
+  unsigned n)
+{
+  unsigned len = 0u;
+  unsigned const bits = tcmplxA_brcvt_fast_reverse(window);
+  unsigned const line = tcmplxA_gaspvec_peek(forest, i, bits, &len);
+  /* codes are prefix-free, so a match inside the buffer is the match */
+  if (line == UINT_MAX || len > n)
+    return UINT_MAX;
+  ps->bits = bits >> (15u-len);
+  ps->bit_length = (unsigned char)len;
+  return line;
+}
+
 struct tcmplxA_brcvt_block tcmplxA_brcvt_switch_blocktype(struct tcmplxA_brcvt_block box,
     unsigned char max_value, unsigned cmd)
 {
@@ -1073,7 +1640,8 @@ static int tcmplxA_brcvt_land_insert_copy(struct tcmplxA_brcvt* ps, int* end) {
       return tcmplxA_brcvt_meta_endcode(ps);
     }
     ps->bit_length = 0;
-    ps->state = (ps->blocktypeD_remaining
+    /* an implicit zero distance reads no code, so no block switch */
+    ps->state = (ps->blocktypeD_remaining || ps->fwd.ctxt_i
       ? tcmplxA_BrCvt_Distance : tcmplxA_BrCvt_DistanceRestart);
     ps->fwd.literal_i = 0;
     ps->fwd.literal_total = ps->fwd.stop;
@@ -1137,9 +1705,14 @@ int tcmplxA_brcvt_inflow_distextra(struct tcmplxA_brcvt* ps) {
     text = tcmplxA_bdict_get_word(size, index);
     if (!text)
       return tcmplxA_ErrSanitize;
-    memcpy(ps->fwd.bstore, text, size);
-    if (tcmplxA_bdict_transform(ps->fwd.bstore, &size, transform) != tcmplxA_Success)
+    if (transform == 0u) {
+      /* identity: emit straight from the dictionary */
+      ps->fwd.bword = text;
+    } else if (tcmplxA_bdict_transform_copy
+        (ps->fwd.bstore, &size, text, size, transform) != tcmplxA_Success)
+    {
       return tcmplxA_ErrSanitize;
+    } else ps->fwd.bword = NULL;
     ps->fwd.literal_total = size;
   }
   return tcmplxA_ErrPartial;
@@ -1207,12 +1780,34 @@ int tcmplxA_brcvt_inflow_do_copy(struct tcmplxA_brcvt* ps,
   size_t* ret, unsigned char* dst, size_t dstsz)
 {
   struct tcmplxA_brcvt_forward* const fwd = &ps->fwd;
+  if (ps->state == tcmplxA_BrCvt_DoCopy && fwd->pos > 0u && fwd->pos <= *ret
+    && fwd->literal_i < fwd->literal_total
+    && fwd->literal_total - fwd->literal_i <= dstsz - *ret
+    && fwd->pos <= tcmplxA_blockbuf_ring_size(ps->buffer))
+  {
+    /* source bytes are still in the output buffer */
+    size_t const n = fwd->literal_total - fwd->literal_i;
+    unsigned char* const out = dst + *ret;
+    unsigned char const* const from = out - fwd->pos;
+    size_t j;
+    for (j = 0u; j < n; ++j)
+      out[j] = from[j];
+    tcmplxA_blockbuf_bypass(ps->buffer, out, n);
+    fwd->accum += (tcmplxA_uint32)n;
+    ps->metablock_pos += (tcmplxA_uint32)n;
+    *ret += n;
+    fwd->literal_i = fwd->literal_total;
+    fwd->literal_ctxt[0] = (n > 1u) ? out[n-2u] : fwd->literal_ctxt[1];
+    fwd->literal_ctxt[1] = out[n-1u];
+  } else if (ps->state == tcmplxA_BrCvt_BDict) {
+    int const res = tcmplxA_brcvt_inflow_bdict(ps, ret, dst, dstsz);
+    if (res != tcmplxA_Success)
+      return res;
+  }
   for (; fwd->literal_i < fwd->literal_total; ++fwd->literal_i) {
     unsigned char ch_byte = 0;
     if (*ret >= dstsz)
       return tcmplxA_ErrPartial;
-    else if (ps->state == tcmplxA_BrCvt_BDict)
-      ch_byte = fwd->bstore[fwd->literal_i];
     else if (ps->fwd.pos > tcmplxA_blockbuf_ring_size(ps->buffer))
       return tcmplxA_ErrOutOfRange;
     else
@@ -1227,27 +1822,60 @@ int tcmplxA_brcvt_inflow_do_copy(struct tcmplxA_brcvt* ps,
   return tcmplxA_Success;
 }
 
+int tcmplxA_brcvt_inflow_bdict(struct tcmplxA_brcvt* ps,
+  size_t* ret, unsigned char* dst, size_t dstsz)
+{
+  struct tcmplxA_brcvt_forward* const fwd = &ps->fwd;
+  unsigned char const* const word = fwd->bword ? fwd->bword : fwd->bstore;
+  size_t const room = dstsz - *ret;
+  size_t n;
+  unsigned char* out;
+  if (fwd->literal_total > sizeof(fwd->bstore))
+    return tcmplxA_ErrSanitize;
+  else if (fwd->literal_i >= fwd->literal_total)
+    return tcmplxA_Success;
+  n = fwd->literal_total - fwd->literal_i;
+  if (n > room)
+    n = room;
+  if (n == 0u)
+    return tcmplxA_ErrPartial;
+  out = dst + *ret;
+  memcpy(out, word + fwd->literal_i, n);
+  tcmplxA_blockbuf_bypass(ps->buffer, out, n);
+  fwd->accum += (tcmplxA_uint32)n;
+  ps->metablock_pos += (tcmplxA_uint32)n;
+  *ret += n;
+  fwd->literal_i += (tcmplxA_uint32)n;
+  fwd->literal_ctxt[0] = (n > 1u) ? out[n-2u] : fwd->literal_ctxt[1];
+  fwd->literal_ctxt[1] = out[n-1u];
+  return (fwd->literal_i < fwd->literal_total)
+    ? tcmplxA_ErrPartial : tcmplxA_Success;
+}
+
 int tcmplxA_brcvt_handle_inskip(struct tcmplxA_brcvt* ps,
   size_t* ret, unsigned char* dst, size_t dstsz)
 {
   int skip = 1;
   long int repeat;
-  struct tcmplxA_brcvt_forward *const fwd = &ps->fwd;
   for (repeat = 0; repeat < 134217728L && skip; ++repeat) {
     switch (ps->state) {
     case tcmplxA_BrCvt_DataInsertCopy:
-      if (ps->insert_skip != tcmplxA_brcvt_NoSkip) {
-        int const res = tcmplxA_brcvt_inflow_insert(ps, ps->insert_skip);
-        tcmplxA_brcvt_countbits(0, 0, "[[INSCOPY %u]]", ps->insert_skip);
+      {
+        unsigned short const skip = tcmplxA_brcvt_data_skip(ps);
+        int res;
+        if (skip == tcmplxA_brcvt_NoSkip)
+          return tcmplxA_Success;
+        res = tcmplxA_brcvt_inflow_insert(ps, skip);
+        tcmplxA_brcvt_countbits(0, 0, "[[INSCOPY %u]]", skip);
         if (res != tcmplxA_Success)
           return res;
         continue;
-      } else return tcmplxA_Success;
+      }
     case tcmplxA_BrCvt_Literal:
       if (ps->fwd.literal_i >= ps->fwd.literal_total) {
         if (tcmplxA_brcvt_metaterm(ps, 1))
           return tcmplxA_brcvt_meta_endcode(ps);
-        ps->state = (ps->blocktypeD_remaining
+        ps->state = (ps->blocktypeD_remaining || ps->fwd.ctxt_i
           ? tcmplxA_BrCvt_Distance : tcmplxA_BrCvt_DistanceRestart);
         ps->fwd.literal_i = 0;
         ps->fwd.literal_total = ps->fwd.stop;
@@ -1257,15 +1885,18 @@ int tcmplxA_brcvt_handle_inskip(struct tcmplxA_brcvt* ps,
         tcmplxA_brcvt_countbits(0, 0, "[[-> distance%s]]",
           ps->state == tcmplxA_BrCvt_Distance ? "" : "-restart");
         continue;
-      } else if (ps->literal_skip != tcmplxA_brcvt_NoSkip) {
+      } else {
+        unsigned short const skip = tcmplxA_brcvt_data_skip(ps);
+        if (skip == tcmplxA_brcvt_NoSkip)
+          return tcmplxA_Success;
         if (*ret >= dstsz)
           return tcmplxA_ErrPartial;
-        tcmplxA_brcvt_inflow_literal(ps, ps->literal_skip, ret, dst, dstsz);
-        tcmplxA_brcvt_countbits(0, 0, "[[LITERAL %u]]", ps->literal_skip);
+        tcmplxA_brcvt_inflow_literal(ps, skip, ret, dst, dstsz);
+        tcmplxA_brcvt_countbits(0, 0, "[[LITERAL %u]]", skip);
         ps->fwd.literal_i += 1;
         tcmplxA_brcvt_dec_literal_rem(ps);
         continue;
-      } else return tcmplxA_Success;
+      }
     case tcmplxA_BrCvt_Distance:
       if (ps->fwd.ctxt_i) {
         int const res = tcmplxA_brcvt_inflow_distance(ps, 0);
@@ -1274,24 +1905,34 @@ int tcmplxA_brcvt_handle_inskip(struct tcmplxA_brcvt* ps,
         if (res == tcmplxA_Success)
           return res;
         continue;
-      } else if (ps->distance_skip != tcmplxA_brcvt_NoSkip) {
-        int const res = tcmplxA_brcvt_inflow_distance(ps, ps->distance_skip);
+      } else {
+        unsigned short const skip = tcmplxA_brcvt_data_skip(ps);
+        int res;
+        if (skip == tcmplxA_brcvt_NoSkip)
+          return tcmplxA_Success;
+        res = tcmplxA_brcvt_inflow_distance(ps, skip);
         ps->blocktypeD_remaining -= 1;
-        tcmplxA_brcvt_countbits(0, 0, "[[DIST %u]]", ps->distance_skip);
+        tcmplxA_brcvt_countbits(0, 0, "[[DIST %u]]", skip);
         if (res == tcmplxA_Success)
           return res;
         continue;
-      } else return tcmplxA_Success;
+      }
     case tcmplxA_BrCvt_DoCopy:
-      return tcmplxA_brcvt_inflow_do_copy(ps, ret, dst, dstsz);
+      {
+        int const res = tcmplxA_brcvt_inflow_do_copy(ps, ret, dst, dstsz);
+        if (res != tcmplxA_Success || ps->state == tcmplxA_BrCvt_DoCopy)
+          return res;
+        /* the next command may start on a zero-bit tree */
+        continue;
+      }
     case tcmplxA_BrCvt_BDict:
-      if (fwd->literal_total > sizeof(fwd->bstore))
-        return tcmplxA_ErrSanitize;
-      for (; fwd->literal_i < fwd->literal_total; ++fwd->literal_i) {
-        if (*ret >= dstsz)
-          return tcmplxA_ErrPartial;
-        tcmplxA_brcvt_inflow_literal(ps, fwd->bstore[fwd->literal_i], ret, dst, dstsz);
+      {
+        int const res = tcmplxA_brcvt_inflow_bdict(ps, ret, dst, dstsz);
+        if (res != tcmplxA_Success)
+          return res;
       }
+      if (tcmplxA_brcvt_metaterm(ps, 1))
+        return tcmplxA_brcvt_meta_endcode(ps);
       ps->bit_length = 0;
       ps->state = (ps->blocktypeI_remaining ? tcmplxA_BrCvt_DataInsertCopy
         : tcmplxA_BrCvt_InsertRestart);
@@ -1345,6 +1986,7 @@ int tcmplxA_brcvt_handle_inskip(struct tcmplxA_brcvt* ps,
         return tcmplxA_Success;
       tcmplxA_brcvt_countbits(0, 0, "[literal-restart %u]", ps->blocktypeL_skip);
       ps->blocktypeL_index = tcmplxA_brcvt_switch_blocktype(ps->blocktypeL_index, ps->blocktypeL_max, ps->blocktypeL_skip);
+      tcmplxA_brcvt_literal_select(ps);
       ps->state = tcmplxA_BrCvt_LiteralRecount;
       ps->extra_length = 0;
       break;
@@ -1374,20 +2016,261 @@ static int tcmplxA_brcvt_inflow_restart(struct tcmplxA_brcvt* ps, struct tcmplxA
   return 1;
 }
 
-static int tcmplxA_brcvt_zsrtostr_bits
-  ( struct tcmplxA_brcvt* ps, unsigned int y,
-    size_t* ret, unsigned char* dst, size_t dstsz)
+int tcmplxA_brcvt_fast_ready(struct tcmplxA_brcvt const* ps) {
+  /*
+   * A zero-bit symbol left pending by a full output buffer sits on a
+   * bit that the bit-serial states expect to read again.
+   */
+  switch (ps->state) {
+  case tcmplxA_BrCvt_DataInsertCopy:
+  case tcmplxA_BrCvt_Literal:
+    return ps->bit_length == 0u
+      && tcmplxA_brcvt_data_skip(ps) == tcmplxA_brcvt_NoSkip;
+  case tcmplxA_BrCvt_Distance:
+    return ps->bit_length == 0u && !ps->fwd.ctxt_i
+      && tcmplxA_brcvt_data_skip(ps) == tcmplxA_brcvt_NoSkip;
+  case tcmplxA_BrCvt_DataInsertExtra:
+  case tcmplxA_BrCvt_DataCopyExtra:
+  case tcmplxA_BrCvt_DataDistanceExtra:
+    return ps->count == 0u;
+  default:
+    return 0;
+  }
+}
+
+unsigned tcmplxA_brcvt_fast_reverse(unsigned long long int window) {
+  unsigned v = (unsigned)(window & 0x7fffu);
+  v = ((v>>1)&0x5555u) | ((v&0x5555u)<<1);
+  v = ((v>>2)&0x3333u) | ((v&0x3333u)<<2);
+  v = ((v>>4)&0x0f0fu) | ((v&0x0f0fu)<<4);
+  v = ((v>>8)&0x00ffu) | ((v&0x00ffu)<<8);
+  return v>>1;
+}
+
+unsigned tcmplxA_brcvt_fast_code
+  ( struct tcmplxA_gaspvec const* forest, size_t i,
+    unsigned long long int* window, unsigned* window_bits)
 {
-  unsigned int i;
-  int ae = tcmplxA_Success;
+  unsigned len = 0u;
+  unsigned const line = tcmplxA_gaspvec_peek
+    (forest, i, tcmplxA_brcvt_fast_reverse(*window), &len);
+  if (line != UINT_MAX) {
+    *window >>= len;
+    *window_bits -= len;
+  }
+  return line;
+}
+
+void tcmplxA_brcvt_fast_flush(struct tcmplxA_brcvt* ps,
+  unsigned char const* dst, size_t* flushed, size_t ret)
+{
+  size_t const n = ret - *flushed;
+  if (n == 0u)
+    return;
+  tcmplxA_blockbuf_bypass(ps->buffer, dst + *flushed, n);
+  ps->fwd.accum += (tcmplxA_uint32)n;
+  ps->metablock_pos += (tcmplxA_uint32)n;
+  *flushed = ret;
+  return;
+}
+
+int tcmplxA_brcvt_zsrtostr_fast
+  ( struct tcmplxA_brcvt* ps, size_t* ret, unsigned char* dst, size_t dstsz,
+    unsigned char const** src, unsigned char const* src_end)
+{
+  unsigned char const* const start = *src;
+  unsigned char const* p = start;
+  unsigned long long int window;
+  unsigned window_bits;
   size_t ret_out = *ret;
-  for (i = ps->bit_index; i < 8u && ae == tcmplxA_Success; ++i) {
-    unsigned int x = (y>>i)&1u;
+  size_t flushed = ret_out;
+  size_t pos;
+  unsigned const bit_start = ps->bit_index;
+  int ae = tcmplxA_Success;
+  window = (*p) >> bit_start;
+  window_bits = 8u - bit_start;
+  p += 1;
+  for (;;) {
+    int step_ok = 1;
+    for (; window_bits <= 56u && p < src_end; ++p) {
+      window |= ((unsigned long long int)(*p)) << window_bits;
+      window_bits += 8u;
+    }
+    if (window_bits < tcmplxA_brcvt_FastStep
+    ||  dstsz - ret_out < tcmplxA_brcvt_FastOutput)
+      break;
+    switch (ps->state) {
+    case tcmplxA_BrCvt_DataInsertCopy:
+      {
+        unsigned line;
+        tcmplxA_brcvt_fast_flush(ps, dst, &flushed, ret_out);
+        line = tcmplxA_brcvt_fast_code(ps->insert_forest,
+          ps->blocktypeI_index.current, &window, &window_bits);
+        if (line >= 704) {
+          step_ok = 0;
+          break;
+        }
+        tcmplxA_brcvt_countbits(0, 0, "insert-and-copy %u", line);
+        tcmplxA_brcvt_inflow_insert(ps, line);
+      } break;
+    case tcmplxA_BrCvt_DataInsertExtra:
+      {
+        unsigned const n = ps->extra_length&31u;
+        int end = 0;
+        tcmplxA_brcvt_fast_flush(ps, dst, &flushed, ret_out);
+        ps->fwd.literal_total +=
+          (tcmplxA_uint32)(window & ((1ul<<n)-1u));
+        window >>= n;
+        window_bits -= n;
+        tcmplxA_brcvt_countbits(0, 0, "insert-extra");
+        ps->extra_length >>= 5;
+        ps->bits = 0;
+        ps->count = 0;
+        if (ps->extra_length > 0)
+          ps->state = tcmplxA_BrCvt_DataCopyExtra;
+        else {
+          ps->state = tcmplxA_BrCvt_Literal;
+          ae = tcmplxA_brcvt_land_insert_copy(ps, &end);
+        }
+      } break;
+    case tcmplxA_BrCvt_DataCopyExtra:
+      {
+        unsigned const n = ps->extra_length;
+        int end = 0;
+        if (n > tcmplxA_brcvt_FastExtraMax) {
+          step_ok = 0;
+          break;
+        }
+        tcmplxA_brcvt_fast_flush(ps, dst, &flushed, ret_out);
+        ps->fwd.stop += (tcmplxA_uint32)(window & ((1ul<<n)-1u));
+        window >>= n;
+        window_bits -= n;
+        tcmplxA_brcvt_countbits(0, 0, "copy-extra");
+        ps->bits = 0;
+        ps->state = tcmplxA_BrCvt_Literal;
+        ae = tcmplxA_brcvt_land_insert_copy(ps, &end);
+      } break;
+    case tcmplxA_BrCvt_Literal:
+      if (ps->fwd.literal_i >= ps->fwd.literal_total) {
+        tcmplxA_brcvt_fast_flush(ps, dst, &flushed, ret_out);
+        break;
+      } else {
+        unsigned const index = tcmplxA_brcvt_literal_tree(ps);
+        unsigned const line = tcmplxA_brcvt_fast_code(ps->literals_forest,
+          index, &window, &window_bits);
+        if (line >= 256) {
+          /* a tree without bits leaves the literal to the skip handler */
+          tcmplxA_brcvt_fast_flush(ps, dst, &flushed, ret_out);
+          step_ok = (tcmplxA_gaspvec_get_skip(ps->literals_forest, index)
+            != tcmplxA_brcvt_NoSkip);
+          break;
+        }
+        tcmplxA_brcvt_countbits(0, 0, "literal %u (tree %u)", line, index);
+        dst[ret_out++] = (unsigned char)line;
+        ps->fwd.literal_ctxt[0] = ps->fwd.literal_ctxt[1];
+        ps->fwd.literal_ctxt[1] = (unsigned char)line;
+        ps->fwd.literal_i ++;
+        tcmplxA_brcvt_dec_literal_rem(ps);
+        ps->bit_length = 0;
+        ps->bits = 0;
+        /* the next literal's tree may have no bits, given the context */
+        if (ps->state == tcmplxA_BrCvt_Literal
+        &&  ps->fwd.literal_i < ps->fwd.literal_total
+        &&  tcmplxA_brcvt_data_skip(ps) == tcmplxA_brcvt_NoSkip)
+          continue;
+        tcmplxA_brcvt_fast_flush(ps, dst, &flushed, ret_out);
+      } break;
+    case tcmplxA_BrCvt_Distance:
+    case tcmplxA_BrCvt_DataDistanceExtra:
+      {
+        tcmplxA_uint32 const copy_max = (ps->fwd.literal_total
+            < sizeof(ps->fwd.bstore))
+          ? (tcmplxA_uint32)sizeof(ps->fwd.bstore) : ps->fwd.literal_total;
+        int res = tcmplxA_Success;
+        tcmplxA_brcvt_fast_flush(ps, dst, &flushed, ret_out);
+        if (dstsz - ret_out < copy_max) {
+          step_ok = 0;
+          break;
+        } else if (ps->state == tcmplxA_BrCvt_Distance) {
+          unsigned line;
+          if (ps->fwd.ctxt_i
+          ||  tcmplxA_brcvt_data_skip(ps) != tcmplxA_brcvt_NoSkip)
+            break;
+          line = tcmplxA_brcvt_fast_code(ps->distance_forest,
+            tcmplxA_brcvt_distance_tree(ps), &window, &window_bits);
+          if (line >= 520) {
+            step_ok = 0;
+            break;
+          }
+          tcmplxA_brcvt_countbits(0, 0, "distance-code %u", line);
+          res = tcmplxA_brcvt_inflow_distance(ps, line);
+          ps->blocktypeD_remaining -= 1;
+        } else if (ps->extra_length > tcmplxA_brcvt_FastExtraMax) {
+          step_ok = 0;
+          break;
+        } else {
+          unsigned const n = ps->extra_length;
+          ps->bits = (tcmplxA_uint32)(window & ((1ul<<n)-1u));
+          window >>= n;
+          window_bits -= n;
+          res = tcmplxA_brcvt_inflow_distextra(ps);
+          tcmplxA_brcvt_countbits(0, 0, "distance-extra %u", ps->bits);
+          ps->extra_length = 0;
+          ps->bit_length = 0;
+          ps->bits = 0;
+          ps->count = 0;
+          if (res != tcmplxA_ErrPartial)
+            ae = res;
+        }
+        if (res == tcmplxA_ErrPartial) {
+          ae = tcmplxA_brcvt_inflow_do_copy(ps, &ret_out, dst, dstsz);
+          flushed = ret_out;
+        }
+      } break;
+    default:
+      step_ok = 0;
+      break;
+    }
+    if (!step_ok || ae != tcmplxA_Success)
+      break;
+    ae = tcmplxA_brcvt_handle_inskip(ps, &ret_out, dst, dstsz);
+    flushed = ret_out;
+    if (ae != tcmplxA_Success)
+      break;
+  }
+  tcmplxA_brcvt_fast_flush(ps, dst, &flushed, ret_out);
+  /* hand the read position back to the bit-serial states */
+  pos = (size_t)(p - start)*8u - window_bits;
+  if (ae == tcmplxA_ErrPartial) {
+    /* the last bit read is fed again, like the bit-serial states do */
+    if (pos > bit_start)
+      pos -= 1u;
+  } else if (ae != tcmplxA_Success) {
+    /* the byte holding the last bit read counts as used up */
+    pos = (pos+7u) & ~(size_t)7u;
+  }
+  *src = start + pos/8u;
+  ps->bit_index = (unsigned char)(pos&7u);
+  *ret = ret_out;
+  return ae;
+}
+
+static int tcmplxA_brcvt_zsrtostr_bits
+  ( struct tcmplxA_brcvt* ps, unsigned char const** src,
+    unsigned char const* src_end,
+    size_t* ret, unsigned char* dst, size_t dstsz)
+{
+  unsigned char const* const p = *src;
+  /* the next byte, if any, lets whole prefix codes be read at once */
+  unsigned int const y_bits = (src_end - p > 1) ? 16u : 8u;
+  unsigned int const y = (y_bits > 8u) ? p[0] | (p[1]<<8) : p[0];
+  unsigned int i;
+  int ae = tcmplxA_Success;
+  size_t ret_out = *ret;
+  for (i = ps->bit_index; i < 8u && ae == tcmplxA_Success; ++i) {
+    unsigned int x = (y>>i)&1u;
     switch (ps->state) {
     case tcmplxA_BrCvt_WBits: /* WBITS */
-      if (ps->bit_length == 0) {
-        tcmplxA_fixlist_codesort(ps->wbits);
-      }
       if (ps->bit_length < 7u) {
         size_t j;
         ps->bits = (ps->bits<<1) | x;
@@ -1396,8 +2279,14 @@ static int tcmplxA_brcvt_zsrtostr_bits
           (ps->wbits, ps->bit_length, ps->bits);
         if (j < 16) {
           ps->wbits_select =
-            (unsigned char)tcmplxA_fixlist_at(ps->wbits, j)->value;
+            (unsigned char)tcmplxA_fixlist_at_c(ps->wbits, j)->value;
           tcmplxA_brcvt_countbits(ps->bits, ps->bit_length, "WBITS %i", ps->wbits_select);
+          if (ps->memory_cap > 0u
+          &&  (1ul<<ps->wbits_select)-16u > tcmplxA_blockbuf_extent(ps->buffer))
+          {
+            ae = tcmplxA_ErrMemoryCap;
+            break;
+          }
           ps->state = tcmplxA_BrCvt_LastCheck;
           ps->bit_length = 0;
           break;
@@ -1554,12 +2443,19 @@ static int tcmplxA_brcvt_zsrtostr_bits
           ps->state += 1;
           ps->blocktypeL_max = (unsigned char)(alphasize-1u);
         }
+        ae = tcmplxA_brcvt_capcheck(ps,
+          ps->literals_map ? tcmplxA_ctxtmap_memory_usage(ps->literals_map) : 0u,
+          tcmplxA_ctxtmap_memory_bound(ps->treety.count, 64));
+        if (ae != tcmplxA_Success)
+          break;
         tcmplxA_ctxtmap_destroy(ps->literals_map);
-        ps->literals_map = tcmplxA_ctxtmap_new(ps->treety.count, 64);
+        ps->literals_map = tcmplxA_ctxtmap_new_alloc(ps->treety.count, 64, ps->alloc);
         if (!ps->literals_map) {
           ae = tcmplxA_ErrMemory;
           break;
         }
+        /* block type codes add two symbols to the type count */
+        ps->treety.count = (unsigned short)(ps->treety.count + 2u);
       } break;
     case tcmplxA_BrCvt_BlockTypesLAlpha:
       {
@@ -1568,6 +2464,7 @@ static int tcmplxA_brcvt_zsrtostr_bits
         if (res == tcmplxA_EOF) {
           ps->blocktypeL_skip = tcmplxA_brcvt_resolve_skip(&ps->literal_blocktype);
           tcmplxA_brcvt_reset19(&ps->treety);
+          ps->treety.count = 26;
           ps->state += 1;
         } else if (res != tcmplxA_Success)
           ae = res;
@@ -1633,12 +2530,19 @@ static int tcmplxA_brcvt_zsrtostr_bits
           ps->state += 1;
           ps->blocktypeI_max = (unsigned char)(alphasize-1u);
         }
+        ae = tcmplxA_brcvt_capcheck(ps,
+          ps->insert_forest ? tcmplxA_gaspvec_memory_usage(ps->insert_forest) : 0u,
+          tcmplxA_gaspvec_memory_bound(ps->treety.count, 704u));
+        if (ae != tcmplxA_Success)
+          break;
         tcmplxA_gaspvec_destroy(ps->insert_forest);
-        ps->insert_forest = tcmplxA_gaspvec_new(ps->treety.count);
+        ps->insert_forest = tcmplxA_gaspvec_new_alloc(ps->treety.count, ps->alloc);
         if (!ps->insert_forest) {
           ae = tcmplxA_ErrMemory;
           break;
         }
+        /* block type codes add two symbols to the type count */
+        ps->treety.count = (unsigned short)(ps->treety.count + 2u);
       } break;
     case tcmplxA_BrCvt_BlockTypesIAlpha:
       {
@@ -1647,6 +2551,7 @@ static int tcmplxA_brcvt_zsrtostr_bits
         if (res == tcmplxA_EOF) {
           ps->blocktypeI_skip = tcmplxA_brcvt_resolve_skip(&ps->insert_blocktype);
           tcmplxA_brcvt_reset19(&ps->treety);
+          ps->treety.count = 26;
           ps->state += 1;
         } else if (res != tcmplxA_Success)
           ae = res;
@@ -1712,12 +2617,19 @@ static int tcmplxA_brcvt_zsrtostr_bits
           ps->state += 1;
           ps->blocktypeD_max = (unsigned char)(alphasize-1u);
         }
+        ae = tcmplxA_brcvt_capcheck(ps,
+          ps->distance_map ? tcmplxA_ctxtmap_memory_usage(ps->distance_map) : 0u,
+          tcmplxA_ctxtmap_memory_bound(ps->treety.count, 4));
+        if (ae != tcmplxA_Success)
+          break;
         tcmplxA_ctxtmap_destroy(ps->distance_map);
-        ps->distance_map = tcmplxA_ctxtmap_new(ps->treety.count, 4);
+        ps->distance_map = tcmplxA_ctxtmap_new_alloc(ps->treety.count, 4, ps->alloc);
         if (!ps->distance_map) {
           ae = tcmplxA_ErrMemory;
           break;
         }
+        /* block type codes add two symbols to the type count */
+        ps->treety.count = (unsigned short)(ps->treety.count + 2u);
       } break;
     case tcmplxA_BrCvt_BlockTypesDAlpha:
       {
@@ -1726,6 +2638,7 @@ static int tcmplxA_brcvt_zsrtostr_bits
         if (res == tcmplxA_EOF) {
           ps->blocktypeD_skip = tcmplxA_brcvt_resolve_skip(&ps->distance_blocktype);
           tcmplxA_brcvt_reset19(&ps->treety);
+          ps->treety.count = 26;
           ps->state += 1;
         } else if (res != tcmplxA_Success)
           ae = res;
@@ -1821,8 +2734,15 @@ static int tcmplxA_brcvt_zsrtostr_bits
           break;
         }
         tcmplxA_brcvt_countbits(ps->bits, ps->bit_length, "NTREES%c %u", literal?'L':'D', alphasize);
+        ae = tcmplxA_brcvt_capcheck(ps,
+          *forest_ptr ? tcmplxA_gaspvec_memory_usage(*forest_ptr) : 0u,
+          tcmplxA_gaspvec_memory_bound(alphasize, literal ? 256u
+            : (16u + tcmplxA_ringdist_get_direct(ps->ring)
+              + (48u << tcmplxA_ringdist_get_postfix(ps->ring)))));
+        if (ae != tcmplxA_Success)
+          break;
         tcmplxA_gaspvec_destroy(*forest_ptr);
-        *forest_ptr = tcmplxA_gaspvec_new(alphasize);
+        *forest_ptr = tcmplxA_gaspvec_new_alloc(alphasize, ps->alloc);
         if (!*forest_ptr) {
           ae = tcmplxA_ErrMemory;
           break;
@@ -1859,7 +2779,7 @@ static int tcmplxA_brcvt_zsrtostr_bits
         ps->state += 1;
         tcmplxA_brcvt_reset19(&ps->treety);
         ps->treety.count = (unsigned short)(ps->rlemax + ntrees);
-        ps->alphabits = (unsigned char)(ps->rlemax + ntrees);
+        ps->alphabits = (unsigned char)tcmplxA_util_bitwidth(ps->rlemax + ntrees - 1u);
       } break;
     case tcmplxA_BrCvt_ContextPrefixL:
     case tcmplxA_BrCvt_ContextPrefixD:
@@ -1984,19 +2904,33 @@ static int tcmplxA_brcvt_zsrtostr_bits
         int const res = tcmplxA_brcvt_inflow19(treety, tree, x, ps->alphabits);
         if (res == tcmplxA_EOF) {
           unsigned short const noskip = tcmplxA_brcvt_resolve_skip(tree);
+          unsigned char const skip_bit =
+            (unsigned char)(1u << (ps->state - tcmplxA_BrCvt_GaspVectorL));
           tcmplxA_gaspvec_set_skip(forest, ps->index, noskip);
           if (ps->index == 0)
-            *tcmplxA_brcvt_active_skip(ps) = noskip;
+            ps->data_skips &= ~skip_bit;
+          if (noskip != tcmplxA_brcvt_NoSkip)
+            ps->data_skips |= skip_bit;
           ps->bit_length = 0;
           ps->index += 1;
           ps->bits = 0;
           if (ps->index >= tcmplxA_gaspvec_size(forest)) {
             tcmplxA_uint32 const old_accum = ps->fwd.accum;
+            unsigned char old_ctxt[2];
+            memcpy(old_ctxt, ps->fwd.literal_ctxt, sizeof(old_ctxt));
+            ae = tcmplxA_gaspvec_compile(forest);
+            if (ae != tcmplxA_Success)
+              break;
             ps->state += 1;
             ps->index = 0;
             ps->fwd = tcmplxA_brcvt_fwd_zero;
             ps->fwd.accum = old_accum;
-            if (ps->state != tcmplxA_BrCvt_DataInsertCopy || ps->insert_skip == tcmplxA_brcvt_NoSkip)
+            /* literal context carries across meta-blocks */
+            memcpy(ps->fwd.literal_ctxt, old_ctxt, sizeof(old_ctxt));
+            if (ps->state != tcmplxA_BrCvt_DataInsertCopy)
+              break;
+            tcmplxA_brcvt_literal_select(ps);
+            if (tcmplxA_brcvt_data_skip(ps) == tcmplxA_brcvt_NoSkip)
               break;
             ae = tcmplxA_brcvt_handle_inskip(ps, &ret_out, dst, dstsz);
           }
@@ -2004,9 +2938,17 @@ static int tcmplxA_brcvt_zsrtostr_bits
           ae = res;
       } break;
     case tcmplxA_BrCvt_DataInsertCopy:
-      {
-        unsigned const line = tcmplxA_brcvt_inflow_lookup(ps,
-          tcmplxA_gaspvec_at(ps->insert_forest, ps->blocktypeI_index.current), x);
+      if (tcmplxA_brcvt_data_skip(ps) != tcmplxA_brcvt_NoSkip)
+        /* bit re-read after a full output buffer */break;
+      else {
+        unsigned line = UINT_MAX;
+        if (ps->bit_length == 0u)
+          line = tcmplxA_brcvt_inflow_peek(ps, ps->insert_forest,
+            ps->blocktypeI_index.current, y>>i, y_bits-i);
+        if (line != UINT_MAX)
+          i += ps->bit_length-1u;
+        else line = tcmplxA_brcvt_inflow_gasp(ps,
+          ps->insert_forest, ps->blocktypeI_index.current, x);
         if (line >= 704)
           break;
         tcmplxA_brcvt_countbits(ps->bits, ps->bit_length, "insert-and-copy %u", line);
@@ -2051,16 +2993,21 @@ static int tcmplxA_brcvt_zsrtostr_bits
     case tcmplxA_BrCvt_Literal:
       if (ret_out >= dstsz)
         ae = tcmplxA_ErrPartial;
+      else if (tcmplxA_brcvt_data_skip(ps) != tcmplxA_brcvt_NoSkip)
+        /* bit re-read after a full output buffer */break;
       else {
-        int const mode = tcmplxA_ctxtmap_get_mode(ps->literals_map, ps->blocktypeL_index.current);
-        int const column = tcmplxA_ctxtmap_literal_context(mode, ps->fwd.literal_ctxt[1],
-          ps->fwd.literal_ctxt[0]);
-        int const index = tcmplxA_ctxtmap_get(ps->literals_map, ps->blocktypeL_index.current, column);
-        unsigned const line = tcmplxA_brcvt_inflow_lookup(ps,
-          tcmplxA_gaspvec_at(ps->literals_forest, index), x);
+        unsigned const index = tcmplxA_brcvt_literal_tree(ps);
+        unsigned line = UINT_MAX;
+        if (ps->bit_length == 0u)
+          line = tcmplxA_brcvt_inflow_peek(ps, ps->literals_forest,
+            index, y>>i, y_bits-i);
+        if (line != UINT_MAX)
+          i += ps->bit_length-1u;
+        else line = tcmplxA_brcvt_inflow_gasp(ps,
+          ps->literals_forest, index, x);
         if (line >= 256)
           break;
-        tcmplxA_brcvt_countbits(ps->bits, ps->bit_length, "literal %u (tree %i)", line, index);
+        tcmplxA_brcvt_countbits(ps->bits, ps->bit_length, "literal %u (tree %u)", line, index);
         tcmplxA_brcvt_inflow_literal(ps, line, &ret_out, dst, dstsz);
         ps->fwd.literal_i ++;
         tcmplxA_brcvt_dec_literal_rem(ps);
@@ -2068,12 +3015,20 @@ static int tcmplxA_brcvt_zsrtostr_bits
         ps->bits = 0;
       } break;
     case tcmplxA_BrCvt_Distance:
-      {
-        int const column = tcmplxA_ctxtmap_distance_context(ps->fwd.literal_total);
-        int const index = tcmplxA_ctxtmap_get(ps->distance_map, ps->blocktypeD_index.current, column);
-        unsigned const line = tcmplxA_brcvt_inflow_lookup(ps,
-          tcmplxA_gaspvec_at(ps->distance_forest, index), x);
+      if (ps->fwd.ctxt_i
+      ||  tcmplxA_brcvt_data_skip(ps) != tcmplxA_brcvt_NoSkip)
+        /* bit re-read after a full output buffer */break;
+      else {
+        unsigned const index = tcmplxA_brcvt_distance_tree(ps);
+        unsigned line = UINT_MAX;
         int res;
+        if (ps->bit_length == 0u)
+          line = tcmplxA_brcvt_inflow_peek(ps, ps->distance_forest,
+            index, y>>i, y_bits-i);
+        if (line != UINT_MAX)
+          i += ps->bit_length-1u;
+        else line = tcmplxA_brcvt_inflow_gasp(ps,
+          ps->distance_forest, index, x);
         if (line >= 520)
           break;
         tcmplxA_brcvt_countbits(ps->bits, ps->bit_length, "distance-code %u", line);
@@ -2127,6 +3082,7 @@ static int tcmplxA_brcvt_zsrtostr_bits
       {
         break;
       }
+      tcmplxA_brcvt_literal_select(ps);
       ae = tcmplxA_brcvt_handle_inskip(ps, &ret_out, dst, dstsz);
       break;
     case tcmplxA_BrCvt_Done: /* end of stream */
@@ -2145,6 +3101,15 @@ static int tcmplxA_brcvt_zsrtostr_bits
         break;
     }
   }
+  /*
+   * A halt feeds the last bit read again; otherwise the caller steps
+   * past the current byte on its own.
+   */
+  if (ae > tcmplxA_Success)
+    *src = p + (i>>3);
+  else if (ae == tcmplxA_Success)
+    *src = p + (i>>4);
+  else *src = p + ((i-1u)>>3);
   ps->bit_index = i&7u;
   *ret = ret_out;
   return ae;
@@ -2298,9 +3263,9 @@ int tcmplxA_brcvt_inflow19(struct tcmplxA_brcvt_treety* treety,
         treety->nonzero += 1;
         if (treety->len_check > 32)
           return tcmplxA_ErrSanitize;
+        if (treety->nonzero == 1)
+          treety->singular = tcmplxA_brcvt_clen[treety->index];
       }
-      if (treety->nonzero == 1)
-        treety->singular = tcmplxA_brcvt_clen[treety->index];
       tcmplxA_fixlist_at(&treety->nineteen, treety->index++)->len = len;
       if (treety->index >= tcmplxA_brcvt_CLenExtent || treety->len_check >= 32) {
         if (treety->nonzero > 1 && treety->len_check != 32)
@@ -2749,7 +3714,7 @@ void tcmplxA_brcvt_next_block(struct tcmplxA_brcvt* ps) {
     ps->state = tcmplxA_BrCvt_MetaStart;
   else if (ps->emptymeta)
     ps->state = tcmplxA_BrCvt_MetaStart;
-  else if (!(ps->h_end&2u))
+  else if (!(ps->h_end&2u) || tcmplxA_blockbuf_input_size(ps->buffer) > 0u)
     ps->state = tcmplxA_BrCvt_Nibbles;
   else {
     ps->state = tcmplxA_BrCvt_LastCheck;
@@ -2766,25 +3731,42 @@ int tcmplxA_brcvt_can_add_input(struct tcmplxA_brcvt const* ps) {
     && (ps->state <= tcmplxA_BrCvt_MetaText);
 }
 
+tcmplxA_uint32 tcmplxA_brcvt_flat_distance(tcmplxA_uint32 distance,
+  unsigned short copy_len, tcmplxA_uint32 accum, unsigned char wbits_select)
+{
+  if (distance & tcmplxA_BlockBuf_BDictRef) {
+    /* bdict command */
+    tcmplxA_uint32 const past_window = (tcmplxA_uint32)((1ul<<wbits_select)-16ul);
+    unsigned const n_words = tcmplxA_bdict_word_count(copy_len);
+    unsigned short const filter = (distance>>16) & 127u;
+    unsigned const selector = distance & 65535u;
+    tcmplxA_uint32 const past_counter =
+      (accum > past_window) ? past_window : accum;
+    if (n_words == 0 || selector >= n_words)
+      return 0u;
+    return past_counter + filter*n_words + selector;
+  } else return distance + 1; /* adjust by one */
+}
+
 struct tcmplxA_brcvt_token tcmplxA_brcvt_next_token
-  (struct tcmplxA_brcvt_forward* fwd, struct tcmplxA_ctxtspan const* guesses,
-    unsigned char const* data, size_t size, unsigned char wbits_select, unsigned short skip)
+  (struct tcmplxA_brcvt_forward* fwd, struct tcmplxA_brcvt_split const* split,
+    struct tcmplxA_blockcmds const* cmds, unsigned char wbits_select,
+    unsigned short skip)
 {
   struct tcmplxA_brcvt_token out = {0};
   if (fwd->ostate == 0) {
-    fwd->stop = (tcmplxA_uint32)(guesses->count > 1
-      ? guesses->offsets[1] : guesses->total_bytes);
+    fwd->stop = (split->count > 1 ? split->offsets[1] : ~(tcmplxA_uint32)0);
     fwd->ostate = tcmplxA_BrCvt_DataInsertCopy;
   }
-  if (fwd->i >= size)
+  if (fwd->i >= cmds->count)
     return out;
   else if (fwd->ostate == tcmplxA_BrCvt_Literal && fwd->pos >= fwd->stop
-    && fwd->i < size && skip == tcmplxA_brcvt_NoSkip)
+    && skip == tcmplxA_brcvt_NoSkip)
   {
     fwd->ctxt_i += 1;
-    for (; fwd->ctxt_i < guesses->count; ++fwd->ctxt_i) {
-      fwd->stop = (tcmplxA_uint32)(fwd->ctxt_i+1 < guesses->count
-        ? guesses->offsets[fwd->ctxt_i+1] : guesses->total_bytes);
+    for (; fwd->ctxt_i < split->count; ++fwd->ctxt_i) {
+      fwd->stop = (fwd->ctxt_i+1 < split->count
+        ? split->offsets[fwd->ctxt_i+1] : ~(tcmplxA_uint32)0);
       if (fwd->pos < fwd->stop) {
         out.state = tcmplxA_BrCvt_LiteralRestart;
         return out;
@@ -2794,161 +3776,59 @@ struct tcmplxA_brcvt_token tcmplxA_brcvt_next_token
   switch (fwd->ostate) {
   case tcmplxA_BrCvt_DataInsertCopy:
     {
-      /* acquire all inserts */
-      tcmplxA_uint32 total = 0;
-      size_t next_i;
-      tcmplxA_uint32 literals = 0;
-      tcmplxA_uint32 first_literals = 0;
-      out.state = tcmplxA_BrCvt_DataInsertCopy;
-      /* compose insert length, collapsing adjacent insertions together */
-      for (next_i = fwd->i; next_i < size; ++next_i) {
-        unsigned short next_span = 0;
-        unsigned char const ch = data[next_i];
-        if (literals) {
-          literals -= 1;
-          continue;
-        } else if (ch & 128u)
-          break;
-        next_span = (ch & 63u);
-        if (ch & 64u) {
-          assert(next_i < size-1u);
-          next_i += 1;
-          next_span = (next_span << 8) + data[next_i] + 64u;
-        }
-        /* skip over empty spans (or quit at end of command sequence) */
-        if (next_span == 0 && first_literals == 0) {
-          fwd->i = next_i+1;
-          if (fwd->i >= size) {
-            out.state = 0;
-            fwd->ostate = tcmplxA_BrCvt_Done;
-            return out;
-          }
-          continue;
-        }
-        if (!first_literals)
-          first_literals = next_span;
-        literals = next_span;
-        assert(literals <= 16777216-total);
-        total += literals;
+      tcmplxA_uint32 const total = cmds->insert_lens[fwd->i];
+      tcmplxA_uint32 const copy_len = cmds->copy_lens[fwd->i];
+      if (total == 0 && copy_len == 0) {
+        out.state = tcmplxA_BrCvt_BadToken;
+        break;
       }
+      out.state = tcmplxA_BrCvt_DataInsertCopy;
       out.first = total;
+      out.second = (unsigned short)copy_len;
       fwd->accum += total;
       if (fwd->accum >= 16777200u)
         fwd->accum = 16777200u;
-      fwd->i += (1 + ((data[fwd->i]&64u)!=0));
+      fwd->literal_i = 0;
+      fwd->literal_total = total;
+      fwd->command_span = (unsigned short)copy_len;
       /* Update the forwarder state for the later token. */
-      if (out.first == 0)
+      if (total == 0) {
         fwd->ostate = tcmplxA_BrCvt_Distance;
-      else
+        fwd->pos += copy_len;
+      } else
         fwd->ostate = tcmplxA_BrCvt_Literal;
-      fwd->literal_i = 0;
-      fwd->command_span = (unsigned short)first_literals;
-      fwd->literal_total = total;
-      if (next_i >= size)
-        break;
-      /* parse copy length */{
-        unsigned char const ch = data[next_i];
-        unsigned short next_span = 0;
-        assert(ch & 128u);
-        next_span = (ch & 63u);
-        if (ch & 64u) {
-          assert(next_i < size-1u);
-          next_i += 1;
-          next_span = (next_span << 8) + data[next_i] + 64u;
-        }
-        out.second = next_span;
-      }
     } break;
   case tcmplxA_BrCvt_Literal:
     out.state = tcmplxA_BrCvt_Literal;
-    out.first = data[fwd->i];
-    fwd->i += 1;
+    out.first = cmds->literals[cmds->literal_offsets[fwd->i] + fwd->literal_i];
     fwd->literal_i += 1;
     fwd->pos += 1;
-    if (fwd->i >= size)
-      fwd->ostate = tcmplxA_BrCvt_Done;
-    else if (fwd->literal_i >= fwd->literal_total) {
-      /* end of insertion sequence, so check for copy count */
-      unsigned char const ch = data[fwd->i];
-      unsigned short next_span = (ch & 63u);
-      if (ch & 64u) {
-        assert(fwd->i < size-1u);
-        fwd->i += 1;
-        next_span = (next_span << 8) + data[fwd->i] + 64u;
-      }
-      fwd->i += 1;
+    if (fwd->literal_i < fwd->literal_total)
+      break;
+    else if (fwd->command_span > 0) {
+      /* end of insertion sequence, so move on to the copy */
       fwd->ostate = tcmplxA_BrCvt_Distance;
-      fwd->pos += next_span;
-      fwd->command_span = next_span;
-    } else if (fwd->literal_i >= fwd->command_span) {
-      /* more insertion commands follow; read in the next non-empty insertion command */
-      size_t next_i;
-      assert(fwd->command_span <= fwd->literal_total);
-      fwd->literal_total -= fwd->command_span;
-      fwd->literal_i = 0;
-      for (next_i = fwd->i; next_i < size; ++next_i) {
-        unsigned short next_span = 0;
-        unsigned char const ch = data[next_i];
-        if (ch & 128u) {
-          /* inconsistency detected, so give up. */
-          out.state = tcmplxA_BrCvt_BadToken;
-          return out;
-        } else if ((ch & 63u) == 0u)
-          /* insertion is empty, so */continue;
-        next_span = (ch & 63u);
-        if (ch & 64u) {
-          assert(next_i < size-1u);
-          next_i += 1;
-          next_span = (next_span << 8) + data[next_i] + 64u;
-        }
-        fwd->i = next_i+1;
-        fwd->command_span = next_span;
-        break;
-      }
+      fwd->pos += fwd->command_span;
+    } else {
+      fwd->i += 1;
+      fwd->ostate = (fwd->i >= cmds->count
+        ? tcmplxA_BrCvt_Done : tcmplxA_BrCvt_DataInsertCopy);
     } break;
   case tcmplxA_BrCvt_Distance:
     {
-      unsigned char const root = data[fwd->i];
-      if (root < 128) {
-        /* bdict command */
-        tcmplxA_uint32 const past_window = (tcmplxA_uint32)((1ul<<wbits_select)-16ul);
-        unsigned const n_words = tcmplxA_bdict_word_count(fwd->command_span);
-        unsigned short const filter = root & 127u;
-        tcmplxA_uint32 word_id = filter * n_words;
-        tcmplxA_uint32 past_counter = 0;
-        unsigned selector = 0;
-        if (n_words == 0 || size < 3 || fwd->i > size-3) {
-          out.state = tcmplxA_BrCvt_BadToken;
-          break;
-        }
-        fwd->i += 1;
-        selector = (data[fwd->i]<<8)|data[fwd->i+1];
-        if (selector >= n_words) {
-          out.state = tcmplxA_BrCvt_BadToken;
-          break;
-        }
-        fwd->i += 2;
-        word_id += selector;
-        past_counter = (fwd->accum > past_window) ? past_window : fwd->accum;
-        out.state = tcmplxA_BrCvt_BDict;
-        out.first = past_counter + word_id;
-      } else {
-        tcmplxA_uint32 distance = 0;
-        unsigned const byte_count = (root&64u) ? 4 : 2;
-        unsigned j;
-        if (size < byte_count || fwd->i > size-byte_count) {
-          out.state = tcmplxA_BrCvt_BadToken;
-          break;
-        }
-        for (j = 0; j < byte_count; ++j, ++fwd->i) {
-          unsigned const digit = data[fwd->i] & (j ? 255u : 63u);
-          distance = (distance<<8) | digit;
-        }
-        out.state = tcmplxA_BrCvt_Distance;
-        out.first = distance + ((root&64u)<<8) + 1; /* +16384 when 30-bit sequence; adjust by one */
+      tcmplxA_uint32 const distance = cmds->distances[fwd->i];
+      out.first = tcmplxA_brcvt_flat_distance
+        (distance, fwd->command_span, fwd->accum, wbits_select);
+      if (out.first == 0u) {
+        out.state = tcmplxA_BrCvt_BadToken;
+        break;
       }
+      out.state = (distance & tcmplxA_BlockBuf_BDictRef)
+        ? tcmplxA_BrCvt_BDict : tcmplxA_BrCvt_Distance;
       fwd->accum += fwd->command_span;
-      fwd->ostate = (fwd->i >= size ? tcmplxA_BrCvt_Done : tcmplxA_BrCvt_DataInsertCopy);
+      fwd->i += 1;
+      fwd->ostate = (fwd->i >= cmds->count
+        ? tcmplxA_BrCvt_Done : tcmplxA_BrCvt_DataInsertCopy);
     } break;
   default:
     out.state = tcmplxA_BrCvt_BadToken;
@@ -2976,6 +3856,8 @@ int tcmplxA_brcvt_apply_token(struct tcmplxA_brcvt* ps,
         return tcmplxA_ErrSanitize;
       if (!tcmplxA_brcvt_outflow_lookup(ps, tcmplxA_gaspvec_at_c(ps->insert_forest, 0), icv_row->code, &ae))
         return ae;
+      if (ps->stream_tf)
+        ps->histogram[icv_row->code] += 1u;
       ps->extra_length = icv_row->insert_bits;
       ps->bit_length = icv_row->copy_bits;
       ps->extra_bits[0] = (next.first - icv_row->insert_first);
@@ -2983,43 +3865,64 @@ int tcmplxA_brcvt_apply_token(struct tcmplxA_brcvt* ps,
     }
     break;
   case tcmplxA_BrCvt_Literal:
-    /* all contexts for the current block type point to the same prefix tree,
-    so just fetch that tree
-    */
     {
-      unsigned const mode = ps->guesses.modes[ps->fwd.ctxt_i];
-      unsigned const context = ps->ctxt_mode_map[mode];
-      struct tcmplxA_fixlist const* const fix =
-          tcmplxA_gaspvec_at_c(ps->literals_forest, context);
+      struct tcmplxA_fixlist const* const fix = tcmplxA_gaspvec_at_c
+        (ps->literals_forest, tcmplxA_brcvt_literal_tree(ps));
       if (!tcmplxA_brcvt_outflow_lookup(ps, fix, next.first, &ae))
         return ae;
+      if (ps->stream_tf)
+        tcmplxA_brcvt_quick_literals(ps)[next.first&255u] += 1u;
+      ps->fwd.literal_ctxt[0] = ps->fwd.literal_ctxt[1];
+      ps->fwd.literal_ctxt[1] = (unsigned char)next.first;
     }
     break;
   case tcmplxA_BrCvt_Distance:
   case tcmplxA_BrCvt_BDict:
     {
-      int const to_record = (next.state==tcmplxA_BrCvt_Distance);
-      tcmplxA_uint32 extra = 0;
-      // TODO: use `to_record`
-      unsigned const cmd = tcmplxA_ringdist_encode(ps->ring, next.first, &extra,
-        to_record ? 0xFFffFFff : 0);
       unsigned const sum_direct = tcmplxA_ringdist_get_direct(ps->ring) + 16u;
-      if (cmd >= tcmplxA_brcvt_DistHistoSize)
+      int const column = tcmplxA_ctxtmap_distance_context(ps->fwd.command_span);
+      tcmplxA_uint32 extra = 0;
+      unsigned cmd;
+      if (ps->stream_tf) {
+        /* the ring holds the distances of the commands before this one */
+        cmd = tcmplxA_ringdist_encode(ps->ring, next.first, &extra,
+          (next.state == tcmplxA_BrCvt_Distance) ? 0xFFffFFff : 0);
+        if (cmd < tcmplxA_brcvt_DistHistoSize)
+          ps->histogram[tcmplxA_brcvt_InsHistoSize + cmd] += 1u;
+      } else {
+        /* the compress check already encoded this command's distance */
+        struct tcmplxA_brcvt_distcode const* const code =
+          ps->distance_codes + (ps->fwd.i-1u);
+        cmd = code->code;
+        extra = code->extra;
+      }
+      if (cmd >= tcmplxA_brcvt_DistHistoSize || column < 0
+      ||  ps->fwd.pos > tcmplxA_blockbuf_input_size(ps->buffer))
+      {
         return tcmplxA_ErrSanitize;
+      }
+      /* the copy ends where the next literal starts */
+      tcmplxA_brcvt_keep_context(ps->fwd.literal_ctxt,
+        tcmplxA_blockbuf_input_data(ps->buffer), ps->fwd.pos);
       ps->extra_length = (cmd < sum_direct) ? 0
         : 1 + ((cmd - sum_direct) >> (tcmplxA_ringdist_get_postfix(ps->ring)+1));
       if (ps->extra_length > 0) {
         ps->extra_bits[0] = extra;
       }
-      if (!tcmplxA_brcvt_outflow_lookup(ps, tcmplxA_gaspvec_at_c(ps->distance_forest,0), cmd, &ae))
+      if (!tcmplxA_brcvt_outflow_lookup(ps, tcmplxA_gaspvec_at_c(ps->distance_forest,
+          (size_t)tcmplxA_ctxtmap_get(ps->distance_map, 0, (size_t)column)), cmd, &ae))
+      {
         return ae;
+      }
     }
     break;
   case tcmplxA_BrCvt_LiteralRestart:
     {
-      unsigned const mode = ps->guesses.modes[ps->fwd.ctxt_i];
-      unsigned const context = ps->ctxt_mode_map[mode];
-      tcmplxA_uint32 const len = ps->guess_lengths[ps->fwd.ctxt_i];
+      unsigned char const max_type = (unsigned char)
+        (tcmplxA_ctxtmap_block_types(ps->literals_map)-1u);
+      unsigned const code = tcmplxA_brcvt_blocktype_code(ps->blocktypeL_index,
+        max_type, ps->split.types[ps->fwd.ctxt_i]);
+      tcmplxA_uint32 const len = ps->split.lengths[ps->fwd.ctxt_i];
       size_t const icv = tcmplxA_inscopy_encode(ps->blockcounts, len, 0, 0);
       struct tcmplxA_inscopy_row const* const icv_row =
         tcmplxA_inscopy_at_c(ps->blockcounts, icv);
@@ -3032,7 +3935,10 @@ int tcmplxA_brcvt_apply_token(struct tcmplxA_brcvt* ps,
       ps->extra_bits[0] = ps->bits;
       ps->extra_length = ps->bit_cap;
       ps->bit_cap = 0;
-      if (!tcmplxA_brcvt_outflow_lookup(ps, &ps->literal_blocktype, context+2, &ae))
+      ps->blocktypeL_index =
+        tcmplxA_brcvt_switch_blocktype(ps->blocktypeL_index, max_type, code);
+      tcmplxA_brcvt_literal_select(ps);
+      if (!tcmplxA_brcvt_outflow_lookup(ps, &ps->literal_blocktype, code, &ae))
         return ae;
     }
     break;
@@ -3062,200 +3968,1119 @@ static unsigned tcmplxA_brcvt_unshift4(unsigned mode, unsigned offset) {
   return (mode+offset)%4u;
 }
 
-static int tcmplxA_brcvt_check_compress(struct tcmplxA_brcvt* ps) {
-  unsigned int ctxt_i;
-  int guess_nonzero = 0;
-  size_t btypes = 0;
-  size_t btype_j;
-  size_t try_bit_count = 0;
-  int blocktype_tree = tcmplxA_FixList_BrotliComplex;
-  /* calculate the guesses */
-  tcmplxA_uint32 ctxt_histogram[4] = {0};
-  /** @brief Map from outflow context index to mode. */
-  unsigned char ctxt_mode_revmap[4] = {255,255,255,255};
-  unsigned char ctxt_mode_alloc = 0;
-  int block_ae;
-  tcmplxA_blockbuf_clear_output(ps->buffer);
-  block_ae = tcmplxA_blockbuf_try_block(ps->buffer);
-  if (block_ae != tcmplxA_Success)
-    return block_ae;
-  memset(ps->ctxt_mode_map, 255, 4*sizeof(char));
-  if (tcmplxA_inscopy_lengthsort(ps->values) != tcmplxA_Success)
-    return tcmplxA_ErrInit;
-  ps->guesses = tcmplxA_brcvt_guess_zero;
-  tcmplxA_ctxtspan_subdivide(&ps->guesses,
-    tcmplxA_blockbuf_input_data(ps->buffer), tcmplxA_blockbuf_input_size(ps->buffer),
-    tcmplxA_BrCvt_Margin);
-  tcmplxA_fixlist_resize(&ps->literal_blocktype, 4);
-  ps->context_encode.sz = 0;
-  /* prepare the fixed-size forests */{
-    if (!ps->insert_forest) {
-      ps->insert_forest = tcmplxA_gaspvec_new(1);
-      if (!ps->insert_forest)
-        return tcmplxA_ErrMemory;
+unsigned tcmplxA_brcvt_log2q4(tcmplxA_uint32 x) {
+  /* sixteenths of log2(1 + i/16), rounded */
+  static unsigned char const fraction[16] =
+    {0, 1, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 15};
+  unsigned const width = tcmplxA_util_bitwidth((unsigned)x);
+  unsigned mantissa;
+  if (width == 0)
+    return 0;
+  mantissa = (unsigned)(width > 5u ? (x >> (width-5u)) : (x << (5u-width)));
+  return (width-1u)*16u + fraction[mantissa&15u];
+}
+
+size_t tcmplxA_brcvt_histogram_cost(tcmplxA_uint32 const* a,
+  tcmplxA_uint32 const* b, size_t size, int with_tree)
+{
+  tcmplxA_uint32 total = 0;
+  size_t nonzero = 0;
+  size_t cost;
+  size_t weighted = 0;
+  unsigned log_total;
+  size_t i;
+  /* sum(count*(log(total)-log(count))) in one pass, as
+   * total*log(total) - sum(count*log(count)) */
+  for (i = 0; i < size; ++i) {
+    tcmplxA_uint32 const count = a[i] + (b ? b[i] : 0u);
+    unsigned log_count;
+    if (count == 0)
+      continue;
+    log_count = tcmplxA_brcvt_log2q4(count);
+    weighted += (size_t)(count>>4)*log_count + (((count&15u)*log_count)>>4);
+    total += count;
+    nonzero += 1;
+  }
+  log_total = tcmplxA_brcvt_log2q4(total);
+  cost = (size_t)(total>>4)*log_total + (((total&15u)*log_total)>>4)
+    - weighted;
+  if (with_tree)
+    cost += nonzero*tcmplxA_brcvt_SplitCodeBits + tcmplxA_brcvt_SplitTreeBits;
+  return cost;
+}
+
+void tcmplxA_brcvt_split_chunk(struct tcmplxA_brcvt_split* split,
+  struct tcmplxA_brcvt_splitter* sp)
+{
+  tcmplxA_uint32* const chunk =
+    sp->histograms + sp->types_max*tcmplxA_brcvt_LitHistoSize;
+  size_t btype;
+  size_t i;
+  if (sp->chunk_len == 0)
+    return;
+  if (split->count == 0) {
+    /* the first block always takes block type zero */
+    split->offsets[0] = 0;
+    split->lengths[0] = sp->chunk_len;
+    split->types[0] = 0;
+    split->count = 1;
+    sp->types = 1;
+    sp->last[0] = sp->last[1] = 0;
+    sp->last_cost[0] = sp->last_cost[1] =
+      tcmplxA_brcvt_histogram_cost(chunk, NULL, tcmplxA_brcvt_LitHistoSize, 0);
+    btype = 0;
+  } else {
+    size_t const cost = tcmplxA_brcvt_histogram_cost
+      (chunk, NULL, tcmplxA_brcvt_LitHistoSize, 0);
+    size_t joint[2];
+    long int diff[2];
+    for (i = 0; i < 2; ++i) {
+      joint[i] = tcmplxA_brcvt_histogram_cost(chunk,
+        sp->histograms + sp->last[i]*tcmplxA_brcvt_LitHistoSize,
+        tcmplxA_brcvt_LitHistoSize, 0);
+      diff[i] = (long int)joint[i] - (long int)(cost + sp->last_cost[i]);
     }
-    if (!ps->distance_forest) {
-      ps->distance_forest = tcmplxA_gaspvec_new(1);
-      if (!ps->distance_forest)
-        return tcmplxA_ErrMemory;
+    if (split->count < split->cap && sp->types < sp->types_max
+    &&  diff[0] > tcmplxA_brcvt_SplitThreshold
+    &&  diff[1] > tcmplxA_brcvt_SplitThreshold)
+    {
+      /* start a new block type */
+      btype = sp->types;
+      sp->types += 1;
+      sp->last[1] = sp->last[0];
+      sp->last_cost[1] = sp->last_cost[0];
+      sp->last[0] = btype;
+      sp->last_cost[0] = cost;
+    } else if (split->count < split->cap
+    &&  diff[1] < diff[0] - tcmplxA_brcvt_SplitSwitch)
+    {
+      /* switch back to the second-to-last block type */
+      btype = sp->last[1];
+      sp->last[1] = sp->last[0];
+      sp->last_cost[1] = sp->last_cost[0];
+      sp->last[0] = btype;
+      sp->last_cost[0] = joint[1];
+    } else {
+      /* extend the current block */
+      split->lengths[split->count-1u] += sp->chunk_len;
+      sp->last_cost[0] = joint[0];
+      btype = sp->last[0];
+    }
+    if (btype != split->types[split->count-1u]) {
+      split->offsets[split->count] = sp->chunk_offset;
+      split->lengths[split->count] = sp->chunk_len;
+      split->types[split->count] = (unsigned char)btype;
+      split->count += 1;
     }
   }
-  /* synchronize the distance scratch space with actual output.
-  * (Uncompress blocks can introduce drift.) */
-  tcmplxA_ringdist_copy(ps->try_ring, ps->ring);
-  /* fill the histograms and build prefix trees */{
-    tcmplxA_uint32 *const insert_histogram = ps->histogram;
-    tcmplxA_uint32 *const distance_histogram = insert_histogram+tcmplxA_brcvt_InsHistoSize;
-    tcmplxA_uint32 *literal_histograms[4] = {NULL};
-    tcmplxA_uint32 literal_lengths[tcmplxA_CtxtSpan_Size] = {0};
-    struct tcmplxA_brcvt_forward try_fwd = {0};
-    size_t const size = tcmplxA_blockbuf_output_size(ps->buffer);
-    size_t i = 0;
-    tcmplxA_uint32 literal_counter = 0;
-    tcmplxA_uint32 next_copy = 0;
-    unsigned ctxt_j = 0;
-    unsigned char const* const data = tcmplxA_blockbuf_output_data(ps->buffer);
-    int ae = tcmplxA_Success;
-    try_fwd.accum = ps->fwd.accum;
-    /* compute histogram addresses for literals */{
-      tcmplxA_uint32 *const literal_start = distance_histogram+tcmplxA_brcvt_DistHistoSize;
-      for (btype_j = 0; btype_j < 4u; ++btype_j)
-        literal_histograms[btype_j] = literal_start+tcmplxA_brcvt_LitHistoSize*btype_j;
+  /* fold the chunk into its block type */{
+    tcmplxA_uint32* const hist =
+      sp->histograms + btype*tcmplxA_brcvt_LitHistoSize;
+    for (i = 0; i < tcmplxA_brcvt_LitHistoSize; ++i) {
+      hist[i] += chunk[i];
+      chunk[i] = 0;
     }
-    ctxt_i = 0;
-    memset(ps->histogram, 0, sizeof(tcmplxA_uint32)*tcmplxA_brcvt_HistogramSize);
-    for (i = 0; i < size; ++i) {
-      struct tcmplxA_brcvt_token next =
-        tcmplxA_brcvt_next_token(&try_fwd, &ps->guesses, data, size, ps->wbits_select, ps->blocktypeL_skip);
-      if (try_fwd.i <= i && next.state != tcmplxA_BrCvt_LiteralRestart)
-        return tcmplxA_ErrSanitize;
-      i = try_fwd.i-1;
-      switch (next.state) {
-      case tcmplxA_BrCvt_DataInsertCopy:
-        /* */{
-          size_t const icv = tcmplxA_inscopy_encode(ps->values, next.first,
-            next.second ? next.second : 2, 0);
-          struct tcmplxA_inscopy_row const* const icv_row =
-            tcmplxA_inscopy_at_c(ps->values, icv);
-          if (!icv_row)
-            return tcmplxA_ErrSanitize;
-          assert(icv_row->code < 704u);
-          insert_histogram[icv_row->code] += 1;
-          try_bit_count += icv_row->insert_bits;
-          try_bit_count += icv_row->copy_bits;
-          next_copy = next.second;
-        } break;
-      case tcmplxA_BrCvt_LiteralRestart:
-        assert(ctxt_i < tcmplxA_CtxtSpan_Size);
-        literal_lengths[ctxt_i] = literal_counter;
-        literal_counter = 0;
-        ctxt_i = try_fwd.ctxt_i;
-        break;
-      case tcmplxA_BrCvt_Literal:
-        /* */{
-          tcmplxA_uint32* const hist = literal_histograms[ps->guesses.modes[ctxt_i]];
-          hist[next.first&255u] += 1;
-          literal_counter += 1;
-        } break;
-      case tcmplxA_BrCvt_Distance:
-      case tcmplxA_BrCvt_BDict:
-        /* */{
-          int const to_record = (next.state==tcmplxA_BrCvt_Distance);
-          tcmplxA_uint32 extra = 0;
-          // TODO: use `to_record`
-          unsigned const cmd = tcmplxA_ringdist_encode(ps->try_ring, next.first, &extra,
-            to_record ? 0xFFffFFff : 0);
-          if (cmd >= tcmplxA_brcvt_DistHistoSize)
-            return tcmplxA_ErrSanitize;
-          try_bit_count += extra;
-          distance_histogram[cmd] += 1;
-        } break;
-      default:
-        return tcmplxA_ErrSanitize;
-      }
+    for (i = 0; i < tcmplxA_CtxtMap_ModeMax; ++i) {
+      sp->modes[btype*tcmplxA_CtxtMap_ModeMax+i] += sp->chunk_modes[i];
+      sp->chunk_modes[i] = 0;
     }
-    assert(ctxt_i < tcmplxA_CtxtSpan_Size);
-    literal_lengths[ctxt_i] = literal_counter;
-    /* NOTE: Context creation moved here to avoid the zero-item prefix list. */
-    for (ctxt_j = 0; ctxt_j <= ctxt_i; ++ctxt_j) {
-      unsigned const mode = ps->guesses.modes[ctxt_j];
-      if (literal_lengths[ctxt_j] == 0)
-        continue;
-      assert(mode < 4);
-      if (ps->ctxt_mode_map[mode] >= 4) {
-        /* allocate a spot */
-        assert(ctxt_mode_alloc < 4);
-        ps->ctxt_mode_map[mode] = ctxt_mode_alloc;
-        ctxt_mode_revmap[ctxt_mode_alloc] = mode;
-        ctxt_mode_alloc += 1;
+  }
+  sp->chunk_len = 0;
+  return;
+}
+
+size_t tcmplxA_brcvt_pair_cost(tcmplxA_uint32 const* a,
+  tcmplxA_uint32 const* b, unsigned short const* spans)
+{
+  unsigned short const first = spans[0] < spans[2] ? spans[0] : spans[2];
+  unsigned short const last = spans[1] > spans[3] ? spans[1] : spans[3];
+  if (last <= first)
+    return tcmplxA_brcvt_histogram_cost(a, b, 0, 1);
+  return tcmplxA_brcvt_histogram_cost(a+first, b+first, last-first, 1);
+}
+
+size_t tcmplxA_brcvt_cluster(tcmplxA_uint32* const* histograms,
+  size_t n, size_t size, size_t max, unsigned short* parent,
+  long int* pairs)
+{
+  size_t costs[tcmplxA_brcvt_SplitTypesMax];
+  long int best_diff[tcmplxA_brcvt_SplitTypesMax];
+  unsigned short best_with[tcmplxA_brcvt_SplitTypesMax];
+  /* nonzero entries of each histogram, since sparse ones are common */
+  unsigned short spans[tcmplxA_brcvt_SplitTypesMax][2];
+  size_t roots = n;
+  size_t i, j;
+  assert(n <= tcmplxA_brcvt_SplitTypesMax);
+  for (i = 0; i < n; ++i) {
+    tcmplxA_uint32 const* const hist = histograms[i];
+    size_t first = 0, last = size;
+    while (first < last && hist[first] == 0u)
+      first += 1;
+    while (last > first && hist[last-1u] == 0u)
+      last -= 1;
+    spans[i][0] = (unsigned short)first;
+    spans[i][1] = (unsigned short)last;
+    costs[i] = tcmplxA_brcvt_histogram_cost(hist, NULL, size, 1);
+    parent[i] = (unsigned short)i;
+    best_diff[i] = LONG_MAX;
+    best_with[i] = (unsigned short)i;
+  }
+  /* find the cheapest merge for each histogram; the cost of merging
+   * `i` and `j` (with i < j) stays at `pairs[j*(j-1)/2+i]` */
+  for (j = 1; j < n; ++j) {
+    long int* const row = pairs + j*(j-1u)/2u;
+    for (i = 0; i < j; ++i) {
+      unsigned short const pair_spans[4] =
+        {spans[i][0], spans[i][1], spans[j][0], spans[j][1]};
+      long int const diff = (long int)tcmplxA_brcvt_pair_cost
+          (histograms[i], histograms[j], pair_spans)
+        - (long int)(costs[i] + costs[j]);
+      row[i] = diff;
+      if (diff < best_diff[i]) {
+        best_diff[i] = diff;
+        best_with[i] = (unsigned short)j;
+      }
+      if (diff < best_diff[j]) {
+        best_diff[j] = diff;
+        best_with[j] = (unsigned short)i;
       }
-      ctxt_histogram[ps->ctxt_mode_map[mode]] += 1;
-    }
-    for (ctxt_i = 0; ctxt_i < 4u; ++ctxt_i) {
-      struct tcmplxA_fixline* const line = tcmplxA_fixlist_at(&ps->literal_blocktype, ctxt_i);
-      line->value = ctxt_i + 2;
-      if (ctxt_histogram[ctxt_i] > 0)
-        guess_nonzero += 1;
     }
-    tcmplxA_fixlist_gen_lengths(&ps->literal_blocktype, ctxt_histogram, 3);
-    {
-      int const res = tcmplxA_fixlist_gen_codes(&ps->literal_blocktype);
-      if (res != tcmplxA_Success)
-        return res;
+  }
+  /* merge while merging saves bits or too many clusters remain */
+  for (;;) {
+    size_t keep = n;
+    size_t drop;
+    tcmplxA_uint32* hist;
+    for (i = 0; i < n; ++i) {
+      if (parent[i] == i && best_diff[i] < LONG_MAX
+      &&  (best_diff[i] < 0 || roots > max)
+      &&  (keep >= n || best_diff[i] < best_diff[keep]))
+      {
+        keep = i;
+      }
     }
-    blocktype_tree = tcmplxA_fixlist_match_preset(&ps->literal_blocktype, 0);
-    if (blocktype_tree == tcmplxA_FixList_BrotliComplex)
-      return tcmplxA_ErrSanitize;
-    try_bit_count += 4;
-    /* NOTE: This context map generation is delayed until after the tokens are generated. */
-    btypes = tcmplxA_fixlist_size(&ps->literal_blocktype);
-    try_bit_count += (blocktype_tree >= tcmplxA_FixList_BrotliSimple3 ? 3 : 2) * btypes;
-    try_bit_count += (blocktype_tree >= tcmplxA_FixList_BrotliSimple4A);
-    if ((!ps->literals_map) || tcmplxA_ctxtmap_block_types(ps->literals_map) != btypes) {
-      tcmplxA_ctxtmap_destroy(ps->literals_map);
-      ps->literals_map = tcmplxA_ctxtmap_new(btypes, 64);
-      if (!ps->literals_map)
-        return tcmplxA_ErrMemory;
+    if (keep >= n)
+      break;
+    drop = best_with[keep];
+    if (drop < keep) {
+      size_t const swap = drop;
+      drop = keep;
+      keep = swap;
     }
-    for (btype_j = 0; btype_j < btypes; ++btype_j) {
-      struct tcmplxA_fixline const* const line = tcmplxA_fixlist_at_c(&ps->literal_blocktype, btype_j);
-      tcmplxA_ctxtmap_set_mode(ps->literals_map, btype_j, ctxt_mode_revmap[line->value - 2]);
-      for (ctxt_i = 0; ctxt_i < 64; ++ctxt_i)
-        tcmplxA_ctxtmap_set(ps->literals_map, btype_j, ctxt_i, (int)btype_j);
+    hist = histograms[keep];
+    for (i = 0; i < size; ++i)
+      hist[i] += histograms[drop][i];
+    costs[keep] = tcmplxA_brcvt_histogram_cost(hist, NULL, size, 1);
+    if (spans[drop][0] < spans[keep][0])
+      spans[keep][0] = spans[drop][0];
+    if (spans[drop][1] > spans[keep][1])
+      spans[keep][1] = spans[drop][1];
+    for (i = 0; i < n; ++i) {
+      if (parent[i] == drop)
+        parent[i] = (unsigned short)keep;
     }
-    /* prepare the variable-size forest */ {
-      if ((!ps->literals_forest) || tcmplxA_gaspvec_size(ps->literals_forest) != btypes) {
-        tcmplxA_gaspvec_destroy(ps->literals_forest);
-        ps->literals_forest = tcmplxA_gaspvec_new(btypes);
-        if (!ps->literals_forest)
-          return tcmplxA_ErrMemory;
+    roots -= 1;
+    /* only merges with the kept histogram change cost */
+    best_diff[keep] = LONG_MAX;
+    for (i = 0; i < n; ++i) {
+      unsigned short pair_spans[4];
+      long int diff;
+      if (parent[i] != i || i == keep)
+        continue;
+      pair_spans[0] = spans[keep][0];
+      pair_spans[1] = spans[keep][1];
+      pair_spans[2] = spans[i][0];
+      pair_spans[3] = spans[i][1];
+      diff = (long int)tcmplxA_brcvt_pair_cost
+          (hist, histograms[i], pair_spans)
+        - (long int)(costs[keep] + costs[i]);
+      if (i < keep)
+        pairs[keep*(keep-1u)/2u + i] = diff;
+      else pairs[i*(i-1u)/2u + keep] = diff;
+      if (diff < best_diff[keep]) {
+        best_diff[keep] = diff;
+        best_with[keep] = (unsigned short)i;
       }
-      if (btypes <= 1)
-        ps->blocktypeL_skip = 0;
-      else
-        ps->blocktypeL_skip = tcmplxA_brcvt_NoSkip;
     }
-    /* apply histograms to the trees */
-    try_bit_count += tcmplxA_brcvt_apply_histogram(
-      ps->distance_forest,0, distance_histogram,
-      tcmplxA_brcvt_DistHistoSize, &ae);
-    try_bit_count += tcmplxA_brcvt_apply_histogram(
-      ps->insert_forest,0, insert_histogram,
-      tcmplxA_brcvt_InsHistoSize, &ae);
-    for (btype_j = 0; btype_j < btypes; ++btype_j) {
-      int const btype = tcmplxA_ctxtmap_get_mode(ps->literals_map, btype_j);
-      try_bit_count += tcmplxA_brcvt_apply_histogram(
-        ps->literals_forest,btype_j,
-        literal_histograms[btype],
-        tcmplxA_brcvt_LitHistoSize, &ae);
+    /* refresh the best merges that pointed at either histogram */
+    for (i = 0; i < n; ++i) {
+      if (parent[i] != i || i == keep)
+        continue;
+      if (best_with[i] == keep || best_with[i] == drop) {
+        best_diff[i] = LONG_MAX;
+        for (j = 0; j < n; ++j) {
+          long int other;
+          if (parent[j] != j || j == i)
+            continue;
+          other = (j < i) ? pairs[i*(i-1u)/2u + j] : pairs[j*(j-1u)/2u + i];
+          if (other < best_diff[i]) {
+            best_diff[i] = other;
+            best_with[i] = (unsigned short)j;
+          }
+        }
+      } else {
+        long int const diff = (i < keep)
+          ? pairs[keep*(keep-1u)/2u + i] : pairs[i*(i-1u)/2u + keep];
+        if (diff < best_diff[i]) {
+          best_diff[i] = diff;
+          best_with[i] = (unsigned short)keep;
+        }
+      }
     }
-    memcpy(ps->guess_lengths, literal_lengths, tcmplxA_CtxtSpan_Size*sizeof(tcmplxA_uint32));
   }
-  if (try_bit_count/8+1 > tcmplxA_blockbuf_input_size(ps->buffer))
+  return roots;
+}
+
+size_t tcmplxA_brcvt_split_cluster(struct tcmplxA_brcvt_split* split,
+  struct tcmplxA_brcvt_splitter* sp, unsigned short* slots, long int* pairs)
+{
+  tcmplxA_uint32* histograms[tcmplxA_brcvt_SplitTypesMax];
+  unsigned short parent[tcmplxA_brcvt_SplitTypesMax];
+  unsigned short renumber[tcmplxA_brcvt_SplitTypesMax];
+  size_t const n = sp->types;
+  size_t btypes = 0;
+  size_t i, j;
+  if (n == 0)
+    return 0;
+  for (i = 0; i < n; ++i)
+    histograms[i] = sp->histograms + i*tcmplxA_brcvt_LitHistoSize;
+  tcmplxA_brcvt_cluster(histograms, n, tcmplxA_brcvt_LitHistoSize, n, parent,
+    pairs);
+  /* carry the context mode tallies to the merged block types */
+  for (i = 0; i < n; ++i) {
+    if (parent[i] == i)
+      continue;
+    for (j = 0; j < tcmplxA_CtxtMap_ModeMax; ++j) {
+      sp->modes[parent[i]*tcmplxA_CtxtMap_ModeMax+j] +=
+        sp->modes[i*tcmplxA_CtxtMap_ModeMax+j];
+    }
+  }
+  /* number the block types by first use, then join repeated blocks */
+  for (i = 0; i < n; ++i)
+    renumber[i] = USHRT_MAX;
+  for (i = 0, j = 0; i < split->count; ++i) {
+    unsigned short const root = parent[split->types[i]];
+    if (renumber[root] == USHRT_MAX) {
+      renumber[root] = (unsigned short)btypes;
+      slots[btypes] = root;
+      btypes += 1;
+    }
+    if (j > 0 && split->types[j-1u] == renumber[root]) {
+      split->lengths[j-1u] += split->lengths[i];
+      continue;
+    }
+    split->offsets[j] = split->offsets[i];
+    split->lengths[j] = split->lengths[i];
+    split->types[j] = (unsigned char)renumber[root];
+    j += 1;
+  }
+  split->count = j;
+  return btypes;
+}
+
+unsigned tcmplxA_brcvt_blocktype_code(struct tcmplxA_brcvt_block box,
+  unsigned char max_value, unsigned btype)
+{
+  if (btype == (box.current >= max_value ? 0u : box.current+1u))
+    return 1;
+  else if (btype == box.previous)
+    return 0;
+  else return btype+2u;
+}
+
+unsigned tcmplxA_brcvt_varlen_uint8(unsigned value, tcmplxA_uint32* bits) {
+  unsigned width;
+  if (value == 0) {
+    *bits = 0;
+    return 1;
+  }
+  width = tcmplxA_util_bitwidth(value)-1u;
+  *bits = 1u | (width<<1) | ((tcmplxA_uint32)(value - (1u<<width))<<4);
+  return 4u+width;
+}
+
+size_t tcmplxA_brcvt_literal_types_max(tcmplxA_uint32 block_size) {
+  size_t const types = block_size/tcmplxA_brcvt_SplitTypeBytes;
+  if (types < 4u)
+    return 4u;
+  else if (types > tcmplxA_brcvt_SplitTypesMax)
+    return tcmplxA_brcvt_SplitTypesMax;
+  else return types;
+}
+
+size_t tcmplxA_brcvt_histogram_size(size_t types_max) {
+  /* one literal histogram per block type, then the pending chunk */
+  return tcmplxA_brcvt_CmdHistoSize
+    + (types_max+1u)*tcmplxA_brcvt_LitHistoSize
+    + types_max*tcmplxA_CtxtMap_ModeMax;
+}
+
+size_t tcmplxA_brcvt_split_cap(tcmplxA_uint32 block_size) {
+  return block_size/tcmplxA_brcvt_SplitChunk + 2u;
+}
+
+size_t tcmplxA_brcvt_context_histograms_max(tcmplxA_uint32 block_size) {
+  size_t const contexts = tcmplxA_brcvt_literal_types_max(block_size)
+    * tcmplxA_brcvt_LitContexts;
+  size_t const budget = block_size/tcmplxA_brcvt_ContextHistoBytes;
+  return budget < contexts ? budget : contexts;
+}
+
+size_t tcmplxA_brcvt_literal_trees_max(tcmplxA_uint32 block_size) {
+  size_t const types = tcmplxA_brcvt_literal_types_max(block_size);
+  size_t const trees = block_size/tcmplxA_brcvt_LitTreeBytes;
+  if (trees > tcmplxA_brcvt_LitTreesMax)
+    return tcmplxA_brcvt_LitTreesMax;
+  else return trees > types ? trees : types;
+}
+
+size_t tcmplxA_brcvt_cluster_pairs(tcmplxA_uint32 block_size) {
+  /* block types, contexts of one block type, or trees across types */
+  size_t const trees = tcmplxA_brcvt_literal_trees_max(block_size);
+  size_t const n = trees > tcmplxA_brcvt_LitContexts
+    ? trees : tcmplxA_brcvt_LitContexts;
+  return n*(n-1u)/2u;
+}
+
+void tcmplxA_brcvt_keep_context(unsigned char* ctxt,
+  unsigned char const* data, tcmplxA_uint32 pos)
+{
+  if (pos >= 2u) {
+    ctxt[0] = data[pos-2u];
+    ctxt[1] = data[pos-1u];
+  } else if (pos == 1u) {
+    ctxt[0] = ctxt[1];
+    ctxt[1] = data[0];
+  }
+  return;
+}
+
+int tcmplxA_brcvt_reserve_contexts(struct tcmplxA_brcvt* ps, size_t n) {
+  size_t const histo_bytes =
+    tcmplxA_brcvt_LitHistoSize*sizeof(tcmplxA_uint32);
+  tcmplxA_uint32* histograms;
+  int ae;
+  if (n <= ps->context_histogram_cap)
+    return tcmplxA_Success;
+  else if (n > tcmplxA_brcvt_context_histograms_max
+      (tcmplxA_blockbuf_capacity(ps->buffer)))
+  {
+    return tcmplxA_ErrMemory;
+  }
+  ae = tcmplxA_brcvt_capcheck(ps,
+    ps->context_histogram_cap*histo_bytes, n*histo_bytes);
+  if (ae != tcmplxA_Success)
+    return ae;
+  histograms = tcmplxA_util_allocate(ps->alloc, n*histo_bytes);
+  if (histograms == NULL)
+    return tcmplxA_ErrMemory;
+  tcmplxA_util_deallocate(ps->alloc, ps->context_histogram);
+  ps->context_histogram = histograms;
+  ps->context_histogram_cap = n;
+  return tcmplxA_Success;
+}
+
+int tcmplxA_brcvt_reserve_distances(struct tcmplxA_brcvt* ps, size_t n) {
+  size_t const code_bytes = sizeof(struct tcmplxA_brcvt_distcode);
+  struct tcmplxA_brcvt_distcode* codes;
+  int ae;
+  if (n <= ps->distance_codes_cap)
+    return tcmplxA_Success;
+  else if (n > tcmplxA_blockbuf_capacity(ps->buffer)/2u+1u)
+    return tcmplxA_ErrMemory;
+  ae = tcmplxA_brcvt_capcheck(ps,
+    ps->distance_codes_cap*code_bytes, n*code_bytes);
+  if (ae != tcmplxA_Success)
+    return ae;
+  codes = tcmplxA_util_allocate(ps->alloc, n*code_bytes);
+  if (codes == NULL)
+    return tcmplxA_ErrMemory;
+  tcmplxA_util_deallocate(ps->alloc, ps->distance_codes);
+  ps->distance_codes = codes;
+  ps->distance_codes_cap = n;
+  return tcmplxA_Success;
+}
+
+int tcmplxA_brcvt_context_literals(struct tcmplxA_brcvt* ps,
+  struct tcmplxA_blockcmds const* cmds,
+  tcmplxA_uint32* const* type_histograms, size_t* bit_count)
+{
+  struct tcmplxA_ctxtmap* const map = ps->literals_map;
+  size_t const btypes = tcmplxA_ctxtmap_block_types(map);
+  size_t const total = btypes*tcmplxA_brcvt_LitContexts;
+  size_t const trees_max = tcmplxA_brcvt_literal_trees_max
+    (tcmplxA_blockbuf_capacity(ps->buffer));
+  unsigned char* const map_data = tcmplxA_ctxtmap_data(map);
+  tcmplxA_uint32* trees[tcmplxA_brcvt_LitTreesMax];
+  tcmplxA_uint32* ordered[tcmplxA_brcvt_LitTreesMax];
+  unsigned short parent[tcmplxA_brcvt_LitTreesMax];
+  unsigned short renumber[tcmplxA_brcvt_LitTreesMax];
+  size_t ntrees = 0;
+  tcmplxA_uint32 literals = 0;
+  size_t i, j;
+  int ae = tcmplxA_Success;
+  for (i = 0; i < cmds->count; ++i)
+    literals += cmds->insert_lens[i];
+  if (ps->quick_tf || literals < tcmplxA_brcvt_ContextMinLiterals
+  ||  tcmplxA_brcvt_reserve_contexts(ps, total) != tcmplxA_Success)
+  {
+    /* fall back to one prefix tree per block type */
+    for (j = 0; j < total; ++j)
+      map_data[j] = (unsigned char)(j/tcmplxA_brcvt_LitContexts);
+    for (j = 0; j < btypes; ++j)
+      trees[j] = type_histograms[j];
+    ntrees = btypes;
+  } else {
+    tcmplxA_uint32* const histograms = ps->context_histogram;
+    unsigned char const* const data = tcmplxA_blockbuf_input_data(ps->buffer);
+    tcmplxA_uint32 const data_size = tcmplxA_blockbuf_input_size(ps->buffer);
+    size_t const per_type = trees_max/btypes;
+    unsigned char ctxt[2];
+    unsigned char const* lut = tcmplxA_ctxtmap_literal_lut
+      (tcmplxA_ctxtmap_get_mode(map, 0));
+    size_t block = 0;
+    size_t btype = 0;
+    tcmplxA_uint32 pos = 0;
+    memcpy(ctxt, ps->fwd.literal_ctxt, sizeof(ctxt));
+    memset(histograms, 0, total*tcmplxA_brcvt_LitHistoSize*sizeof(tcmplxA_uint32));
+    /* gather one histogram per block type and literal context */
+    for (i = 0; i < cmds->count; ++i) {
+      unsigned char const* const literals =
+        cmds->literals + cmds->literal_offsets[i];
+      tcmplxA_uint32 const insert_len = cmds->insert_lens[i];
+      tcmplxA_uint32 k;
+      for (k = 0; k < insert_len; ++k, ++pos) {
+        unsigned ctxt_id;
+        if (block+1u < ps->split.count && ps->split.offsets[block+1u] <= pos) {
+          do {
+            block += 1u;
+          } while (block+1u < ps->split.count
+            && ps->split.offsets[block+1u] <= pos);
+          btype = ps->split.types[block];
+          lut = tcmplxA_ctxtmap_literal_lut(tcmplxA_ctxtmap_get_mode(map, btype));
+        }
+        ctxt_id = lut[ctxt[1]] | lut[256+ctxt[0]];
+        histograms[(btype*tcmplxA_brcvt_LitContexts + ctxt_id)
+          * tcmplxA_brcvt_LitHistoSize + literals[k]] += 1u;
+        ctxt[0] = ctxt[1];
+        ctxt[1] = literals[k];
+      }
+      if (cmds->copy_lens[i] > 0u) {
+        pos += cmds->copy_lens[i];
+        if (pos > data_size)
+          return tcmplxA_ErrSanitize;
+        tcmplxA_brcvt_keep_context(ctxt, data, pos);
+      }
+    }
+    /* cluster the contexts of each block type */
+    for (btype = 0; btype < btypes; ++btype) {
+      tcmplxA_uint32* used[tcmplxA_brcvt_LitContexts];
+      unsigned char used_ctxt[tcmplxA_brcvt_LitContexts];
+      size_t n = 0;
+      size_t k, m;
+      unsigned char tree;
+      for (j = 0; j < tcmplxA_brcvt_LitContexts; ++j) {
+        tcmplxA_uint32* const histogram = histograms
+          + (btype*tcmplxA_brcvt_LitContexts + j)*tcmplxA_brcvt_LitHistoSize;
+        for (k = 0; k < tcmplxA_brcvt_LitHistoSize; ++k) {
+          if (histogram[k] > 0u)
+            break;
+        }
+        if (k < tcmplxA_brcvt_LitHistoSize) {
+          used[n] = histogram;
+          used_ctxt[n] = (unsigned char)j;
+          n += 1;
+        }
+      }
+      if (n == 0) {
+        used[0] = histograms
+          + btype*tcmplxA_brcvt_LitContexts*tcmplxA_brcvt_LitHistoSize;
+        used_ctxt[0] = 0;
+        n = 1;
+      }
+      tcmplxA_brcvt_cluster(used, n, tcmplxA_brcvt_LitHistoSize,
+        per_type, parent, ps->cluster_pairs);
+      for (m = 0; m < n; ++m) {
+        if (parent[m] == m) {
+          renumber[m] = (unsigned short)ntrees;
+          trees[ntrees] = used[m];
+          ntrees += 1;
+        }
+      }
+      /* point unused contexts at the tree of the context before them */
+      tree = (unsigned char)renumber[parent[0]];
+      for (j = 0, m = 0; j < tcmplxA_brcvt_LitContexts; ++j) {
+        if (m < n && used_ctxt[m] == j) {
+          tree = (unsigned char)renumber[parent[m]];
+          m += 1;
+        }
+        map_data[btype*tcmplxA_brcvt_LitContexts + j] = tree;
+      }
+    }
+    /* merge similar trees across block types */
+    if (ntrees > 1u) {
+      tcmplxA_brcvt_cluster(trees, ntrees, tcmplxA_brcvt_LitHistoSize,
+        trees_max, parent, ps->cluster_pairs);
+      for (j = 0; j < total; ++j)
+        map_data[j] = (unsigned char)parent[map_data[j]];
+    }
+  }
+  /* number the trees by first use */
+  for (j = 0; j < ntrees; ++j)
+    renumber[j] = USHRT_MAX;
+  for (i = 0, j = 0; j < total; ++j) {
+    unsigned char const tree = map_data[j];
+    if (renumber[tree] == USHRT_MAX) {
+      renumber[tree] = (unsigned short)i;
+      ordered[i] = trees[tree];
+      i += 1;
+    }
+    map_data[j] = (unsigned char)renumber[tree];
+  }
+  ntrees = i;
+  if ((!ps->literals_forest) || tcmplxA_gaspvec_size(ps->literals_forest) != ntrees) {
+    ae = tcmplxA_brcvt_capcheck(ps,
+      ps->literals_forest ? tcmplxA_gaspvec_memory_usage(ps->literals_forest) : 0u,
+      tcmplxA_gaspvec_memory_bound(ntrees, tcmplxA_brcvt_LitHistoSize));
+    if (ae != tcmplxA_Success)
+      return ae;
+    tcmplxA_gaspvec_destroy(ps->literals_forest);
+    ps->literals_forest = tcmplxA_gaspvec_new_alloc(ntrees, ps->alloc);
+    if (!ps->literals_forest)
+      return tcmplxA_ErrMemory;
+  }
+  for (j = 0; j < ntrees; ++j) {
+    *bit_count += tcmplxA_brcvt_apply_histogram(ps->literals_forest, j,
+      ordered[j], tcmplxA_brcvt_LitHistoSize, &ae);
+  }
+  *bit_count += tcmplxA_brcvt_map_cost(map, ntrees);
+  return ae;
+}
+
+int tcmplxA_brcvt_context_distances(struct tcmplxA_brcvt* ps,
+  tcmplxA_uint32* histograms, size_t* bit_count)
+{
+  tcmplxA_uint32* used[tcmplxA_brcvt_DistContexts];
+  unsigned short parent[tcmplxA_brcvt_DistContexts];
+  unsigned short renumber[tcmplxA_brcvt_DistContexts];
+  unsigned char used_ctxt[tcmplxA_brcvt_DistContexts];
+  unsigned char* map_data;
+  size_t const alphabet = tcmplxA_brcvt_distance_alphabet(ps->ring);
+  size_t ntrees = 0;
+  size_t n = 0;
+  size_t j, m;
+  int tree;
+  int ae = tcmplxA_Success;
+  if (!ps->distance_map) {
+    ps->distance_map = tcmplxA_ctxtmap_new_alloc
+      (1, tcmplxA_brcvt_DistContexts, ps->alloc);
+    if (!ps->distance_map)
+      return tcmplxA_ErrMemory;
+  }
+  map_data = tcmplxA_ctxtmap_data(ps->distance_map);
+  for (j = 0; j < tcmplxA_brcvt_DistContexts; ++j) {
+    tcmplxA_uint32* const histogram = histograms + j*tcmplxA_brcvt_DistHistoSize;
+    for (m = 0; m < alphabet; ++m) {
+      if (histogram[m] > 0u)
+        break;
+    }
+    if (m < alphabet) {
+      used[n] = histogram;
+      used_ctxt[n] = (unsigned char)j;
+      n += 1;
+    }
+  }
+  if (n == 0) {
+    used[0] = histograms;
+    used_ctxt[0] = 0;
+    n = 1;
+  }
+  tcmplxA_brcvt_cluster(used, n, alphabet, n, parent, ps->cluster_pairs);
+  for (m = 0; m < n; ++m) {
+    if (parent[m] == m) {
+      renumber[m] = (unsigned short)ntrees;
+      used[ntrees] = used[m];
+      ntrees += 1;
+    }
+  }
+  tree = renumber[parent[0]];
+  for (j = 0, m = 0; j < tcmplxA_brcvt_DistContexts; ++j) {
+    if (m < n && used_ctxt[m] == j) {
+      tree = renumber[parent[m]];
+      m += 1;
+    }
+    map_data[j] = (unsigned char)tree;
+  }
+  if ((!ps->distance_forest) || tcmplxA_gaspvec_size(ps->distance_forest) != ntrees) {
+    ae = tcmplxA_brcvt_capcheck(ps,
+      ps->distance_forest ? tcmplxA_gaspvec_memory_usage(ps->distance_forest) : 0u,
+      tcmplxA_gaspvec_memory_bound(ntrees, alphabet));
+    if (ae != tcmplxA_Success)
+      return ae;
+    tcmplxA_gaspvec_destroy(ps->distance_forest);
+    ps->distance_forest = tcmplxA_gaspvec_new_alloc(ntrees, ps->alloc);
+    if (!ps->distance_forest)
+      return tcmplxA_ErrMemory;
+  }
+  for (j = 0; j < ntrees; ++j) {
+    *bit_count += tcmplxA_brcvt_apply_histogram(ps->distance_forest, j,
+      used[j], alphabet, &ae);
+  }
+  *bit_count += tcmplxA_brcvt_map_cost(ps->distance_map, ntrees);
+  return ae;
+}
+
+size_t tcmplxA_brcvt_map_cost(struct tcmplxA_ctxtmap const* map,
+  size_t ntrees)
+{
+  size_t const total = tcmplxA_ctxtmap_block_types(map)
+    * tcmplxA_ctxtmap_contexts(map);
+  unsigned char const* const map_data = tcmplxA_ctxtmap_data_c(map);
+  size_t const code_bits = tcmplxA_util_bitwidth((unsigned)ntrees) + 2u;
+  size_t changes = 0;
+  size_t j;
+  if (ntrees <= 1u)
+    return 0u;
+  /* runs of repeats cost a few bits; each change costs a tree index */
+  for (j = 1; j < total; ++j) {
+    if (map_data[j] != map_data[j-1u])
+      changes += 1u;
+  }
+  return (changes+1u)*code_bits + ntrees*4u + 8u;
+}
+
+size_t tcmplxA_brcvt_distance_alphabet(struct tcmplxA_ringdist const* ring) {
+  return 16u + tcmplxA_ringdist_get_direct(ring)
+    + (48u << tcmplxA_ringdist_get_postfix(ring));
+}
+
+int tcmplxA_brcvt_distance_params(struct tcmplxA_brcvt* ps,
+  struct tcmplxA_blockcmds const* cmds)
+{
+  tcmplxA_uint32 histogram[tcmplxA_brcvt_DistHistoSize];
+  size_t best_cost = ~(size_t)0;
+  unsigned best_direct = tcmplxA_ringdist_get_direct(ps->ring);
+  unsigned best_postfix = tcmplxA_ringdist_get_postfix(ps->ring);
+  unsigned postfix;
+  for (postfix = 0u; postfix <= 3u; ++postfix) {
+    size_t last_cost = ~(size_t)0;
+    unsigned direct_msb;
+    for (direct_msb = 0u; direct_msb <= 15u; ++direct_msb) {
+      unsigned const direct = direct_msb<<postfix;
+      tcmplxA_uint32 accum = ps->fwd.accum;
+      size_t cost = 0u;
+      size_t i;
+      int ae;
+      tcmplxA_ringdist_copy(ps->try_ring, ps->ring);
+      ae = tcmplxA_ringdist_reconfigure(ps->try_ring, 1, direct, postfix);
+      if (ae != tcmplxA_Success)
+        return ae;
+      memset(histogram, 0, sizeof(histogram));
+      /* follow the commands the way the token generator does */
+      for (i = 0; i < cmds->count; ++i) {
+        tcmplxA_uint32 const distance = cmds->distances[i];
+        unsigned short const copy_len = (unsigned short)cmds->copy_lens[i];
+        tcmplxA_uint32 extra = 0;
+        tcmplxA_uint32 flat;
+        unsigned cmd;
+        accum += cmds->insert_lens[i];
+        if (accum >= 16777200u)
+          accum = 16777200u;
+        if (copy_len == 0u)
+          continue;
+        flat = tcmplxA_brcvt_flat_distance
+          (distance, copy_len, accum, ps->wbits_select);
+        if (flat == 0u)
+          return tcmplxA_ErrSanitize;
+        cmd = tcmplxA_ringdist_encode(ps->try_ring, flat, &extra,
+          (distance & tcmplxA_BlockBuf_BDictRef) ? 0 : 0xFFffFFff);
+        if (cmd >= tcmplxA_brcvt_DistHistoSize)
+          return tcmplxA_ErrSanitize;
+        histogram[cmd] += 1u;
+        cost += tcmplxA_ringdist_bit_count(ps->try_ring, cmd);
+        accum += copy_len;
+      }
+      cost += tcmplxA_brcvt_histogram_cost(histogram, NULL,
+        tcmplxA_brcvt_distance_alphabet(ps->try_ring), 1);
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_direct = direct;
+        best_postfix = postfix;
+      }
+      /* more direct codes rarely help once they stop helping */
+      if (cost > last_cost)
+        break;
+      last_cost = cost;
+    }
+  }
+  return tcmplxA_ringdist_reconfigure(ps->ring, 1, best_direct, best_postfix);
+}
+
+tcmplxA_uint32* tcmplxA_brcvt_quick_literals(struct tcmplxA_brcvt* ps) {
+  return ps->histogram + tcmplxA_brcvt_InsHistoSize
+    + tcmplxA_brcvt_DistHistoSize*tcmplxA_brcvt_DistContexts;
+}
+
+int tcmplxA_brcvt_quick_histograms(struct tcmplxA_brcvt* ps,
+  tcmplxA_uint32* insert_histogram, tcmplxA_uint32* distance_histogram,
+  tcmplxA_uint32* literal_histogram)
+{
+  size_t const alphabet = tcmplxA_brcvt_distance_alphabet(ps->ring);
+  size_t i;
+  /* the start of the block weighs as much as the whole block before */{
+    tcmplxA_uint32 accum = ps->fwd.accum;
+    struct tcmplxA_blockcmds cmds;
+    int const ae = tcmplxA_blockbuf_step_commands(ps->buffer,
+      tcmplxA_blockbuf_input_size(ps->buffer)/tcmplxA_brcvt_QuickSample);
+    if (ae != tcmplxA_Success && ae != tcmplxA_ErrPartial)
+      return ae;
+    cmds = tcmplxA_blockbuf_commands(ps->buffer);
+    for (i = 0; i < cmds.count; ++i) {
+      tcmplxA_uint32 const insert_len = cmds.insert_lens[i];
+      tcmplxA_uint32 const copy_len = cmds.copy_lens[i];
+      unsigned char const* const literals =
+        cmds.literals + cmds.literal_offsets[i];
+      size_t const icv = tcmplxA_inscopy_encode(ps->values, insert_len,
+        copy_len ? (unsigned short)copy_len : 2, 0);
+      struct tcmplxA_inscopy_row const* const icv_row =
+        tcmplxA_inscopy_at_c(ps->values, icv);
+      tcmplxA_uint32 k;
+      if (!icv_row)
+        return tcmplxA_ErrSanitize;
+      insert_histogram[icv_row->code] += tcmplxA_brcvt_QuickSample;
+      accum += insert_len;
+      if (accum >= 16777200u)
+        accum = 16777200u;
+      for (k = 0; k < insert_len; ++k)
+        literal_histogram[literals[k]] += tcmplxA_brcvt_QuickSample;
+      if (copy_len > 0) {
+        tcmplxA_uint32 const distance = cmds.distances[i];
+        tcmplxA_uint32 const flat = tcmplxA_brcvt_flat_distance
+          (distance, (unsigned short)copy_len, accum, ps->wbits_select);
+        tcmplxA_uint32 extra = 0;
+        unsigned cmd;
+        if (flat == 0u)
+          return tcmplxA_ErrSanitize;
+        cmd = tcmplxA_ringdist_encode(ps->try_ring, flat, &extra,
+          (distance & tcmplxA_BlockBuf_BDictRef) ? 0 : 0xFFffFFff);
+        if (cmd >= tcmplxA_brcvt_DistHistoSize)
+          return tcmplxA_ErrSanitize;
+        distance_histogram[cmd] += tcmplxA_brcvt_QuickSample;
+        accum += copy_len;
+      }
+    }
+  }
+  /* output always writes the distance */
+  for (i = tcmplxA_brcvt_InsZeroCodes; i < tcmplxA_brcvt_InsHistoSize; ++i)
+    insert_histogram[i] += 1u;
+  for (i = 0; i < alphabet; ++i)
+    distance_histogram[i] += 1u;
+  for (i = 0; i < tcmplxA_brcvt_LitHistoSize; ++i)
+    literal_histogram[i] += 1u;
+  return tcmplxA_Success;
+}
+
+static int tcmplxA_brcvt_check_compress(struct tcmplxA_brcvt* ps) {
+  size_t btypes = 0;
+  size_t btype_j;
+  size_t try_bit_count = 0;
+  unsigned int ctxt_i;
+  /** @brief Histogram index for each block type. */
+  unsigned short slots[tcmplxA_brcvt_SplitTypesMax] = {0};
+  tcmplxA_uint32* type_histograms[tcmplxA_brcvt_SplitTypesMax];
+  int block_ae;
+  tcmplxA_blockbuf_clear_output(ps->buffer);
+  if (tcmplxA_blockbuf_probe_flat(ps->buffer)) {
+    /* skip the match search for incompressible data */
+    tcmplxA_uint32 const input_size = tcmplxA_blockbuf_input_size(ps->buffer);
+    if (tcmplxA_blockbuf_bypass(ps->buffer,
+          tcmplxA_blockbuf_input_data(ps->buffer), input_size) != input_size)
+      return tcmplxA_ErrMemory;
+    return tcmplxA_ErrBlockOverflow;
+  }
+  if (ps->memory_cap > 0u) {
+    /* keep the match search scratch under the cap too */
+    size_t const usage = tcmplxA_brcvt_memory_usage(ps);
+    tcmplxA_blockbuf_set_scratch_cap(ps->buffer,
+      usage < ps->memory_cap ? ps->memory_cap-usage : 0u);
+  }
+  ps->stream_tf = ps->quick_tf;
+  if (ps->stream_tf) {
+    /* the search runs as the commands go out */
+    block_ae = tcmplxA_blockbuf_start_commands(ps->buffer);
+    if (block_ae != tcmplxA_Success)
+      return block_ae;
+  } else {
+    block_ae = tcmplxA_blockbuf_try_commands(ps->buffer);
+    if (block_ae != tcmplxA_Success)
+      return block_ae;
+    block_ae = tcmplxA_brcvt_reserve_distances
+      (ps, tcmplxA_blockbuf_commands(ps->buffer).count);
+    if (block_ae != tcmplxA_Success)
+      return block_ae;
+  }
+  ps->guesses = tcmplxA_brcvt_guess_zero;
+  if (!ps->quick_tf) {
+    tcmplxA_ctxtspan_subdivide(&ps->guesses,
+      tcmplxA_blockbuf_input_data(ps->buffer),
+      tcmplxA_blockbuf_input_size(ps->buffer), tcmplxA_BrCvt_Margin);
+  }
+  ps->split.count = 0;
+  ps->context_encode.sz = 0;
+  /* prepare the fixed-size forests */{
+    if (!ps->insert_forest) {
+      block_ae = tcmplxA_brcvt_capcheck
+        (ps, 0u, tcmplxA_gaspvec_memory_bound(1u, 704u));
+      if (block_ae != tcmplxA_Success)
+        return block_ae;
+      ps->insert_forest = tcmplxA_gaspvec_new_alloc(1, ps->alloc);
+      if (!ps->insert_forest)
+        return tcmplxA_ErrMemory;
+    }
+  }
+  /* choose the distance parameters, then
+  * synchronize the distance scratch space with actual output.
+  * (Uncompress blocks can introduce drift.) */{
+    struct tcmplxA_blockcmds const cmds = tcmplxA_blockbuf_commands(ps->buffer);
+    int const ae = ps->quick_tf
+      ? tcmplxA_ringdist_reconfigure(ps->ring, 1, 0u, 0u)
+      : tcmplxA_brcvt_distance_params(ps, &cmds);
+    if (ae != tcmplxA_Success)
+      return ae;
+  }
+  tcmplxA_ringdist_copy(ps->try_ring, ps->ring);
+  /* fill the histograms and build prefix trees */{
+    tcmplxA_uint32 *const insert_histogram = ps->histogram;
+    tcmplxA_uint32 *const distance_histogram = insert_histogram+tcmplxA_brcvt_InsHistoSize;
+    struct tcmplxA_brcvt_splitter splitter = {0};
+    struct tcmplxA_brcvt_split const whole = {0};
+    struct tcmplxA_brcvt_forward try_fwd = {0};
+    struct tcmplxA_blockcmds const cmds = tcmplxA_blockbuf_commands(ps->buffer);
+    size_t span_i = 0;
+    int ae = tcmplxA_Success;
+    try_fwd.accum = ps->fwd.accum;
+    splitter.types_max = ps->literal_types_max;
+    splitter.histograms = distance_histogram
+      + tcmplxA_brcvt_DistHistoSize*tcmplxA_brcvt_DistContexts;
+    splitter.modes = splitter.histograms
+      + (splitter.types_max+1u)*tcmplxA_brcvt_LitHistoSize;
+    if (ps->stream_tf) {
+      /* one block type and one distance context, counted ahead */
+      ae = tcmplxA_brcvt_quick_histograms(ps, insert_histogram,
+        distance_histogram, splitter.histograms);
+      if (ae != tcmplxA_Success)
+        return ae;
+    } else memset(ps->histogram, 0, sizeof(tcmplxA_uint32)
+      * tcmplxA_brcvt_histogram_size(ps->literal_types_max));
+    while (!ps->stream_tf && try_fwd.i < cmds.count) {
+      /* position of the next literal, before any copy that follows it */
+      tcmplxA_uint32 const offset = try_fwd.pos;
+      struct tcmplxA_brcvt_token next =
+        tcmplxA_brcvt_next_token(&try_fwd, &whole, &cmds, ps->wbits_select, 0);
+      switch (next.state) {
+      case tcmplxA_BrCvt_DataInsertCopy:
+        /* */{
+          size_t const icv = tcmplxA_inscopy_encode(ps->values, next.first,
+            next.second ? next.second : 2, 0);
+          struct tcmplxA_inscopy_row const* const icv_row =
+            tcmplxA_inscopy_at_c(ps->values, icv);
+          if (!icv_row)
+            return tcmplxA_ErrSanitize;
+          assert(icv_row->code < 704u);
+          insert_histogram[icv_row->code] += 1;
+          try_bit_count += icv_row->insert_bits;
+          try_bit_count += icv_row->copy_bits;
+        } break;
+      case tcmplxA_BrCvt_Literal:
+        /* */{
+          tcmplxA_uint32* const chunk = splitter.histograms
+            + splitter.types_max*tcmplxA_brcvt_LitHistoSize;
+          while (span_i+1u < ps->guesses.count
+          &&  ps->guesses.offsets[span_i+1u] <= offset)
+          {
+            span_i += 1;
+          }
+          if (splitter.chunk_len == 0)
+            splitter.chunk_offset = offset;
+          chunk[next.first&255u] += 1;
+          splitter.chunk_modes[ps->guesses.modes[span_i]&3u] += 1;
+          splitter.chunk_len += 1;
+          if (splitter.chunk_len >= tcmplxA_brcvt_SplitChunk)
+            tcmplxA_brcvt_split_chunk(&ps->split, &splitter);
+        } break;
+      case tcmplxA_BrCvt_Distance:
+      case tcmplxA_BrCvt_BDict:
+        /* */{
+          int const to_record = (next.state==tcmplxA_BrCvt_Distance);
+          tcmplxA_uint32 extra = 0;
+          // TODO: use `to_record`
+          int const column =
+            tcmplxA_ctxtmap_distance_context(try_fwd.command_span);
+          unsigned const cmd = tcmplxA_ringdist_encode(ps->try_ring, next.first, &extra,
+            to_record ? 0xFFffFFff : 0);
+          struct tcmplxA_brcvt_distcode* const code =
+            ps->distance_codes + (try_fwd.i-1u);
+          if (cmd >= tcmplxA_brcvt_DistHistoSize || column < 0)
+            return tcmplxA_ErrSanitize;
+          /* keep the code for output, which follows the same tokens */
+          code->code = (unsigned short)cmd;
+          code->extra = extra;
+          try_bit_count += tcmplxA_ringdist_bit_count(ps->try_ring, cmd);
+          distance_histogram[column*tcmplxA_brcvt_DistHistoSize + cmd] += 1;
+        } break;
+      default:
+        return tcmplxA_ErrSanitize;
+      }
+    }
+    if (!ps->quick_tf) {
+      tcmplxA_brcvt_split_chunk(&ps->split, &splitter);
+      btypes = tcmplxA_brcvt_split_cluster
+        (&ps->split, &splitter, slots, ps->cluster_pairs);
+    }
+    /* a block of copies alone still needs one literal block type */
+    if (btypes == 0)
+      btypes = 1;
+    ps->blocktypeL_index = tcmplxA_brcvt_btype_zero;
+    if (btypes > 1) {
+      /* prepare the block type codes */
+      tcmplxA_uint32 histogram[tcmplxA_brcvt_SplitTypesMax+2u] = {0};
+      struct tcmplxA_brcvt_block box = tcmplxA_brcvt_btype_zero;
+      unsigned char const max_type = (unsigned char)(btypes-1u);
+      size_t j;
+      ae = tcmplxA_fixlist_resize(&ps->literal_blocktype, btypes+2u);
+      if (ae != tcmplxA_Success)
+        return ae;
+      for (j = 0; j < btypes+2u; ++j)
+        tcmplxA_fixlist_at(&ps->literal_blocktype, j)->value = (unsigned)j;
+      for (j = 1; j < ps->split.count; ++j) {
+        unsigned const code =
+          tcmplxA_brcvt_blocktype_code(box, max_type, ps->split.types[j]);
+        histogram[code] += 1;
+        box = tcmplxA_brcvt_switch_blocktype(box, max_type, code);
+      }
+      ae = tcmplxA_fixlist_gen_lengths(&ps->literal_blocktype, histogram, 15);
+      if (ae != tcmplxA_Success)
+        return ae;
+      ae = tcmplxA_fixlist_gen_codes(&ps->literal_blocktype);
+      if (ae != tcmplxA_Success)
+        return ae;
+      for (j = 0; j < btypes+2u; ++j) {
+        try_bit_count += histogram[j]
+          * (size_t)tcmplxA_fixlist_at_c(&ps->literal_blocktype, j)->len;
+      }
+      for (j = 0; j < ps->split.count; ++j) {
+        size_t const icv = tcmplxA_inscopy_encode
+          (ps->blockcounts, ps->split.lengths[j], 0, 0);
+        struct tcmplxA_inscopy_row const* const icv_row =
+          tcmplxA_inscopy_at_c(ps->blockcounts, icv);
+        if (!icv_row)
+          return tcmplxA_ErrSanitize;
+        try_bit_count += icv_row->insert_bits + tcmplxA_brcvt_BlockCountBits;
+      }
+      /* both tree descriptions */
+      try_bit_count += (btypes+2u+26u)*4u;
+    }
+    try_bit_count += 4 + 2*btypes;
+    if ((!ps->literals_map) || tcmplxA_ctxtmap_block_types(ps->literals_map) != btypes) {
+      ae = tcmplxA_brcvt_capcheck(ps,
+        ps->literals_map ? tcmplxA_ctxtmap_memory_usage(ps->literals_map) : 0u,
+        tcmplxA_ctxtmap_memory_bound(btypes, 64u));
+      if (ae != tcmplxA_Success)
+        return ae;
+      tcmplxA_ctxtmap_destroy(ps->literals_map);
+      ps->literals_map = tcmplxA_ctxtmap_new_alloc(btypes, 64, ps->alloc);
+      if (!ps->literals_map)
+        return tcmplxA_ErrMemory;
+    }
+    for (btype_j = 0; btype_j < btypes; ++btype_j) {
+      /* use the context mode most of the block type's literals prefer */
+      tcmplxA_uint32 const* const modes =
+        splitter.modes + slots[btype_j]*tcmplxA_CtxtMap_ModeMax;
+      int mode = 0;
+      for (ctxt_i = 1; ctxt_i < tcmplxA_CtxtMap_ModeMax; ++ctxt_i) {
+        if (modes[ctxt_i] > modes[mode])
+          mode = (int)ctxt_i;
+      }
+      tcmplxA_ctxtmap_set_mode(ps->literals_map, btype_j, mode);
+      type_histograms[btype_j] =
+        splitter.histograms + slots[btype_j]*tcmplxA_brcvt_LitHistoSize;
+    }
+    if (btypes <= 1)
+      ps->blocktypeL_skip = 0;
+    else
+      ps->blocktypeL_skip = tcmplxA_brcvt_NoSkip;
+    /* cluster the contexts and apply histograms to the trees */
+    ae = tcmplxA_brcvt_context_literals
+      (ps, &cmds, type_histograms, &try_bit_count);
+    if (ae != tcmplxA_Success)
+      return ae;
+    ae = tcmplxA_brcvt_context_distances
+      (ps, distance_histogram, &try_bit_count);
+    if (ae != tcmplxA_Success)
+      return ae;
+    try_bit_count += tcmplxA_brcvt_apply_histogram(
+      ps->insert_forest,0, insert_histogram,
+      tcmplxA_brcvt_InsHistoSize, &ae);
+    if (ae != tcmplxA_Success)
+      return ae;
+    tcmplxA_brcvt_literal_select(ps);
+  }
+  if (ps->stream_tf) {
+    /* output counts its own codes for the next meta-block */
+    memset(ps->histogram, 0, sizeof(tcmplxA_uint32)
+      * tcmplxA_brcvt_histogram_size(ps->literal_types_max));
+    return tcmplxA_Success;
+  } else if (try_bit_count/8+1 > tcmplxA_blockbuf_input_size(ps->buffer))
     return tcmplxA_ErrBlockOverflow;
+  /* output reuses the trial distance codes, so take their ring too */
+  tcmplxA_ringdist_copy(ps->ring, ps->try_ring);
   return tcmplxA_Success;
 }
 
+tcmplxA_uint32 tcmplxA_brcvt_block_capacity
+  (struct tcmplxA_brcvt const* ps)
+{
+  tcmplxA_uint32 capacity = tcmplxA_blockbuf_capacity(ps->buffer);
+  if (ps->quick_tf && capacity > tcmplxA_brcvt_QuickBlockSize)
+    capacity = tcmplxA_brcvt_QuickBlockSize;
+  if (ps->latency > 0u && capacity > ps->latency)
+    capacity = ps->latency;
+  return capacity;
+}
+
+tcmplxA_uint32 tcmplxA_brcvt_meta_boundary
+  (struct tcmplxA_brcvt const* ps, tcmplxA_uint32 input_len)
+{
+  tcmplxA_uint32 const window =
+    tcmplxA_brcvt_MetaChunk*tcmplxA_brcvt_MetaLookahead;
+  unsigned char const* const data = tcmplxA_blockbuf_input_data(ps->buffer);
+  tcmplxA_uint32 histogram[256] = {0};
+  tcmplxA_uint32 ahead[256];
+  tcmplxA_uint32 pos;
+  tcmplxA_uint32 i;
+  if (ps->quick_tf)
+    return input_len;
+  for (i = 0; i < tcmplxA_brcvt_MetaChunk && i < input_len; ++i)
+    histogram[data[i]] += 1u;
+  for (pos = tcmplxA_brcvt_MetaChunk; pos + window <= input_len;
+      pos += tcmplxA_brcvt_MetaChunk)
+  {
+    size_t together, apart;
+    memset(ahead, 0, sizeof(ahead));
+    for (i = 0; i < window; ++i)
+      ahead[data[pos+i]] += 1u;
+    together = tcmplxA_brcvt_histogram_cost(histogram, ahead, 256, 1);
+    apart = tcmplxA_brcvt_histogram_cost(histogram, NULL, 256, 1)
+      + tcmplxA_brcvt_histogram_cost(ahead, NULL, 256, 1)
+      + tcmplxA_brcvt_MetaShiftBits;
+    if (apart < together)
+      return pos;
+    for (i = 0; i < tcmplxA_brcvt_MetaChunk; ++i)
+      histogram[data[pos+i]] += 1u;
+  }
+  return input_len;
+}
+
 size_t tcmplxA_brcvt_apply_histogram(struct tcmplxA_gaspvec* tree_list,
   size_t tree_index,
   tcmplxA_uint32 const* histogram, size_t histogram_size,
@@ -3318,7 +5143,7 @@ size_t tcmplxA_brcvt_apply_histogram(struct tcmplxA_gaspvec* tree_list,
 int tcmplxA_brcvt_encode_map(struct tcmplxA_blockstr* buffer, size_t zeroes,
     int map_datum, unsigned* rlemax_ptr)
 {
-  unsigned char code[3] = {0};
+  unsigned char code[4] = {0};
   int len = 0;
   if (zeroes > 0) {
     code[len] = tcmplxA_util_bitwidth((unsigned)zeroes)-1u;
@@ -3326,42 +5151,49 @@ int tcmplxA_brcvt_encode_map(struct tcmplxA_blockstr* buffer, size_t zeroes,
     if (zeroes > 1) {
       if (code[0] > *rlemax_ptr)
         *rlemax_ptr = code[0];
-      code[0] |= tcmplxA_brcvt_ZeroBit;
       code[len] = (unsigned char)(((1u<<code[0])-1u)&zeroes);
+      code[0] |= tcmplxA_brcvt_ZeroBit;
       len += 1;
     }
   }
   if (map_datum) {
-    code[len] = map_datum;
+    if (map_datum >= tcmplxA_brcvt_ZeroBit) {
+      /* tree indices past the flag bits take an escape byte */
+      code[len] = tcmplxA_brcvt_RepeatBit;
+      len += 1;
+    }
+    code[len] = (unsigned char)map_datum;
     len += 1;
   }
   return tcmplxA_blockstr_append(buffer, code, len);
 }
 
 static int tcmplxA_brcvt_apply_token_checked(struct tcmplxA_brcvt* ps) {
-  size_t loop_i;
-  size_t const size = tcmplxA_blockbuf_output_size(ps->buffer);
-  unsigned char const* const data = tcmplxA_blockbuf_output_data(ps->buffer);
-  if (ps->fwd.i >= size) {
-    tcmplxA_blockbuf_clear_input(ps->buffer);
-    tcmplxA_brcvt_next_block(ps);
-    return tcmplxA_Success;
-  }
-  for (loop_i = 0; loop_i < size; ++loop_i) {
-    size_t const old_fwd_index = ps->fwd.i;
-    struct tcmplxA_brcvt_token const next =
-      tcmplxA_brcvt_next_token(&ps->fwd, &ps->guesses, data, size, ps->wbits_select,
-        ps->blocktypeL_skip);
+  for (;;) {
+    struct tcmplxA_blockcmds const cmds = tcmplxA_blockbuf_commands(ps->buffer);
     int ae = tcmplxA_Success;
-    if (ps->fwd.i <= old_fwd_index && next.state != tcmplxA_BrCvt_LiteralRestart)
-      return tcmplxA_ErrSanitize;
-    ps->state = next.state;
-    ae = tcmplxA_brcvt_apply_token(ps, next);
-    if (ae != tcmplxA_ErrPartial)
-      return ae;
-    else if (ps->fwd.i >= size)
-      break;
+    if (ps->fwd.i < cmds.count) {
+      struct tcmplxA_brcvt_token next;
+      /* a streaming search may have found more commands since */
+      if (ps->fwd.ostate == tcmplxA_BrCvt_Done)
+        ps->fwd.ostate = tcmplxA_BrCvt_DataInsertCopy;
+      next = tcmplxA_brcvt_next_token(&ps->fwd, &ps->split, &cmds,
+        ps->wbits_select, ps->blocktypeL_skip);
+      ps->state = next.state;
+      ae = tcmplxA_brcvt_apply_token(ps, next);
+      if (ae != tcmplxA_ErrPartial)
+        return ae;
+    } else if (ps->stream_tf) {
+      ae = tcmplxA_blockbuf_step_commands(ps->buffer, tcmplxA_brcvt_QuickStep);
+      if (ae == tcmplxA_Success) {
+        /* the search is done, so stop once its commands are out */
+        if (ps->fwd.i >= tcmplxA_blockbuf_commands(ps->buffer).count)
+          break;
+      } else if (ae != tcmplxA_ErrPartial)
+        return ae;
+    } else break;
   }
+  ps->stream_tf = 0u;
   /* Guaranteed progress means this line only reached by end of buffer. */
   tcmplxA_blockbuf_clear_input(ps->buffer);
   tcmplxA_brcvt_next_block(ps);
@@ -3396,9 +5228,11 @@ static int tcmplxA_brcvt_strrtozs_bits
   for (i = ps->bit_index; i < 8u && ae == tcmplxA_Success; ++i) {
     unsigned int x = 0u;
     if (tcmplxA_brcvt_can_add_input(ps)) {
+      tcmplxA_uint32 const capacity = tcmplxA_brcvt_block_capacity(ps);
+      tcmplxA_uint32 const input_size =
+        tcmplxA_blockbuf_input_size(ps->buffer);
       tcmplxA_uint32 const input_space =
-          tcmplxA_blockbuf_capacity(ps->buffer)
-        - tcmplxA_blockbuf_input_size(ps->buffer);
+        (input_size < capacity) ? capacity - input_size : 0u;
       size_t const src_count = src_end - p;
       size_t const min_count = (input_space < src_count)
           ? (size_t)input_space : src_count;
@@ -3410,15 +5244,20 @@ static int tcmplxA_brcvt_strrtozs_bits
     switch (ps->state) {
     case tcmplxA_BrCvt_WBits: /* WBITS */
       if (ps->bit_length == 0u) {
-        struct tcmplxA_fixlist* const wbits = ps->wbits;
+        struct tcmplxA_fixlist const* const wbits = ps->wbits;
+        size_t j;
 #if (!defined NDEBUG) && (defined tcmplxA_BrCvt_LogErr)
         tcmplxA_brcvt_counter = 0;
 #endif //NDEBUG && tcmplxA_BrCvt_LogErr
-        tcmplxA_fixlist_valuesort(wbits);
         assert(ps->wbits_select >= 10 && ps->wbits_select <= 24);
+        /* the shared list is in code order, so look for the value */
+        for (j = 0u; j+1u < tcmplxA_fixlist_size(wbits); ++j) {
+          if (tcmplxA_fixlist_at_c(wbits, j)->value == ps->wbits_select)
+            break;
+        }
         {
           struct tcmplxA_fixline const* const line =
-            tcmplxA_fixlist_at_c(wbits, ps->wbits_select-10);
+            tcmplxA_fixlist_at_c(wbits, j);
           ps->bit_length = line->len;
           ps->count = 1u;
           ps->bits = line->code;
@@ -3507,12 +5346,22 @@ static int tcmplxA_brcvt_strrtozs_bits
       break;
     case tcmplxA_BrCvt_Nibbles:
       if (ps->bit_length == 0u) {
-        size_t const input_len = tcmplxA_blockbuf_input_size(ps->buffer);
-        if (input_len < tcmplxA_blockbuf_capacity(ps->buffer)
+        tcmplxA_uint32 input_len = tcmplxA_blockbuf_input_size(ps->buffer);
+        if (input_len < tcmplxA_brcvt_block_capacity(ps)
         &&  !(ps->h_end&2u) && !ps->emptymeta)
         {
           ae = tcmplxA_ErrPartial;
           break;
+        } else if (!ps->emptymeta) {
+          /* leave the rest of the input for the next meta-block */
+          tcmplxA_uint32 const end =
+            tcmplxA_brcvt_meta_boundary(ps, input_len);
+          if (end < input_len) {
+            ae = tcmplxA_blockbuf_hold_input(ps->buffer, end);
+            if (ae != tcmplxA_Success)
+              break;
+            input_len = end;
+          }
         }
         ps->bit_length = 3;
         ps->backward = (tcmplxA_uint32)input_len-1u;
@@ -3561,6 +5410,17 @@ static int tcmplxA_brcvt_strrtozs_bits
         int const want_compress = (tcmplxA_brcvt_check_compress(ps)==tcmplxA_Success);
         if (!want_compress) {
           x = 1;
+          if (ps->stream_tf) {
+            /* the window still takes the rest of the block */
+            ps->stream_tf = 0u;
+            ae = tcmplxA_blockbuf_step_commands(ps->buffer,
+              tcmplxA_blockbuf_input_size(ps->buffer));
+            if (ae != tcmplxA_Success)
+              break;
+          }
+          tcmplxA_brcvt_keep_context(ps->fwd.literal_ctxt,
+            tcmplxA_blockbuf_input_data(ps->buffer),
+            tcmplxA_blockbuf_input_size(ps->buffer));
           tcmplxA_blockbuf_clear_output(ps->buffer);
           ae = tcmplxA_blockbuf_noconv_block(ps->buffer);
           if (ae != tcmplxA_Success)
@@ -3579,38 +5439,21 @@ static int tcmplxA_brcvt_strrtozs_bits
     case tcmplxA_BrCvt_BlockTypesL:
       if (ps->bit_length == 0) {
         ps->count = 0;
-        switch (tcmplxA_fixlist_size(&ps->literal_blocktype)) {
-        case 0:
-        case 1:
-          ps->bit_length = 1;
-          ps->bits = 0;
-          break;
-        case 2:
-          ps->bit_length = 4;
-          ps->bits = 1;
-          break;
-        case 3:
-        case 4:
-          ps->bit_length = 5;
-          ps->bits = 3 | ((tcmplxA_fixlist_size(&ps->literal_blocktype)-3)<<4);
-          break;
-        default:
-          ae = tcmplxA_ErrSanitize;
-          break;
-        }
+        ps->bit_length = tcmplxA_brcvt_varlen_uint8((unsigned)
+          tcmplxA_ctxtmap_block_types(ps->literals_map)-1u, &ps->bits);
       }
       if (ps->count < ps->bit_length) {
         x = (ps->bits>>ps->count)&1u;
         ps->count += 1;
       }
       if (ps->count >= ps->bit_length) {
+        size_t const btypes = tcmplxA_ctxtmap_block_types(ps->literals_map);
         ps->bit_length = 0;
         tcmplxA_fixlist_close(&ps->treety.nineteen);
         tcmplxA_brcvt_reset19(&ps->treety);
-        ps->alphabits = 2u+(tcmplxA_fixlist_size(&ps->literal_blocktype)>=3);
-        if (tcmplxA_fixlist_size(&ps->literal_blocktype) > 1) {
+        if (btypes > 1) {
           ps->state += 1;
-          ps->alphabits = tcmplxA_util_bitwidth((unsigned)tcmplxA_fixlist_size(&ps->literal_blocktype)+1u);
+          ps->alphabits = tcmplxA_util_bitwidth((unsigned)btypes+1u);
 	} else
           ps->state += 4;
       } break;
@@ -3622,6 +5465,7 @@ static int tcmplxA_brcvt_strrtozs_bits
           ps->bit_length = 0;
           tcmplxA_brcvt_reset19(&ps->treety);
           ps->state += 1;
+          ae = tcmplxA_fixlist_valuesort(&ps->literal_blocktype);
         } else if (res != tcmplxA_Success)
           ae = res;
       } break;
@@ -3634,10 +5478,9 @@ static int tcmplxA_brcvt_strrtozs_bits
         unsigned short blockcountL_skip = tcmplxA_brcvt_NoSkip;
         unsigned blockcountL_population = 0;
         ps->bit_length = 1;
-        tcmplxA_inscopy_lengthsort(ps->blockcounts);
-        for (j = 0; j < ps->guesses.count; ++j) {
-          size_t const v = tcmplxA_inscopy_encode(ps->blockcounts, ps->guess_lengths[j], 0, 0);
-	  if (ps->guess_lengths[j] == 0)
+        for (j = 0; j < ps->split.count; ++j) {
+          size_t const v = tcmplxA_inscopy_encode(ps->blockcounts, ps->split.lengths[j], 0, 0);
+	  if (ps->split.lengths[j] == 0)
             continue;
           if (v >= 26) {
             ae = tcmplxA_ErrSanitize;
@@ -3648,7 +5491,7 @@ static int tcmplxA_brcvt_strrtozs_bits
             blockcountL_skip = (unsigned short)v;
           }
           histogram[v] += 1;
-          total += ps->guess_lengths[j];
+          total += ps->split.lengths[j];
         }
         assert(total <= tcmplxA_blockbuf_input_size(ps->buffer));
         if (ae != tcmplxA_Success)
@@ -3681,7 +5524,7 @@ static int tcmplxA_brcvt_strrtozs_bits
     case tcmplxA_BrCvt_BlockStartL:
       if (ps->bit_length == 0) {
         size_t const code_index =
-          tcmplxA_inscopy_encode(ps->blockcounts, ps->guess_lengths[0], 0,0);
+          tcmplxA_inscopy_encode(ps->blockcounts, ps->split.lengths[0], 0,0);
         struct tcmplxA_inscopy_row const* const row =
           tcmplxA_inscopy_at_c(ps->blockcounts, code_index);
         struct tcmplxA_fixline const* line;
@@ -3692,7 +5535,7 @@ static int tcmplxA_brcvt_strrtozs_bits
         }
         if (!tcmplxA_brcvt_outflow_lookup(ps, &ps->literal_blockcount, row->code, &ae))
           break;
-        ps->count = (ps->guess_lengths[0] - row->insert_first);
+        ps->count = (ps->split.lengths[0] - row->insert_first);
         ps->extra_length = row->insert_bits;
       }
       if (ps->bit_length < ps->bit_cap) {
@@ -3735,60 +5578,56 @@ static int tcmplxA_brcvt_strrtozs_bits
         ps->state = tcmplxA_BrCvt_ContextTypesL;
         ps->bit_length = 0;
         ps->count = 0;
+        ps->index = 0;
       } break;
     case tcmplxA_BrCvt_ContextTypesL:
-      if (ps->bit_length == 0) {
-        size_t const contexts = tcmplxA_ctxtmap_block_types(ps->literals_map);
-        size_t j;
-        for (j = 0; j < contexts; ++j) {
-          int const mode = tcmplxA_ctxtmap_get_mode(ps->literals_map, i);
-          ps->bits |= ((mode&3u)<<ps->bit_length);
-          ps->bit_length += 2;
-        }
-      }
-      if (ps->count < ps->bit_length) {
-        x = (ps->bits>>ps->count)&1u;
+      /* two bits of context mode per block type */{
+        int const mode = tcmplxA_ctxtmap_get_mode(ps->literals_map, ps->index);
+        x = ((unsigned)mode>>ps->count)&1u;
         ps->count += 1;
-      }
-      if (ps->count >= ps->bit_length) {
-        ps->state = tcmplxA_BrCvt_TreeCountL;
-        ps->bit_length = 0;
-        ps->count = 0;
+        if (ps->count >= 2) {
+          ps->count = 0;
+          ps->index += 1;
+        }
+        if (ps->index >= tcmplxA_ctxtmap_block_types(ps->literals_map)) {
+          ps->state = tcmplxA_BrCvt_TreeCountL;
+          ps->bit_length = 0;
+          ps->index = 0;
+        }
       } break;
     case tcmplxA_BrCvt_TreeCountL:
+    case tcmplxA_BrCvt_TreeCountD:
       if (ps->bit_length == 0) {
-        size_t const btypes = tcmplxA_fixlist_size(&ps->literal_blocktype);
+        struct tcmplxA_gaspvec const* const forest =
+          (ps->state == tcmplxA_BrCvt_TreeCountL)
+          ? ps->literals_forest : ps->distance_forest;
         ps->count = 0;
-        switch (btypes) {
-        case 1:
-          ps->bits = 0;
-          ps->bit_length = 1;
-          break;
-        case 2:
-          ps->bits = 1;
-          ps->bit_length = 4;
-          break;
-        default:
-          ps->bits = 3|(((btypes&1u)^1u)<<4);
-          ps->bit_length = 5;
-          break;
-        }
+        ps->bit_length = tcmplxA_brcvt_varlen_uint8((unsigned)
+          tcmplxA_gaspvec_size(forest)-1u, &ps->bits);
       }
       if (ps->count < ps->bit_length) {
         x = (ps->bits>>ps->count)&1u;
         ps->count += 1;
       }
       if (ps->count >= ps->bit_length) {
-        if (ps->count == 1)
-          ps->state = tcmplxA_BrCvt_TreeCountD;
-        else {
-          ps->state = tcmplxA_BrCvt_ContextRunMaxL;
+        int const literal = (ps->state == tcmplxA_BrCvt_TreeCountL);
+        if (ps->count == 1) {
+          /* a single tree needs no context map */
+          ps->state = literal
+            ? tcmplxA_BrCvt_TreeCountD : tcmplxA_BrCvt_GaspVectorL;
+        } else {
+          ps->state = literal
+            ? tcmplxA_BrCvt_ContextRunMaxL : tcmplxA_BrCvt_ContextRunMaxD;
         }
         ps->bit_length = 0;
+        ps->count = 0;
       } break;
     case tcmplxA_BrCvt_ContextRunMaxL:
+    case tcmplxA_BrCvt_ContextRunMaxD:
       if (ps->bit_length == 0) {
-        struct tcmplxA_ctxtmap* const map = ps->literals_map;
+        struct tcmplxA_ctxtmap* const map =
+          (ps->state == tcmplxA_BrCvt_ContextRunMaxL)
+          ? ps->literals_map : ps->distance_map;
         size_t const total = tcmplxA_ctxtmap_block_types(map)
           * tcmplxA_ctxtmap_contexts(map);
         size_t j = 0;
@@ -3823,16 +5662,18 @@ static int tcmplxA_brcvt_strrtozs_bits
         ps->count += 1;
       }
       if (ps->count >= ps->bit_length) {
-        size_t const btypes = tcmplxA_ctxtmap_block_types(ps->literals_map);
+        size_t const ntrees = tcmplxA_gaspvec_size
+          ((ps->state == tcmplxA_BrCvt_ContextRunMaxL)
+            ? ps->literals_forest : ps->distance_forest);
         tcmplxA_uint32 histogram[tcmplxA_brcvt_ContextHistogram] = {0};
         size_t j;
         unsigned int const rlemax = ps->rlemax;
-        unsigned char const alphabits = (unsigned char)(rlemax+btypes);
+        size_t const alphasize = rlemax+ntrees;
         /* calculate prefix tree */
-        ae = tcmplxA_fixlist_resize(&ps->context_tree, alphabits);
+        ae = tcmplxA_fixlist_resize(&ps->context_tree, alphasize);
         if (ae != tcmplxA_Success)
           break;
-	for (j = 0; j < alphabits; ++j)
+	for (j = 0; j < alphasize; ++j)
           tcmplxA_fixlist_at(&ps->context_tree, j)->value = (unsigned)j;
         for (j = 0; j < ps->context_encode.sz; ++j) {
           unsigned char const ch = ps->context_encode.p[j];
@@ -3845,7 +5686,13 @@ static int tcmplxA_brcvt_strrtozs_bits
             }
           } else if (!(ch & tcmplxA_brcvt_RepeatBit)) {
             histogram[ch&(tcmplxA_brcvt_ZeroBit-1)] += 1;
-          } else continue;
+            /* skip the extra bits that follow the run length code */
+            j += 1;
+          } else {
+            /* escaped tree index */
+            j += 1;
+            histogram[ps->context_encode.p[j]+rlemax] += 1;
+          }
         }
         ae = tcmplxA_fixlist_gen_lengths(&ps->context_tree, histogram, 8);
         if (ae != tcmplxA_Success)
@@ -3854,10 +5701,11 @@ static int tcmplxA_brcvt_strrtozs_bits
         if (ae != tcmplxA_Success)
           break;
         tcmplxA_brcvt_reset19(&ps->treety);
-        ps->alphabits = alphabits;
+        ps->alphabits = (unsigned char)tcmplxA_util_bitwidth((unsigned)(alphasize-1u));
         ps->state += 1;
       } break;
     case tcmplxA_BrCvt_ContextPrefixL:
+    case tcmplxA_BrCvt_ContextPrefixD:
       {
         int const res = tcmplxA_brcvt_outflow19(&ps->treety, &ps->context_tree, &x, ps->alphabits);
         if (res == tcmplxA_EOF) {
@@ -3872,11 +5720,15 @@ static int tcmplxA_brcvt_strrtozs_bits
           ae = res;
       } break;
     case tcmplxA_BrCvt_ContextValuesL:
+    case tcmplxA_BrCvt_ContextValuesD:
       if (ps->bit_cap == 0) {
         unsigned char const code = ps->context_encode.p[ps->index];
+        int const escape = (code == tcmplxA_brcvt_RepeatBit);
         unsigned int const extra = (code&tcmplxA_brcvt_ZeroBit)
           ? code & (tcmplxA_brcvt_ZeroBit-1u) : 0;
-        unsigned int const value = extra ? extra : (code?code+ps->rlemax:0);
+        unsigned int const value = escape
+          ? ps->context_encode.p[++ps->index]+ps->rlemax
+          : (extra ? extra : (code?code+ps->rlemax:0));
         if (!tcmplxA_brcvt_outflow_lookup(ps, &ps->context_tree, value, &ae))
           break;
         ps->extra_length = extra;
@@ -3892,6 +5744,7 @@ static int tcmplxA_brcvt_strrtozs_bits
           ps->state += 1;
       } break;
     case tcmplxA_BrCvt_ContextRepeatL:
+    case tcmplxA_BrCvt_ContextRepeatD:
       if (ps->bit_length == 0) {
         assert(ps->index < ps->context_encode.sz);
         ps->bits = ps->context_encode.p[ps->index];
@@ -3910,14 +5763,12 @@ static int tcmplxA_brcvt_strrtozs_bits
           ps->state -= 1;
       } break;
     case tcmplxA_BrCvt_ContextInvertL:
+    case tcmplxA_BrCvt_ContextInvertD:
       x = 1;
-      ps->state = tcmplxA_BrCvt_TreeCountD;
-      break;
-    case tcmplxA_BrCvt_TreeCountD:
-      x = 0;
+      ps->state = (ps->state == tcmplxA_BrCvt_ContextInvertL)
+        ? tcmplxA_BrCvt_TreeCountD : tcmplxA_BrCvt_GaspVectorL;
       ps->bit_length = 0;
       ps->count = 0;
-      ps->state = tcmplxA_BrCvt_GaspVectorL;
       break;
     case tcmplxA_BrCvt_GaspVectorL:
     case tcmplxA_BrCvt_GaspVectorI:
@@ -3944,8 +5795,11 @@ static int tcmplxA_brcvt_strrtozs_bits
           ps->bit_cap = 0;
           if (ps->count >= tcmplxA_gaspvec_size(forest)) {
             tcmplxA_uint32 const accum = ps->fwd.accum;
+            unsigned char ctxt[2];
+            memcpy(ctxt, ps->fwd.literal_ctxt, sizeof(ctxt));
             ps->fwd = tcmplxA_brcvt_fwd_zero;
             ps->fwd.accum = accum;
+            memcpy(ps->fwd.literal_ctxt, ctxt, sizeof(ctxt));
             ps->state += 1;
             ps->count = 0;
             if (ps->state == tcmplxA_BrCvt_DataInsertCopy) {
@@ -4007,7 +5861,7 @@ static int tcmplxA_brcvt_strrtozs_bits
       break;
     case tcmplxA_BrCvt_LiteralRecount:
       if (ps->extra_length > 0)
-        x = (ps->extra_bits[0]>>(--ps->bit_length))&1u;
+        x = (ps->extra_bits[0]>>(--ps->extra_length))&1u;
       if (ps->extra_length == 0) {
         if (ps->bit_length > 0) {
           ps->state = tcmplxA_BrCvt_DataCopyExtra;
@@ -4017,13 +5871,6 @@ static int tcmplxA_brcvt_strrtozs_bits
         }
       }
       break;
-    case tcmplxA_BrCvt_ContextRunMaxD:
-    case tcmplxA_BrCvt_ContextPrefixD:
-    case tcmplxA_BrCvt_ContextValuesD:
-    case tcmplxA_BrCvt_ContextRepeatD:
-    case tcmplxA_BrCvt_ContextInvertD:
-      ae = tcmplxA_ErrSanitize;
-      break;
     case tcmplxA_BrCvt_Uncompress:
       x = 0;
       break;
@@ -4043,32 +5890,137 @@ static int tcmplxA_brcvt_strrtozs_bits
   *src = p;
   return ae;
 }
+int tcmplxA_brcvt_capcheck
+  (struct tcmplxA_brcvt const* ps, size_t freed, size_t needed)
+{
+  size_t held;
+  if (ps->memory_cap == 0u)
+    return tcmplxA_Success;
+  held = tcmplxA_brcvt_memory_usage(ps) - freed;
+  if (needed > ps->memory_cap || held > ps->memory_cap-needed)
+    return tcmplxA_ErrMemoryCap;
+  return tcmplxA_Success;
+}
+
+size_t tcmplxA_brcvt_memory_floor
+  ( tcmplxA_uint32 block_size,
+    tcmplxA_uint32 n, size_t chain_length)
+{
+  size_t buffer;
+  if (n > 16777200u)
+    n = 16777200u;
+  if (block_size >= 16777200u)
+    block_size = 16777200u;
+  buffer = tcmplxA_blockbuf_memory_bound(block_size, n, chain_length);
+  if (buffer == (size_t)-1)
+    return (size_t)-1;
+  return sizeof(struct tcmplxA_brcvt) + buffer
+    + tcmplxA_brmeta_memory_bound(0u, 0u)
+    + tcmplxA_ringdist_memory_bound()*2u
+    + tcmplxA_brcvt_histogram_size(tcmplxA_brcvt_literal_types_max(block_size))
+      * sizeof(tcmplxA_uint32)
+    + tcmplxA_brcvt_split_cap(block_size)
+      * (2u*sizeof(tcmplxA_uint32)+sizeof(unsigned char))
+    + tcmplxA_brcvt_cluster_pairs(block_size)*sizeof(long int);
+}
 /* END   brcvt state / static */
 
 /* BEGIN brcvt state / public */
 struct tcmplxA_brcvt* tcmplxA_brcvt_new
   ( tcmplxA_uint32 block_size,
     tcmplxA_uint32 n, size_t chain_length)
+{
+  return tcmplxA_brcvt_new_alloc(block_size, n, chain_length, NULL);
+}
+
+struct tcmplxA_brcvt* tcmplxA_brcvt_new_alloc
+  ( tcmplxA_uint32 block_size,
+    tcmplxA_uint32 n, size_t chain_length,
+    struct tcmplxA_allocator const* alloc)
 {
   struct tcmplxA_brcvt* out;
-  out = tcmplxA_util_malloc(sizeof(struct tcmplxA_brcvt));
+  out = tcmplxA_util_allocate(alloc, sizeof(struct tcmplxA_brcvt));
   if (out != NULL
-  &&  tcmplxA_brcvt_init(out, block_size, n, chain_length) != tcmplxA_Success)
+  &&  tcmplxA_brcvt_init(out, block_size, n, chain_length, alloc)
+      != tcmplxA_Success)
   {
-    tcmplxA_util_free(out);
+    tcmplxA_util_deallocate(alloc, out);
+    return NULL;
+  }
+  return out;
+}
+
+struct tcmplxA_brcvt* tcmplxA_brcvt_new_capped
+  ( tcmplxA_uint32 block_size,
+    tcmplxA_uint32 n, size_t chain_length, size_t memory_cap,
+    struct tcmplxA_allocator const* alloc)
+{
+  struct tcmplxA_brcvt* out;
+  unsigned int wbits = 10u;
+  if (memory_cap == 0u)
     return NULL;
+  if (block_size >= 16777200u)
+    block_size = 16777200u;
+  /* Brotli windows are (1<<WBITS)-16 bytes */
+  while (wbits < 24u && (1ul<<(wbits+1u))-16u <= n)
+    wbits += 1u;
+  while (tcmplxA_brcvt_memory_bound
+      (block_size, (tcmplxA_uint32)((1ul<<wbits)-16u), chain_length)
+    > memory_cap)
+  {
+    size_t const window_bytes = (size_t)1u<<wbits;
+    size_t const chain_bytes = chain_length*251u*sizeof(tcmplxA_uint32);
+    size_t const block_bytes = block_size*3u;
+    /* shrink the largest part that can still shrink */
+    if (wbits > 10u && window_bytes >= chain_bytes
+        && window_bytes >= block_bytes)
+      wbits -= 1u;
+    else if (chain_length > 1u && chain_bytes >= block_bytes)
+      chain_length /= 2u;
+    else if (block_size > 256u)
+      block_size /= 2u;
+    else if (wbits > 10u)
+      wbits -= 1u;
+    else if (chain_length > 1u)
+      chain_length /= 2u;
+    else if (tcmplxA_brcvt_memory_floor(block_size,
+          (tcmplxA_uint32)((1ul<<wbits)-16u), chain_length) <= memory_cap)
+    {
+      /* trees and maps then count against the cap as they grow */
+      break;
+    } else return NULL;
   }
+  out = tcmplxA_brcvt_new_alloc(block_size,
+    (tcmplxA_uint32)((1ul<<wbits)-16u), chain_length, alloc);
+  if (out != NULL)
+    out->memory_cap = memory_cap;
   return out;
 }
 
 void tcmplxA_brcvt_destroy(struct tcmplxA_brcvt* x) {
   if (x != NULL) {
+    struct tcmplxA_allocator const* const alloc = x->alloc;
     tcmplxA_brcvt_close(x);
-    tcmplxA_util_free(x);
+    tcmplxA_util_deallocate(alloc, x);
   }
   return;
 }
 
+void tcmplxA_brcvt_reset(struct tcmplxA_brcvt* x) {
+  tcmplxA_blockbuf_reset(x->buffer);
+  tcmplxA_ringdist_reset(x->ring, 1,4u,0u);
+  tcmplxA_ringdist_reset(x->try_ring, 1,4u,0u);
+  tcmplxA_brmeta_clear(x->metadata);
+  tcmplxA_brcvt_reset19(&x->treety);
+  x->context_encode.sz = 0;
+  x->guesses = tcmplxA_brcvt_guess_zero;
+  x->stream_tf = 0u;
+  memset(x->histogram, 0, sizeof(tcmplxA_uint32)
+    * tcmplxA_brcvt_histogram_size(x->literal_types_max));
+  tcmplxA_brcvt_restart(x);
+  return;
+}
+
 int tcmplxA_brcvt_zsrtostr
   ( struct tcmplxA_brcvt* ps, size_t* ret, unsigned char* dst, size_t dstsz,
     unsigned char const** src, unsigned char const* src_end)
@@ -4081,6 +6033,14 @@ int tcmplxA_brcvt_zsrtostr
       ae = tcmplxA_EOF;
       break;
     }
+    if (src_end - p >= tcmplxA_brcvt_FastInput
+    &&  dstsz - ret_out >= tcmplxA_brcvt_FastOutput
+    &&  tcmplxA_brcvt_fast_ready(ps))
+    {
+      ae = tcmplxA_brcvt_zsrtostr_fast(ps, &ret_out, dst, dstsz, &p, src_end);
+      if (ae != tcmplxA_Success || p >= src_end)
+        break;
+    }
     switch (ps->state) {
     case tcmplxA_BrCvt_WBits: /* initial state */
     case tcmplxA_BrCvt_LastCheck:
@@ -4131,7 +6091,7 @@ int tcmplxA_brcvt_zsrtostr
     case tcmplxA_BrCvt_InsertRecount:
     case tcmplxA_BrCvt_DistanceRecount:
     case tcmplxA_BrCvt_LiteralRecount:
-      ae = tcmplxA_brcvt_zsrtostr_bits(ps, (*p), &ret_out, dst, dstsz);
+      ae = tcmplxA_brcvt_zsrtostr_bits(ps, &p, src_end, &ret_out, dst, dstsz);
       break;
     case tcmplxA_BrCvt_MetaText:
       if (ps->metablock_pos == 0) {
@@ -4139,6 +6099,17 @@ int tcmplxA_brcvt_zsrtostr
         size_t const use_backward = (ps->backward >= ps->max_len_meta)
           ? ps->max_len_meta : ps->backward;
         ps->meta_index = tcmplxA_brmeta_size(ps->metadata);
+        if (ps->memory_cap > 0u) {
+          size_t total = use_backward;
+          size_t i;
+          for (i = 0; i < ps->meta_index; ++i)
+            total += tcmplxA_brmeta_itemsize(ps->metadata, i);
+          ae = tcmplxA_brcvt_capcheck(ps,
+            tcmplxA_brmeta_memory_usage(ps->metadata),
+            tcmplxA_brmeta_memory_bound(ps->meta_index+1u, total));
+          if (ae != tcmplxA_Success)
+            break;
+        }
         ae = tcmplxA_brmeta_emplace(ps->metadata, use_backward);
         if (ae != tcmplxA_Success)
           break;
@@ -4170,6 +6141,8 @@ int tcmplxA_brcvt_zsrtostr
         dst[ret_out] = (*p);
         ret_out += 1u;
         ps->metablock_pos += 1;
+        ps->fwd.literal_ctxt[0] = ps->fwd.literal_ctxt[1];
+        ps->fwd.literal_ctxt[1] = (*p);
       }
       if (ps->metablock_pos >= ps->backward) {
         ps->metatext = NULL;
@@ -4198,8 +6171,51 @@ int tcmplxA_brcvt_zsrtostr
 size_t tcmplxA_brcvt_bypass
   (struct tcmplxA_brcvt* x, unsigned char const* buf, size_t sz)
 {
-  // TODO (this function)
-  return 0u;
+  if (x->state != tcmplxA_BrCvt_WBits || x->bit_length != 0u) {
+    return 0u;
+  } else {
+    size_t const n = tcmplxA_blockbuf_bypass(x->buffer, buf, sz);
+    x->fwd.accum = (n >= 16777200u-x->fwd.accum)
+      ? 16777200u : x->fwd.accum+(tcmplxA_uint32)n;
+    return n;
+  }
+}
+
+int tcmplxA_brcvt_bypass_copy
+  (struct tcmplxA_brcvt* dst, struct tcmplxA_brcvt const* src)
+{
+  if (dst == src)
+    return tcmplxA_Success;
+  else if (dst->state != tcmplxA_BrCvt_WBits || dst->bit_length != 0u
+    ||  src->state != tcmplxA_BrCvt_WBits || src->bit_length != 0u)
+  {
+    return tcmplxA_ErrParam;
+  } else {
+    int const res = tcmplxA_blockbuf_copy_ring(dst->buffer, src->buffer);
+    if (res != tcmplxA_Success)
+      return res;
+    dst->fwd.accum = src->fwd.accum;
+    return tcmplxA_Success;
+  }
+}
+
+void tcmplxA_brcvt_set_quick(struct tcmplxA_brcvt* x, int quick_tf) {
+  x->quick_tf = (quick_tf != 0);
+  tcmplxA_blockbuf_set_greedy(x->buffer, quick_tf);
+  tcmplxA_blockbuf_set_skip(x->buffer, quick_tf);
+  return;
+}
+
+void tcmplxA_brcvt_set_suffix(struct tcmplxA_brcvt* x, int suffix_tf) {
+  tcmplxA_blockbuf_set_suffix(x->buffer, suffix_tf);
+  return;
+}
+
+void tcmplxA_brcvt_set_latency
+  (struct tcmplxA_brcvt* x, tcmplxA_uint32 latency)
+{
+  x->latency = latency;
+  return;
 }
 
 int tcmplxA_brcvt_strrtozs
@@ -4326,4 +6342,72 @@ struct tcmplxA_brmeta const* tcmplxA_brcvt_metadata_c
 {
   return ps->metadata;
 }
+
+size_t tcmplxA_brcvt_memory_usage(struct tcmplxA_brcvt const* x) {
+  struct tcmplxA_fixlist const* const lists[] = {
+    &x->literal_blocktype, &x->literal_blockcount,
+    &x->insert_blocktype, &x->insert_blockcount,
+    &x->distance_blocktype, &x->distance_blockcount,
+    &x->context_tree, &x->treety.nineteen
+  };
+  size_t out = sizeof(struct tcmplxA_brcvt)
+    + tcmplxA_blockbuf_memory_usage(x->buffer)
+    + tcmplxA_brmeta_memory_usage(x->metadata)
+    + tcmplxA_ringdist_memory_usage(x->ring)
+    + tcmplxA_ringdist_memory_usage(x->try_ring)
+    + tcmplxA_brcvt_histogram_size(x->literal_types_max)*sizeof(tcmplxA_uint32)
+    + x->split.cap*(2u*sizeof(tcmplxA_uint32)+sizeof(unsigned char))
+    + x->context_histogram_cap
+      * (tcmplxA_brcvt_LitHistoSize*sizeof(tcmplxA_uint32))
+    + x->cluster_pairs_cap*sizeof(long int)
+    + x->distance_codes_cap*sizeof(struct tcmplxA_brcvt_distcode)
+    + x->context_encode.cap + x->treety.sequence_list.cap;
+  size_t i;
+  for (i = 0u; i < sizeof(lists)/sizeof(lists[0]); ++i) {
+    out += tcmplxA_fixlist_memory_usage(lists[i])
+      - sizeof(struct tcmplxA_fixlist);
+  }
+  if (x->literals_map)
+    out += tcmplxA_ctxtmap_memory_usage(x->literals_map);
+  if (x->distance_map)
+    out += tcmplxA_ctxtmap_memory_usage(x->distance_map);
+  if (x->literals_forest)
+    out += tcmplxA_gaspvec_memory_usage(x->literals_forest);
+  if (x->insert_forest)
+    out += tcmplxA_gaspvec_memory_usage(x->insert_forest);
+  if (x->distance_forest)
+    out += tcmplxA_gaspvec_memory_usage(x->distance_forest);
+  return out;
+}
+
+size_t tcmplxA_brcvt_memory_bound
+  ( tcmplxA_uint32 block_size,
+    tcmplxA_uint32 n, size_t chain_length)
+{
+  size_t const start =
+    tcmplxA_brcvt_memory_floor(block_size, n, chain_length);
+  size_t types;
+  if (start == (size_t)-1)
+    return (size_t)-1;
+  if (block_size >= 16777200u)
+    block_size = 16777200u;
+  types = tcmplxA_brcvt_literal_types_max(block_size);
+  return start
+    + tcmplxA_brcvt_context_histograms_max(block_size)
+      * (tcmplxA_brcvt_LitHistoSize*sizeof(tcmplxA_uint32))
+    + (block_size/2u+1u)*sizeof(struct tcmplxA_brcvt_distcode)
+    /* block types, block counts, context tree, code length tree */
+    + ((258u+26u)*3u + (16u+256u) + 19u)*sizeof(struct tcmplxA_fixline)
+    /* context map (two bytes per entry) and tree descriptions,
+     * doubled past their sizes */
+    + (types*64u*2u+4u)*2u + 704u*4u
+    /* one context mode per literal block type, clustered literal
+     * and distance trees, one insert-and-copy tree */
+    + tcmplxA_ctxtmap_memory_bound(types, 64u)
+    + tcmplxA_ctxtmap_memory_bound(1u, 4u)
+    + tcmplxA_gaspvec_memory_bound
+        (tcmplxA_brcvt_literal_trees_max(block_size), 256u)
+    + tcmplxA_gaspvec_memory_bound(1u, 704u)
+    + tcmplxA_gaspvec_memory_bound(4u, 16u+120u+(48u<<3));
+}
 /* END   brcvt state / public */
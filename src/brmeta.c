@@ -31,15 +31,18 @@ struct tcmplxA_brmeta {
     struct tcmplxA_brline** lines;
     size_t n;
     size_t cap;
+    struct tcmplxA_allocator const* alloc;
 };
 /**
  * @brief Initialize a metadata storage.
  * @param b storage to initialize
  * @param cap desired initial capacity
+ * @param alloc (nullable) allocator for the storage; NULL for the heap
  * @return an error code
  */
 static
-int tcmplxA_brmeta_init(struct tcmplxA_brmeta* b, size_t cap);
+int tcmplxA_brmeta_init
+  (struct tcmplxA_brmeta* b, size_t cap, struct tcmplxA_allocator const* alloc);
 
 /**
  * @brief Ensure space for one more slot.
@@ -50,7 +53,10 @@ static
 int tcmplxA_brmeta_ensure(struct tcmplxA_brmeta* b);
 
 /* BEGIN brmeta storage / static */
-int tcmplxA_brmeta_init(struct tcmplxA_brmeta* b, size_t cap) {
+int tcmplxA_brmeta_init
+  (struct tcmplxA_brmeta* b, size_t cap, struct tcmplxA_allocator const* alloc)
+{
+  b->alloc = alloc;
   b->n = 0;
   b->cap = 0;
   b->lines = NULL;
@@ -58,14 +64,14 @@ int tcmplxA_brmeta_init(struct tcmplxA_brmeta* b, size_t cap) {
     cap = tcmplxA_BrMeta_CapInitMax;
   if (cap > 0) {
     struct tcmplxA_brline** const ptr =
-      tcmplxA_util_malloc(cap*sizeof(struct tcmplxA_brline*));
+      tcmplxA_util_allocate(alloc, cap*sizeof(struct tcmplxA_brline*));
     if (!ptr)
       return tcmplxA_ErrMemory;
 #ifndef NDEBUG
     {
       size_t i;
-      for (i = 0; i < b->cap; ++i)
-        b->lines[i] = NULL;
+      for (i = 0; i < cap; ++i)
+        ptr[i] = NULL;
     }
 #endif /*NDEBUG*/
     b->lines = ptr;
@@ -82,7 +88,7 @@ int tcmplxA_brmeta_ensure(struct tcmplxA_brmeta* b) {
     return tcmplxA_Success;
   else if (b->cap >= tcmplxA_BrMeta_CapMax/2)
     return tcmplxA_ErrMemory;
-  ptr = tcmplxA_util_malloc(new_cap*sizeof(struct tcmplxA_brline*));
+  ptr = tcmplxA_util_allocate(b->alloc, new_cap*sizeof(struct tcmplxA_brline*));
   if (!ptr)
     return tcmplxA_ErrMemory;
   for (i = 0; i < b->n; ++i) {
@@ -91,7 +97,11 @@ int tcmplxA_brmeta_ensure(struct tcmplxA_brmeta* b) {
     b->lines[i] = NULL;
 #endif /*NDEBUG*/
   }
-  tcmplxA_util_free(b->lines);
+#ifndef NDEBUG
+  for (; i < new_cap; ++i)
+    ptr[i] = NULL;
+#endif /*NDEBUG*/
+  tcmplxA_util_deallocate(b->alloc, b->lines);
   b->lines = ptr;
   b->cap = new_cap;
   return tcmplxA_Success;
@@ -100,12 +110,18 @@ int tcmplxA_brmeta_ensure(struct tcmplxA_brmeta* b) {
 
 /* BEGIN brmeta storage / public */
 struct tcmplxA_brmeta* tcmplxA_brmeta_new(size_t cap) {
+  return tcmplxA_brmeta_new_alloc(cap, NULL);
+}
+
+struct tcmplxA_brmeta* tcmplxA_brmeta_new_alloc
+  (size_t cap, struct tcmplxA_allocator const* alloc)
+{
   struct tcmplxA_brmeta* out;
-  out = tcmplxA_util_malloc(sizeof(struct tcmplxA_brmeta));
+  out = tcmplxA_util_allocate(alloc, sizeof(struct tcmplxA_brmeta));
   if (out != NULL
-  &&  tcmplxA_brmeta_init(out, cap) != tcmplxA_Success)
+  &&  tcmplxA_brmeta_init(out, cap, alloc) != tcmplxA_Success)
   {
-    tcmplxA_util_free(out);
+    tcmplxA_util_deallocate(alloc, out);
     return NULL;
   }
   return out;
@@ -113,11 +129,13 @@ struct tcmplxA_brmeta* tcmplxA_brmeta_new(size_t cap) {
 
 void tcmplxA_brmeta_destroy(struct tcmplxA_brmeta* p) {
   size_t i;
+  struct tcmplxA_allocator const* alloc;
   if (!p)
     return;
+  alloc = p->alloc;
   for (i = 0; i < p->n; ++i) {
     if (p->lines[i])
-      tcmplxA_util_free(p->lines[i]);
+      tcmplxA_util_deallocate(alloc, p->lines[i]);
 #ifndef NDEBUG
     p->lines[i] = NULL;
 #endif /*NDEBUG*/
@@ -127,12 +145,12 @@ void tcmplxA_brmeta_destroy(struct tcmplxA_brmeta* p) {
     assert(!p->lines[i]);
   }
 #endif /*NDEBUG*/
-  tcmplxA_util_free(p->lines);
+  tcmplxA_util_deallocate(alloc, p->lines);
 #ifndef NDEBUG
   p->n = 0;
   p->cap = 0;
 #endif /*NDEBUG*/
-  tcmplxA_util_free(p);
+  tcmplxA_util_deallocate(alloc, p);
   return;
 }
 
@@ -147,7 +165,7 @@ int tcmplxA_brmeta_emplace(struct tcmplxA_brmeta* b, size_t n) {
     return tcmplxA_ErrParam;
   else {
     struct tcmplxA_brline* const ptr =
-      tcmplxA_util_malloc(sizeof(struct tcmplxA_brline)+n+1);
+      tcmplxA_util_allocate(b->alloc, sizeof(struct tcmplxA_brline)+n+1);
     if (ptr == NULL)
       return tcmplxA_ErrMemory;
     memset(ptr->data, 0, n+1);
@@ -186,4 +204,30 @@ unsigned char* tcmplxA_brmeta_itemdata
   assert(b->lines && b->lines[i]);
   return b->lines[i]->data;
 }
+
+void tcmplxA_brmeta_clear(struct tcmplxA_brmeta* b) {
+  size_t i;
+  for (i = 0; i < b->n; ++i) {
+    tcmplxA_util_deallocate(b->alloc, b->lines[i]);
+    b->lines[i] = NULL;
+  }
+  b->n = 0;
+  return;
+}
+
+size_t tcmplxA_brmeta_memory_usage(struct tcmplxA_brmeta const* b) {
+  size_t out = sizeof(struct tcmplxA_brmeta)
+    + b->cap*sizeof(struct tcmplxA_brline*);
+  size_t i;
+  for (i = 0; i < b->n; ++i)
+    out += sizeof(struct tcmplxA_brline)+b->lines[i]->len+1u;
+  return out;
+}
+
+size_t tcmplxA_brmeta_memory_bound(size_t n, size_t total) {
+  /* the line array at most doubles past the item count */
+  return sizeof(struct tcmplxA_brmeta)
+    + (n*2u+1u)*sizeof(struct tcmplxA_brline*)
+    + n*(sizeof(struct tcmplxA_brline)+1u) + total;
+}
 /* END   brmeta storage / public */
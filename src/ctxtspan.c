@@ -4,7 +4,6 @@
  * @author Cody Licorish (svgmovement@gmail.com)
  */
 #define TCMPLX_A_WIN32_DLL_INTERNAL
-#include "ctxtmap_p.h"
 #include "text-complex/access/ctxtspan.h"
 #include "text-complex/access/api.h"
 #include "text-complex/access/util.h"
@@ -20,21 +19,6 @@ enum tcmplxA_ctxtspan_consts {
 };
 
 
-/**
- * @brief Count the number of nonzero bits in an integer.
- * @param x integer to inspect
- * @return a bit count
- */
-static
-int tcmplxA_ctxtspan_popcount(unsigned x);
-/**
- * @brief Add and subtract numbers from a score ceiling.
- * @param sub subtractor
- * @param add addend
- * @return a sum
- */
-static
-unsigned tcmplxA_ctxtspan_subscore(unsigned sub, unsigned add);
 /**
  * @brief Absolute difference of two unsigned integers.
  * @param a one integer
@@ -51,24 +35,56 @@ unsigned tcmplxA_ctxtspan_absdiff(unsigned a, unsigned b);
 static
 enum tcmplxA_ctxtmap_mode tcmplxA_ctxtspan_select(struct tcmplxA_ctxtscore const* score);
 
-/* BEGIN context span / static */
-int tcmplxA_ctxtspan_popcount(unsigned x) {
-#if (defined __GNUC__)
-    return __builtin_popcount(x);
-#else
-    int out = 0;
-    int i;
-    for (i = 0; i < (CHAR_BIT *sizeof(unsigned)); ++i, x >>= 1) {
-        out += (x&1);
-    }
-    return out;
-#endif //__GNUC__
-}
+/**
+ * @brief LSB6 (low nibble) and MSB6 (high nibble) scores
+ *   by the exclusive-or of two neighboring bytes.
+ * @note Each score is the ceiling plus the count of changed bits
+ *   in the context bits, less three times the count of changed bits
+ *   outside them; more changes inside than outside score the ceiling.
+ */
+static
+unsigned char const tcmplxA_ctxtspan_pairscore[256] = {
+    0x66, 0x36, 0x36, 0x06, 0x66, 0x46, 0x46, 0x16, 0x66, 0x46, 0x46, 0x16,
+    0x66, 0x56, 0x56, 0x26, 0x66, 0x46, 0x46, 0x16, 0x66, 0x56, 0x56, 0x26,
+    0x66, 0x56, 0x56, 0x26, 0x66, 0x66, 0x66, 0x36, 0x66, 0x46, 0x46, 0x16,
+    0x66, 0x56, 0x56, 0x26, 0x66, 0x56, 0x56, 0x26, 0x66, 0x66, 0x66, 0x36,
+    0x66, 0x56, 0x56, 0x26, 0x66, 0x66, 0x66, 0x36, 0x66, 0x66, 0x66, 0x36,
+    0x66, 0x66, 0x66, 0x46, 0x63, 0x44, 0x44, 0x15, 0x64, 0x55, 0x55, 0x26,
+    0x64, 0x55, 0x55, 0x26, 0x65, 0x66, 0x66, 0x36, 0x64, 0x55, 0x55, 0x26,
+    0x65, 0x66, 0x66, 0x36, 0x65, 0x66, 0x66, 0x36, 0x66, 0x66, 0x66, 0x46,
+    0x64, 0x55, 0x55, 0x26, 0x65, 0x66, 0x66, 0x36, 0x65, 0x66, 0x66, 0x36,
+    0x66, 0x66, 0x66, 0x46, 0x65, 0x66, 0x66, 0x36, 0x66, 0x66, 0x66, 0x46,
+    0x66, 0x66, 0x66, 0x46, 0x66, 0x66, 0x66, 0x56, 0x63, 0x44, 0x44, 0x15,
+    0x64, 0x55, 0x55, 0x26, 0x64, 0x55, 0x55, 0x26, 0x65, 0x66, 0x66, 0x36,
+    0x64, 0x55, 0x55, 0x26, 0x65, 0x66, 0x66, 0x36, 0x65, 0x66, 0x66, 0x36,
+    0x66, 0x66, 0x66, 0x46, 0x64, 0x55, 0x55, 0x26, 0x65, 0x66, 0x66, 0x36,
+    0x65, 0x66, 0x66, 0x36, 0x66, 0x66, 0x66, 0x46, 0x65, 0x66, 0x66, 0x36,
+    0x66, 0x66, 0x66, 0x46, 0x66, 0x66, 0x66, 0x46, 0x66, 0x66, 0x66, 0x56,
+    0x60, 0x51, 0x51, 0x22, 0x61, 0x62, 0x62, 0x33, 0x61, 0x62, 0x62, 0x33,
+    0x62, 0x63, 0x63, 0x44, 0x61, 0x62, 0x62, 0x33, 0x62, 0x63, 0x63, 0x44,
+    0x62, 0x63, 0x63, 0x44, 0x63, 0x64, 0x64, 0x55, 0x61, 0x62, 0x62, 0x33,
+    0x62, 0x63, 0x63, 0x44, 0x62, 0x63, 0x63, 0x44, 0x63, 0x64, 0x64, 0x55,
+    0x62, 0x63, 0x63, 0x44, 0x63, 0x64, 0x64, 0x55, 0x63, 0x64, 0x64, 0x55,
+    0x64, 0x65, 0x65, 0x66
+};
 
-unsigned tcmplxA_ctxtspan_subscore(unsigned sub, unsigned add) {
-    return add > sub ? tcmplxA_CtxtSpan_Ceiling : tcmplxA_CtxtSpan_Ceiling+add-sub;
-}
+/**
+ * @brief UTF-8 scanner transitions by pending continuation count
+ *   and the high nibble of the current byte.
+ * @note Each entry is the next count shifted left by one,
+ *   plus one if the byte earns a point.
+ */
+static
+unsigned char const tcmplxA_ctxtspan_utf8step[4][16] = {
+    /* expecting a lead or ASCII */
+    {1,1,1,1, 1,1,1,1, 0,0,0,0, 3,3,5,7},
+    /* expecting continuations */
+    {0,0,0,0, 0,0,0,0, 1,1,1,1, 0,0,0,0},
+    {0,0,0,0, 0,0,0,0, 3,3,3,3, 0,0,0,0},
+    {0,0,0,0, 0,0,0,0, 5,5,5,5, 0,0,0,0}
+};
 
+/* BEGIN context span / static */
 enum tcmplxA_ctxtmap_mode tcmplxA_ctxtspan_select(struct tcmplxA_ctxtscore const* score) {
     unsigned current_score = 0;
     int mode = 0;
@@ -91,48 +107,33 @@ unsigned tcmplxA_ctxtspan_absdiff(unsigned a, unsigned b) {
 void tcmplxA_ctxtspan_guess(struct tcmplxA_ctxtscore* results,
     void const* buf, size_t buf_len)
 {
-    struct tcmplxA_ctxtscore out = *results;
     unsigned char const* const p = (unsigned char const*)buf;
-    unsigned char last = 0;
-    unsigned char utf8count = 0;
+    unsigned char const* const lut2 =
+        tcmplxA_ctxtmap_literal_lut(tcmplxA_CtxtMap_Signed)+256;
+    unsigned lsb6 = 0, msb6 = 0, signed_score = 0, utf8 = 0;
+    unsigned last = 0;
+    unsigned last_lut2 = lut2[0];
+    unsigned utf8count = 0;
     size_t i;
-    for (i = 0; i < buf_len; last = p[i], ++i) {
-        unsigned char const current = p[i];
-        /* LSB6 & MSB6 */{
-            unsigned char const lsb_tmp = last ^ current;
-            out.vec[tcmplxA_CtxtMap_LSB6] += tcmplxA_ctxtspan_subscore(
-                tcmplxA_ctxtspan_popcount(lsb_tmp&0xC0)*3,
-                tcmplxA_ctxtspan_popcount(lsb_tmp&0x3F));
-            out.vec[tcmplxA_CtxtMap_MSB6] += tcmplxA_ctxtspan_subscore(
-                tcmplxA_ctxtspan_popcount(lsb_tmp&0x03)*3,
-                tcmplxA_ctxtspan_popcount(lsb_tmp&0xFC));
-        }
-        /* Signed */{
-            unsigned char const last_lut2 = tcmplxA_ctxtmap_getlut2(last);
-            unsigned char const lut2 = tcmplxA_ctxtmap_getlut2(current);
-            out.vec[tcmplxA_CtxtMap_Signed] += (7 -
-                (lut2>last_lut2 ? lut2-last_lut2 : last_lut2-lut2));
-        }
-        /* UTF8 */{
-            if (utf8count > 0) {
-                unsigned const ok = ((current&0xC0)==0x80);
-                utf8count = ok ? utf8count-1 : 0;
-                out.vec[tcmplxA_CtxtMap_UTF8] += ok*tcmplxA_CtxtSpan_UtfPoint;
-            } else if (current >= 0xF0) {
-                utf8count = 3;
-                out.vec[tcmplxA_CtxtMap_UTF8] += tcmplxA_CtxtSpan_UtfPoint;
-            } else if (current >= 0xE0) {
-                utf8count = 2;
-                out.vec[tcmplxA_CtxtMap_UTF8] += tcmplxA_CtxtSpan_UtfPoint;
-            } else if (current >= 0xC0) {
-                utf8count = 1;
-                out.vec[tcmplxA_CtxtMap_UTF8] += tcmplxA_CtxtSpan_UtfPoint;
-            } else {
-                out.vec[tcmplxA_CtxtMap_UTF8] += (current<0x80)*tcmplxA_CtxtSpan_UtfPoint;
-            }
-        }
+    /* table lookups only, so every byte costs the same */
+    for (i = 0; i < buf_len; ++i) {
+        unsigned const current = p[i];
+        unsigned const pair = tcmplxA_ctxtspan_pairscore[last^current];
+        unsigned const current_lut2 = lut2[current];
+        unsigned const step =
+            tcmplxA_ctxtspan_utf8step[utf8count][current>>4];
+        lsb6 += pair&15u;
+        msb6 += pair>>4;
+        signed_score += 7u - tcmplxA_ctxtspan_absdiff(current_lut2, last_lut2);
+        utf8 += (step&1u)*tcmplxA_CtxtSpan_UtfPoint;
+        utf8count = step>>1;
+        last = current;
+        last_lut2 = current_lut2;
     }
-    *results = out;
+    results->vec[tcmplxA_CtxtMap_LSB6] += lsb6;
+    results->vec[tcmplxA_CtxtMap_MSB6] += msb6;
+    results->vec[tcmplxA_CtxtMap_Signed] += signed_score;
+    results->vec[tcmplxA_CtxtMap_UTF8] += utf8;
     return;
 }
 
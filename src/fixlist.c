@@ -108,9 +108,17 @@ struct tcmplxA_fixline const tcmplxA_fixlist_ps_BrotliS4B[] = {
   {0x6  /*110*/, 3u, 0 },
   {0x7  /*111*/, 3u, 0 }
 };
+/* in code order, for decoding straight from the shared list */
 static
 struct tcmplxA_fixline const tcmplxA_fixlist_ps_BrotliWBits[] = {
   {   0        /*0*/, 1u, 16 },
+  { 0x9     /*1001*/, 4u, 21 },
+  { 0xA     /*1010*/, 4u, 19 },
+  { 0xB     /*1011*/, 4u, 23 },
+  { 0xC     /*1100*/, 4u, 18 },
+  { 0xD     /*1101*/, 4u, 22 },
+  { 0xE     /*1110*/, 4u, 20 },
+  { 0xF     /*1111*/, 4u, 24 },
   {0x40  /*1000000*/, 7u, 17 },
   {0x41  /*1000001*/, 7u, 12 },
   {0x42  /*1000010*/, 7u, 10 },
@@ -119,28 +127,19 @@ struct tcmplxA_fixline const tcmplxA_fixlist_ps_BrotliWBits[] = {
   {0x45  /*1000101*/, 7u, 13 },
   {0x46  /*1000110*/, 7u, 11 },
   {0x47  /*1000111*/, 7u, 15 },
-  { 0x9     /*1001*/, 4u, 21 },
-  { 0xA     /*1010*/, 4u, 19 },
-  { 0xB     /*1011*/, 4u, 23 },
-  { 0xC     /*1100*/, 4u, 18 },
-  { 0xD     /*1101*/, 4u, 22 },
-  { 0xE     /*1110*/, 4u, 20 },
-  { 0xF     /*1111*/, 4u, 24 },
 };
 
+/* read-only lists shared by all users of the presets */
 static
-struct {
-  size_t n;
-  struct tcmplxA_fixline const* v;
-} const tcmplxA_fixlist_ps[] = {
-  {  6u, tcmplxA_fixlist_ps_BrotliComplex },
-  {  1u, tcmplxA_fixlist_ps_BrotliS1 },
-  {  2u, tcmplxA_fixlist_ps_BrotliS2 },
-  {  3u, tcmplxA_fixlist_ps_BrotliS3 },
-  {  4u, tcmplxA_fixlist_ps_BrotliS4A },
-  {  4u, tcmplxA_fixlist_ps_BrotliS4B },
-  { 15u, tcmplxA_fixlist_ps_BrotliWBits },
-  {256u, NULL }
+struct tcmplxA_fixlist const tcmplxA_fixlist_ps[] = {
+  { (struct tcmplxA_fixline*)tcmplxA_fixlist_ps_BrotliComplex, 6u, NULL },
+  { (struct tcmplxA_fixline*)tcmplxA_fixlist_ps_BrotliS1, 1u, NULL },
+  { (struct tcmplxA_fixline*)tcmplxA_fixlist_ps_BrotliS2, 2u, NULL },
+  { (struct tcmplxA_fixline*)tcmplxA_fixlist_ps_BrotliS3, 3u, NULL },
+  { (struct tcmplxA_fixline*)tcmplxA_fixlist_ps_BrotliS4A, 4u, NULL },
+  { (struct tcmplxA_fixline*)tcmplxA_fixlist_ps_BrotliS4B, 4u, NULL },
+  { (struct tcmplxA_fixline*)tcmplxA_fixlist_ps_BrotliWBits, 15u, NULL },
+  { NULL, 256u, NULL }
 };
 
 /**
@@ -214,6 +213,19 @@ int tcmplxA_fixlist_ref_cmp(void const* a, void const* b);
  */
 static
 tcmplxA_uint32 tcmplxA_fixlist_min_frac(tcmplxA_uint32 x);
+/**
+ * @internal
+ * @brief Compute unlimited prefix code lengths in place
+ *   (Moffat and Katajainen).
+ * @param nodes references sorted by descending frequency
+ * @param n number of references, at least two
+ * @param[out] a code lengths, from the least frequent reference
+ *   to the most frequent
+ * @return the longest code length
+ */
+static
+tcmplxA_uint32 tcmplxA_fixlist_huffman_lengths
+  (struct tcmplxA_fixlist_ref const* nodes, size_t n, tcmplxA_uint32* a);
 /**
  * @brief Check if the heap can provide packable items.
  * @param h heap represented by an array
@@ -268,7 +280,11 @@ int tcmplxA_fixline_codevaluecmp(void const* a, void const* b);
 
 
 /* BEGIN prefix list / static */
-int tcmplxA_fixlist_init(struct tcmplxA_fixlist* x, size_t sz) {
+int tcmplxA_fixlist_init
+  ( struct tcmplxA_fixlist* x, size_t sz,
+    struct tcmplxA_allocator const* alloc)
+{
+  x->alloc = alloc;
   x->p = NULL;
   x->n = 0u;
   return tcmplxA_fixlist_resize(x,sz);
@@ -278,7 +294,7 @@ int tcmplxA_fixlist_resize(struct tcmplxA_fixlist* x, size_t sz) {
   struct tcmplxA_fixline *ptr;
   if (sz == 0u) {
     if (x->p != NULL) {
-      tcmplxA_util_free(x->p);
+      tcmplxA_util_deallocate(x->alloc, x->p);
     }
     x->p = NULL;
     x->n = 0u;
@@ -286,13 +302,13 @@ int tcmplxA_fixlist_resize(struct tcmplxA_fixlist* x, size_t sz) {
   } else if (sz >= UINT_MAX/sizeof(struct tcmplxA_fixline)) {
     return tcmplxA_ErrMemory;
   }
-  ptr = (struct tcmplxA_fixline*)tcmplxA_util_malloc
-          (sizeof(struct tcmplxA_fixline)*sz);
+  ptr = (struct tcmplxA_fixline*)tcmplxA_util_allocate
+          (x->alloc, sizeof(struct tcmplxA_fixline)*sz);
   if (ptr == NULL) {
     return tcmplxA_ErrMemory;
   }
   if (x->p != NULL) {
-    tcmplxA_util_free(x->p);
+    tcmplxA_util_deallocate(x->alloc, x->p);
   }
   x->p = ptr;
   x->n = sz;
@@ -300,7 +316,7 @@ int tcmplxA_fixlist_resize(struct tcmplxA_fixlist* x, size_t sz) {
 }
 
 void tcmplxA_fixlist_close(struct tcmplxA_fixlist* x) {
-  tcmplxA_util_free(x->p);
+  tcmplxA_util_deallocate(x->alloc, x->p);
   x->p = NULL;
   x->n = 0u;
   return;
@@ -385,6 +401,54 @@ void tcmplxA_fixlist_heap_add
   return;
 }
 
+tcmplxA_uint32 tcmplxA_fixlist_huffman_lengths
+  (struct tcmplxA_fixlist_ref const* nodes, size_t n, tcmplxA_uint32* a)
+{
+  size_t root = 0u;
+  size_t leaf = 2u;
+  size_t next;
+  size_t avail, used;
+  tcmplxA_uint32 depth;
+  for (next = 0u; next < n; ++next)
+    a[next] = nodes[n-1u-next].freq;
+  /* pair the two least weights, leaving parent indices behind */
+  a[0] += a[1];
+  for (next = 1u; next < n-1u; ++next) {
+    if (leaf >= n || a[root] < a[leaf]) {
+      a[next] = a[root];
+      a[root++] = (tcmplxA_uint32)next;
+    } else a[next] = a[leaf++];
+    if (leaf >= n || (root < next && a[root] < a[leaf])) {
+      a[next] += a[root];
+      a[root++] = (tcmplxA_uint32)next;
+    } else a[next] += a[leaf++];
+  }
+  /* internal node depths, from the root down */
+  a[n-2u] = 0u;
+  for (next = n-2u; next > 0u; --next)
+    a[next-1u] = a[a[next-1u]]+1u;
+  /* leaf depths, shortest at the end */
+  avail = 1u;
+  used = 0u;
+  depth = 0u;
+  root = n-1u;
+  next = n;
+  while (avail > 0u) {
+    while (root > 0u && a[root-1u] == depth) {
+      used += 1u;
+      root -= 1u;
+    }
+    while (avail > used) {
+      a[--next] = depth;
+      avail -= 1u;
+    }
+    avail = 2u*used;
+    depth += 1u;
+    used = 0u;
+  }
+  return a[0];
+}
+
 int tcmplxA_fixlist_ref_cmp(void const* pa, void const* pb) {
   struct tcmplxA_fixlist_ref const* const a =
     (struct tcmplxA_fixlist_ref const*)pa;
@@ -479,12 +543,18 @@ int tcmplxA_fixline_codevaluecmp(void const* a, void const* b) {
 
 /* BEGIN prefix list / public */
 struct tcmplxA_fixlist* tcmplxA_fixlist_new(size_t sz) {
+  return tcmplxA_fixlist_new_alloc(sz, NULL);
+}
+
+struct tcmplxA_fixlist* tcmplxA_fixlist_new_alloc
+  (size_t sz, struct tcmplxA_allocator const* alloc)
+{
   struct tcmplxA_fixlist* out;
-  out = tcmplxA_util_malloc(sizeof(struct tcmplxA_fixlist));
+  out = tcmplxA_util_allocate(alloc, sizeof(struct tcmplxA_fixlist));
   if (out != NULL
-  &&  tcmplxA_fixlist_init(out, sz) != tcmplxA_Success)
+  &&  tcmplxA_fixlist_init(out, sz, alloc) != tcmplxA_Success)
   {
-    tcmplxA_util_free(out);
+    tcmplxA_util_deallocate(alloc, out);
     return NULL;
   }
   return out;
@@ -492,8 +562,9 @@ struct tcmplxA_fixlist* tcmplxA_fixlist_new(size_t sz) {
 
 void tcmplxA_fixlist_destroy(struct tcmplxA_fixlist* x) {
   if (x != NULL) {
+    struct tcmplxA_allocator const* const alloc = x->alloc;
     tcmplxA_fixlist_close(x);
-    tcmplxA_util_free(x);
+    tcmplxA_util_deallocate(alloc, x);
   }
   return;
 }
@@ -585,8 +656,8 @@ int tcmplxA_fixlist_preset(struct tcmplxA_fixlist* dst, unsigned int i) {
     if (res != tcmplxA_Success) {
       return res;
     }
-    if (tcmplxA_fixlist_ps[i].v)
-      memcpy(dst->p, tcmplxA_fixlist_ps[i].v, sizeof(struct tcmplxA_fixline)*sz);
+    if (tcmplxA_fixlist_ps[i].p)
+      memcpy(dst->p, tcmplxA_fixlist_ps[i].p, sizeof(struct tcmplxA_fixline)*sz);
     else switch (i) {
     case tcmplxA_FixList_BrotliBlockType:
       {
@@ -616,6 +687,13 @@ int tcmplxA_fixlist_preset(struct tcmplxA_fixlist* dst, unsigned int i) {
   return tcmplxA_Success;
 }
 
+struct tcmplxA_fixlist const* tcmplxA_fixlist_preset_c(unsigned int i) {
+  size_t const n = sizeof(tcmplxA_fixlist_ps)/sizeof(tcmplxA_fixlist_ps[0]);
+  if (i >= n || tcmplxA_fixlist_ps[i].p == NULL)
+    return NULL;
+  else return &tcmplxA_fixlist_ps[i];
+}
+
 int tcmplxA_fixlist_gen_lengths
   ( struct tcmplxA_fixlist* dst, tcmplxA_uint32 const* table,
     unsigned int max_bits)
@@ -629,15 +707,15 @@ int tcmplxA_fixlist_gen_lengths
   } else {
     /* allocate the nodes */
     struct tcmplxA_fixlist_ref* const nodes =
-      tcmplxA_util_malloc(dst->n*sizeof(struct tcmplxA_fixlist_ref));
+      tcmplxA_util_allocate(dst->alloc, dst->n*sizeof(struct tcmplxA_fixlist_ref));
     size_t heap_top = dst->n*2u;
     struct tcmplxA_fixlist_heapitem* const heap =
-      tcmplxA_util_malloc(heap_top*sizeof(struct tcmplxA_fixlist_heapitem));
+      tcmplxA_util_allocate(dst->alloc, heap_top*sizeof(struct tcmplxA_fixlist_heapitem));
     size_t heap_count = 0u;
     size_t node_count = 0u;
     if (nodes == NULL || heap == NULL) {
-      tcmplxA_util_free(heap);
-      tcmplxA_util_free(nodes);
+      tcmplxA_util_deallocate(dst->alloc, heap);
+      tcmplxA_util_deallocate(dst->alloc, nodes);
       return tcmplxA_ErrMemory;
     }
     /* */{
@@ -656,17 +734,32 @@ int tcmplxA_fixlist_gen_lengths
         if (max_bits > 0u) {
           for (i = 0u; i < node_count; ++i)
             dst->p[nodes[i].index].len = 1u;
-          tcmplxA_util_free(heap);
-          tcmplxA_util_free(nodes);
+          tcmplxA_util_deallocate(dst->alloc, heap);
+          tcmplxA_util_deallocate(dst->alloc, nodes);
           return tcmplxA_Success;
         } else {
-          tcmplxA_util_free(heap);
-          tcmplxA_util_free(nodes);
+          tcmplxA_util_deallocate(dst->alloc, heap);
+          tcmplxA_util_deallocate(dst->alloc, nodes);
           return tcmplxA_Success;
         }
       }
       qsort(nodes, node_count, sizeof(struct tcmplxA_fixlist_ref),
           &tcmplxA_fixlist_ref_cmp);
+      /* most histograms need no length limit */{
+        tcmplxA_uint32* const lengths = (tcmplxA_uint32*)tcmplxA_util_allocate
+          (dst->alloc, node_count*sizeof(tcmplxA_uint32));
+        if (lengths != NULL && tcmplxA_fixlist_huffman_lengths
+              (nodes, node_count, lengths) <= max_bits)
+        {
+          for (i = 0u; i < node_count; ++i)
+            dst->p[nodes[i].index].len = lengths[node_count-1u-i];
+          tcmplxA_util_deallocate(dst->alloc, lengths);
+          tcmplxA_util_deallocate(dst->alloc, heap);
+          tcmplxA_util_deallocate(dst->alloc, nodes);
+          return tcmplxA_Success;
+        }
+        tcmplxA_util_deallocate(dst->alloc, lengths);
+      }
     }
     /* do the algorithm */{
       struct tcmplxA_fixlist_state states[16];
@@ -706,21 +799,21 @@ int tcmplxA_fixlist_gen_lengths
               it.midline = (l==midline ? 1u : 0u);
               res = tcmplxA_fixlist_heappush(heap, &heap_count, heap_top, &it);
               if (/*unlikely*/res != tcmplxA_Success) {
-                tcmplxA_util_free(heap);
-                tcmplxA_util_free(nodes);
+                tcmplxA_util_deallocate(dst->alloc, heap);
+                tcmplxA_util_deallocate(dst->alloc, nodes);
                 return res;
               }
             }
           }
           /* inspect */
           if (heap_count == 0u || frac > min_frac) {
-            tcmplxA_util_free(heap);
-            tcmplxA_util_free(nodes);
+            tcmplxA_util_deallocate(dst->alloc, heap);
+            tcmplxA_util_deallocate(dst->alloc, nodes);
             return tcmplxA_ErrFixLenRange;
           } else if (frac == min_frac) {
             if (heap[0].total_frac != min_frac) {
-              tcmplxA_util_free(heap);
-              tcmplxA_util_free(nodes);
+              tcmplxA_util_deallocate(dst->alloc, heap);
+              tcmplxA_util_deallocate(dst->alloc, nodes);
               return tcmplxA_ErrFixLenRange;
             } else {
               struct tcmplxA_fixlist_heapitem addend;
@@ -819,8 +912,8 @@ int tcmplxA_fixlist_gen_lengths
         }
       }
     }
-    tcmplxA_util_free(heap);
-    tcmplxA_util_free(nodes);
+    tcmplxA_util_deallocate(dst->alloc, heap);
+    tcmplxA_util_deallocate(dst->alloc, nodes);
     return tcmplxA_Success;
   }
 }
@@ -857,6 +950,9 @@ size_t tcmplxA_fixlist_valuebsearch
   (struct tcmplxA_fixlist const* dst, unsigned long int value)
 {
   struct tcmplxA_fixline key;
+  /* dense alphabets keep each value at its own index */
+  if (value < dst->n && dst->p[value].value == value)
+    return (size_t)value;
   key.value = value;
   /* */{
     struct tcmplxA_fixline* x = bsearch
@@ -896,8 +992,8 @@ int tcmplxA_fixlist_match_preset(struct tcmplxA_fixlist* dst,
     return tcmplxA_FixList_BrotliComplex;
   if (nonzero_start > 0) {
     memmove(dst->p, dst->p+nonzero_start, sizeof(struct tcmplxA_fixline)*nonzero_total);
-    dst->n = nonzero_total;
   }
+  dst->n = nonzero_total;
   switch (nonzero_total) {
   case 1:
     dst->p[0].len = 0;
@@ -932,4 +1028,12 @@ int tcmplxA_fixlist_match_preset(struct tcmplxA_fixlist* dst,
   }
   return tcmplxA_FixList_BrotliComplex;
 }
+
+size_t tcmplxA_fixlist_memory_usage(struct tcmplxA_fixlist const* x) {
+  return sizeof(struct tcmplxA_fixlist) + x->n*sizeof(struct tcmplxA_fixline);
+}
+
+size_t tcmplxA_fixlist_memory_bound(size_t n) {
+  return sizeof(struct tcmplxA_fixlist) + n*sizeof(struct tcmplxA_fixline);
+}
 /* END   prefix list / public */
@@ -13,19 +13,25 @@ extern "C" {
 #endif /*__cplusplus*/
 
 struct tcmplxA_fixline;
+struct tcmplxA_allocator;
 
 struct tcmplxA_fixlist {
   struct tcmplxA_fixline* p;
   size_t n;
+  struct tcmplxA_allocator const* alloc;
 };
 
 /**
  * @internal
  * @brief Initialize a prefix list.
  * @param x the prefix list to initialize
+ * @param sz number of lines in the list
+ * @param alloc (nullable) allocator for the list; NULL for the heap
  * @return zero on success, nonzero otherwise
  */
-int tcmplxA_fixlist_init(struct tcmplxA_fixlist* x, size_t sz);
+int tcmplxA_fixlist_init
+  ( struct tcmplxA_fixlist* x, size_t sz,
+    struct tcmplxA_allocator const* alloc);
 /**
  * @internal
  * @brief Resize a prefix list.
@@ -4,12 +4,38 @@
  */
 #include "fixlist_p.h"
 #include <text-complex/access/gaspvec.h>
+#include <text-complex/access/fixlist.h>
 #include <text-complex/access/util.h>
 #include <limits.h>
+#include <string.h>
 
 
+enum tcmplxA_gaspvec_uconst {
+  /** @brief Number of code bits resolved by a root table. */
+  tcmplxA_GaspVec_RootBits = 8,
+  tcmplxA_GaspVec_RootSize = 1<<tcmplxA_GaspVec_RootBits,
+  /** @brief Longest supported prefix code. */
+  tcmplxA_GaspVec_MaxBits = 15
+};
+
+/**
+ * @brief Lookup table entry.
+ * @note A root entry with nonzero `sub` links to a second-level table
+ *   of `1<<sub` entries starting at `value` past the root.
+ */
+struct tcmplxA_gasplut {
+  /** @brief Alphabet symbol, or subtable offset for a link. */
+  unsigned short value;
+  /** @brief Length of the matching prefix code; zero if none. */
+  unsigned char len;
+  /** @brief Bits indexed by the linked subtable; zero if not a link. */
+  unsigned char sub;
+};
+
 struct tcmplxA_gasproot {
   struct tcmplxA_fixlist tree;
+  /** @brief Offset of the root table in the lookup arena. */
+  size_t lut;
   unsigned short noskip;
 };
 
@@ -17,6 +43,12 @@ struct tcmplxA_gaspvec {
   struct tcmplxA_gasproot* trees;
   unsigned count;
   unsigned cap;
+  struct tcmplxA_allocator const* alloc;
+  /** @brief Lookup tables for all trees, back to back. */
+  struct tcmplxA_gasplut* luts;
+  size_t lut_cap;
+  /** @brief Whether the lookup tables match the trees. */
+  int lut_ok;
 };
 
 
@@ -24,9 +56,13 @@ struct tcmplxA_gaspvec {
  * @internal
  * @brief Initialize a prefix gasp vector.
  * @param x the prefix gasp vector to initialize
+ * @param sz number of trees in the list
+ * @param alloc (nullable) allocator for the vector; NULL for the heap
  * @return zero on success, nonzero otherwise
  */
-int tcmplxA_gaspvec_init(struct tcmplxA_gaspvec* x, size_t sz);
+int tcmplxA_gaspvec_init
+  ( struct tcmplxA_gaspvec* x, size_t sz,
+    struct tcmplxA_allocator const* alloc);
 /**
  * @internal
  * @brief Resize a prefix gasp vector.
@@ -41,12 +77,39 @@ int tcmplxA_gaspvec_resize(struct tcmplxA_gaspvec* x, size_t sz);
  * @param x the prefix gasp vector to close
  */
 void tcmplxA_gaspvec_close(struct tcmplxA_gaspvec* x);
+/**
+ * @internal
+ * @brief Compute subtable widths for one prefix tree.
+ * @param tree the tree to inspect
+ * @param[out] sub_bits subtable width for each root entry
+ * @return the number of lookup entries needed, or zero if the tree
+ *   has codes too long to support
+ */
+static size_t tcmplxA_gaspvec_lut_count
+  (struct tcmplxA_fixlist const* tree, unsigned char* sub_bits);
+/**
+ * @internal
+ * @brief Fill the lookup table for one prefix tree.
+ * @param tree the tree to compile
+ * @param sub_bits subtable widths from the count pass
+ * @param[out] lut lookup table to fill
+ */
+static void tcmplxA_gaspvec_lut_fill
+  ( struct tcmplxA_fixlist const* tree, unsigned char const* sub_bits,
+    struct tcmplxA_gasplut* lut);
 
 #pragma region("gaspvec / static")
-int tcmplxA_gaspvec_init(struct tcmplxA_gaspvec* x, size_t sz) {
+int tcmplxA_gaspvec_init
+  ( struct tcmplxA_gaspvec* x, size_t sz,
+    struct tcmplxA_allocator const* alloc)
+{
+  x->alloc = alloc;
   x->trees = NULL;
   x->count = 0u;
   x->cap = 0u;
+  x->luts = NULL;
+  x->lut_cap = 0u;
+  x->lut_ok = 0;
   return tcmplxA_gaspvec_resize(x,sz);
 }
 
@@ -56,56 +119,139 @@ int tcmplxA_gaspvec_resize(struct tcmplxA_gaspvec* x, size_t sz) {
     return tcmplxA_ErrMemory;
   } else if (sz > 0 && sz > x->cap) {
     size_t i;
-    ptr = (struct tcmplxA_gasproot*)tcmplxA_util_malloc
-            (sizeof(struct tcmplxA_gasproot)*sz);
+    ptr = (struct tcmplxA_gasproot*)tcmplxA_util_allocate
+            (x->alloc, sizeof(struct tcmplxA_gasproot)*sz);
     if (!ptr)
       return tcmplxA_ErrMemory;
     if (x->trees) {
-      for (i = 0; i < x->count; ++i)
+      for (i = 0; i < x->cap; ++i)
         tcmplxA_fixlist_close(&x->trees[i].tree);
-      tcmplxA_util_free(x->trees);
+      tcmplxA_util_deallocate(x->alloc, x->trees);
     }
     for (i = 0; i < sz; ++i) {
-      tcmplxA_fixlist_init(&ptr[i].tree, 0);
+      tcmplxA_fixlist_init(&ptr[i].tree, 0, x->alloc);
       ptr[i].noskip = USHRT_MAX;
+      ptr[i].lut = 0u;
     }
     x->trees = ptr;
     x->cap = sz;
   }
   x->count = sz;
+  x->lut_ok = 0;
   return tcmplxA_Success;
 }
 
 void tcmplxA_gaspvec_close(struct tcmplxA_gaspvec* x) {
   unsigned i;
-  for (i = 0; i < x->count; ++i)
+  for (i = 0; i < x->cap; ++i)
     tcmplxA_fixlist_close(&x->trees[i].tree);
-  tcmplxA_util_free(x->trees);
+  tcmplxA_util_deallocate(x->alloc, x->trees);
+  tcmplxA_util_deallocate(x->alloc, x->luts);
   x->trees = NULL;
   x->count = 0u;
   x->cap = 0u;
+  x->luts = NULL;
+  x->lut_cap = 0u;
+  x->lut_ok = 0;
+  return;
+}
+
+size_t tcmplxA_gaspvec_lut_count
+  (struct tcmplxA_fixlist const* tree, unsigned char* sub_bits)
+{
+  size_t i;
+  size_t out = tcmplxA_GaspVec_RootSize;
+  memset(sub_bits, 0, tcmplxA_GaspVec_RootSize);
+  for (i = 0; i < tree->n; ++i) {
+    struct tcmplxA_fixline const* const line = &tree->p[i];
+    if (line->len > tcmplxA_GaspVec_MaxBits)
+      return 0u;
+    else if (line->len > tcmplxA_GaspVec_RootBits) {
+      unsigned const extra = line->len - tcmplxA_GaspVec_RootBits;
+      unsigned const root = (line->code >> extra) & 255u;
+      if (sub_bits[root] < extra)
+        sub_bits[root] = (unsigned char)extra;
+    }
+  }
+  for (i = 0; i < tcmplxA_GaspVec_RootSize; ++i) {
+    if (sub_bits[i])
+      out += ((size_t)1u)<<sub_bits[i];
+  }
+  return out;
+}
+
+void tcmplxA_gaspvec_lut_fill
+  ( struct tcmplxA_fixlist const* tree, unsigned char const* sub_bits,
+    struct tcmplxA_gasplut* lut)
+{
+  size_t i;
+  size_t next = tcmplxA_GaspVec_RootSize;
+  memset(lut, 0, sizeof(struct tcmplxA_gasplut)*tcmplxA_GaspVec_RootSize);
+  /* links */for (i = 0; i < tcmplxA_GaspVec_RootSize; ++i) {
+    size_t const sub_size = ((size_t)1u)<<sub_bits[i];
+    if (!sub_bits[i])
+      continue;
+    lut[i].value = (unsigned short)next;
+    lut[i].sub = sub_bits[i];
+    memset(lut+next, 0, sizeof(struct tcmplxA_gasplut)*sub_size);
+    next += sub_size;
+  }
+  /* leaves */for (i = 0; i < tree->n; ++i) {
+    struct tcmplxA_fixline const* const line = &tree->p[i];
+    struct tcmplxA_gasplut leaf;
+    struct tcmplxA_gasplut* table = lut;
+    unsigned spread;
+    unsigned start;
+    unsigned j;
+    if (line->len == 0)
+      continue;
+    leaf.value = (unsigned short)line->value;
+    leaf.len = (unsigned char)line->len;
+    leaf.sub = 0u;
+    if (line->len > tcmplxA_GaspVec_RootBits) {
+      unsigned const extra = line->len - tcmplxA_GaspVec_RootBits;
+      struct tcmplxA_gasplut const* const link =
+        &lut[(line->code >> extra) & 255u];
+      table = lut + link->value;
+      spread = link->sub - extra;
+      start = (line->code & ((1u<<extra)-1u)) << spread;
+    } else {
+      spread = tcmplxA_GaspVec_RootBits - line->len;
+      start = line->code << spread;
+    }
+    for (j = 0; j < (1u<<spread); ++j)
+      table[start+j] = leaf;
+  }
   return;
 }
 #pragma endregion
 
 #pragma region("gaspvec / functions")
 struct tcmplxA_gaspvec* tcmplxA_gaspvec_new(size_t n) {
+  return tcmplxA_gaspvec_new_alloc(n, NULL);
+}
+
+struct tcmplxA_gaspvec* tcmplxA_gaspvec_new_alloc
+  (size_t n, struct tcmplxA_allocator const* alloc)
+{
   struct tcmplxA_gaspvec* out;
-  out = tcmplxA_util_malloc(sizeof(struct tcmplxA_gaspvec));
+  out = tcmplxA_util_allocate(alloc, sizeof(struct tcmplxA_gaspvec));
   if (out != NULL
-  &&  tcmplxA_gaspvec_init(out, n) != tcmplxA_Success)
+  &&  tcmplxA_gaspvec_init(out, n, alloc) != tcmplxA_Success)
   {
-    tcmplxA_util_free(out);
+    tcmplxA_util_deallocate(alloc, out);
     return NULL;
   }
   return out;
 }
 
 void tcmplxA_gaspvec_destroy(struct tcmplxA_gaspvec* x) {
+  struct tcmplxA_allocator const* alloc;
   if (!x)
     return;
+  alloc = x->alloc;
   tcmplxA_gaspvec_close(x);
-  tcmplxA_util_free(x);
+  tcmplxA_util_deallocate(alloc, x);
   return;
 }
 
@@ -118,7 +264,8 @@ struct tcmplxA_fixlist* tcmplxA_gaspvec_at
 {
   if (i >= x->count)
     return NULL;
-  else return &x->trees[i].tree;
+  x->lut_ok = 0;
+  return &x->trees[i].tree;
 }
 
 struct tcmplxA_fixlist const* tcmplxA_gaspvec_at_c
@@ -140,4 +287,107 @@ void tcmplxA_gaspvec_set_skip(struct tcmplxA_gaspvec const* x, size_t i, unsigne
     return;
   x->trees[i].noskip = noskip;
 }
+
+int tcmplxA_gaspvec_compile(struct tcmplxA_gaspvec* x) {
+  unsigned char sub_bits[tcmplxA_GaspVec_RootSize];
+  size_t total = 0u;
+  unsigned i;
+  x->lut_ok = 0;
+  for (i = 0; i < x->count; ++i) {
+    size_t const n = tcmplxA_gaspvec_lut_count(&x->trees[i].tree, sub_bits);
+    if (n == 0u)
+      return tcmplxA_ErrParam;
+    x->trees[i].lut = total;
+    total += n;
+  }
+  if (total > x->lut_cap) {
+    struct tcmplxA_gasplut* ptr;
+    if (total > ((size_t)-1)/sizeof(struct tcmplxA_gasplut))
+      return tcmplxA_ErrMemory;
+    ptr = (struct tcmplxA_gasplut*)tcmplxA_util_allocate
+      (x->alloc, total*sizeof(struct tcmplxA_gasplut));
+    if (!ptr)
+      return tcmplxA_ErrMemory;
+    tcmplxA_util_deallocate(x->alloc, x->luts);
+    x->luts = ptr;
+    x->lut_cap = total;
+  }
+  for (i = 0; i < x->count; ++i) {
+    struct tcmplxA_fixlist const* const tree = &x->trees[i].tree;
+    tcmplxA_gaspvec_lut_count(tree, sub_bits);
+    tcmplxA_gaspvec_lut_fill(tree, sub_bits, x->luts + x->trees[i].lut);
+  }
+  x->lut_ok = 1;
+  return tcmplxA_Success;
+}
+
+unsigned tcmplxA_gaspvec_decode
+  (struct tcmplxA_gaspvec const* x, size_t i, unsigned n, unsigned bits)
+{
+  struct tcmplxA_gasplut const* root;
+  struct tcmplxA_gasplut entry;
+  if (i >= x->count || n == 0u || n > tcmplxA_GaspVec_MaxBits)
+    return UINT_MAX;
+  else if (!x->lut_ok) {
+    struct tcmplxA_fixlist const* const tree = &x->trees[i].tree;
+    size_t const line = tcmplxA_fixlist_codebsearch(tree, n, bits);
+    if (line >= tree->n)
+      return UINT_MAX;
+    return (unsigned)tree->p[line].value;
+  }
+  root = x->luts + x->trees[i].lut;
+  if (n <= tcmplxA_GaspVec_RootBits)
+    entry = root[(bits << (tcmplxA_GaspVec_RootBits-n)) & 255u];
+  else {
+    unsigned const extra = n - tcmplxA_GaspVec_RootBits;
+    struct tcmplxA_gasplut const link = root[(bits >> extra) & 255u];
+    if (link.sub < extra)
+      return UINT_MAX;
+    entry = root[link.value
+      + ((bits & ((1u<<extra)-1u)) << (link.sub-extra))];
+  }
+  return (entry.len == n && entry.sub == 0u) ? entry.value : UINT_MAX;
+}
+
+unsigned tcmplxA_gaspvec_peek
+  ( struct tcmplxA_gaspvec const* x, size_t i, unsigned bits,
+    unsigned* len)
+{
+  unsigned const rest_bits =
+    tcmplxA_GaspVec_MaxBits - tcmplxA_GaspVec_RootBits;
+  struct tcmplxA_gasplut const* root;
+  struct tcmplxA_gasplut entry;
+  if (i >= x->count || !x->lut_ok)
+    return UINT_MAX;
+  root = x->luts + x->trees[i].lut;
+  entry = root[(bits >> rest_bits) & 255u];
+  if (entry.sub) {
+    unsigned const rest = bits & ((1u<<rest_bits)-1u);
+    entry = root[entry.value + (rest >> (rest_bits-entry.sub))];
+  }
+  if (entry.len == 0u || entry.sub != 0u)
+    return UINT_MAX;
+  *len = entry.len;
+  return entry.value;
+}
+
+size_t tcmplxA_gaspvec_memory_usage(struct tcmplxA_gaspvec const* x) {
+  size_t out = sizeof(struct tcmplxA_gaspvec)
+    + x->cap*sizeof(struct tcmplxA_gasproot)
+    + x->lut_cap*sizeof(struct tcmplxA_gasplut);
+  unsigned i;
+  for (i = 0; i < x->cap; ++i)
+    out += x->trees[i].tree.n*sizeof(struct tcmplxA_fixline);
+  return out;
+}
+
+size_t tcmplxA_gaspvec_memory_bound(size_t n, size_t alphabet) {
+  /* a subtable of 2^k entries takes at least k+1 codes of a complete tree */
+  size_t const lut = tcmplxA_GaspVec_RootSize
+    + (alphabet < 2048u ? alphabet*16u : 32768u);
+  return sizeof(struct tcmplxA_gaspvec)
+    + n*(sizeof(struct tcmplxA_gasproot)
+        + alphabet*sizeof(struct tcmplxA_fixline)
+        + lut*sizeof(struct tcmplxA_gasplut));
+}
 #pragma endregion
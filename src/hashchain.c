@@ -16,7 +16,13 @@ struct tcmplxA_hashchain {
   unsigned char last_count;
   unsigned char last_bytes[3];
   tcmplxA_uint32 counter;
+  /** @brief Counter value at each link; NULL for small windows. */
   tcmplxA_uint32* chains;
+  /**
+   * @brief Low 16 bits of the counter value at each link;
+   *   NULL for large windows.
+   */
+  unsigned short* short_chains;
   size_t* positions;
   size_t chain_length;
 };
@@ -24,7 +30,16 @@ struct tcmplxA_hashchain {
 enum tcmplxA_hashchain_const {
   tcmplxA_HashChain_PreMax = (INT_MAX / sizeof(tcmplxA_uint32)) / 251u,
   tcmplxA_HashChain_Max = (tcmplxA_HashChain_PreMax > (size_t)-1)
-      ? ((size_t)-1) : tcmplxA_HashChain_PreMax
+      ? ((size_t)-1) : tcmplxA_HashChain_PreMax,
+  /**
+   * @brief Largest window to link with 16-bit chain entries.
+   * @note Also the number of additions between sweeps of the
+   *   16-bit entries. A sweep marks each entry at least this far
+   *   back as stale, so that no live entry gets to 65536 additions
+   *   back and wraps.
+   */
+  tcmplxA_HashChain_ShortWindow = 32768u,
+  tcmplxA_HashChain_ShortMask = 0xFFFFu
 };
 
 /**
@@ -32,15 +47,50 @@ enum tcmplxA_hashchain_const {
  * @param n maximum sliding window size
  * @param x the hash chain to initialize
  * @param chain_length run-time parameter limiting hash chain length
+ * @param alloc (nullable) allocator for the chains; NULL for the heap
  * @return zero on success, nonzero otherwise
  */
 static int tcmplxA_hashchain_init
-  (struct tcmplxA_hashchain* x, tcmplxA_uint32 n, size_t chain_length);
+  ( struct tcmplxA_hashchain* x, tcmplxA_uint32 n, size_t chain_length,
+    struct tcmplxA_allocator const* alloc);
 /**
  * @brief Close a hash chain.
  * @param x the hash chain to close
  */
 static void tcmplxA_hashchain_close(struct tcmplxA_hashchain* x);
+/**
+ * @brief Compute the size of one chain link.
+ * @param n maximum sliding window size
+ * @return the number of bytes per link
+ */
+static size_t tcmplxA_hashchain_link_size(tcmplxA_uint32 n);
+/**
+ * @brief Mark the 16-bit chain entries that are too old to keep.
+ * @param x the hash chain to update
+ */
+static void tcmplxA_hashchain_sweep(struct tcmplxA_hashchain* x);
+/**
+ * @brief Search 32-bit chain entries for a match.
+ * @param x the hash chain to search
+ * @param b three bytes to match
+ * @param pos least backward distance to consider
+ * @param limit most chain entries to inspect
+ * @return a backward distance, or `(tcmplxA_uint32)-1` if none
+ */
+static tcmplxA_uint32 tcmplxA_hashchain_find_wide
+  ( struct tcmplxA_hashchain const* x, unsigned char const* b,
+    tcmplxA_uint32 pos, size_t limit);
+/**
+ * @brief Search 16-bit chain entries for a match.
+ * @param x the hash chain to search
+ * @param b three bytes to match
+ * @param pos least backward distance to consider
+ * @param limit most chain entries to inspect
+ * @return a backward distance, or `(tcmplxA_uint32)-1` if none
+ */
+static tcmplxA_uint32 tcmplxA_hashchain_find_short
+  ( struct tcmplxA_hashchain const* x, unsigned char const* b,
+    tcmplxA_uint32 pos, size_t limit);
 /**
  * @brief Calculate a hash.
  * @param b three bytes to use as input
@@ -58,25 +108,27 @@ static void tcmplxA_hashchain_fetch
 
 /* BEGIN hash chain / static */
 int tcmplxA_hashchain_init
-  (struct tcmplxA_hashchain* x, tcmplxA_uint32 n, size_t chain_length)
+  ( struct tcmplxA_hashchain* x, tcmplxA_uint32 n, size_t chain_length,
+    struct tcmplxA_allocator const* alloc)
 {
-  int const res = tcmplxA_ringslide_init(&x->sr, n);
+  int const res = tcmplxA_ringslide_init(&x->sr, n, alloc);
   if (res != tcmplxA_Success)
     return res;
   else {
-    tcmplxA_uint32 *new_chains;
+    void *new_chains;
     size_t *new_positions;
-    size_t const chain_size = chain_length*251u*sizeof(tcmplxA_uint32);
+    size_t const chain_size =
+      chain_length*251u*tcmplxA_hashchain_link_size(n);
     size_t const positions_size = 251u*sizeof(size_t);
     if (chain_length >= tcmplxA_HashChain_Max) {
       tcmplxA_ringslide_close(&x->sr);
       return tcmplxA_ErrMemory;
     }
-    new_chains = tcmplxA_util_malloc(chain_size);
-    new_positions = tcmplxA_util_malloc(positions_size);
+    new_chains = tcmplxA_util_allocate(alloc, chain_size);
+    new_positions = tcmplxA_util_allocate(alloc, positions_size);
     if (new_chains == NULL || new_positions == NULL) {
-      tcmplxA_util_free(new_positions);
-      tcmplxA_util_free(new_chains);
+      tcmplxA_util_deallocate(alloc, new_positions);
+      tcmplxA_util_deallocate(alloc, new_chains);
       tcmplxA_ringslide_close(&x->sr);
       return tcmplxA_ErrMemory;
     }
@@ -86,21 +138,114 @@ int tcmplxA_hashchain_init
     memset(x->last_bytes, 0, sizeof(unsigned char)*3u);
     x->counter = 0u;
     x->chain_length = chain_length;
-    x->chains = new_chains;
+    if (n > tcmplxA_HashChain_ShortWindow) {
+      x->chains = (tcmplxA_uint32*)new_chains;
+      x->short_chains = NULL;
+    } else {
+      x->chains = NULL;
+      x->short_chains = (unsigned short*)new_chains;
+    }
     x->positions = new_positions;
     return tcmplxA_Success;
   }
 }
 
 void tcmplxA_hashchain_close(struct tcmplxA_hashchain* x) {
-  tcmplxA_util_free(x->positions);
+  tcmplxA_util_deallocate(x->sr.alloc, x->positions);
   x->positions = NULL;
-  tcmplxA_util_free(x->chains);
+  tcmplxA_util_deallocate(x->sr.alloc, x->chains);
   x->chains = NULL;
+  tcmplxA_util_deallocate(x->sr.alloc, x->short_chains);
+  x->short_chains = NULL;
   tcmplxA_ringslide_close(&x->sr);
   return;
 }
 
+size_t tcmplxA_hashchain_link_size(tcmplxA_uint32 n) {
+  return n > tcmplxA_HashChain_ShortWindow
+    ? sizeof(tcmplxA_uint32) : sizeof(unsigned short);
+}
+
+void tcmplxA_hashchain_sweep(struct tcmplxA_hashchain* x) {
+  unsigned short* const chains = x->short_chains;
+  size_t const n = x->chain_length*251u;
+  unsigned int const here =
+    (unsigned int)(x->counter & tcmplxA_HashChain_ShortMask);
+  /* stale entries stay at least `ShortWindow` back until the next sweep */
+  unsigned short const stale = (unsigned short)
+    ((here - tcmplxA_HashChain_ShortWindow) & tcmplxA_HashChain_ShortMask);
+  size_t i;
+  for (i = 0u; i < n; ++i) {
+    /* live entries are never zero additions back */
+    unsigned int const age = (here - chains[i]) & tcmplxA_HashChain_ShortMask;
+    if (age == 0u || age >= tcmplxA_HashChain_ShortWindow)
+      chains[i] = stale;
+  }
+  return;
+}
+
+tcmplxA_uint32 tcmplxA_hashchain_find_wide
+  ( struct tcmplxA_hashchain const* x, unsigned char const* b,
+    tcmplxA_uint32 pos, size_t limit)
+{
+  unsigned int const i = tcmplxA_hashchain_hash(b);
+  size_t chain_i = x->positions[i];
+  tcmplxA_uint32 const* const chain = x->chains+(i*x->chain_length);
+  tcmplxA_uint32 const here = x->counter;
+  tcmplxA_uint32 const size = tcmplxA_ringslide_size(&x->sr)-2u;
+  size_t j;
+  for (j = 0u; j < limit; ++j) {
+    if (chain_i == 0u)
+      chain_i = x->chain_length;
+    /* */{
+      tcmplxA_uint32 const y = here-chain[--chain_i]-1u;
+      if (y < pos)
+        continue;
+      else if (y >= size)
+        return ((tcmplxA_uint32)-1);
+      else {
+        unsigned char tmp[3];
+        tcmplxA_hashchain_fetch(&x->sr, tmp, y);
+        if (memcmp(tmp, b, 3u*sizeof(unsigned char)) == 0)
+            return y+2u;
+      }
+    }
+  }
+  return ((tcmplxA_uint32)-1);
+}
+
+tcmplxA_uint32 tcmplxA_hashchain_find_short
+  ( struct tcmplxA_hashchain const* x, unsigned char const* b,
+    tcmplxA_uint32 pos, size_t limit)
+{
+  unsigned int const i = tcmplxA_hashchain_hash(b);
+  size_t chain_i = x->positions[i];
+  unsigned short const* const chain = x->short_chains+(i*x->chain_length);
+  unsigned int const here =
+    (unsigned int)(x->counter & tcmplxA_HashChain_ShortMask);
+  tcmplxA_uint32 const size = tcmplxA_ringslide_size(&x->sr)-2u;
+  size_t j;
+  for (j = 0u; j < limit; ++j) {
+    if (chain_i == 0u)
+      chain_i = x->chain_length;
+    /* sweeps keep every entry less than 65536 additions back */{
+      tcmplxA_uint32 const y =
+        ((here-chain[--chain_i]) & tcmplxA_HashChain_ShortMask) - 1u;
+      if (y < pos)
+        continue;
+      else if (y >= size)
+        return ((tcmplxA_uint32)-1);
+      else {
+        unsigned char tmp[3];
+        tcmplxA_hashchain_fetch(&x->sr, tmp, y);
+        if (memcmp(tmp, b, 3u*sizeof(unsigned char)) == 0)
+            return y+2u;
+      }
+    }
+  }
+  return ((tcmplxA_uint32)-1);
+}
+
 unsigned int tcmplxA_hashchain_hash(unsigned char const* b) {
   return ((unsigned int)((b[0]<<6)+(b[1]<<3)+b[2]))%251u;
 }
@@ -118,13 +263,20 @@ void tcmplxA_hashchain_fetch
 /* BEGIN hash chain / public */
 struct tcmplxA_hashchain* tcmplxA_hashchain_new
   (tcmplxA_uint32 n, size_t chain_length)
+{
+  return tcmplxA_hashchain_new_alloc(n, chain_length, NULL);
+}
+
+struct tcmplxA_hashchain* tcmplxA_hashchain_new_alloc
+  ( tcmplxA_uint32 n, size_t chain_length,
+    struct tcmplxA_allocator const* alloc)
 {
   struct tcmplxA_hashchain* out;
-  out = tcmplxA_util_malloc(sizeof(struct tcmplxA_hashchain));
+  out = tcmplxA_util_allocate(alloc, sizeof(struct tcmplxA_hashchain));
   if (out != NULL
-  &&  tcmplxA_hashchain_init(out,n,chain_length) != tcmplxA_Success)
+  &&  tcmplxA_hashchain_init(out,n,chain_length,alloc) != tcmplxA_Success)
   {
-    tcmplxA_util_free(out);
+    tcmplxA_util_deallocate(alloc, out);
     return NULL;
   }
   return out;
@@ -132,8 +284,9 @@ struct tcmplxA_hashchain* tcmplxA_hashchain_new
 
 void tcmplxA_hashchain_destroy(struct tcmplxA_hashchain* x) {
   if (x != NULL) {
+    struct tcmplxA_allocator const* const alloc = x->sr.alloc;
     tcmplxA_hashchain_close(x);
-    tcmplxA_util_free(x);
+    tcmplxA_util_deallocate(alloc, x);
   }
   return;
 }
@@ -152,8 +305,16 @@ int tcmplxA_hashchain_add(struct tcmplxA_hashchain* x, unsigned int v) {
   /* add to hash table */{
     unsigned int const i = tcmplxA_hashchain_hash(x->last_bytes);
     size_t const pos = x->positions[i];
-    tcmplxA_uint32 *const chain = x->chains+(i*x->chain_length);
-    chain[pos] = x->counter++;
+    if (x->short_chains != NULL) {
+      if ((x->counter & (tcmplxA_HashChain_ShortWindow-1u)) == 0u
+      &&  x->counter != 0u)
+      {
+        tcmplxA_hashchain_sweep(x);
+      }
+      x->short_chains[i*x->chain_length+pos] =
+        (unsigned short)(x->counter & tcmplxA_HashChain_ShortMask);
+    } else x->chains[i*x->chain_length+pos] = x->counter;
+    x->counter += 1u;
     x->positions[i] = (pos+1u >= x->chain_length ? 0u : pos+1u);
   }
   return tcmplxA_ringslide_add(&x->sr, v);
@@ -172,34 +333,97 @@ unsigned int tcmplxA_hashchain_peek
 tcmplxA_uint32 tcmplxA_hashchain_find
   ( struct tcmplxA_hashchain const* x, unsigned char const* b,
     tcmplxA_uint32 pos)
+{
+  return tcmplxA_hashchain_find_limit(x, b, pos, x->chain_length);
+}
+
+tcmplxA_uint32 tcmplxA_hashchain_find_limit
+  ( struct tcmplxA_hashchain const* x, unsigned char const* b,
+    tcmplxA_uint32 pos, size_t limit)
 {
   if (tcmplxA_ringslide_size(&x->sr) < 3u)
     return ((tcmplxA_uint32)-1);
-  else {
-    unsigned int const i = tcmplxA_hashchain_hash(b);
-    size_t chain_i = x->positions[i];
-    tcmplxA_uint32 *const chain = x->chains+(i*x->chain_length);
-    tcmplxA_uint32 const here = x->counter;
-    tcmplxA_uint32 const size = tcmplxA_ringslide_size(&x->sr)-2u;
-    size_t j;
-    for (j = 0u; j < x->chain_length; ++j) {
-      if (chain_i == 0u)
-        chain_i = x->chain_length;
-      /* */{
-        tcmplxA_uint32 const y = here-chain[--chain_i]-1u;
-        if (y < pos)
-          continue;
-        else if (y >= size)
-          return ((tcmplxA_uint32)-1);
-        else {
-          unsigned char tmp[3];
-          tcmplxA_hashchain_fetch(&x->sr, tmp, y);
-          if (memcmp(tmp, b, 3u*sizeof(unsigned char)) == 0)
-              return y+2u;
-        }
-      }
+  if (limit > x->chain_length)
+    limit = x->chain_length;
+  return x->short_chains != NULL
+    ? tcmplxA_hashchain_find_short(x, b, pos, limit)
+    : tcmplxA_hashchain_find_wide(x, b, pos, limit);
+}
+
+void tcmplxA_hashchain_reset(struct tcmplxA_hashchain* x) {
+  tcmplxA_ringslide_reset(&x->sr);
+  x->last_count = 0u;
+  memset(x->last_bytes, 0, sizeof(unsigned char)*3u);
+  /*
+   * Chain entries from before the reset lie farther back than the
+   * (now empty) window, so the search stops at them just as it stops
+   * at zero entries. Clear them only when the counter nears overflow.
+   */
+  if (x->counter >= 0x80000000u) {
+    if (x->short_chains != NULL)
+      memset(x->short_chains, 0, x->chain_length*251u*sizeof(unsigned short));
+    else memset(x->chains, 0, x->chain_length*251u*sizeof(tcmplxA_uint32));
+    memset(x->positions, 0, 251u*sizeof(size_t));
+    x->counter = 0u;
+  }
+  return;
+}
+
+int tcmplxA_hashchain_copy
+  (struct tcmplxA_hashchain* dst, struct tcmplxA_hashchain const* src)
+{
+  size_t const chain_size = src->chain_length*251u
+    * (src->short_chains != NULL
+      ? sizeof(unsigned short) : sizeof(tcmplxA_uint32));
+  if (dst == src)
+    return tcmplxA_Success;
+  if (dst->chain_length != src->chain_length
+  ||  (dst->short_chains != NULL) != (src->short_chains != NULL))
+  {
+    void* const new_chains = tcmplxA_util_allocate(dst->sr.alloc, chain_size);
+    if (new_chains == NULL)
+      return tcmplxA_ErrMemory;
+    tcmplxA_util_deallocate(dst->sr.alloc, dst->chains);
+    tcmplxA_util_deallocate(dst->sr.alloc, dst->short_chains);
+    if (src->short_chains != NULL) {
+      dst->chains = NULL;
+      dst->short_chains = (unsigned short*)new_chains;
+    } else {
+      dst->chains = (tcmplxA_uint32*)new_chains;
+      dst->short_chains = NULL;
     }
-    return ((tcmplxA_uint32)-1);
+    dst->chain_length = src->chain_length;
   }
+  /* */{
+    int const res = tcmplxA_ringslide_copy(&dst->sr, &src->sr);
+    if (res != tcmplxA_Success)
+      return res;
+  }
+  if (src->short_chains != NULL)
+    memcpy(dst->short_chains, src->short_chains, chain_size);
+  else memcpy(dst->chains, src->chains, chain_size);
+  memcpy(dst->positions, src->positions, 251u*sizeof(size_t));
+  memcpy(dst->last_bytes, src->last_bytes, sizeof(unsigned char)*3u);
+  dst->last_count = src->last_count;
+  dst->counter = src->counter;
+  return tcmplxA_Success;
+}
+
+size_t tcmplxA_hashchain_memory_usage(struct tcmplxA_hashchain const* x) {
+  return sizeof(struct tcmplxA_hashchain)
+    + x->chain_length*251u*(x->short_chains != NULL
+      ? sizeof(unsigned short) : sizeof(tcmplxA_uint32))
+    + 251u*sizeof(size_t)
+    + (tcmplxA_ringslide_memory_usage(&x->sr)
+      - sizeof(struct tcmplxA_ringslide));
+}
+
+size_t tcmplxA_hashchain_memory_bound(tcmplxA_uint32 n, size_t chain_length) {
+  if (n > 0x1000000 || chain_length >= tcmplxA_HashChain_Max)
+    return (size_t)-1;
+  return sizeof(struct tcmplxA_hashchain)
+    + chain_length*251u*tcmplxA_hashchain_link_size(n)
+    + 251u*sizeof(size_t)
+    + n*sizeof(unsigned char);
 }
 /* END   hash chain / public */
@@ -25,32 +25,26 @@ enum tcmplxA_inscopy_type_ex {
 struct tcmplxA_inscopy {
   struct tcmplxA_inscopy_row* p;
   size_t n;
+  struct tcmplxA_allocator const* alloc;
 };
 
 /**
- * @brief Fill an insert-copy table with the DEFLATE
- *   literal-length alphabet.
- * @param r array of 286 rows
+ * @brief Length class: a starting length and its extra bit count.
  */
-static void tcmplxA_inscopy_1951_fill(struct tcmplxA_inscopy_row* r);
-/**
- * @brief Fill an insert-copy table with the Brotli
- *   length alphabet cross product.
- * @param r array of 704 rows
- */
-static void tcmplxA_inscopy_7932_fill(struct tcmplxA_inscopy_row* r);
-/**
- * @brief Fill an insert-copy table with the Brotli block code alphabet.
- * @param r array of 26 rows
- */
-static void tcmplxA_inscopy_7932B_fill(struct tcmplxA_inscopy_row* r);
+struct tcmplxA_inscopy_tab {
+  unsigned char bits;
+  unsigned short first;
+};
+
 /**
  * @brief Initialize a insert copy table.
  * @param x the insert copy table to initialize
  * @param n desired row count
+ * @param alloc (nullable) allocator for the table; NULL for the heap
  * @return zero on success, nonzero otherwise
  */
-static int tcmplxA_inscopy_init(struct tcmplxA_inscopy* x, size_t n);
+static int tcmplxA_inscopy_init
+  (struct tcmplxA_inscopy* x, size_t n, struct tcmplxA_allocator const* alloc);
 /**
  * \brief Resize an insert copy table.
  * \param x the table to resize
@@ -84,20 +78,476 @@ static int tcmplxA_inscopy_length_cmp(void const* a, void const* b);
  * @return -1,0,+1 for `a<b`,`a==b`,`a>b`
  */
 static int tcmplxA_inscopy_encode_cmp(void const* k, void const* icr);
+/**
+ * @brief Find the length class holding a length.
+ * @param t length classes in ascending order
+ * @param n number of length classes
+ * @param wide starting class for each bit width of a length
+ * @param x the length to classify (at least `t[0].first`)
+ * @return an index into `t`
+ */
+static unsigned int tcmplxA_inscopy_class
+  ( struct tcmplxA_inscopy_tab const* t, unsigned int n,
+    unsigned char const* wide, unsigned long int x);
+/**
+ * @brief Compute a Brotli insert-and-copy length code.
+ * @param i insert length
+ * @param c copy length
+ * @param z_tf nonzero to select the zero distance variation
+ * @return the alphabet code if one fits, SIZE_MAX otherwise
+ */
+static size_t tcmplxA_inscopy_7932_code
+  (unsigned long int i, unsigned long int c, int z_tf);
+/**
+ * @brief Compute a Brotli block count code.
+ * @param i block count
+ * @return the alphabet code if one fits, SIZE_MAX otherwise
+ */
+static size_t tcmplxA_inscopy_7932B_code(unsigned long int i);
+/**
+ * @brief Compute a DEFLATE length code.
+ * @param c copy length
+ * @return the alphabet code if one fits, SIZE_MAX otherwise
+ */
+static size_t tcmplxA_inscopy_1951_code(unsigned long int c);
+
+
+/*
+ * Preset rows, in code order:
+ *   {type, zero_distance_tf, insert_bits, copy_bits,
+ *     insert_first, copy_first, code}
+ */
+static
+struct tcmplxA_inscopy_row const tcmplxA_inscopy_ps_Deflate[286] = {
+  {0,0,0,0,0,0,0}, {0,0,0,0,0,0,1}, {0,0,0,0,0,0,2}, {0,0,0,0,0,0,3},
+  {0,0,0,0,0,0,4}, {0,0,0,0,0,0,5}, {0,0,0,0,0,0,6}, {0,0,0,0,0,0,7},
+  {0,0,0,0,0,0,8}, {0,0,0,0,0,0,9}, {0,0,0,0,0,0,10}, {0,0,0,0,0,0,11},
+  {0,0,0,0,0,0,12}, {0,0,0,0,0,0,13}, {0,0,0,0,0,0,14}, {0,0,0,0,0,0,15},
+  {0,0,0,0,0,0,16}, {0,0,0,0,0,0,17}, {0,0,0,0,0,0,18}, {0,0,0,0,0,0,19},
+  {0,0,0,0,0,0,20}, {0,0,0,0,0,0,21}, {0,0,0,0,0,0,22}, {0,0,0,0,0,0,23},
+  {0,0,0,0,0,0,24}, {0,0,0,0,0,0,25}, {0,0,0,0,0,0,26}, {0,0,0,0,0,0,27},
+  {0,0,0,0,0,0,28}, {0,0,0,0,0,0,29}, {0,0,0,0,0,0,30}, {0,0,0,0,0,0,31},
+  {0,0,0,0,0,0,32}, {0,0,0,0,0,0,33}, {0,0,0,0,0,0,34}, {0,0,0,0,0,0,35},
+  {0,0,0,0,0,0,36}, {0,0,0,0,0,0,37}, {0,0,0,0,0,0,38}, {0,0,0,0,0,0,39},
+  {0,0,0,0,0,0,40}, {0,0,0,0,0,0,41}, {0,0,0,0,0,0,42}, {0,0,0,0,0,0,43},
+  {0,0,0,0,0,0,44}, {0,0,0,0,0,0,45}, {0,0,0,0,0,0,46}, {0,0,0,0,0,0,47},
+  {0,0,0,0,0,0,48}, {0,0,0,0,0,0,49}, {0,0,0,0,0,0,50}, {0,0,0,0,0,0,51},
+  {0,0,0,0,0,0,52}, {0,0,0,0,0,0,53}, {0,0,0,0,0,0,54}, {0,0,0,0,0,0,55},
+  {0,0,0,0,0,0,56}, {0,0,0,0,0,0,57}, {0,0,0,0,0,0,58}, {0,0,0,0,0,0,59},
+  {0,0,0,0,0,0,60}, {0,0,0,0,0,0,61}, {0,0,0,0,0,0,62}, {0,0,0,0,0,0,63},
+  {0,0,0,0,0,0,64}, {0,0,0,0,0,0,65}, {0,0,0,0,0,0,66}, {0,0,0,0,0,0,67},
+  {0,0,0,0,0,0,68}, {0,0,0,0,0,0,69}, {0,0,0,0,0,0,70}, {0,0,0,0,0,0,71},
+  {0,0,0,0,0,0,72}, {0,0,0,0,0,0,73}, {0,0,0,0,0,0,74}, {0,0,0,0,0,0,75},
+  {0,0,0,0,0,0,76}, {0,0,0,0,0,0,77}, {0,0,0,0,0,0,78}, {0,0,0,0,0,0,79},
+  {0,0,0,0,0,0,80}, {0,0,0,0,0,0,81}, {0,0,0,0,0,0,82}, {0,0,0,0,0,0,83},
+  {0,0,0,0,0,0,84}, {0,0,0,0,0,0,85}, {0,0,0,0,0,0,86}, {0,0,0,0,0,0,87},
+  {0,0,0,0,0,0,88}, {0,0,0,0,0,0,89}, {0,0,0,0,0,0,90}, {0,0,0,0,0,0,91},
+  {0,0,0,0,0,0,92}, {0,0,0,0,0,0,93}, {0,0,0,0,0,0,94}, {0,0,0,0,0,0,95},
+  {0,0,0,0,0,0,96}, {0,0,0,0,0,0,97}, {0,0,0,0,0,0,98}, {0,0,0,0,0,0,99},
+  {0,0,0,0,0,0,100}, {0,0,0,0,0,0,101}, {0,0,0,0,0,0,102}, {0,0,0,0,0,0,103},
+  {0,0,0,0,0,0,104}, {0,0,0,0,0,0,105}, {0,0,0,0,0,0,106}, {0,0,0,0,0,0,107},
+  {0,0,0,0,0,0,108}, {0,0,0,0,0,0,109}, {0,0,0,0,0,0,110}, {0,0,0,0,0,0,111},
+  {0,0,0,0,0,0,112}, {0,0,0,0,0,0,113}, {0,0,0,0,0,0,114}, {0,0,0,0,0,0,115},
+  {0,0,0,0,0,0,116}, {0,0,0,0,0,0,117}, {0,0,0,0,0,0,118}, {0,0,0,0,0,0,119},
+  {0,0,0,0,0,0,120}, {0,0,0,0,0,0,121}, {0,0,0,0,0,0,122}, {0,0,0,0,0,0,123},
+  {0,0,0,0,0,0,124}, {0,0,0,0,0,0,125}, {0,0,0,0,0,0,126}, {0,0,0,0,0,0,127},
+  {0,0,0,0,0,0,128}, {0,0,0,0,0,0,129}, {0,0,0,0,0,0,130}, {0,0,0,0,0,0,131},
+  {0,0,0,0,0,0,132}, {0,0,0,0,0,0,133}, {0,0,0,0,0,0,134}, {0,0,0,0,0,0,135},
+  {0,0,0,0,0,0,136}, {0,0,0,0,0,0,137}, {0,0,0,0,0,0,138}, {0,0,0,0,0,0,139},
+  {0,0,0,0,0,0,140}, {0,0,0,0,0,0,141}, {0,0,0,0,0,0,142}, {0,0,0,0,0,0,143},
+  {0,0,0,0,0,0,144}, {0,0,0,0,0,0,145}, {0,0,0,0,0,0,146}, {0,0,0,0,0,0,147},
+  {0,0,0,0,0,0,148}, {0,0,0,0,0,0,149}, {0,0,0,0,0,0,150}, {0,0,0,0,0,0,151},
+  {0,0,0,0,0,0,152}, {0,0,0,0,0,0,153}, {0,0,0,0,0,0,154}, {0,0,0,0,0,0,155},
+  {0,0,0,0,0,0,156}, {0,0,0,0,0,0,157}, {0,0,0,0,0,0,158}, {0,0,0,0,0,0,159},
+  {0,0,0,0,0,0,160}, {0,0,0,0,0,0,161}, {0,0,0,0,0,0,162}, {0,0,0,0,0,0,163},
+  {0,0,0,0,0,0,164}, {0,0,0,0,0,0,165}, {0,0,0,0,0,0,166}, {0,0,0,0,0,0,167},
+  {0,0,0,0,0,0,168}, {0,0,0,0,0,0,169}, {0,0,0,0,0,0,170}, {0,0,0,0,0,0,171},
+  {0,0,0,0,0,0,172}, {0,0,0,0,0,0,173}, {0,0,0,0,0,0,174}, {0,0,0,0,0,0,175},
+  {0,0,0,0,0,0,176}, {0,0,0,0,0,0,177}, {0,0,0,0,0,0,178}, {0,0,0,0,0,0,179},
+  {0,0,0,0,0,0,180}, {0,0,0,0,0,0,181}, {0,0,0,0,0,0,182}, {0,0,0,0,0,0,183},
+  {0,0,0,0,0,0,184}, {0,0,0,0,0,0,185}, {0,0,0,0,0,0,186}, {0,0,0,0,0,0,187},
+  {0,0,0,0,0,0,188}, {0,0,0,0,0,0,189}, {0,0,0,0,0,0,190}, {0,0,0,0,0,0,191},
+  {0,0,0,0,0,0,192}, {0,0,0,0,0,0,193}, {0,0,0,0,0,0,194}, {0,0,0,0,0,0,195},
+  {0,0,0,0,0,0,196}, {0,0,0,0,0,0,197}, {0,0,0,0,0,0,198}, {0,0,0,0,0,0,199},
+  {0,0,0,0,0,0,200}, {0,0,0,0,0,0,201}, {0,0,0,0,0,0,202}, {0,0,0,0,0,0,203},
+  {0,0,0,0,0,0,204}, {0,0,0,0,0,0,205}, {0,0,0,0,0,0,206}, {0,0,0,0,0,0,207},
+  {0,0,0,0,0,0,208}, {0,0,0,0,0,0,209}, {0,0,0,0,0,0,210}, {0,0,0,0,0,0,211},
+  {0,0,0,0,0,0,212}, {0,0,0,0,0,0,213}, {0,0,0,0,0,0,214}, {0,0,0,0,0,0,215},
+  {0,0,0,0,0,0,216}, {0,0,0,0,0,0,217}, {0,0,0,0,0,0,218}, {0,0,0,0,0,0,219},
+  {0,0,0,0,0,0,220}, {0,0,0,0,0,0,221}, {0,0,0,0,0,0,222}, {0,0,0,0,0,0,223},
+  {0,0,0,0,0,0,224}, {0,0,0,0,0,0,225}, {0,0,0,0,0,0,226}, {0,0,0,0,0,0,227},
+  {0,0,0,0,0,0,228}, {0,0,0,0,0,0,229}, {0,0,0,0,0,0,230}, {0,0,0,0,0,0,231},
+  {0,0,0,0,0,0,232}, {0,0,0,0,0,0,233}, {0,0,0,0,0,0,234}, {0,0,0,0,0,0,235},
+  {0,0,0,0,0,0,236}, {0,0,0,0,0,0,237}, {0,0,0,0,0,0,238}, {0,0,0,0,0,0,239},
+  {0,0,0,0,0,0,240}, {0,0,0,0,0,0,241}, {0,0,0,0,0,0,242}, {0,0,0,0,0,0,243},
+  {0,0,0,0,0,0,244}, {0,0,0,0,0,0,245}, {0,0,0,0,0,0,246}, {0,0,0,0,0,0,247},
+  {0,0,0,0,0,0,248}, {0,0,0,0,0,0,249}, {0,0,0,0,0,0,250}, {0,0,0,0,0,0,251},
+  {0,0,0,0,0,0,252}, {0,0,0,0,0,0,253}, {0,0,0,0,0,0,254}, {0,0,0,0,0,0,255},
+  {1,0,0,0,0,0,256}, {2,0,0,0,0,3,257}, {2,0,0,0,0,4,258}, {2,0,0,0,0,5,259},
+  {2,0,0,0,0,6,260}, {2,0,0,0,0,7,261}, {2,0,0,0,0,8,262}, {2,0,0,0,0,9,263},
+  {2,0,0,0,0,10,264}, {2,0,0,1,0,11,265}, {2,0,0,1,0,13,266},
+  {2,0,0,1,0,15,267}, {2,0,0,1,0,17,268}, {2,0,0,2,0,19,269},
+  {2,0,0,2,0,23,270}, {2,0,0,2,0,27,271}, {2,0,0,2,0,31,272},
+  {2,0,0,3,0,35,273}, {2,0,0,3,0,43,274}, {2,0,0,3,0,51,275},
+  {2,0,0,3,0,59,276}, {2,0,0,4,0,67,277}, {2,0,0,4,0,83,278},
+  {2,0,0,4,0,99,279}, {2,0,0,4,0,115,280}, {2,0,0,5,0,131,281},
+  {2,0,0,5,0,163,282}, {2,0,0,5,0,195,283}, {130,0,0,5,0,227,284},
+  {2,0,0,0,0,258,285}
+};
+static
+struct tcmplxA_inscopy_row const tcmplxA_inscopy_ps_BrotliIC[704] = {
+  {3,1,0,0,0,2,0}, {3,1,0,0,0,3,1}, {3,1,0,0,0,4,2}, {3,1,0,0,0,5,3},
+  {3,1,0,0,0,6,4}, {3,1,0,0,0,7,5}, {3,1,0,0,0,8,6}, {3,1,0,0,0,9,7},
+  {3,1,0,0,1,2,8}, {3,1,0,0,1,3,9}, {3,1,0,0,1,4,10}, {3,1,0,0,1,5,11},
+  {3,1,0,0,1,6,12}, {3,1,0,0,1,7,13}, {3,1,0,0,1,8,14}, {3,1,0,0,1,9,15},
+  {3,1,0,0,2,2,16}, {3,1,0,0,2,3,17}, {3,1,0,0,2,4,18}, {3,1,0,0,2,5,19},
+  {3,1,0,0,2,6,20}, {3,1,0,0,2,7,21}, {3,1,0,0,2,8,22}, {3,1,0,0,2,9,23},
+  {3,1,0,0,3,2,24}, {3,1,0,0,3,3,25}, {3,1,0,0,3,4,26}, {3,1,0,0,3,5,27},
+  {3,1,0,0,3,6,28}, {3,1,0,0,3,7,29}, {3,1,0,0,3,8,30}, {3,1,0,0,3,9,31},
+  {3,1,0,0,4,2,32}, {3,1,0,0,4,3,33}, {3,1,0,0,4,4,34}, {3,1,0,0,4,5,35},
+  {3,1,0,0,4,6,36}, {3,1,0,0,4,7,37}, {3,1,0,0,4,8,38}, {3,1,0,0,4,9,39},
+  {3,1,0,0,5,2,40}, {3,1,0,0,5,3,41}, {3,1,0,0,5,4,42}, {3,1,0,0,5,5,43},
+  {3,1,0,0,5,6,44}, {3,1,0,0,5,7,45}, {3,1,0,0,5,8,46}, {3,1,0,0,5,9,47},
+  {3,1,1,0,6,2,48}, {3,1,1,0,6,3,49}, {3,1,1,0,6,4,50}, {3,1,1,0,6,5,51},
+  {3,1,1,0,6,6,52}, {3,1,1,0,6,7,53}, {3,1,1,0,6,8,54}, {3,1,1,0,6,9,55},
+  {3,1,1,0,8,2,56}, {3,1,1,0,8,3,57}, {3,1,1,0,8,4,58}, {3,1,1,0,8,5,59},
+  {3,1,1,0,8,6,60}, {3,1,1,0,8,7,61}, {3,1,1,0,8,8,62}, {3,1,1,0,8,9,63},
+  {3,1,0,1,0,10,64}, {3,1,0,1,0,12,65}, {3,1,0,2,0,14,66}, {3,1,0,2,0,18,67},
+  {3,1,0,3,0,22,68}, {3,1,0,3,0,30,69}, {3,1,0,4,0,38,70}, {3,1,0,4,0,54,71},
+  {3,1,0,1,1,10,72}, {3,1,0,1,1,12,73}, {3,1,0,2,1,14,74}, {3,1,0,2,1,18,75},
+  {3,1,0,3,1,22,76}, {3,1,0,3,1,30,77}, {3,1,0,4,1,38,78}, {3,1,0,4,1,54,79},
+  {3,1,0,1,2,10,80}, {3,1,0,1,2,12,81}, {3,1,0,2,2,14,82}, {3,1,0,2,2,18,83},
+  {3,1,0,3,2,22,84}, {3,1,0,3,2,30,85}, {3,1,0,4,2,38,86}, {3,1,0,4,2,54,87},
+  {3,1,0,1,3,10,88}, {3,1,0,1,3,12,89}, {3,1,0,2,3,14,90}, {3,1,0,2,3,18,91},
+  {3,1,0,3,3,22,92}, {3,1,0,3,3,30,93}, {3,1,0,4,3,38,94}, {3,1,0,4,3,54,95},
+  {3,1,0,1,4,10,96}, {3,1,0,1,4,12,97}, {3,1,0,2,4,14,98}, {3,1,0,2,4,18,99},
+  {3,1,0,3,4,22,100}, {3,1,0,3,4,30,101}, {3,1,0,4,4,38,102},
+  {3,1,0,4,4,54,103}, {3,1,0,1,5,10,104}, {3,1,0,1,5,12,105},
+  {3,1,0,2,5,14,106}, {3,1,0,2,5,18,107}, {3,1,0,3,5,22,108},
+  {3,1,0,3,5,30,109}, {3,1,0,4,5,38,110}, {3,1,0,4,5,54,111},
+  {3,1,1,1,6,10,112}, {3,1,1,1,6,12,113}, {3,1,1,2,6,14,114},
+  {3,1,1,2,6,18,115}, {3,1,1,3,6,22,116}, {3,1,1,3,6,30,117},
+  {3,1,1,4,6,38,118}, {3,1,1,4,6,54,119}, {3,1,1,1,8,10,120},
+  {3,1,1,1,8,12,121}, {3,1,1,2,8,14,122}, {3,1,1,2,8,18,123},
+  {3,1,1,3,8,22,124}, {3,1,1,3,8,30,125}, {3,1,1,4,8,38,126},
+  {3,1,1,4,8,54,127}, {3,0,0,0,0,2,128}, {3,0,0,0,0,3,129}, {3,0,0,0,0,4,130},
+  {3,0,0,0,0,5,131}, {3,0,0,0,0,6,132}, {3,0,0,0,0,7,133}, {3,0,0,0,0,8,134},
+  {3,0,0,0,0,9,135}, {3,0,0,0,1,2,136}, {3,0,0,0,1,3,137}, {3,0,0,0,1,4,138},
+  {3,0,0,0,1,5,139}, {3,0,0,0,1,6,140}, {3,0,0,0,1,7,141}, {3,0,0,0,1,8,142},
+  {3,0,0,0,1,9,143}, {3,0,0,0,2,2,144}, {3,0,0,0,2,3,145}, {3,0,0,0,2,4,146},
+  {3,0,0,0,2,5,147}, {3,0,0,0,2,6,148}, {3,0,0,0,2,7,149}, {3,0,0,0,2,8,150},
+  {3,0,0,0,2,9,151}, {3,0,0,0,3,2,152}, {3,0,0,0,3,3,153}, {3,0,0,0,3,4,154},
+  {3,0,0,0,3,5,155}, {3,0,0,0,3,6,156}, {3,0,0,0,3,7,157}, {3,0,0,0,3,8,158},
+  {3,0,0,0,3,9,159}, {3,0,0,0,4,2,160}, {3,0,0,0,4,3,161}, {3,0,0,0,4,4,162},
+  {3,0,0,0,4,5,163}, {3,0,0,0,4,6,164}, {3,0,0,0,4,7,165}, {3,0,0,0,4,8,166},
+  {3,0,0,0,4,9,167}, {3,0,0,0,5,2,168}, {3,0,0,0,5,3,169}, {3,0,0,0,5,4,170},
+  {3,0,0,0,5,5,171}, {3,0,0,0,5,6,172}, {3,0,0,0,5,7,173}, {3,0,0,0,5,8,174},
+  {3,0,0,0,5,9,175}, {3,0,1,0,6,2,176}, {3,0,1,0,6,3,177}, {3,0,1,0,6,4,178},
+  {3,0,1,0,6,5,179}, {3,0,1,0,6,6,180}, {3,0,1,0,6,7,181}, {3,0,1,0,6,8,182},
+  {3,0,1,0,6,9,183}, {3,0,1,0,8,2,184}, {3,0,1,0,8,3,185}, {3,0,1,0,8,4,186},
+  {3,0,1,0,8,5,187}, {3,0,1,0,8,6,188}, {3,0,1,0,8,7,189}, {3,0,1,0,8,8,190},
+  {3,0,1,0,8,9,191}, {3,0,0,1,0,10,192}, {3,0,0,1,0,12,193},
+  {3,0,0,2,0,14,194}, {3,0,0,2,0,18,195}, {3,0,0,3,0,22,196},
+  {3,0,0,3,0,30,197}, {3,0,0,4,0,38,198}, {3,0,0,4,0,54,199},
+  {3,0,0,1,1,10,200}, {3,0,0,1,1,12,201}, {3,0,0,2,1,14,202},
+  {3,0,0,2,1,18,203}, {3,0,0,3,1,22,204}, {3,0,0,3,1,30,205},
+  {3,0,0,4,1,38,206}, {3,0,0,4,1,54,207}, {3,0,0,1,2,10,208},
+  {3,0,0,1,2,12,209}, {3,0,0,2,2,14,210}, {3,0,0,2,2,18,211},
+  {3,0,0,3,2,22,212}, {3,0,0,3,2,30,213}, {3,0,0,4,2,38,214},
+  {3,0,0,4,2,54,215}, {3,0,0,1,3,10,216}, {3,0,0,1,3,12,217},
+  {3,0,0,2,3,14,218}, {3,0,0,2,3,18,219}, {3,0,0,3,3,22,220},
+  {3,0,0,3,3,30,221}, {3,0,0,4,3,38,222}, {3,0,0,4,3,54,223},
+  {3,0,0,1,4,10,224}, {3,0,0,1,4,12,225}, {3,0,0,2,4,14,226},
+  {3,0,0,2,4,18,227}, {3,0,0,3,4,22,228}, {3,0,0,3,4,30,229},
+  {3,0,0,4,4,38,230}, {3,0,0,4,4,54,231}, {3,0,0,1,5,10,232},
+  {3,0,0,1,5,12,233}, {3,0,0,2,5,14,234}, {3,0,0,2,5,18,235},
+  {3,0,0,3,5,22,236}, {3,0,0,3,5,30,237}, {3,0,0,4,5,38,238},
+  {3,0,0,4,5,54,239}, {3,0,1,1,6,10,240}, {3,0,1,1,6,12,241},
+  {3,0,1,2,6,14,242}, {3,0,1,2,6,18,243}, {3,0,1,3,6,22,244},
+  {3,0,1,3,6,30,245}, {3,0,1,4,6,38,246}, {3,0,1,4,6,54,247},
+  {3,0,1,1,8,10,248}, {3,0,1,1,8,12,249}, {3,0,1,2,8,14,250},
+  {3,0,1,2,8,18,251}, {3,0,1,3,8,22,252}, {3,0,1,3,8,30,253},
+  {3,0,1,4,8,38,254}, {3,0,1,4,8,54,255}, {3,0,2,0,10,2,256},
+  {3,0,2,0,10,3,257}, {3,0,2,0,10,4,258}, {3,0,2,0,10,5,259},
+  {3,0,2,0,10,6,260}, {3,0,2,0,10,7,261}, {3,0,2,0,10,8,262},
+  {3,0,2,0,10,9,263}, {3,0,2,0,14,2,264}, {3,0,2,0,14,3,265},
+  {3,0,2,0,14,4,266}, {3,0,2,0,14,5,267}, {3,0,2,0,14,6,268},
+  {3,0,2,0,14,7,269}, {3,0,2,0,14,8,270}, {3,0,2,0,14,9,271},
+  {3,0,3,0,18,2,272}, {3,0,3,0,18,3,273}, {3,0,3,0,18,4,274},
+  {3,0,3,0,18,5,275}, {3,0,3,0,18,6,276}, {3,0,3,0,18,7,277},
+  {3,0,3,0,18,8,278}, {3,0,3,0,18,9,279}, {3,0,3,0,26,2,280},
+  {3,0,3,0,26,3,281}, {3,0,3,0,26,4,282}, {3,0,3,0,26,5,283},
+  {3,0,3,0,26,6,284}, {3,0,3,0,26,7,285}, {3,0,3,0,26,8,286},
+  {3,0,3,0,26,9,287}, {3,0,4,0,34,2,288}, {3,0,4,0,34,3,289},
+  {3,0,4,0,34,4,290}, {3,0,4,0,34,5,291}, {3,0,4,0,34,6,292},
+  {3,0,4,0,34,7,293}, {3,0,4,0,34,8,294}, {3,0,4,0,34,9,295},
+  {3,0,4,0,50,2,296}, {3,0,4,0,50,3,297}, {3,0,4,0,50,4,298},
+  {3,0,4,0,50,5,299}, {3,0,4,0,50,6,300}, {3,0,4,0,50,7,301},
+  {3,0,4,0,50,8,302}, {3,0,4,0,50,9,303}, {3,0,5,0,66,2,304},
+  {3,0,5,0,66,3,305}, {3,0,5,0,66,4,306}, {3,0,5,0,66,5,307},
+  {3,0,5,0,66,6,308}, {3,0,5,0,66,7,309}, {3,0,5,0,66,8,310},
+  {3,0,5,0,66,9,311}, {3,0,5,0,98,2,312}, {3,0,5,0,98,3,313},
+  {3,0,5,0,98,4,314}, {3,0,5,0,98,5,315}, {3,0,5,0,98,6,316},
+  {3,0,5,0,98,7,317}, {3,0,5,0,98,8,318}, {3,0,5,0,98,9,319},
+  {3,0,2,1,10,10,320}, {3,0,2,1,10,12,321}, {3,0,2,2,10,14,322},
+  {3,0,2,2,10,18,323}, {3,0,2,3,10,22,324}, {3,0,2,3,10,30,325},
+  {3,0,2,4,10,38,326}, {3,0,2,4,10,54,327}, {3,0,2,1,14,10,328},
+  {3,0,2,1,14,12,329}, {3,0,2,2,14,14,330}, {3,0,2,2,14,18,331},
+  {3,0,2,3,14,22,332}, {3,0,2,3,14,30,333}, {3,0,2,4,14,38,334},
+  {3,0,2,4,14,54,335}, {3,0,3,1,18,10,336}, {3,0,3,1,18,12,337},
+  {3,0,3,2,18,14,338}, {3,0,3,2,18,18,339}, {3,0,3,3,18,22,340},
+  {3,0,3,3,18,30,341}, {3,0,3,4,18,38,342}, {3,0,3,4,18,54,343},
+  {3,0,3,1,26,10,344}, {3,0,3,1,26,12,345}, {3,0,3,2,26,14,346},
+  {3,0,3,2,26,18,347}, {3,0,3,3,26,22,348}, {3,0,3,3,26,30,349},
+  {3,0,3,4,26,38,350}, {3,0,3,4,26,54,351}, {3,0,4,1,34,10,352},
+  {3,0,4,1,34,12,353}, {3,0,4,2,34,14,354}, {3,0,4,2,34,18,355},
+  {3,0,4,3,34,22,356}, {3,0,4,3,34,30,357}, {3,0,4,4,34,38,358},
+  {3,0,4,4,34,54,359}, {3,0,4,1,50,10,360}, {3,0,4,1,50,12,361},
+  {3,0,4,2,50,14,362}, {3,0,4,2,50,18,363}, {3,0,4,3,50,22,364},
+  {3,0,4,3,50,30,365}, {3,0,4,4,50,38,366}, {3,0,4,4,50,54,367},
+  {3,0,5,1,66,10,368}, {3,0,5,1,66,12,369}, {3,0,5,2,66,14,370},
+  {3,0,5,2,66,18,371}, {3,0,5,3,66,22,372}, {3,0,5,3,66,30,373},
+  {3,0,5,4,66,38,374}, {3,0,5,4,66,54,375}, {3,0,5,1,98,10,376},
+  {3,0,5,1,98,12,377}, {3,0,5,2,98,14,378}, {3,0,5,2,98,18,379},
+  {3,0,5,3,98,22,380}, {3,0,5,3,98,30,381}, {3,0,5,4,98,38,382},
+  {3,0,5,4,98,54,383}, {3,0,0,5,0,70,384}, {3,0,0,5,0,102,385},
+  {3,0,0,6,0,134,386}, {3,0,0,7,0,198,387}, {3,0,0,8,0,326,388},
+  {3,0,0,9,0,582,389}, {3,0,0,10,0,1094,390}, {3,0,0,24,0,2118,391},
+  {3,0,0,5,1,70,392}, {3,0,0,5,1,102,393}, {3,0,0,6,1,134,394},
+  {3,0,0,7,1,198,395}, {3,0,0,8,1,326,396}, {3,0,0,9,1,582,397},
+  {3,0,0,10,1,1094,398}, {3,0,0,24,1,2118,399}, {3,0,0,5,2,70,400},
+  {3,0,0,5,2,102,401}, {3,0,0,6,2,134,402}, {3,0,0,7,2,198,403},
+  {3,0,0,8,2,326,404}, {3,0,0,9,2,582,405}, {3,0,0,10,2,1094,406},
+  {3,0,0,24,2,2118,407}, {3,0,0,5,3,70,408}, {3,0,0,5,3,102,409},
+  {3,0,0,6,3,134,410}, {3,0,0,7,3,198,411}, {3,0,0,8,3,326,412},
+  {3,0,0,9,3,582,413}, {3,0,0,10,3,1094,414}, {3,0,0,24,3,2118,415},
+  {3,0,0,5,4,70,416}, {3,0,0,5,4,102,417}, {3,0,0,6,4,134,418},
+  {3,0,0,7,4,198,419}, {3,0,0,8,4,326,420}, {3,0,0,9,4,582,421},
+  {3,0,0,10,4,1094,422}, {3,0,0,24,4,2118,423}, {3,0,0,5,5,70,424},
+  {3,0,0,5,5,102,425}, {3,0,0,6,5,134,426}, {3,0,0,7,5,198,427},
+  {3,0,0,8,5,326,428}, {3,0,0,9,5,582,429}, {3,0,0,10,5,1094,430},
+  {3,0,0,24,5,2118,431}, {3,0,1,5,6,70,432}, {3,0,1,5,6,102,433},
+  {3,0,1,6,6,134,434}, {3,0,1,7,6,198,435}, {3,0,1,8,6,326,436},
+  {3,0,1,9,6,582,437}, {3,0,1,10,6,1094,438}, {3,0,1,24,6,2118,439},
+  {3,0,1,5,8,70,440}, {3,0,1,5,8,102,441}, {3,0,1,6,8,134,442},
+  {3,0,1,7,8,198,443}, {3,0,1,8,8,326,444}, {3,0,1,9,8,582,445},
+  {3,0,1,10,8,1094,446}, {3,0,1,24,8,2118,447}, {3,0,6,0,130,2,448},
+  {3,0,6,0,130,3,449}, {3,0,6,0,130,4,450}, {3,0,6,0,130,5,451},
+  {3,0,6,0,130,6,452}, {3,0,6,0,130,7,453}, {3,0,6,0,130,8,454},
+  {3,0,6,0,130,9,455}, {3,0,7,0,194,2,456}, {3,0,7,0,194,3,457},
+  {3,0,7,0,194,4,458}, {3,0,7,0,194,5,459}, {3,0,7,0,194,6,460},
+  {3,0,7,0,194,7,461}, {3,0,7,0,194,8,462}, {3,0,7,0,194,9,463},
+  {3,0,8,0,322,2,464}, {3,0,8,0,322,3,465}, {3,0,8,0,322,4,466},
+  {3,0,8,0,322,5,467}, {3,0,8,0,322,6,468}, {3,0,8,0,322,7,469},
+  {3,0,8,0,322,8,470}, {3,0,8,0,322,9,471}, {3,0,9,0,578,2,472},
+  {3,0,9,0,578,3,473}, {3,0,9,0,578,4,474}, {3,0,9,0,578,5,475},
+  {3,0,9,0,578,6,476}, {3,0,9,0,578,7,477}, {3,0,9,0,578,8,478},
+  {3,0,9,0,578,9,479}, {3,0,10,0,1090,2,480}, {3,0,10,0,1090,3,481},
+  {3,0,10,0,1090,4,482}, {3,0,10,0,1090,5,483}, {3,0,10,0,1090,6,484},
+  {3,0,10,0,1090,7,485}, {3,0,10,0,1090,8,486}, {3,0,10,0,1090,9,487},
+  {3,0,12,0,2114,2,488}, {3,0,12,0,2114,3,489}, {3,0,12,0,2114,4,490},
+  {3,0,12,0,2114,5,491}, {3,0,12,0,2114,6,492}, {3,0,12,0,2114,7,493},
+  {3,0,12,0,2114,8,494}, {3,0,12,0,2114,9,495}, {3,0,14,0,6210,2,496},
+  {3,0,14,0,6210,3,497}, {3,0,14,0,6210,4,498}, {3,0,14,0,6210,5,499},
+  {3,0,14,0,6210,6,500}, {3,0,14,0,6210,7,501}, {3,0,14,0,6210,8,502},
+  {3,0,14,0,6210,9,503}, {3,0,24,0,22594,2,504}, {3,0,24,0,22594,3,505},
+  {3,0,24,0,22594,4,506}, {3,0,24,0,22594,5,507}, {3,0,24,0,22594,6,508},
+  {3,0,24,0,22594,7,509}, {3,0,24,0,22594,8,510}, {3,0,24,0,22594,9,511},
+  {3,0,2,5,10,70,512}, {3,0,2,5,10,102,513}, {3,0,2,6,10,134,514},
+  {3,0,2,7,10,198,515}, {3,0,2,8,10,326,516}, {3,0,2,9,10,582,517},
+  {3,0,2,10,10,1094,518}, {3,0,2,24,10,2118,519}, {3,0,2,5,14,70,520},
+  {3,0,2,5,14,102,521}, {3,0,2,6,14,134,522}, {3,0,2,7,14,198,523},
+  {3,0,2,8,14,326,524}, {3,0,2,9,14,582,525}, {3,0,2,10,14,1094,526},
+  {3,0,2,24,14,2118,527}, {3,0,3,5,18,70,528}, {3,0,3,5,18,102,529},
+  {3,0,3,6,18,134,530}, {3,0,3,7,18,198,531}, {3,0,3,8,18,326,532},
+  {3,0,3,9,18,582,533}, {3,0,3,10,18,1094,534}, {3,0,3,24,18,2118,535},
+  {3,0,3,5,26,70,536}, {3,0,3,5,26,102,537}, {3,0,3,6,26,134,538},
+  {3,0,3,7,26,198,539}, {3,0,3,8,26,326,540}, {3,0,3,9,26,582,541},
+  {3,0,3,10,26,1094,542}, {3,0,3,24,26,2118,543}, {3,0,4,5,34,70,544},
+  {3,0,4,5,34,102,545}, {3,0,4,6,34,134,546}, {3,0,4,7,34,198,547},
+  {3,0,4,8,34,326,548}, {3,0,4,9,34,582,549}, {3,0,4,10,34,1094,550},
+  {3,0,4,24,34,2118,551}, {3,0,4,5,50,70,552}, {3,0,4,5,50,102,553},
+  {3,0,4,6,50,134,554}, {3,0,4,7,50,198,555}, {3,0,4,8,50,326,556},
+  {3,0,4,9,50,582,557}, {3,0,4,10,50,1094,558}, {3,0,4,24,50,2118,559},
+  {3,0,5,5,66,70,560}, {3,0,5,5,66,102,561}, {3,0,5,6,66,134,562},
+  {3,0,5,7,66,198,563}, {3,0,5,8,66,326,564}, {3,0,5,9,66,582,565},
+  {3,0,5,10,66,1094,566}, {3,0,5,24,66,2118,567}, {3,0,5,5,98,70,568},
+  {3,0,5,5,98,102,569}, {3,0,5,6,98,134,570}, {3,0,5,7,98,198,571},
+  {3,0,5,8,98,326,572}, {3,0,5,9,98,582,573}, {3,0,5,10,98,1094,574},
+  {3,0,5,24,98,2118,575}, {3,0,6,1,130,10,576}, {3,0,6,1,130,12,577},
+  {3,0,6,2,130,14,578}, {3,0,6,2,130,18,579}, {3,0,6,3,130,22,580},
+  {3,0,6,3,130,30,581}, {3,0,6,4,130,38,582}, {3,0,6,4,130,54,583},
+  {3,0,7,1,194,10,584}, {3,0,7,1,194,12,585}, {3,0,7,2,194,14,586},
+  {3,0,7,2,194,18,587}, {3,0,7,3,194,22,588}, {3,0,7,3,194,30,589},
+  {3,0,7,4,194,38,590}, {3,0,7,4,194,54,591}, {3,0,8,1,322,10,592},
+  {3,0,8,1,322,12,593}, {3,0,8,2,322,14,594}, {3,0,8,2,322,18,595},
+  {3,0,8,3,322,22,596}, {3,0,8,3,322,30,597}, {3,0,8,4,322,38,598},
+  {3,0,8,4,322,54,599}, {3,0,9,1,578,10,600}, {3,0,9,1,578,12,601},
+  {3,0,9,2,578,14,602}, {3,0,9,2,578,18,603}, {3,0,9,3,578,22,604},
+  {3,0,9,3,578,30,605}, {3,0,9,4,578,38,606}, {3,0,9,4,578,54,607},
+  {3,0,10,1,1090,10,608}, {3,0,10,1,1090,12,609}, {3,0,10,2,1090,14,610},
+  {3,0,10,2,1090,18,611}, {3,0,10,3,1090,22,612}, {3,0,10,3,1090,30,613},
+  {3,0,10,4,1090,38,614}, {3,0,10,4,1090,54,615}, {3,0,12,1,2114,10,616},
+  {3,0,12,1,2114,12,617}, {3,0,12,2,2114,14,618}, {3,0,12,2,2114,18,619},
+  {3,0,12,3,2114,22,620}, {3,0,12,3,2114,30,621}, {3,0,12,4,2114,38,622},
+  {3,0,12,4,2114,54,623}, {3,0,14,1,6210,10,624}, {3,0,14,1,6210,12,625},
+  {3,0,14,2,6210,14,626}, {3,0,14,2,6210,18,627}, {3,0,14,3,6210,22,628},
+  {3,0,14,3,6210,30,629}, {3,0,14,4,6210,38,630}, {3,0,14,4,6210,54,631},
+  {3,0,24,1,22594,10,632}, {3,0,24,1,22594,12,633}, {3,0,24,2,22594,14,634},
+  {3,0,24,2,22594,18,635}, {3,0,24,3,22594,22,636}, {3,0,24,3,22594,30,637},
+  {3,0,24,4,22594,38,638}, {3,0,24,4,22594,54,639}, {3,0,6,5,130,70,640},
+  {3,0,6,5,130,102,641}, {3,0,6,6,130,134,642}, {3,0,6,7,130,198,643},
+  {3,0,6,8,130,326,644}, {3,0,6,9,130,582,645}, {3,0,6,10,130,1094,646},
+  {3,0,6,24,130,2118,647}, {3,0,7,5,194,70,648}, {3,0,7,5,194,102,649},
+  {3,0,7,6,194,134,650}, {3,0,7,7,194,198,651}, {3,0,7,8,194,326,652},
+  {3,0,7,9,194,582,653}, {3,0,7,10,194,1094,654}, {3,0,7,24,194,2118,655},
+  {3,0,8,5,322,70,656}, {3,0,8,5,322,102,657}, {3,0,8,6,322,134,658},
+  {3,0,8,7,322,198,659}, {3,0,8,8,322,326,660}, {3,0,8,9,322,582,661},
+  {3,0,8,10,322,1094,662}, {3,0,8,24,322,2118,663}, {3,0,9,5,578,70,664},
+  {3,0,9,5,578,102,665}, {3,0,9,6,578,134,666}, {3,0,9,7,578,198,667},
+  {3,0,9,8,578,326,668}, {3,0,9,9,578,582,669}, {3,0,9,10,578,1094,670},
+  {3,0,9,24,578,2118,671}, {3,0,10,5,1090,70,672}, {3,0,10,5,1090,102,673},
+  {3,0,10,6,1090,134,674}, {3,0,10,7,1090,198,675}, {3,0,10,8,1090,326,676},
+  {3,0,10,9,1090,582,677}, {3,0,10,10,1090,1094,678},
+  {3,0,10,24,1090,2118,679}, {3,0,12,5,2114,70,680}, {3,0,12,5,2114,102,681},
+  {3,0,12,6,2114,134,682}, {3,0,12,7,2114,198,683}, {3,0,12,8,2114,326,684},
+  {3,0,12,9,2114,582,685}, {3,0,12,10,2114,1094,686},
+  {3,0,12,24,2114,2118,687}, {3,0,14,5,6210,70,688}, {3,0,14,5,6210,102,689},
+  {3,0,14,6,6210,134,690}, {3,0,14,7,6210,198,691}, {3,0,14,8,6210,326,692},
+  {3,0,14,9,6210,582,693}, {3,0,14,10,6210,1094,694},
+  {3,0,14,24,6210,2118,695}, {3,0,24,5,22594,70,696},
+  {3,0,24,5,22594,102,697}, {3,0,24,6,22594,134,698},
+  {3,0,24,7,22594,198,699}, {3,0,24,8,22594,326,700},
+  {3,0,24,9,22594,582,701}, {3,0,24,10,22594,1094,702},
+  {3,0,24,24,22594,2118,703}
+};
+static
+struct tcmplxA_inscopy_row const tcmplxA_inscopy_ps_BrotliBlock[26] = {
+  {4,0,2,0,1,0,0}, {4,0,2,0,5,0,1}, {4,0,2,0,9,0,2}, {4,0,2,0,13,0,3},
+  {4,0,3,0,17,0,4}, {4,0,3,0,25,0,5}, {4,0,3,0,33,0,6}, {4,0,3,0,41,0,7},
+  {4,0,4,0,49,0,8}, {4,0,4,0,65,0,9}, {4,0,4,0,81,0,10}, {4,0,4,0,97,0,11},
+  {4,0,5,0,113,0,12}, {4,0,5,0,145,0,13}, {4,0,5,0,177,0,14},
+  {4,0,5,0,209,0,15}, {4,0,6,0,241,0,16}, {4,0,6,0,305,0,17},
+  {4,0,7,0,369,0,18}, {4,0,8,0,497,0,19}, {4,0,9,0,753,0,20},
+  {4,0,10,0,1265,0,21}, {4,0,11,0,2289,0,22}, {4,0,12,0,4337,0,23},
+  {4,0,13,0,8433,0,24}, {4,0,24,0,16625,0,25}
+};
+
+/* read-only tables shared by all users of the presets */
+static
+struct tcmplxA_inscopy const tcmplxA_inscopy_ps[] = {
+  { (struct tcmplxA_inscopy_row*)tcmplxA_inscopy_ps_Deflate, 286u, NULL },
+  { (struct tcmplxA_inscopy_row*)tcmplxA_inscopy_ps_BrotliIC, 704u, NULL },
+  { (struct tcmplxA_inscopy_row*)tcmplxA_inscopy_ps_BrotliBlock, 26u, NULL }
+};
+
+static
+struct tcmplxA_inscopy_tab const tcmplxA_inscopy_7932_inserts[24] = {
+  {0,  0}, {0,  1}, {0,   2}, {0,   3}, {0,   4}, {0,    5},
+  {1,  6}, {1,  8}, {2,  10}, {2,  14}, {3,  18}, {3,   26},
+  {4, 34}, {4, 50}, {5,  66}, {5,  98}, {6, 130}, {7,  194},
+  {8,322}, {9,578},{10,1090},{12,2114},{14,6210},{24,22594}
+};
+
+static
+struct tcmplxA_inscopy_tab const tcmplxA_inscopy_7932_copies[24] = {
+  {0,  2}, {0,  3}, {0,   4}, {0,   5}, {0,   6}, {0,    7},
+  {0,  8}, {0,  9}, {1,  10}, {1,  12}, {2,  14}, {2,   18},
+  {3, 22}, {3, 30}, {4,  38}, {4,  54}, {5,  70}, {5,  102},
+  {6,134}, {7,198}, {8, 326}, {9, 582},{10,1094},{24, 2118}
+};
+
+static
+struct tcmplxA_inscopy_tab const tcmplxA_inscopy_7932B_counts[26] = {
+  {2,   1}, {2,   5}, {2,   9}, {2,  13}, {3,  17}, {3,  25},
+  {3,  33}, {3,  41}, {4,  49}, {4,  65}, {4,  81}, {4,  97},
+  {5, 113}, {5, 145}, {5, 177}, {5, 209}, {6, 241}, {6, 305},
+  {7, 369}, {8, 497}, {9, 753},{10,1265},{11,2289},{12,4337},
+  {13,8433},{24,16625}
+};
+
+/* insert length classes by length, up to 129 */
+static
+unsigned char const tcmplxA_inscopy_7932_insert_small[130] = {
+   0,  1,  2,  3,  4,  5,  6,  6,  7,  7,  8,  8,  8,  8,  9,  9,
+   9,  9, 10, 10, 10, 10, 10, 10, 10, 10, 11, 11, 11, 11, 11, 11,
+  11, 11, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+  12, 12, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+  13, 13, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+  14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+  14, 14, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+  15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+  15, 15
+};
+
+/* copy length classes by length, up to 133 */
+static
+unsigned char const tcmplxA_inscopy_7932_copy_small[134] = {
+   0,  0,
+   0,  1,  2,  3,  4,  5,  6,  7,  8,  8,  9,  9, 10, 10, 10, 10,
+  11, 11, 11, 11, 12, 12, 12, 12, 12, 12, 12, 12, 13, 13, 13, 13,
+  13, 13, 13, 13, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+  14, 14, 14, 14, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+  15, 15, 15, 15, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+  16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+  16, 16, 16, 16, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+  17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+  17, 17, 17, 17
+};
+
+/* first candidate length class by length bit width */
+static
+unsigned char const tcmplxA_inscopy_7932_insert_wide[26] = {
+   0,  1,  2,  4,  7,  9, 11, 13, 15, 17, 18, 19, 20,
+  21, 22, 22, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23
+};
+
+static
+unsigned char const tcmplxA_inscopy_7932_copy_wide[26] = {
+   0,  0,  0,  2,  6, 10, 13, 15, 17, 19, 20, 21, 22,
+  23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23
+};
+
+static
+unsigned char const tcmplxA_inscopy_7932B_wide[26] = {
+   0,  0,  0,  0,  1,  3,  5,  8, 12, 16, 19, 20, 21,
+  22, 23, 24, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25
+};
 
+/* Brotli command cells by insert class and copy class, each over 8 */
+static
+unsigned char const tcmplxA_inscopy_7932_cells[3][3] = {
+  {2, 3, 6}, {4, 5, 8}, {7, 9, 10}
+};
 
+/* DEFLATE length codes less 257, by copy length less 3 */
 static
-struct { void (*f)(struct tcmplxA_inscopy_row*); size_t n; }
-const tcmplxA_inscopy_ps[] = {
-  { tcmplxA_inscopy_1951_fill, 286u },
-  { tcmplxA_inscopy_7932_fill, 704u },
-  { tcmplxA_inscopy_7932B_fill, 26u }
+unsigned char const tcmplxA_inscopy_1951_lengths[256] = {
+   0,  1,  2,  3,  4,  5,  6,  7,  8,  8,  9,  9, 10, 10, 11, 11,
+  12, 12, 12, 12, 13, 13, 13, 13, 14, 14, 14, 14, 15, 15, 15, 15,
+  16, 16, 16, 16, 16, 16, 16, 16, 17, 17, 17, 17, 17, 17, 17, 17,
+  18, 18, 18, 18, 18, 18, 18, 18, 19, 19, 19, 19, 19, 19, 19, 19,
+  20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20,
+  21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21,
+  22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22,
+  23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23,
+  24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24,
+  24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24,
+  25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25,
+  25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25,
+  26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26,
+  26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26,
+  27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27,
+  27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 28
 };
 
 
 
 /* BEGIN insert copy table / static */
-int tcmplxA_inscopy_init(struct tcmplxA_inscopy* x, size_t n) {
+int tcmplxA_inscopy_init
+  (struct tcmplxA_inscopy* x, size_t n, struct tcmplxA_allocator const* alloc)
+{
+  x->alloc = alloc;
   x->p = NULL;
   x->n = 0u;
   return tcmplxA_inscopy_resize(x,n);
@@ -107,7 +557,7 @@ int tcmplxA_inscopy_resize(struct tcmplxA_inscopy* x, size_t sz) {
   struct tcmplxA_inscopy_row *ptr;
   if (sz == 0u) {
     if (x->p != NULL) {
-      tcmplxA_util_free(x->p);
+      tcmplxA_util_deallocate(x->alloc, x->p);
     }
     x->p = NULL;
     x->n = 0u;
@@ -115,13 +565,13 @@ int tcmplxA_inscopy_resize(struct tcmplxA_inscopy* x, size_t sz) {
   } else if (sz >= UINT_MAX/sizeof(struct tcmplxA_inscopy_row)) {
     return tcmplxA_ErrMemory;
   }
-  ptr = (struct tcmplxA_inscopy_row*)tcmplxA_util_malloc
-          (sizeof(struct tcmplxA_inscopy_row)*sz);
+  ptr = (struct tcmplxA_inscopy_row*)tcmplxA_util_allocate
+          (x->alloc, sizeof(struct tcmplxA_inscopy_row)*sz);
   if (ptr == NULL) {
     return tcmplxA_ErrMemory;
   }
   if (x->p != NULL) {
-    tcmplxA_util_free(x->p);
+    tcmplxA_util_deallocate(x->alloc, x->p);
   }
   x->p = ptr;
   x->n = sz;
@@ -129,149 +579,12 @@ int tcmplxA_inscopy_resize(struct tcmplxA_inscopy* x, size_t sz) {
 }
 
 void tcmplxA_inscopy_close(struct tcmplxA_inscopy* x) {
-  tcmplxA_util_free(x->p);
+  tcmplxA_util_deallocate(x->alloc, x->p);
   x->p = NULL;
   x->n = 0u;
   return;
 }
 
-void tcmplxA_inscopy_1951_fill(struct tcmplxA_inscopy_row* r) {
-  size_t i;
-  unsigned short first_copy = 3u;
-  unsigned short bits = 0u;
-  /* put literals */for (i = 0u; i < 256u; ++i) {
-    r[i].code = (unsigned short)i;
-    r[i].type = tcmplxA_InsCopy_Literal;
-    r[i].zero_distance_tf = 0;
-    r[i].copy_bits = 0;
-    r[i].insert_bits = 0;
-    r[i].copy_first = 0;
-    r[i].insert_first = 0;
-  }
-  /* put stop code */{ /* i=256; */
-    r[i].code = (unsigned short)i;
-    r[i].type = tcmplxA_InsCopy_Stop;
-    r[i].zero_distance_tf = 0;
-    r[i].copy_bits = 0;
-    r[i].insert_bits = 0;
-    r[i].copy_first = 0;
-    r[i].insert_first = 0;
-    ++i;
-  }
-  /* put some zero-bit insert codes */for (; i < 261u; ++i) {
-    r[i].code = (unsigned short)i;
-    r[i].type = tcmplxA_InsCopy_Copy;
-    r[i].zero_distance_tf = 0;
-    r[i].copy_bits = 0;
-    r[i].insert_bits = 0;
-    r[i].copy_first = first_copy;
-    r[i].insert_first = 0;
-    first_copy += 1u;
-  }
-  /* put most of the other insert codes */for (; i < 285u; ++i) {
-    r[i].code = (unsigned short)i;
-    r[i].type = tcmplxA_InsCopy_Copy;
-    r[i].zero_distance_tf = 0;
-    r[i].copy_bits = bits;
-    r[i].insert_bits = 0;
-    r[i].copy_first = first_copy;
-    r[i].insert_first = 0;
-    first_copy += (1u<<bits);
-    if ((i%4) == 0) {
-      bits += 1u;
-    }
-  }
-  /* adjust 284 */{
-    r[284].type = tcmplxA_InsCopy_CopyMinus1;
-    first_copy -= 1u;
-  }
-  /* put code 285 */{ /* i=285; */
-    r[i].code = (unsigned short)i;
-    r[i].type = tcmplxA_InsCopy_Copy;
-    r[i].zero_distance_tf = 0;
-    r[i].copy_bits = 0;
-    r[i].insert_bits = 0;
-    r[i].copy_first = first_copy;
-    r[i].insert_first = 0;
-    /* ++i; */
-  }
-  return;
-}
-
-void tcmplxA_inscopy_7932B_fill(struct tcmplxA_inscopy_row* r) {
-  size_t i;
-  unsigned short first = 1u;
-  static unsigned char const bits[26] = {
-      2,2,2,2, 3,3,3,3, 4,4,4,4, 5,5,5,5, 6,6, 7, 8, 9, 10, 11, 12, 13, 24
-    };
-  for (i = 0u; i < 26u; ++i) {
-    r[i].code = (unsigned short)i;
-    r[i].type = tcmplxA_InsCopy_BlockCount;
-    r[i].zero_distance_tf = 0;
-    r[i].insert_bits = bits[i];
-    r[i].copy_bits = 0;
-    r[i].insert_first = first;
-    r[i].copy_first = 0;
-    first = (unsigned short)(first + (1u << bits[i]));
-  }
-  return;
-}
-
-void tcmplxA_inscopy_7932_fill(struct tcmplxA_inscopy_row* r) {
-  size_t i;
-  struct tab {
-    unsigned char bits;
-    unsigned short first;
-  };
-  static struct {
-    unsigned char zero_dist_tf : 1;
-    unsigned short insert_start : 5;
-    unsigned short copy_start : 5;
-  } const lookup_matrix[11] = {
-    {1, 0, 0}, {1, 0, 8},
-    {0, 0, 0}, {0, 0, 8}, /*      */
-    {0, 8, 0}, {0, 8, 8}, /*      */
-    /*      */ /*      */ /*      */
-
-    /*      */ /*      */ {0, 0,16},
-    /*      */ /*      */ /*      */
-    {0,16, 0}, /*      */ /*      */
-
-    /*      */ /*      */ /*      */
-    /*      */ /*      */ {0, 8,16},
-    /*      */ {0,16, 8}, {0,16,16}
-  };
-  static struct tab const insert_tabs[24] = {
-    {0,  0}, {0,  1}, {0,   2}, {0,   3}, {0,   4}, {0,    5},
-    {1,  6}, {1,  8}, {2,  10}, {2,  14}, {3,  18}, {3,   26},
-    {4, 34}, {4, 50}, {5,  66}, {5,  98}, {6, 130}, {7,  194},
-    {8,322}, {9,578},{10,1090},{12,2114},{14,6210},{24,22594}
-  };
-  static struct tab const copy_tabs[24] = {
-    {0,  2}, {0,  3}, {0,   4}, {0,   5}, {0,   6}, {0,    7},
-    {0,  8}, {0,  9}, {1,  10}, {1,  12}, {2,  14}, {2,   18},
-    {3, 22}, {3, 30}, {4,  38}, {4,  54}, {5,  70}, {5,  102},
-    {6,134}, {7,198}, {8, 326}, {9, 582},{10,1094},{24, 2118}
-  };
-  for (i = 0u; i < 704u; ++i) {
-    /* decouple insert code from copy code */
-    size_t const j = i/64u;
-    unsigned int const insert_code =
-      lookup_matrix[j].insert_start + ((i>>3)&7);
-    unsigned int const copy_code =
-      lookup_matrix[j].copy_start + (i&7);
-    /* fill table row */
-    r[i].code = (unsigned short)(i);
-    r[i].type = tcmplxA_InsCopy_InsertCopy;
-    r[i].zero_distance_tf = lookup_matrix[j].zero_dist_tf;
-    r[i].insert_bits = insert_tabs[insert_code].bits;
-    r[i].insert_first = insert_tabs[insert_code].first;
-    r[i].copy_bits = copy_tabs[copy_code].bits;
-    r[i].copy_first = copy_tabs[copy_code].first;
-  }
-  return;
-}
-
 int tcmplxA_inscopy_code_cmp(void const* a, void const* b) {
   struct tcmplxA_inscopy_row const*const a_row =
     (struct tcmplxA_inscopy_row const*)a;
@@ -346,16 +659,68 @@ int tcmplxA_inscopy_encode_cmp(void const* k, void const* icr) {
     }
   }
 }
+
+unsigned int tcmplxA_inscopy_class
+  ( struct tcmplxA_inscopy_tab const* t, unsigned int n,
+    unsigned char const* wide, unsigned long int x)
+{
+  unsigned int k = wide[tcmplxA_util_bitwidth((unsigned int)x)];
+  /* at most a few classes share a bit width */
+  while (k+1u < n && x >= t[k+1u].first)
+    k += 1u;
+  return k;
+}
+
+size_t tcmplxA_inscopy_7932_code
+  (unsigned long int i, unsigned long int c, int z_tf)
+{
+  unsigned int insert_class, copy_class, cell;
+  if (i >= 22594ul+(1ul<<24) || c < 2u || c >= 2118ul+(1ul<<24))
+    return ~(size_t)0u;
+  insert_class = (i < 130u)
+    ? tcmplxA_inscopy_7932_insert_small[i]
+    : tcmplxA_inscopy_class(tcmplxA_inscopy_7932_inserts, 24u,
+        tcmplxA_inscopy_7932_insert_wide, i);
+  copy_class = (c < 134u)
+    ? tcmplxA_inscopy_7932_copy_small[c]
+    : tcmplxA_inscopy_class(tcmplxA_inscopy_7932_copies, 24u,
+        tcmplxA_inscopy_7932_copy_wide, c);
+  if (z_tf) {
+    if (insert_class >= 8u || copy_class >= 16u)
+      return ~(size_t)0u;
+    cell = copy_class>>3;
+  } else cell = tcmplxA_inscopy_7932_cells[insert_class>>3][copy_class>>3];
+  return cell*64u + (insert_class&7u)*8u + (copy_class&7u);
+}
+
+size_t tcmplxA_inscopy_7932B_code(unsigned long int i) {
+  if (i < 1u || i >= 16625ul+(1ul<<24))
+    return ~(size_t)0u;
+  return tcmplxA_inscopy_class(tcmplxA_inscopy_7932B_counts, 26u,
+      tcmplxA_inscopy_7932B_wide, i);
+}
+
+size_t tcmplxA_inscopy_1951_code(unsigned long int c) {
+  if (c < 3u || c > 258u)
+    return ~(size_t)0u;
+  return 257u + tcmplxA_inscopy_1951_lengths[c-3u];
+}
 /* END   insert copy table / static */
 
 /* BEGIN insert copy table / public */
 struct tcmplxA_inscopy* tcmplxA_inscopy_new(size_t n) {
+  return tcmplxA_inscopy_new_alloc(n, NULL);
+}
+
+struct tcmplxA_inscopy* tcmplxA_inscopy_new_alloc
+  (size_t n, struct tcmplxA_allocator const* alloc)
+{
   struct tcmplxA_inscopy* out;
-  out = tcmplxA_util_malloc(sizeof(struct tcmplxA_inscopy));
+  out = tcmplxA_util_allocate(alloc, sizeof(struct tcmplxA_inscopy));
   if (out != NULL
-  &&  tcmplxA_inscopy_init(out, n) != tcmplxA_Success)
+  &&  tcmplxA_inscopy_init(out, n, alloc) != tcmplxA_Success)
   {
-    tcmplxA_util_free(out);
+    tcmplxA_util_deallocate(alloc, out);
     return NULL;
   }
   return out;
@@ -363,8 +728,9 @@ struct tcmplxA_inscopy* tcmplxA_inscopy_new(size_t n) {
 
 void tcmplxA_inscopy_destroy(struct tcmplxA_inscopy* x) {
   if (x != NULL) {
+    struct tcmplxA_allocator const* const alloc = x->alloc;
     tcmplxA_inscopy_close(x);
-    tcmplxA_util_free(x);
+    tcmplxA_util_deallocate(alloc, x);
   }
   return;
 }
@@ -408,16 +774,14 @@ int tcmplxA_inscopy_preset(struct tcmplxA_inscopy* dst, int t) {
   size_t const n = sizeof(tcmplxA_inscopy_ps)/sizeof(tcmplxA_inscopy_ps[0]);
   if (t < 0 || ((size_t)t) >= n)
     return tcmplxA_ErrParam;
-  /* resize */{
-    size_t const sz = tcmplxA_inscopy_ps[t].n;
-    int const res =
-      tcmplxA_inscopy_resize(dst, sz);
-    if (res != tcmplxA_Success) {
-      return res;
-    }
-    (*tcmplxA_inscopy_ps[t].f)(dst->p);
-  }
-  return tcmplxA_Success;
+  return tcmplxA_inscopy_copy(dst, &tcmplxA_inscopy_ps[t]);
+}
+
+struct tcmplxA_inscopy const* tcmplxA_inscopy_preset_c(int t) {
+  size_t const n = sizeof(tcmplxA_inscopy_ps)/sizeof(tcmplxA_inscopy_ps[0]);
+  if (t < 0 || ((size_t)t) >= n)
+    return NULL;
+  else return &tcmplxA_inscopy_ps[t];
 }
 
 int tcmplxA_inscopy_codesort(struct tcmplxA_inscopy* ict) {
@@ -453,7 +817,32 @@ size_t tcmplxA_inscopy_encode
       /*copy_first=*/ c>USHRT_MAX ? USHRT_MAX : (unsigned short int)c,
       /*code=*/ ~(unsigned short int)0u
     };
-  struct tcmplxA_inscopy_row const* out = bsearch
+  struct tcmplxA_inscopy_row const* out;
+  /* compute the code directly for preset alphabets */{
+    size_t code;
+    switch (ict->n) {
+    case 704u:
+      code = tcmplxA_inscopy_7932_code(i, c, z_tf);
+      break;
+    case 286u:
+      code = (i == 0u && !z_tf)
+        ? tcmplxA_inscopy_1951_code(c) : ~(size_t)0u;
+      break;
+    case 26u:
+      code = (c == 0u && !z_tf)
+        ? tcmplxA_inscopy_7932B_code(i) : ~(size_t)0u;
+      break;
+    default:
+      code = ict->n;
+      break;
+    }
+    if (code == ~(size_t)0u)
+      return code;
+    else if (code < ict->n && ict->p[code].code == code)
+      return code;
+    /* else the table is out of code order, so search it */
+  }
+  out = bsearch
       (&key, ict->p, ict->n, sizeof(struct tcmplxA_inscopy_row),
         tcmplxA_inscopy_encode_cmp);
   /* range check */if (out != NULL) {
@@ -466,4 +855,14 @@ size_t tcmplxA_inscopy_encode
     else return (size_t)(out - ict->p);
   } else return ~(size_t)0u;
 }
+
+size_t tcmplxA_inscopy_memory_usage(struct tcmplxA_inscopy const* x) {
+  return sizeof(struct tcmplxA_inscopy)
+    + x->n*sizeof(struct tcmplxA_inscopy_row);
+}
+
+size_t tcmplxA_inscopy_memory_bound(size_t n) {
+  return sizeof(struct tcmplxA_inscopy)
+    + n*sizeof(struct tcmplxA_inscopy_row);
+}
 /* END   insert copy table / public */
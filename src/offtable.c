@@ -13,15 +13,19 @@
 struct tcmplxA_offtable {
   struct tcmplxA_offline* p;
   size_t n;
+  struct tcmplxA_allocator const* alloc;
 };
 
 /**
  * \brief Initialize an offset table.
  * \param x the table to initialize
  * \param sz number of lines in the table
+ * \param alloc (nullable) allocator for the table; NULL for the heap
  * \return zero on success, nonzero otherwise
  */
-static int tcmplxA_offtable_init(struct tcmplxA_offtable* x, size_t sz);
+static int tcmplxA_offtable_init
+  ( struct tcmplxA_offtable* x, size_t sz,
+    struct tcmplxA_allocator const* alloc);
 /**
  * \brief Resize an offset table.
  * \param x the table to resize
@@ -36,7 +40,11 @@ static int tcmplxA_offtable_resize(struct tcmplxA_offtable* x, size_t sz);
 static void tcmplxA_offtable_close(struct tcmplxA_offtable* x);
 
 /* BEGIN offset table / static */
-int tcmplxA_offtable_init(struct tcmplxA_offtable* x, size_t sz) {
+int tcmplxA_offtable_init
+  ( struct tcmplxA_offtable* x, size_t sz,
+    struct tcmplxA_allocator const* alloc)
+{
+  x->alloc = alloc;
   x->p = NULL;
   x->n = 0u;
   return tcmplxA_offtable_resize(x,sz);
@@ -46,7 +54,7 @@ int tcmplxA_offtable_resize(struct tcmplxA_offtable* x, size_t sz) {
   struct tcmplxA_offline *ptr;
   if (sz == 0u) {
     if (x->p != NULL) {
-      tcmplxA_util_free(x->p);
+      tcmplxA_util_deallocate(x->alloc, x->p);
     }
     x->p = NULL;
     x->n = 0u;
@@ -54,13 +62,13 @@ int tcmplxA_offtable_resize(struct tcmplxA_offtable* x, size_t sz) {
   } else if (sz >= UINT_MAX/sizeof(struct tcmplxA_offline)) {
     return tcmplxA_ErrMemory;
   }
-  ptr = (struct tcmplxA_offline*)tcmplxA_util_malloc
-          (sizeof(struct tcmplxA_offline)*sz);
+  ptr = (struct tcmplxA_offline*)tcmplxA_util_allocate
+          (x->alloc, sizeof(struct tcmplxA_offline)*sz);
   if (ptr == NULL) {
     return tcmplxA_ErrMemory;
   }
   if (x->p != NULL) {
-    tcmplxA_util_free(x->p);
+    tcmplxA_util_deallocate(x->alloc, x->p);
   }
   x->p = ptr;
   x->n = sz;
@@ -68,7 +76,7 @@ int tcmplxA_offtable_resize(struct tcmplxA_offtable* x, size_t sz) {
 }
 
 void tcmplxA_offtable_close(struct tcmplxA_offtable* x) {
-  tcmplxA_util_free(x->p);
+  tcmplxA_util_deallocate(x->alloc, x->p);
   x->p = NULL;
   x->n = 0u;
   return;
@@ -77,12 +85,18 @@ void tcmplxA_offtable_close(struct tcmplxA_offtable* x) {
 
 /* BEGIN offset table / public */
 struct tcmplxA_offtable* tcmplxA_offtable_new(size_t n) {
+  return tcmplxA_offtable_new_alloc(n, NULL);
+}
+
+struct tcmplxA_offtable* tcmplxA_offtable_new_alloc
+  (size_t n, struct tcmplxA_allocator const* alloc)
+{
   struct tcmplxA_offtable* out;
-  out = tcmplxA_util_malloc(sizeof(struct tcmplxA_offtable));
+  out = tcmplxA_util_allocate(alloc, sizeof(struct tcmplxA_offtable));
   if (out != NULL
-  &&  tcmplxA_offtable_init(out,n) != tcmplxA_Success)
+  &&  tcmplxA_offtable_init(out,n,alloc) != tcmplxA_Success)
   {
-    tcmplxA_util_free(out);
+    tcmplxA_util_deallocate(alloc, out);
     return NULL;
   }
   return out;
@@ -90,8 +104,9 @@ struct tcmplxA_offtable* tcmplxA_offtable_new(size_t n) {
 
 void tcmplxA_offtable_destroy(struct tcmplxA_offtable* x) {
   if (x != NULL) {
+    struct tcmplxA_allocator const* const alloc = x->alloc;
     tcmplxA_offtable_close(x);
-    tcmplxA_util_free(x);
+    tcmplxA_util_deallocate(alloc, x);
   }
   return;
 }
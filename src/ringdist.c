@@ -18,6 +18,7 @@ struct tcmplxA_ringdist {
   unsigned short int postfix : 4;
   unsigned short int bit_adjust : 4;
   unsigned short int postmask : 8;
+  struct tcmplxA_allocator const* alloc;
 };
 
 /**
@@ -106,22 +107,31 @@ tcmplxA_uint32 tcmplxA_ringdist_retrieve
 /* BEGIN distance ring / public */
 struct tcmplxA_ringdist* tcmplxA_ringdist_new
     (int special_tf, unsigned int direct, unsigned int postfix)
+{
+  return tcmplxA_ringdist_new_alloc(special_tf, direct, postfix, NULL);
+}
+
+struct tcmplxA_ringdist* tcmplxA_ringdist_new_alloc
+    ( int special_tf, unsigned int direct, unsigned int postfix,
+      struct tcmplxA_allocator const* alloc)
 {
   struct tcmplxA_ringdist* out;
-  out = tcmplxA_util_malloc(sizeof(struct tcmplxA_ringdist));
-  if (out != NULL
-  &&  tcmplxA_ringdist_init(out,special_tf,direct,postfix) != tcmplxA_Success)
-  {
-    tcmplxA_util_free(out);
-    return NULL;
+  out = tcmplxA_util_allocate(alloc, sizeof(struct tcmplxA_ringdist));
+  if (out != NULL) {
+    out->alloc = alloc;
+    if (tcmplxA_ringdist_init(out,special_tf,direct,postfix) != tcmplxA_Success) {
+      tcmplxA_util_deallocate(alloc, out);
+      return NULL;
+    }
   }
   return out;
 }
 
 void tcmplxA_ringdist_destroy(struct tcmplxA_ringdist* x) {
   if (x != NULL) {
+    struct tcmplxA_allocator const* const alloc = x->alloc;
     tcmplxA_ringdist_close(x);
-    tcmplxA_util_free(x);
+    tcmplxA_util_deallocate(alloc, x);
   }
   return;
 }
@@ -372,4 +382,19 @@ int tcmplxA_ringdist_reconfigure
   ring->postmask = (1u<<postfix)-1u;
   return tcmplxA_Success;
 }
+
+int tcmplxA_ringdist_reset
+  (struct tcmplxA_ringdist* ring, int special_tf, unsigned int direct, unsigned int postfix)
+{
+  return tcmplxA_ringdist_init(ring, special_tf, direct, postfix);
+}
+
+size_t tcmplxA_ringdist_memory_usage(struct tcmplxA_ringdist const* x) {
+  (void)x;
+  return sizeof(struct tcmplxA_ringdist);
+}
+
+size_t tcmplxA_ringdist_memory_bound(void) {
+  return sizeof(struct tcmplxA_ringdist);
+}
 /* END   distance ring / public */
@@ -12,10 +12,14 @@
 
 
 /* BEGIN slide ring / private */
-int tcmplxA_ringslide_init(struct tcmplxA_ringslide* x, tcmplxA_uint32 n) {
+int tcmplxA_ringslide_init
+  ( struct tcmplxA_ringslide* x, tcmplxA_uint32 n,
+    struct tcmplxA_allocator const* alloc)
+{
   if (n > 0x1000000)
     return tcmplxA_ErrParam;
   else {
+    x->alloc = alloc;
     x->n = n;
     x->pos = 0u;
     x->cap = 0u;
@@ -26,7 +30,7 @@ int tcmplxA_ringslide_init(struct tcmplxA_ringslide* x, tcmplxA_uint32 n) {
 }
 
 void tcmplxA_ringslide_close(struct tcmplxA_ringslide* x) {
-  tcmplxA_util_free(x->p);
+  tcmplxA_util_deallocate(x->alloc, x->p);
   x->p = NULL;
   x->cap = 0u;
   x->pos = 0u;
@@ -34,16 +38,50 @@ void tcmplxA_ringslide_close(struct tcmplxA_ringslide* x) {
   x->n = 0u;
   return;
 }
+
+void tcmplxA_ringslide_reset(struct tcmplxA_ringslide* x) {
+  x->pos = 0u;
+  x->sz = 0u;
+  return;
+}
+
+int tcmplxA_ringslide_copy
+  (struct tcmplxA_ringslide* dst, struct tcmplxA_ringslide const* src)
+{
+  if (dst == src)
+    return tcmplxA_Success;
+  if (dst->cap < src->cap) {
+    unsigned char* const ptr =
+      (unsigned char*)tcmplxA_util_allocate(dst->alloc, src->cap*sizeof(unsigned char));
+    if (ptr == NULL)
+      return tcmplxA_ErrMemory;
+    tcmplxA_util_deallocate(dst->alloc, dst->p);
+    dst->p = ptr;
+    dst->cap = src->cap;
+  }
+  if (src->cap > 0u)
+    memcpy(dst->p, src->p, src->cap*sizeof(unsigned char));
+  dst->n = src->n;
+  dst->pos = src->pos;
+  dst->sz = src->sz;
+  return tcmplxA_Success;
+}
 /* END   slide ring / private */
 
 /* BEGIN slide ring / public */
 struct tcmplxA_ringslide* tcmplxA_ringslide_new(tcmplxA_uint32 n) {
+  return tcmplxA_ringslide_new_alloc(n, NULL);
+}
+
+struct tcmplxA_ringslide* tcmplxA_ringslide_new_alloc
+  (tcmplxA_uint32 n, struct tcmplxA_allocator const* alloc)
+{
   struct tcmplxA_ringslide* out;
-  out = tcmplxA_util_malloc(sizeof(struct tcmplxA_ringslide));
+  out = tcmplxA_util_allocate(alloc, sizeof(struct tcmplxA_ringslide));
   if (out != NULL
-  &&  tcmplxA_ringslide_init(out, n) != tcmplxA_Success)
+  &&  tcmplxA_ringslide_init(out, n, alloc) != tcmplxA_Success)
   {
-    tcmplxA_util_free(out);
+    tcmplxA_util_deallocate(alloc, out);
     return NULL;
   }
   return out;
@@ -51,8 +89,9 @@ struct tcmplxA_ringslide* tcmplxA_ringslide_new(tcmplxA_uint32 n) {
 
 void tcmplxA_ringslide_destroy(struct tcmplxA_ringslide* x) {
   if (x != NULL) {
+    struct tcmplxA_allocator const* const alloc = x->alloc;
     tcmplxA_ringslide_close(x);
-    tcmplxA_util_free(x);
+    tcmplxA_util_deallocate(alloc, x);
   }
   return;
 }
@@ -71,12 +110,12 @@ int tcmplxA_ringslide_add(struct tcmplxA_ringslide* x, unsigned int v) {
     else {
       size_t const ncap = (x->cap == 0u) ? 1u : x->cap*2u;
       unsigned char* const ptr =
-        (unsigned char*)tcmplxA_util_malloc(ncap*sizeof(unsigned char));
+        (unsigned char*)tcmplxA_util_allocate(x->alloc, ncap*sizeof(unsigned char));
       if (ptr == NULL) {
         return tcmplxA_ErrMemory;
       } else {
         memcpy(ptr, x->p, x->cap*sizeof(unsigned char));
-        tcmplxA_util_free(x->p);
+        tcmplxA_util_deallocate(x->alloc, x->p);
         x->p = ptr;
         x->cap = ncap;
       }
@@ -106,4 +145,8 @@ unsigned int tcmplxA_ringslide_peek
     return x->p[x->n-(i-x->pos)-1u];
   else return x->p[x->pos-i-1u];
 }
+
+size_t tcmplxA_ringslide_memory_usage(struct tcmplxA_ringslide const* x) {
+  return sizeof(struct tcmplxA_ringslide) + x->cap*sizeof(unsigned char);
+}
 /* END   slide ring / public */
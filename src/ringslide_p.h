@@ -7,6 +7,8 @@
 
 #include "text-complex/access/api.h"
 
+struct tcmplxA_allocator;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /*__cplusplus*/
@@ -21,21 +23,38 @@ struct tcmplxA_ringslide {
   tcmplxA_uint32 cap;
   tcmplxA_uint32 sz;
   unsigned char* p;
+  struct tcmplxA_allocator const* alloc;
 };
 
 /**
  * @brief Initialize a slide ring.
  * @param x the slide ring to initialize
  * @param n maximum sliding window size
+ * @param alloc (nullable) allocator for the window; NULL for the heap
  * @return zero on success, nonzero otherwise
  */
 int tcmplxA_ringslide_init
-  (struct tcmplxA_ringslide* x, tcmplxA_uint32 n);
+  ( struct tcmplxA_ringslide* x, tcmplxA_uint32 n,
+    struct tcmplxA_allocator const* alloc);
 /**
  * @brief Close a slide ring.
  * @param x the slide ring to close
  */
 void tcmplxA_ringslide_close(struct tcmplxA_ringslide* x);
+/**
+ * @brief Empty a slide ring, keeping its storage.
+ * @param x the slide ring to reset
+ */
+void tcmplxA_ringslide_reset(struct tcmplxA_ringslide* x);
+/**
+ * @brief Copy a slide ring.
+ * @param dst destination slide ring
+ * @param src source slide ring
+ * @return zero on success, nonzero otherwise
+ * @note The destination takes on the window size of the source.
+ */
+int tcmplxA_ringslide_copy
+  (struct tcmplxA_ringslide* dst, struct tcmplxA_ringslide const* src);
 
 
 #ifdef __cplusplus
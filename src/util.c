@@ -11,10 +11,59 @@
 #  include <intrin.h>
 #endif /*_MSC_VER*/
 
+/**
+ * @internal
+ * @brief Type with the strictest alignment used by the library.
+ */
+union tcmplxA_util_maxalign {
+  long double ld;
+  double d;
+  long int l;
+  void* p;
+  void (*fn)(void);
+};
+
 enum tcmplxA_util_const {
-  tcmplxA_util_UIntPrec = sizeof(unsigned)*CHAR_BIT
+  tcmplxA_util_UIntPrec = sizeof(unsigned)*CHAR_BIT,
+  tcmplxA_util_Align = sizeof(union tcmplxA_util_maxalign)
+};
+
+struct tcmplxA_util_arena {
+  /** @brief Allocator interface handed out to objects. */
+  struct tcmplxA_allocator iface;
+  /** @brief Allocator for the slab and for overflow. */
+  struct tcmplxA_allocator const* backing;
+  unsigned char* slab;
+  size_t cap;
+  size_t pos;
+  /** @brief Header offset of the most recent slab allocation. */
+  size_t last;
+};
+
+/**
+ * @internal
+ * @brief Header placed before each slab allocation.
+ */
+union tcmplxA_util_arena_header {
+  /** @brief Header offset of the allocation made before this one. */
+  size_t prev;
+  union tcmplxA_util_maxalign align;
 };
 
+/**
+ * @brief Allocate from an arena.
+ * @param userdata the arena
+ * @param sz number of bytes to allocate
+ * @return a pointer to the bytes on success, NULL otherwise
+ */
+static void* tcmplxA_util_arena_allocate(void* userdata, size_t sz);
+/**
+ * @brief Free to an arena.
+ * @param userdata the arena
+ * @param x (nullable) pointer to bytes to free
+ */
+static void tcmplxA_util_arena_deallocate(void* userdata, void* x);
+
 void* tcmplxA_util_malloc(size_t sz) {
   if (sz == 0)
     return NULL;
@@ -26,6 +75,21 @@ void tcmplxA_util_free(void* x) {
   return;
 }
 
+void* tcmplxA_util_allocate(struct tcmplxA_allocator const* a, size_t sz) {
+  if (sz == 0)
+    return NULL;
+  else if (a == NULL)
+    return malloc(sz);
+  else return (*a->allocate)(a->userdata, sz);
+}
+
+void tcmplxA_util_deallocate(struct tcmplxA_allocator const* a, void* x) {
+  if (a == NULL)
+    free(x);
+  else (*a->deallocate)(a->userdata, x);
+  return;
+}
+
 unsigned tcmplxA_util_bitwidth(unsigned int x) {
 #if (defined __GNUC__)
   return x ? tcmplxA_util_UIntPrec - __builtin_clz(x) : 0;
@@ -42,3 +106,89 @@ unsigned tcmplxA_util_bitwidth(unsigned int x) {
   return y;
 #endif /*bitwidth*/
 }
+
+/* BEGIN arena / static */
+void* tcmplxA_util_arena_allocate(void* userdata, size_t sz) {
+  struct tcmplxA_util_arena* const x = (struct tcmplxA_util_arena*)userdata;
+  size_t const hsz = sizeof(union tcmplxA_util_arena_header);
+  size_t const start = x->pos
+    + (tcmplxA_util_Align - x->pos%tcmplxA_util_Align)%tcmplxA_util_Align;
+  if (start <= x->cap && hsz <= x->cap - start
+  &&  sz <= x->cap - start - hsz)
+  {
+    union tcmplxA_util_arena_header* const h =
+      (union tcmplxA_util_arena_header*)(x->slab + start);
+    h->prev = x->last;
+    x->last = start;
+    x->pos = start + hsz + sz;
+    return h+1;
+  } else return tcmplxA_util_allocate(x->backing, sz);
+}
+
+void tcmplxA_util_arena_deallocate(void* userdata, void* x) {
+  struct tcmplxA_util_arena* const ar = (struct tcmplxA_util_arena*)userdata;
+  unsigned char* const p = (unsigned char*)x;
+  if (p == NULL)
+    return;
+  else if (p >= ar->slab && p < ar->slab + ar->cap) {
+    union tcmplxA_util_arena_header* const h =
+      ((union tcmplxA_util_arena_header*)p)-1;
+    /* only the most recent allocation can give back its space */
+    if ((unsigned char*)h == ar->slab + ar->last && ar->pos > ar->last) {
+      ar->pos = ar->last;
+      ar->last = h->prev;
+    }
+  } else tcmplxA_util_deallocate(ar->backing, x);
+  return;
+}
+/* END   arena / static */
+
+/* BEGIN arena / public */
+struct tcmplxA_util_arena* tcmplxA_util_arena_new
+  (size_t cap, struct tcmplxA_allocator const* backing)
+{
+  struct tcmplxA_util_arena* out = tcmplxA_util_allocate
+    (backing, sizeof(struct tcmplxA_util_arena));
+  if (out != NULL) {
+    out->slab = NULL;
+    if (cap > 0) {
+      out->slab = (unsigned char*)tcmplxA_util_allocate(backing, cap);
+      if (out->slab == NULL) {
+        tcmplxA_util_deallocate(backing, out);
+        return NULL;
+      }
+    }
+    out->iface.allocate = tcmplxA_util_arena_allocate;
+    out->iface.deallocate = tcmplxA_util_arena_deallocate;
+    out->iface.userdata = out;
+    out->backing = backing;
+    out->cap = cap;
+    out->pos = 0;
+    out->last = 0;
+  }
+  return out;
+}
+
+void tcmplxA_util_arena_destroy(struct tcmplxA_util_arena* x) {
+  if (x != NULL) {
+    struct tcmplxA_allocator const* const backing = x->backing;
+    tcmplxA_util_deallocate(backing, x->slab);
+    tcmplxA_util_deallocate(backing, x);
+  }
+  return;
+}
+
+struct tcmplxA_allocator const* tcmplxA_util_arena_allocator
+  (struct tcmplxA_util_arena* x)
+{
+  return &x->iface;
+}
+
+size_t tcmplxA_util_arena_size(struct tcmplxA_util_arena const* x) {
+  return x->pos;
+}
+
+size_t tcmplxA_util_arena_capacity(struct tcmplxA_util_arena const* x) {
+  return x->cap;
+}
+/* END   arena / public */
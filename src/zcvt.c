@@ -28,6 +28,8 @@ enum tcmplxA_zcvt_uconst {
     + tcmplxA_ZCvt_SeqHistoSize,
   tcmplxA_ZCvt_LitDynamicConst = 286u,
   tcmplxA_ZCvt_DistDynamicConst = 30u,
+  /** @brief Longest copy a DEFLATE length code can carry. */
+  tcmplxA_ZCvt_CopyMax = 258u,
 };
 
 struct tcmplxA_zcvt {
@@ -43,8 +45,8 @@ struct tcmplxA_zcvt {
   struct tcmplxA_fixlist* distances;
   /** @brief ... */
   struct tcmplxA_fixlist* sequence;
-  /** @brief ... */
-  struct tcmplxA_inscopy* values;
+  /** @brief Shared literal-length table. */
+  struct tcmplxA_inscopy const* values;
   /** @brief ... */
   struct tcmplxA_ringdist* ring;
   /** @brief ... */
@@ -53,6 +55,10 @@ struct tcmplxA_zcvt {
   tcmplxA_uint32* histogram;
   /** @brief Tree description sequence. */
   struct tcmplxA_blockstr sequence_list;
+  /** @brief Allocator for the state and its members; NULL for the heap. */
+  struct tcmplxA_allocator const* alloc;
+  /** @brief Memory cap in bytes; zero for no cap. */
+  size_t memory_cap;
   /** @brief ... */
   unsigned short int bits;
   /** @brief Read count for bits used after a Huffman code. */
@@ -85,16 +91,23 @@ unsigned char tcmplxA_zcvt_clen[19] =
 /**
  * @brief Initialize a zcvt state.
  * @param x the zcvt state to initialize
+ * @param alloc (nullable) allocator for the state; NULL for the heap
  * @return zero on success, nonzero otherwise
  */
 static int tcmplxA_zcvt_init
   ( struct tcmplxA_zcvt* x, tcmplxA_uint32 block_size,
-    tcmplxA_uint32 n, size_t chain_length);
+    tcmplxA_uint32 n, size_t chain_length,
+    struct tcmplxA_allocator const* alloc);
 /**
  * @brief Close a zcvt state.
  * @param x the zcvt state to close
  */
 static void tcmplxA_zcvt_close(struct tcmplxA_zcvt* x);
+/**
+ * @brief Put a zcvt state's scalar fields at the start of a stream.
+ * @param x the zcvt state to restart
+ */
+static void tcmplxA_zcvt_restart(struct tcmplxA_zcvt* x);
 /**
  * @brief Bit iteration.
  * @param x the zcvt state
@@ -170,72 +183,78 @@ static int tcmplxA_zcvt_strrtozs_bits
  * @param ps the zcvt state to update
  */
 static void tcmplxA_zcvt_noconv_next(struct tcmplxA_zcvt* ps);
+/**
+ * @brief Prepare the length code of a copy command.
+ * @param ps the zcvt state to update
+ * @param len copy length
+ * @return tcmplxA_Success on success, nonzero otherwise
+ */
+static int tcmplxA_zcvt_copy_code(struct tcmplxA_zcvt* ps, tcmplxA_uint32 len);
+/**
+ * @brief Move past one literal of the current command.
+ * @param ps the zcvt state to update
+ */
+static void tcmplxA_zcvt_next_literal(struct tcmplxA_zcvt* ps);
 
 /* BEGIN zcvt state / static */
 int tcmplxA_zcvt_init
     ( struct tcmplxA_zcvt* x, tcmplxA_uint32 block_size,
-      tcmplxA_uint32 n, size_t chain_length)
+      tcmplxA_uint32 n, size_t chain_length,
+      struct tcmplxA_allocator const* alloc)
 {
   int res = tcmplxA_Success;
+  x->alloc = alloc;
+  x->memory_cap = 0u;
   /* buffer */{
-    x->buffer = tcmplxA_blockbuf_new(block_size,n,chain_length, 0);
+    x->buffer = tcmplxA_blockbuf_new_alloc(block_size,n,chain_length, 0, alloc);
     if (x->buffer == NULL)
       res = tcmplxA_ErrMemory;
+    else tcmplxA_blockbuf_set_copy_max(x->buffer, tcmplxA_ZCvt_CopyMax);
   }
   /* literals */{
-    x->literals = tcmplxA_fixlist_new(288u);
+    x->literals = tcmplxA_fixlist_new_alloc(288u, alloc);
     if (x->literals == NULL)
       res = tcmplxA_ErrMemory;
   }
   /* distances */{
-    x->distances = tcmplxA_fixlist_new(32u);
+    x->distances = tcmplxA_fixlist_new_alloc(32u, alloc);
     if (x->distances == NULL)
       res = tcmplxA_ErrMemory;
   }
   /* sequence */{
-    x->sequence = tcmplxA_fixlist_new(19u);
+    x->sequence = tcmplxA_fixlist_new_alloc(19u, alloc);
     if (x->sequence == NULL)
       res = tcmplxA_ErrMemory;
   }
   /* ring */{
-    x->ring = tcmplxA_ringdist_new(0,4u,0u);
+    x->ring = tcmplxA_ringdist_new_alloc(0,4u,0u, alloc);
     if (x->ring == NULL)
       res = tcmplxA_ErrMemory;
   }
   /* try_ring */{
-    x->try_ring = tcmplxA_ringdist_new(0,4u,0u);
+    x->try_ring = tcmplxA_ringdist_new_alloc(0,4u,0u, alloc);
     if (x->try_ring == NULL)
       res = tcmplxA_ErrMemory;
   }
   /* sequence_list */{
-    int const ae = tcmplxA_blockstr_init(&x->sequence_list, 286u+30u);
+    int const ae = tcmplxA_blockstr_init(&x->sequence_list, 286u+30u, alloc);
     if (ae != tcmplxA_Success)
       res = ae;
   }
   /* histogram */{
     if (tcmplxA_ZCvt_HistogramSize < ((size_t)-1)/sizeof(tcmplxA_uint32)) {
-      x->histogram = tcmplxA_util_malloc
-        (tcmplxA_ZCvt_HistogramSize*sizeof(tcmplxA_uint32));
+      x->histogram = tcmplxA_util_allocate
+        (alloc, tcmplxA_ZCvt_HistogramSize*sizeof(tcmplxA_uint32));
     } else x->histogram = NULL;
     if (x->histogram == NULL)
       res = tcmplxA_ErrMemory;
   }
   /* values */{
-    x->values = tcmplxA_inscopy_new(286u);
-    if (x->values == NULL)
-      res = tcmplxA_ErrMemory;
-    else {
-      int const preset_ae =
-        tcmplxA_inscopy_preset(x->values, tcmplxA_InsCopy_Deflate);
-      if (preset_ae != tcmplxA_Success)
-        res = preset_ae;
-      else tcmplxA_inscopy_codesort(x->values);
-    }
+    x->values = tcmplxA_inscopy_preset_c(tcmplxA_InsCopy_Deflate);
   }
   if (res != tcmplxA_Success) {
     tcmplxA_blockstr_close(&x->sequence_list);
-    tcmplxA_inscopy_destroy(x->values);
-    tcmplxA_util_free(x->histogram);
+    tcmplxA_util_deallocate(x->alloc, x->histogram);
     tcmplxA_ringdist_destroy(x->try_ring);
     tcmplxA_ringdist_destroy(x->ring);
     tcmplxA_fixlist_destroy(x->sequence);
@@ -244,26 +263,30 @@ int tcmplxA_zcvt_init
     tcmplxA_blockbuf_destroy(x->buffer);
     return res;
   } else {
-    x->bits = 0u;
-    x->h_end = 0u;
-    x->bit_length = 0u;
-    x->state = 0u;
-    x->bit_index = 0u;
-    x->backward = 0u;
-    x->count = 0u;
-    x->checksum = 0u;
-    x->bit_cap = 0u;
-    x->write_scratch = 0u;
+    tcmplxA_zcvt_restart(x);
     return tcmplxA_Success;
   }
 }
 
+void tcmplxA_zcvt_restart(struct tcmplxA_zcvt* x) {
+  x->bits = 0u;
+  x->h_end = 0u;
+  x->bit_length = 0u;
+  x->state = 0u;
+  x->bit_index = 0u;
+  x->backward = 0u;
+  x->count = 0u;
+  x->checksum = 0u;
+  x->bit_cap = 0u;
+  x->write_scratch = 0u;
+  return;
+}
+
 void tcmplxA_zcvt_close(struct tcmplxA_zcvt* x) {
   tcmplxA_blockstr_close(&x->sequence_list);
-  tcmplxA_util_free(x->histogram);
+  tcmplxA_util_deallocate(x->alloc, x->histogram);
   tcmplxA_ringdist_destroy(x->try_ring);
   tcmplxA_ringdist_destroy(x->ring);
-  tcmplxA_inscopy_destroy(x->values);
   tcmplxA_fixlist_destroy(x->sequence);
   tcmplxA_fixlist_destroy(x->distances);
   tcmplxA_fixlist_destroy(x->literals);
@@ -856,21 +879,43 @@ int tcmplxA_zcvt_strrtozs_bits
       }
       /* try compress the data */if (ps->count == 0u) {
         int dynamic_flag = 0;
+        int stored_flag = 0;
         if (tcmplxA_blockbuf_input_size(ps->buffer) == 0u && (!ps->h_end)) {
           /* stash the current byte to the side */
           ae = tcmplxA_ErrPartial;
           break;
         } else {
           tcmplxA_blockbuf_clear_output(ps->buffer);
-          ae = tcmplxA_blockbuf_try_block(ps->buffer);
+          if (ps->memory_cap > 0u) {
+            /* keep the match search scratch under the cap too */
+            size_t const usage = tcmplxA_zcvt_memory_usage(ps);
+            tcmplxA_blockbuf_set_scratch_cap(ps->buffer,
+              usage < ps->memory_cap ? ps->memory_cap-usage : 0u);
+          }
+          stored_flag = tcmplxA_blockbuf_probe_flat(ps->buffer);
+          ae = stored_flag ? tcmplxA_Success
+            : tcmplxA_blockbuf_try_commands(ps->buffer);
         }
-        if (ae == tcmplxA_Success) {
+        if (ae == tcmplxA_Success && stored_flag) {
+          /* skip the match search for incompressible data */
+          tcmplxA_uint32 const input_size =
+            tcmplxA_blockbuf_input_size(ps->buffer);
+          if (tcmplxA_blockbuf_bypass(ps->buffer,
+                tcmplxA_blockbuf_input_data(ps->buffer), input_size)
+              != input_size)
+          {
+            ae = tcmplxA_ErrMemory;
+            break;
+          }
+          ae = tcmplxA_blockbuf_noconv_block(ps->buffer);
+          if (ae != tcmplxA_Success)
+            break;
+          ps->bits = (ps->h_end&1u);
+          tcmplxA_blockbuf_clear_input(ps->buffer);
+        } else if (ae == tcmplxA_Success) {
           /* histogram */
-          unsigned char const* const buffer_str =
-            tcmplxA_blockbuf_output_data(ps->buffer);
-          tcmplxA_uint32 const buffer_size =
-            tcmplxA_blockbuf_output_size(ps->buffer);
-          tcmplxA_uint32 const buffer_m1 = buffer_size-1u;
+          struct tcmplxA_blockcmds const cmds =
+            tcmplxA_blockbuf_commands(ps->buffer);
           unsigned long int bit_count = 0u;
           tcmplxA_uint32 *const lit_histogram = ps->histogram;
           tcmplxA_uint32 *const dist_histogram =
@@ -885,32 +930,30 @@ int tcmplxA_zcvt_strrtozs_bits
                 tcmplxA_ZCvt_DistHistoSize*sizeof(tcmplxA_uint32));
             memset(seq_histogram, 0u,
                 tcmplxA_ZCvt_SeqHistoSize*sizeof(tcmplxA_uint32));
-            ae = tcmplxA_inscopy_lengthsort(ps->values);
-            if (ae != tcmplxA_Success)
-              break;
           }
           /* calculate histogram */{
-            tcmplxA_uint32 buffer_pos;
-            for (buffer_pos = 0u; buffer_pos < buffer_size; ++buffer_pos) {
-              unsigned char const byt = buffer_str[buffer_pos];
-              int const insert_flag = ((byt&128u) == 0u);
-              unsigned short len;
-              unsigned short j;
-              if (byt&64u) {
-                if (buffer_pos == buffer_m1) {
-                  ae = tcmplxA_ErrSanitize;
-                  break;
-                } else {
-                  len = (((byt&63u)<<8)|(buffer_str[buffer_pos+1u]&255u))+64u;
-                  buffer_pos += 1u;
-                }
-              } else len = byt&63u;
+            size_t cmd_i;
+            for (cmd_i = 0u; cmd_i < cmds.count; ++cmd_i) {
+              tcmplxA_uint32 const len = cmds.copy_lens[cmd_i];
+              tcmplxA_uint32 const distance = cmds.distances[cmd_i];
+              /* literals */{
+                unsigned char const* const literal =
+                  cmds.literals + cmds.literal_offsets[cmd_i];
+                tcmplxA_uint32 const insert_len = cmds.insert_lens[cmd_i];
+                tcmplxA_uint32 j;
+                for (j = 0u; j < insert_len; ++j)
+                  lit_histogram[literal[j]] += 1u;
+              }
               if (len == 0u)
                 continue;
-              else if (!insert_flag) {
+              else if (distance & tcmplxA_BlockBuf_BDictRef) {
+                /* Brotli dictionary not supported in ZLIB stream */
+                ae = tcmplxA_ErrSanitize;
+                break;
+              }
+              /* copy */{
                 size_t const lit_index =
                   tcmplxA_inscopy_encode(ps->values, 0u, len, 0);
-                tcmplxA_uint32 distance = 0u;
                 if (lit_index >= tcmplxA_inscopy_size(ps->values)) {
                   ae = tcmplxA_ErrInsCopyMissing;
                   break;
@@ -920,39 +963,19 @@ int tcmplxA_zcvt_strrtozs_bits
                   lit_histogram[lit->code] += 1u;
                   bit_count += lit->copy_bits;
                 }
-                /* distance */switch (buffer_str[buffer_pos+1u] & 192u) {
-                case 128u:
-                  if (buffer_pos+2u < buffer_size) {
-                    distance = ((buffer_str[buffer_pos+1u]&63u)<<8) | buffer_str[buffer_pos+2u];
-                    buffer_pos += 2u;
-                  } else ae = tcmplxA_ErrBlockOverflow;
-                  break;
-                case 192u:
-                  if (buffer_pos+4u < buffer_size) {
-                    distance = ((((tcmplxA_uint32)(buffer_str[buffer_pos+1u]&63u))<<24)
-                      | (((tcmplxA_uint32)buffer_str[buffer_pos+2u]) << 16)
-                      | (buffer_str[buffer_pos+3u]<<8) | (buffer_str[buffer_pos+4u])) + 16384u;
-                    buffer_pos += 4u;
-                  } else ae = tcmplxA_ErrBlockOverflow;
+              }
+              /* encode distance */{
+                tcmplxA_uint32 extra;
+                unsigned int const dist_code =
+                  tcmplxA_ringdist_encode(ps->try_ring, distance+1, &extra, 0u);
+                if (dist_code == UINT_MAX) {
+                  ae = tcmplxA_ErrParam;
                   break;
-                default:
-                  /* Brotli dictionary not supported in ZLIB stream */
-                  ae = tcmplxA_ErrSanitize;
+                } else {
+                  bit_count +=
+                    tcmplxA_ringdist_bit_count(ps->try_ring, dist_code);
+                  dist_histogram[dist_code] += 1u;
                 }
-                /* encode distance */if (ae == tcmplxA_Success) {
-                  tcmplxA_uint32 extra;
-                  unsigned int const dist_code =
-                    tcmplxA_ringdist_encode(ps->try_ring, distance+1, &extra, 0u);
-                  if (dist_code == UINT_MAX) {
-                    ae = tcmplxA_ErrParam;
-                    break;
-                  } else {
-                    bit_count += extra;
-                    dist_histogram[dist_code] += 1u;
-                  }
-                } else break;
-              } else for (j = 0u; j < len && buffer_pos < buffer_m1; ++j, ++buffer_pos) {
-                lit_histogram[buffer_str[buffer_pos+1u]] += 1u;
               }
             }
             /* Ensure the stop code. */
@@ -1081,7 +1104,8 @@ int tcmplxA_zcvt_strrtozs_bits
         if (ae != tcmplxA_Success)
           break;
         ps->state = 8u;
-        ps->backward = tcmplxA_blockbuf_output_size(ps->buffer);
+        ps->backward =
+          (tcmplxA_uint32)tcmplxA_blockbuf_commands(ps->buffer).count;
         ps->index = 0u;
         ps->bit_length = 0u;
       } /* [[fallthrough]] */;
@@ -1093,49 +1117,24 @@ int tcmplxA_zcvt_strrtozs_bits
           ps->bit_cap = line->len;
           ps->bits = line->code;
         } else {
-          unsigned char const* const data =
-            tcmplxA_blockbuf_output_data(ps->buffer);
-          unsigned char buf[2u] = {0u};
-          unsigned int len;
-          buf[0u] = data[ps->index];
-          if ((buf[0u]&64u) && (ps->index+1u < ps->backward)) {
-            ps->index += 1u;
-            buf[1u] = data[ps->index];
-            len = buf[1u] + ((buf[0u]&63u)<<8) + 64u;
-          } else len = buf[0u]&63u;
-          if ((buf[0u]&128u)==0u) {
+          struct tcmplxA_blockcmds const cmds =
+            tcmplxA_blockbuf_commands(ps->buffer);
+          tcmplxA_uint32 const len = cmds.insert_lens[ps->index];
+          if (len > 0u) {
             /* insert */
-            if (ps->index+1u >= ps->backward || len == 0u) {
-              ae = tcmplxA_ErrSanitize;
-              break;
-            } else {
-              unsigned char const alpha = data[ps->index+1u];
-              struct tcmplxA_fixline const* const line =
-                tcmplxA_fixlist_at_c(ps->literals, alpha);
-              ps->state = 20u;
-              ps->index += 1u;
-              ps->count = len;
-              ps->bit_cap = line->len;
-              ps->bits = line->code;
-            }
+            unsigned char const alpha =
+              cmds.literals[cmds.literal_offsets[ps->index]];
+            struct tcmplxA_fixline const* const line =
+              tcmplxA_fixlist_at_c(ps->literals, alpha);
+            ps->state = 20u;
+            ps->count = len;
+            ps->bit_cap = line->len;
+            ps->bits = line->code;
           } else {
             /* copy */
-            size_t const copy_index = tcmplxA_inscopy_encode
-                (ps->values, 0u, len, 0);
-            if (copy_index == ((size_t)-1)) {
-              ae = tcmplxA_ErrSanitize;
+            ae = tcmplxA_zcvt_copy_code(ps, cmds.copy_lens[ps->index]);
+            if (ae != tcmplxA_Success)
               break;
-            } else {
-              struct tcmplxA_inscopy_row const* const irow =
-                tcmplxA_inscopy_at_c(ps->values, copy_index);
-              unsigned short const alpha = irow->code;
-              struct tcmplxA_fixline const* const line =
-                tcmplxA_fixlist_at_c(ps->literals, alpha);
-              ps->bit_cap = line->len;
-              ps->bits = line->code;
-              ps->count = len - irow->copy_first;
-              ps->extra_length = irow->copy_bits;
-            }
           }
         }
       }
@@ -1153,24 +1152,23 @@ int tcmplxA_zcvt_strrtozs_bits
           }
           ps->count = 0u;
         } else if (ps->state == 20u) {
-          ps->count -= 1u;
-          ps->index += 1u;
-          if (ps->count == 0u) {
-            ps->state = 8u;
-          }
+          tcmplxA_zcvt_next_literal(ps);
           ps->bit_length = 0u;
         } else {
           ps->bit_length = 0u;
           ps->state = (ps->extra_length>0u ? 9u : 10u);
-          ps->index += 1u;
         }
       } break;
     case 20: /* alpha bringback */
       if (ps->bit_length == 0u) {
-        if (ps->index < ps->backward) {
-          unsigned char const* const data =
-            tcmplxA_blockbuf_output_data(ps->buffer);
-          unsigned char const alpha = data[ps->index];
+        struct tcmplxA_blockcmds const cmds =
+          tcmplxA_blockbuf_commands(ps->buffer);
+        if (ps->index < ps->backward
+        &&  ps->count <= cmds.insert_lens[ps->index])
+        {
+          unsigned char const alpha = cmds.literals
+            [ cmds.literal_offsets[ps->index]
+            + cmds.insert_lens[ps->index] - ps->count];
           struct tcmplxA_fixline const* const line =
             tcmplxA_fixlist_at_c(ps->literals, alpha);
           ps->bit_cap = line->len;
@@ -1185,11 +1183,29 @@ int tcmplxA_zcvt_strrtozs_bits
         ps->bit_length += 1u;
       }
       if (ps->bit_length >= ps->bit_cap) {
-        ps->index += 1u;
-        ps->count -= 1u;
-        if (ps->count == 0u)
-          ps->state = 8u;
+        tcmplxA_zcvt_next_literal(ps);
+        ps->bit_length = 0u;
+      } break;
+    case 21: /* copy length code */
+      if (ps->bit_length == 0u) {
+        if (ps->index < ps->backward) {
+          struct tcmplxA_blockcmds const cmds =
+            tcmplxA_blockbuf_commands(ps->buffer);
+          ae = tcmplxA_zcvt_copy_code(ps, cmds.copy_lens[ps->index]);
+          if (ae != tcmplxA_Success)
+            break;
+        } else {
+          ae = tcmplxA_ErrSanitize;
+          break;
+        }
+      }
+      if (ps->bit_length < ps->bit_cap) {
+        x = (ps->bits>>(ps->bit_cap-1u-ps->bit_length))&1u;
+        ps->bit_length += 1u;
+      }
+      if (ps->bit_length >= ps->bit_cap) {
         ps->bit_length = 0u;
+        ps->state = (ps->extra_length>0u ? 9u : 10u);
       } break;
     case 9: /* copy bits */
       if (ps->bit_length < ps->extra_length) {
@@ -1203,37 +1219,16 @@ int tcmplxA_zcvt_strrtozs_bits
       break;
     case 10: /* distance Huffman code */
       if (ps->bit_length == 0u) {
-        unsigned char buf[4] = {0};
-        unsigned long distance = 0;
-        unsigned char const* const data =
-          tcmplxA_blockbuf_output_data(ps->buffer);
+        struct tcmplxA_blockcmds const cmds =
+          tcmplxA_blockbuf_commands(ps->buffer);
+        tcmplxA_uint32 distance;
         assert(ps->index < ps->backward);
-        buf[0u] = data[ps->index];
-        ps->index += 1;
-        if ((buf[0]&128u) == 0u) {
+        distance = cmds.distances[ps->index];
+        if (distance & tcmplxA_BlockBuf_BDictRef) {
           /* zlib stream does not support Brotli references */
           ae = tcmplxA_ErrSanitize;
           break;
-        } else if (ps->index >= ps->backward) {
-          /* also, index needs to be in range */
-          ae = tcmplxA_ErrOutOfRange;
-          break;
-        }
-        if (buf[0u] & 64u) {
-          if (ps->backward - ps->index < 3u) {
-            ae = tcmplxA_ErrOutOfRange;
-            break;
-          }
-          memcpy(buf+1, data+ps->index, 3);
-          ps->index += 2;
-          distance = ((buf[0]&63ul)<<24)
-            + ((buf[1]&255ul)<<16) + ((buf[2]&255u)<<8)
-            + (buf[3]&255u) + 16384ul;
-        } else {
-          buf[1] = data[ps->index];
-          distance = ((buf[0]&63)<<8) + (buf[1]&255);
-        }
-        if (distance > 32768) {
+        } else if (distance > 32768) {
           /* zlib lacks support for large distances */
           ae = tcmplxA_ErrSanitize;
           break;
@@ -1385,32 +1380,125 @@ void tcmplxA_zcvt_noconv_next(struct tcmplxA_zcvt* ps) {
   ps->count = 0u;
   return;
 }
+
+int tcmplxA_zcvt_copy_code(struct tcmplxA_zcvt* ps, tcmplxA_uint32 len) {
+  size_t const copy_index = tcmplxA_inscopy_encode(ps->values, 0u, len, 0);
+  if (copy_index == ((size_t)-1)) {
+    return tcmplxA_ErrSanitize;
+  } else {
+    struct tcmplxA_inscopy_row const* const irow =
+      tcmplxA_inscopy_at_c(ps->values, copy_index);
+    struct tcmplxA_fixline const* const line =
+      tcmplxA_fixlist_at_c(ps->literals, irow->code);
+    ps->state = 21u;
+    ps->bit_cap = line->len;
+    ps->bits = line->code;
+    ps->count = len - irow->copy_first;
+    ps->extra_length = irow->copy_bits;
+    return tcmplxA_Success;
+  }
+}
+
+void tcmplxA_zcvt_next_literal(struct tcmplxA_zcvt* ps) {
+  ps->count -= 1u;
+  if (ps->count == 0u) {
+    struct tcmplxA_blockcmds const cmds =
+      tcmplxA_blockbuf_commands(ps->buffer);
+    if (cmds.copy_lens[ps->index] > 0u) {
+      ps->state = 21u;
+    } else {
+      ps->index += 1u;
+      ps->state = 8u;
+    }
+  }
+  return;
+}
 /* END   zcvt state / static */
 
 /* BEGIN zcvt state / public */
 struct tcmplxA_zcvt* tcmplxA_zcvt_new
   ( tcmplxA_uint32 block_size,
     tcmplxA_uint32 n, size_t chain_length)
+{
+  return tcmplxA_zcvt_new_alloc(block_size, n, chain_length, NULL);
+}
+
+struct tcmplxA_zcvt* tcmplxA_zcvt_new_alloc
+  ( tcmplxA_uint32 block_size,
+    tcmplxA_uint32 n, size_t chain_length,
+    struct tcmplxA_allocator const* alloc)
 {
   struct tcmplxA_zcvt* out;
-  out = tcmplxA_util_malloc(sizeof(struct tcmplxA_zcvt));
+  out = tcmplxA_util_allocate(alloc, sizeof(struct tcmplxA_zcvt));
   if (out != NULL
-  &&  tcmplxA_zcvt_init(out, block_size, n, chain_length) != tcmplxA_Success)
+  &&  tcmplxA_zcvt_init(out, block_size, n, chain_length, alloc)
+      != tcmplxA_Success)
   {
-    tcmplxA_util_free(out);
+    tcmplxA_util_deallocate(alloc, out);
     return NULL;
   }
   return out;
 }
 
+struct tcmplxA_zcvt* tcmplxA_zcvt_new_capped
+  ( tcmplxA_uint32 block_size,
+    tcmplxA_uint32 n, size_t chain_length, size_t memory_cap,
+    struct tcmplxA_allocator const* alloc)
+{
+  struct tcmplxA_zcvt* out;
+  tcmplxA_uint32 window = 256u;
+  if (memory_cap == 0u)
+    return NULL;
+  /* zlib windows are powers of two */
+  while (window < 32768u && window*2u <= n)
+    window *= 2u;
+  while (tcmplxA_zcvt_memory_bound(block_size, window, chain_length)
+      > memory_cap)
+  {
+    size_t const chain_bytes = chain_length*251u*sizeof(tcmplxA_uint32);
+    size_t const block_bytes = block_size*3u;
+    /* shrink the largest part that can still shrink */
+    if (window > 256u && window >= chain_bytes && window >= block_bytes)
+      window /= 2u;
+    else if (chain_length > 1u && chain_bytes >= block_bytes)
+      chain_length /= 2u;
+    else if (block_size > 256u)
+      block_size /= 2u;
+    else if (window > 256u)
+      window /= 2u;
+    else if (chain_length > 1u)
+      chain_length /= 2u;
+    else return NULL;
+  }
+  out = tcmplxA_zcvt_new_alloc(block_size, window, chain_length, alloc);
+  if (out != NULL)
+    out->memory_cap = memory_cap;
+  return out;
+}
+
 void tcmplxA_zcvt_destroy(struct tcmplxA_zcvt* x) {
   if (x != NULL) {
+    struct tcmplxA_allocator const* const alloc = x->alloc;
     tcmplxA_zcvt_close(x);
-    tcmplxA_util_free(x);
+    tcmplxA_util_deallocate(alloc, x);
   }
   return;
 }
 
+void tcmplxA_zcvt_reset(struct tcmplxA_zcvt* x) {
+  tcmplxA_blockbuf_reset(x->buffer);
+  tcmplxA_ringdist_reset(x->ring, 0,4u,0u);
+  tcmplxA_ringdist_reset(x->try_ring, 0,4u,0u);
+  x->sequence_list.sz = 0u;
+  tcmplxA_zcvt_restart(x);
+  return;
+}
+
+void tcmplxA_zcvt_set_suffix(struct tcmplxA_zcvt* x, int suffix_tf) {
+  tcmplxA_blockbuf_set_suffix(x->buffer, suffix_tf);
+  return;
+}
+
 int tcmplxA_zcvt_zsrtostr
   ( struct tcmplxA_zcvt* ps, size_t* ret, unsigned char* dst, size_t dstsz,
     unsigned char const** src, unsigned char const* src_end)
@@ -1432,6 +1520,10 @@ int tcmplxA_zcvt_zsrtostr
           ae = tcmplxA_ErrSanitize;
         } else if (cm != 8u || cinfo > 7u) {
           ae = tcmplxA_ErrSanitize;
+        } else if (ps->memory_cap > 0u
+            &&  (256ul<<cinfo) > tcmplxA_blockbuf_extent(ps->buffer))
+        {
+          ae = tcmplxA_ErrMemoryCap;
         } else if (ps->backward & 32u) {
           ae = tcmplxA_Success;
           ps->state = 1;
@@ -1568,6 +1660,26 @@ size_t tcmplxA_zcvt_bypass
   }
 }
 
+int tcmplxA_zcvt_bypass_copy
+  (struct tcmplxA_zcvt* dst, struct tcmplxA_zcvt const* src)
+{
+  if (dst == src)
+    return tcmplxA_Success;
+  else if (dst->state >= 2u || src->state >= 2u)
+    return tcmplxA_ErrParam;
+  else {
+    tcmplxA_uint32 const dict_check =
+      (src->state == 0u) ? src->checksum : src->backward;
+    int const res = tcmplxA_blockbuf_copy_ring(dst->buffer, src->buffer);
+    if (res != tcmplxA_Success)
+      return res;
+    if (dst->state == 0u)
+      dst->checksum = dict_check;
+    else dst->backward = dict_check;
+    return tcmplxA_Success;
+  }
+}
+
 int tcmplxA_zcvt_strrtozs
   ( struct tcmplxA_zcvt* ps, size_t* ret, unsigned char* dst, size_t dstsz,
     unsigned char const** src, unsigned char const* src_end)
@@ -1583,9 +1695,6 @@ int tcmplxA_zcvt_strrtozs
         unsigned int header = 2048u;
         tcmplxA_uint32 const extent = tcmplxA_blockbuf_extent(ps->buffer);
         unsigned int const cinfo = tcmplxA_zcvt_cinfo(extent);
-        ae = tcmplxA_inscopy_lengthsort(ps->values);
-        if (ae != tcmplxA_Success)
-          break;
         if (cinfo > 7u)
           ae = tcmplxA_ErrSanitize;
         header |= ((cinfo<<12)
@@ -1679,6 +1788,7 @@ int tcmplxA_zcvt_strrtozs
     case 18: /* copy zero length + 11 */
     case 19: /* generate code trees */
     case 20:
+    case 21:
       ae = tcmplxA_zcvt_strrtozs_bits(ps, dst+ret_out, &p, src_end);
       break;
     }
@@ -1698,4 +1808,34 @@ int tcmplxA_zcvt_delimrtozs
   /* set the end flag: */ps->h_end |= 2u;
   return tcmplxA_zcvt_strrtozs(ps, ret, dst, dstsz, &tmp_src, tmp);
 }
+
+size_t tcmplxA_zcvt_memory_usage(struct tcmplxA_zcvt const* x) {
+  return sizeof(struct tcmplxA_zcvt)
+    + tcmplxA_blockbuf_memory_usage(x->buffer)
+    + tcmplxA_fixlist_memory_usage(x->literals)
+    + tcmplxA_fixlist_memory_usage(x->distances)
+    + tcmplxA_fixlist_memory_usage(x->sequence)
+    + tcmplxA_ringdist_memory_usage(x->ring)
+    + tcmplxA_ringdist_memory_usage(x->try_ring)
+    + tcmplxA_ZCvt_HistogramSize*sizeof(tcmplxA_uint32)
+    + x->sequence_list.cap;
+}
+
+size_t tcmplxA_zcvt_memory_bound
+  ( tcmplxA_uint32 block_size,
+    tcmplxA_uint32 n, size_t chain_length)
+{
+  size_t const buffer =
+    tcmplxA_blockbuf_memory_bound(block_size, n, chain_length);
+  if (buffer == (size_t)-1)
+    return (size_t)-1;
+  return sizeof(struct tcmplxA_zcvt) + buffer
+    + tcmplxA_fixlist_memory_bound(288u)
+    + tcmplxA_fixlist_memory_bound(32u)
+    + tcmplxA_fixlist_memory_bound(19u)
+    + tcmplxA_ringdist_memory_bound()*2u
+    + tcmplxA_ZCvt_HistogramSize*sizeof(tcmplxA_uint32)
+    /* tree description, doubled once past its initial capacity */
+    + (286u+30u)*2u;
+}
 /* END   zcvt state / public */
@@ -6,7 +6,7 @@ int main(int argc, char **argv) {
   fprintf(stdout, "text-complex version: %s\n", tcmplxA_api_version());
   /* error code "test" */ {
     int pre_v;
-    for (pre_v = -13; pre_v <= 2; ++pre_v) {
+    for (pre_v = -14; pre_v <= 2; ++pre_v) {
       enum tcmplxA_api_error v = (enum tcmplxA_api_error)pre_v;
       char const* v_text = tcmplxA_api_error_toa(v);
       fprintf(stdout, "error value %i: %s\n", v,
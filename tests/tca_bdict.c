@@ -1,5 +1,6 @@
 
 #include "text-complex/access/bdict.h"
+#include "text-complex/access/api.h"
 #include "munit/munit.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -14,6 +15,8 @@ static MunitResult test_bdict_transform_ferment
     (const MunitParameter params[], void* data);
 static MunitResult test_bdict_transform_affix
     (const MunitParameter params[], void* data);
+static MunitResult test_bdict_transform_copy
+    (const MunitParameter params[], void* data);
 
 /**
  * @brief Resumable CRC32 calculator.
@@ -64,6 +67,8 @@ static MunitTest tests_bdict[] = {
     NULL,NULL,0,NULL},
   {"transform/affix", test_bdict_transform_affix,
     NULL,NULL,0,NULL},
+  {"transform/copy", test_bdict_transform_copy,
+    NULL,NULL,0,NULL},
   {NULL, NULL, NULL,NULL,0,NULL}
 };
 
@@ -402,6 +407,28 @@ MunitResult test_bdict_transform_affix
   return MUNIT_OK;
 };
 
+MunitResult test_bdict_transform_copy
+  (const MunitParameter params[], void* data)
+{
+  unsigned int const transform_index = munit_rand_int_range(0,120);
+  unsigned int const word_len = munit_rand_int_range(4,24);
+  unsigned int const word_index =
+    munit_rand_int_range(0,tcmplxA_bdict_word_count(word_len)-1);
+  unsigned char const* const word =
+    tcmplxA_bdict_get_word(word_len, word_index);
+  unsigned char a_word[38], b_word[38];
+  unsigned int a_word_len = word_len, b_word_len = 0;
+  munit_assert_ptr_not_null(word);
+  memcpy(a_word, word, word_len);
+  munit_assert_int(tcmplxA_bdict_transform
+    (a_word, &a_word_len, transform_index),==,tcmplxA_Success);
+  munit_assert_int(tcmplxA_bdict_transform_copy
+    (b_word, &b_word_len, word, word_len, transform_index),==,tcmplxA_Success);
+  munit_assert_uint(b_word_len,==,a_word_len);
+  munit_assert_memory_equal(a_word_len,a_word,b_word);
+  return MUNIT_OK;
+}
+
 
 int main(int argc, char **argv) {
   return munit_suite_main(&suite_bdict, NULL, argc, argv);
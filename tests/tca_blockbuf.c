@@ -21,6 +21,16 @@ static MunitResult test_blockbuf_bypass
   (const MunitParameter params[], void* data);
 static MunitResult test_blockbuf_add
   (const MunitParameter params[], void* data);
+static MunitResult test_blockbuf_commands
+  (const MunitParameter params[], void* data);
+static MunitResult test_blockbuf_hold
+  (const MunitParameter params[], void* data);
+static MunitResult test_blockbuf_probe
+  (const MunitParameter params[], void* data);
+static MunitResult test_blockbuf_far
+  (const MunitParameter params[], void* data);
+static MunitResult test_blockbuf_suffix
+  (const MunitParameter params[], void* data);
 static void* test_blockbuf_setup
     (const MunitParameter params[], void* user_data);
 static void test_blockbuf_teardown(void* fixture);
@@ -42,6 +52,12 @@ static MunitTest tests_blockbuf[] = {
     test_blockbuf_setup,test_blockbuf_teardown,0,NULL},
   {"add", test_blockbuf_add,
     test_blockbuf_setup,test_blockbuf_teardown,0,NULL},
+  {"commands", test_blockbuf_commands, NULL,NULL,0,NULL},
+  {"hold", test_blockbuf_hold,
+    test_blockbuf_setup,test_blockbuf_teardown,0,NULL},
+  {"probe", test_blockbuf_probe, NULL,NULL,0,NULL},
+  {"far", test_blockbuf_far, NULL,NULL,0,NULL},
+  {"suffix", test_blockbuf_suffix, NULL,NULL,0,NULL},
   {NULL, NULL, NULL,NULL,0,NULL}
 };
 
@@ -290,6 +306,233 @@ MunitResult test_blockbuf_add
   return MUNIT_OK;
 }
 
+MunitResult test_blockbuf_hold
+  (const MunitParameter params[], void* data)
+{
+  struct tcmplxA_blockbuf* const p = (struct tcmplxA_blockbuf*)data;
+  int write_count;
+  int keep_count;
+  unsigned char buf[64];
+  if (p == NULL)
+    return MUNIT_SKIP;
+  (void)params;
+  write_count = munit_rand_int_range(1,64);
+  if ((tcmplxA_uint32)write_count > tcmplxA_blockbuf_capacity(p))
+    write_count = (int)tcmplxA_blockbuf_capacity(p);
+  keep_count = munit_rand_int_range(0,write_count);
+  munit_rand_memory(write_count, (munit_uint8_t*)buf);
+  munit_assert_int(tcmplxA_blockbuf_write(p, buf, write_count),
+    ==, tcmplxA_Success);
+  munit_assert_int(tcmplxA_blockbuf_hold_input(p, write_count+1),
+    ==, tcmplxA_ErrParam);
+  munit_assert_int(tcmplxA_blockbuf_hold_input(p, keep_count),
+    ==, tcmplxA_Success);
+  munit_assert_uint32(tcmplxA_blockbuf_input_size(p), ==, keep_count);
+  munit_assert_memory_equal(keep_count, tcmplxA_blockbuf_input_data(p), buf);
+  /* the held bytes come back as the next input */
+  tcmplxA_blockbuf_clear_input(p);
+  munit_assert_uint32(tcmplxA_blockbuf_input_size(p),
+    ==, write_count-keep_count);
+  munit_assert_memory_equal(write_count-keep_count,
+    tcmplxA_blockbuf_input_data(p), buf+keep_count);
+  tcmplxA_blockbuf_clear_input(p);
+  munit_assert_uint32(tcmplxA_blockbuf_input_size(p), ==, 0);
+  return MUNIT_OK;
+}
+
+MunitResult test_blockbuf_commands
+  (const MunitParameter params[], void* data)
+{
+  struct tcmplxA_blockbuf* const p = tcmplxA_blockbuf_new(1024,4096,16,0);
+  int const period = munit_rand_int_range(1,16);
+  int const noise = munit_rand_int_range(0,64);
+  unsigned char buf[1024];
+  unsigned char out[1024];
+  size_t out_len = 0;
+  (void)params;
+  (void)data;
+  if (p == NULL)
+    return MUNIT_SKIP;
+  tcmplxA_blockbuf_set_recent(p, munit_rand_int_range(0,1));
+  tcmplxA_blockbuf_set_greedy(p, munit_rand_int_range(0,1));
+  tcmplxA_blockbuf_set_skip(p, munit_rand_int_range(0,1));
+  tcmplxA_blockbuf_set_suffix(p, munit_rand_int_range(0,1));
+  /* fill the buffer */{
+    int i;
+    munit_rand_memory(period, (munit_uint8_t*)buf);
+    for (i = period; i < 1024; ++i)
+      buf[i] = buf[i-period];
+    munit_rand_memory(noise, (munit_uint8_t*)buf+512);
+  }
+  /* */{
+    int res;
+    res = tcmplxA_blockbuf_write(p, buf, sizeof(buf));
+    munit_assert_int(res, ==, tcmplxA_Success);
+    res = tcmplxA_blockbuf_try_commands(p);
+    munit_assert_int(res, ==, tcmplxA_Success);
+    munit_assert_uint32(tcmplxA_blockbuf_output_size(p), ==, 0u);
+  }
+  /* replay the commands */{
+    struct tcmplxA_blockcmds const cmds = tcmplxA_blockbuf_commands(p);
+    size_t i;
+    tcmplxA_uint32 literal_pos = 0u;
+    munit_assert_size(cmds.count, >, 0u);
+    for (i = 0; i < cmds.count; ++i) {
+      tcmplxA_uint32 j;
+      munit_assert_uint32(cmds.literal_offsets[i], ==, literal_pos);
+      munit_assert_size(out_len+cmds.insert_lens[i]+cmds.copy_lens[i],
+        <=, sizeof(out));
+      for (j = 0u; j < cmds.insert_lens[i]; ++j)
+        out[out_len++] = cmds.literals[literal_pos++];
+      if (cmds.copy_lens[i] == 0u) {
+        munit_assert_size(i+1u, ==, cmds.count);
+        continue;
+      }
+      munit_assert_uint32(cmds.distances[i], <, out_len);
+      for (j = 0u; j < cmds.copy_lens[i]; ++j, ++out_len)
+        out[out_len] = out[out_len-cmds.distances[i]-1u];
+    }
+    munit_assert_size(out_len, ==, sizeof(buf));
+    munit_assert_memory_equal(sizeof(buf), out, buf);
+  }
+  /* clear */{
+    tcmplxA_blockbuf_clear_output(p);
+    munit_assert_size(tcmplxA_blockbuf_commands(p).count, ==, 0u);
+  }
+  tcmplxA_blockbuf_destroy(p);
+  return MUNIT_OK;
+}
+
+MunitResult test_blockbuf_probe
+  (const MunitParameter params[], void* data)
+{
+  struct tcmplxA_blockbuf* const p = tcmplxA_blockbuf_new(4096,4096,16,0);
+  int const period = munit_rand_int_range(1,64);
+  unsigned char buf[4096];
+  (void)params;
+  (void)data;
+  if (p == NULL)
+    return MUNIT_SKIP;
+  /* random bytes look flat */{
+    int res;
+    munit_rand_memory(sizeof(buf), (munit_uint8_t*)buf);
+    res = tcmplxA_blockbuf_write(p, buf, sizeof(buf));
+    munit_assert_int(res, ==, tcmplxA_Success);
+    munit_assert_int(tcmplxA_blockbuf_probe_flat(p), !=, 0);
+    tcmplxA_blockbuf_clear_input(p);
+  }
+  /* random bytes already in the window do not */{
+    int res;
+    munit_assert_size(tcmplxA_blockbuf_bypass(p, buf, sizeof(buf)),
+      ==, sizeof(buf));
+    res = tcmplxA_blockbuf_write(p, buf, sizeof(buf));
+    munit_assert_int(res, ==, tcmplxA_Success);
+    munit_assert_int(tcmplxA_blockbuf_probe_flat(p), ==, 0);
+    tcmplxA_blockbuf_clear_input(p);
+  }
+  /* too short to sample */{
+    int res;
+    res = tcmplxA_blockbuf_write(p, buf, 512);
+    munit_assert_int(res, ==, tcmplxA_Success);
+    munit_assert_int(tcmplxA_blockbuf_probe_flat(p), ==, 0);
+    tcmplxA_blockbuf_clear_input(p);
+  }
+  /* repeats do not */{
+    int res;
+    int i;
+    for (i = period; i < (int)sizeof(buf); ++i)
+      buf[i] = buf[i-period];
+    res = tcmplxA_blockbuf_write(p, buf, sizeof(buf));
+    munit_assert_int(res, ==, tcmplxA_Success);
+    munit_assert_int(tcmplxA_blockbuf_probe_flat(p), ==, 0);
+  }
+  tcmplxA_blockbuf_destroy(p);
+  return MUNIT_OK;
+}
+
+MunitResult test_blockbuf_far
+  (const MunitParameter params[], void* data)
+{
+  struct tcmplxA_blockbuf* const p = tcmplxA_blockbuf_new(4096,131072,4,0);
+  int const gap = munit_rand_int_range(4,24);
+  unsigned char text[4096];
+  unsigned char noise[4096];
+  (void)params;
+  (void)data;
+  if (p == NULL)
+    return MUNIT_SKIP;
+  munit_rand_memory(sizeof(text), (munit_uint8_t*)text);
+  /* the text, then noise far past the hash chain's reach */{
+    int i;
+    size_t n;
+    n = tcmplxA_blockbuf_bypass(p, text, sizeof(text));
+    munit_assert_size(n, ==, sizeof(text));
+    for (i = 0; i < gap; ++i) {
+      munit_rand_memory(sizeof(noise), (munit_uint8_t*)noise);
+      n = tcmplxA_blockbuf_bypass(p, noise, sizeof(noise));
+      munit_assert_size(n, ==, sizeof(noise));
+    }
+  }
+  /* the text again */{
+    int res;
+    struct tcmplxA_blockcmds cmds;
+    size_t i;
+    tcmplxA_uint32 copied = 0u;
+    res = tcmplxA_blockbuf_write(p, text, sizeof(text));
+    munit_assert_int(res, ==, tcmplxA_Success);
+    /* random, but not flat, since the window holds it */
+    munit_assert_int(tcmplxA_blockbuf_probe_flat(p), ==, 0);
+    res = tcmplxA_blockbuf_try_commands(p);
+    munit_assert_int(res, ==, tcmplxA_Success);
+    cmds = tcmplxA_blockbuf_commands(p);
+    for (i = 0u; i < cmds.count; ++i) {
+      if (cmds.distances[i] == (gap+1)*4096u-1u)
+        copied += cmds.copy_lens[i];
+    }
+    /* most of the text comes from far back */
+    munit_assert_uint32(copied, >=, sizeof(text)/2u);
+  }
+  tcmplxA_blockbuf_destroy(p);
+  return MUNIT_OK;
+}
+
+MunitResult test_blockbuf_suffix
+  (const MunitParameter params[], void* data)
+{
+  struct tcmplxA_blockbuf* const p = tcmplxA_blockbuf_new(512,4096,16,0);
+  unsigned char text[512];
+  (void)params;
+  (void)data;
+  if (p == NULL)
+    return MUNIT_SKIP;
+  tcmplxA_blockbuf_set_suffix(p, 1);
+  munit_rand_memory(sizeof(text), (munit_uint8_t*)text);
+  /* the text */{
+    int res;
+    res = tcmplxA_blockbuf_write(p, text, sizeof(text));
+    munit_assert_int(res, ==, tcmplxA_Success);
+    res = tcmplxA_blockbuf_try_commands(p);
+    munit_assert_int(res, ==, tcmplxA_Success);
+    tcmplxA_blockbuf_clear_output(p);
+    tcmplxA_blockbuf_clear_input(p);
+  }
+  /* the text again, as one copy from the window */{
+    int res;
+    struct tcmplxA_blockcmds cmds;
+    res = tcmplxA_blockbuf_write(p, text, sizeof(text));
+    munit_assert_int(res, ==, tcmplxA_Success);
+    res = tcmplxA_blockbuf_try_commands(p);
+    munit_assert_int(res, ==, tcmplxA_Success);
+    cmds = tcmplxA_blockbuf_commands(p);
+    munit_assert_size(cmds.count, ==, 1u);
+    munit_assert_uint32(cmds.insert_lens[0], ==, 0u);
+    munit_assert_uint32(cmds.copy_lens[0], ==, sizeof(text));
+    munit_assert_uint32(cmds.distances[0], ==, sizeof(text)-1u);
+  }
+  tcmplxA_blockbuf_destroy(p);
+  return MUNIT_OK;
+}
+
 
 
 int main(int argc, char **argv) {
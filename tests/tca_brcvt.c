@@ -5,6 +5,7 @@
 #include "text-complex/access/brcvt.h"
 #include "text-complex/access/zutil.h"
 #include "text-complex/access/brmeta.h"
+#include "text-complex/access/util.h"
 #include "munit/munit.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -23,9 +24,62 @@ static MunitResult test_brcvt_zsrtostr_none
   (const MunitParameter params[], void* data);
 static MunitResult test_brcvt_flush
   (const MunitParameter params[], void* data);
+static MunitResult test_brcvt_bypass_copy
+  (const MunitParameter params[], void* data);
+static MunitResult test_brcvt_reset
+  (const MunitParameter params[], void* data);
+static MunitResult test_brcvt_quick
+  (const MunitParameter params[], void* data);
+static MunitResult test_brcvt_quick_stream
+  (const MunitParameter params[], void* data);
+static MunitResult test_brcvt_short_input
+  (const MunitParameter params[], void* data);
+static MunitResult test_brcvt_memory
+  (const MunitParameter params[], void* data);
+static MunitResult test_brcvt_alloc
+  (const MunitParameter params[], void* data);
+static MunitResult test_brcvt_no_literals
+  (const MunitParameter params[], void* data);
+static MunitResult test_brcvt_literal_types
+  (const MunitParameter params[], void* data);
+static MunitResult test_brcvt_zero_bit_copy
+  (const MunitParameter params[], void* data);
+static MunitResult test_brcvt_zero_bit_partial
+  (const MunitParameter params[], void* data);
+static MunitResult test_brcvt_dict_word_end
+  (const MunitParameter params[], void* data);
+static MunitResult test_brcvt_single_clen
+  (const MunitParameter params[], void* data);
+static MunitResult test_brcvt_implicit_distance
+  (const MunitParameter params[], void* data);
+static MunitResult test_brcvt_literal_split
+  (const MunitParameter params[], void* data);
+static MunitResult test_brcvt_literal_contexts
+  (const MunitParameter params[], void* data);
+static MunitResult test_brcvt_distance_postfix
+  (const MunitParameter params[], void* data);
+static MunitResult test_brcvt_estimate
+  (const MunitParameter params[], void* data);
 static void* test_brcvt_setup
     (const MunitParameter params[], void* user_data);
 static void test_brcvt_teardown(void* fixture);
+static void test_brcvt_skip_header
+  (unsigned char const* buf, size_t* pos);
+static unsigned char* test_brcvt_pack
+  ( struct tcmplxA_brcvt* enc, unsigned char const* text, size_t text_len,
+    size_t* buf_len);
+static unsigned long int test_brcvt_get_bits
+  (unsigned char const* buf, size_t* pos, unsigned int count);
+static void test_brcvt_unpack
+  ( struct tcmplxA_brcvt* dec, unsigned char const* buf, size_t buf_len,
+    unsigned char const* text, size_t text_len, size_t step);
+static void test_brcvt_put_bits
+  (unsigned char* buf, size_t* pos, unsigned long int bits, unsigned int count);
+static size_t test_brcvt_round_trip
+  ( struct tcmplxA_brcvt* enc, struct tcmplxA_brcvt* dec,
+    unsigned char const* text, size_t text_len);
+static void* test_brcvt_count_allocate(void* userdata, size_t sz);
+static void test_brcvt_count_deallocate(void* userdata, void* x);
 
 static MunitParameterEnum test_brcvt_params[] = {
   { NULL, NULL },
@@ -44,6 +98,37 @@ static MunitTest tests_brcvt[] = {
     test_brcvt_setup,test_brcvt_teardown,0,NULL},
   {"flush", test_brcvt_flush,
     test_brcvt_setup,test_brcvt_teardown,0,NULL},
+  {"bypass_copy", test_brcvt_bypass_copy,
+    test_brcvt_setup,test_brcvt_teardown,0,NULL},
+  {"reset", test_brcvt_reset,
+    test_brcvt_setup,test_brcvt_teardown,0,NULL},
+  {"quick", test_brcvt_quick,
+    test_brcvt_setup,test_brcvt_teardown,0,NULL},
+  {"quick_stream", test_brcvt_quick_stream, NULL,NULL,0,NULL},
+  {"short_input", test_brcvt_short_input, NULL,NULL,0,NULL},
+  {"memory", test_brcvt_memory,
+    test_brcvt_setup,test_brcvt_teardown,0,NULL},
+  {"alloc", test_brcvt_alloc, NULL,NULL,0,NULL},
+  {"no_literals", test_brcvt_no_literals, NULL,NULL,0,NULL},
+  {"literal_types", test_brcvt_literal_types, NULL,NULL,0,NULL},
+  {"zero_bit_copy", test_brcvt_zero_bit_copy,
+    test_brcvt_setup,test_brcvt_teardown,MUNIT_TEST_OPTION_SINGLE_ITERATION,NULL},
+  {"zero_bit_partial", test_brcvt_zero_bit_partial,
+    test_brcvt_setup,test_brcvt_teardown,MUNIT_TEST_OPTION_SINGLE_ITERATION,NULL},
+  {"dict_word_end", test_brcvt_dict_word_end,
+    test_brcvt_setup,test_brcvt_teardown,MUNIT_TEST_OPTION_SINGLE_ITERATION,NULL},
+  {"single_clen", test_brcvt_single_clen,
+    test_brcvt_setup,test_brcvt_teardown,MUNIT_TEST_OPTION_SINGLE_ITERATION,NULL},
+  {"implicit_distance", test_brcvt_implicit_distance,
+    test_brcvt_setup,test_brcvt_teardown,MUNIT_TEST_OPTION_SINGLE_ITERATION,NULL},
+  {"literal_split", test_brcvt_literal_split,
+    NULL,NULL,MUNIT_TEST_OPTION_SINGLE_ITERATION,NULL},
+  {"literal_contexts", test_brcvt_literal_contexts,
+    NULL,NULL,MUNIT_TEST_OPTION_SINGLE_ITERATION,NULL},
+  {"distance_postfix", test_brcvt_distance_postfix,
+    NULL,NULL,MUNIT_TEST_OPTION_SINGLE_ITERATION,NULL},
+  {"estimate", test_brcvt_estimate,
+    NULL,NULL,MUNIT_TEST_OPTION_SINGLE_ITERATION,NULL},
   {NULL, NULL, NULL,NULL,0,NULL}
 };
 
@@ -75,6 +160,155 @@ void test_brcvt_teardown(void* fixture) {
   return;
 }
 
+void test_brcvt_skip_header(unsigned char const* buf, size_t* pos) {
+  unsigned long int is_last;
+  unsigned long int nibbles;
+  /* WBITS */
+  if (test_brcvt_get_bits(buf, pos, 1) && !test_brcvt_get_bits(buf, pos, 3))
+    test_brcvt_get_bits(buf, pos, 3);
+  is_last = test_brcvt_get_bits(buf, pos, 1);
+  if (is_last)
+    munit_assert_ulong(test_brcvt_get_bits(buf, pos, 1), ==, 0u);
+  nibbles = test_brcvt_get_bits(buf, pos, 2);
+  munit_assert_ulong(nibbles, <, 3u);
+  *pos += (size_t)(nibbles+4u)*4u;
+  if (!is_last)
+    munit_assert_ulong(test_brcvt_get_bits(buf, pos, 1), ==, 0u);
+  return;
+}
+
+unsigned char* test_brcvt_pack
+  ( struct tcmplxA_brcvt* enc, unsigned char const* text, size_t text_len,
+    size_t* buf_len)
+{
+  size_t const buf_cap = text_len*2u + 1024u;
+  unsigned char* const buf = (unsigned char*)munit_malloc(buf_cap);
+  unsigned char const* text_p = text;
+  int res;
+  *buf_len = 0;
+  while (text_p < text+text_len) {
+    size_t exbuf_len = 0;
+    res = tcmplxA_brcvt_strrtozs(enc, &exbuf_len,
+      buf+*buf_len, buf_cap-*buf_len, &text_p, text+text_len);
+    munit_assert_int(res, >=, tcmplxA_Success);
+    *buf_len += exbuf_len;
+    munit_assert_size(*buf_len, <, buf_cap);
+  }
+  do {
+    size_t exbuf_len = 0;
+    res = tcmplxA_brcvt_delimrtozs(enc, &exbuf_len,
+      buf+*buf_len, buf_cap-*buf_len);
+    munit_assert_int(res, >=, tcmplxA_Success);
+    *buf_len += exbuf_len;
+    munit_assert_size(*buf_len, <, buf_cap);
+  } while (res != tcmplxA_EOF);
+  return buf;
+}
+
+unsigned long int test_brcvt_get_bits
+  (unsigned char const* buf, size_t* pos, unsigned int count)
+{
+  unsigned long int out = 0;
+  unsigned int i;
+  for (i = 0; i < count; ++i, ++*pos)
+    out |= (unsigned long int)((buf[*pos/8u]>>(*pos%8u))&1u) << i;
+  return out;
+}
+
+void test_brcvt_unpack
+  ( struct tcmplxA_brcvt* dec, unsigned char const* buf, size_t buf_len,
+    unsigned char const* text, size_t text_len, size_t step)
+{
+  unsigned char* const dummy = (unsigned char*)munit_malloc(text_len+step);
+  size_t dummy_len = 0;
+  unsigned char const* buf_ptr = buf;
+  int res;
+  do {
+    size_t exdummy_len = 0;
+    res = tcmplxA_brcvt_zsrtostr(dec, &exdummy_len,
+      dummy+dummy_len, step, &buf_ptr, buf+buf_len);
+    munit_assert_int(res, >=, tcmplxA_Success);
+    dummy_len += exdummy_len;
+    munit_assert_size(dummy_len, <=, text_len);
+    /* a short stream stops with input left to want */
+    munit_assert_true(res != tcmplxA_Success || buf_ptr < buf+buf_len);
+  } while (res != tcmplxA_EOF);
+  munit_assert_size(dummy_len, ==, text_len);
+  munit_assert_memory_equal(text_len, dummy, text);
+  free(dummy);
+  return;
+}
+
+void test_brcvt_put_bits
+  (unsigned char* buf, size_t* pos, unsigned long int bits, unsigned int count)
+{
+  unsigned int i;
+  for (i = 0; i < count; ++i, ++*pos) {
+    if ((bits>>i)&1u)
+      buf[*pos/8u] |= (unsigned char)(1u<<(*pos%8u));
+  }
+  return;
+}
+
+size_t test_brcvt_round_trip
+  ( struct tcmplxA_brcvt* enc, struct tcmplxA_brcvt* dec,
+    unsigned char const* text, size_t text_len)
+{
+  size_t const buf_cap = text_len*2u + 1024u;
+  unsigned char* const buf = (unsigned char*)munit_malloc(buf_cap);
+  unsigned char* const dummy = (unsigned char*)munit_malloc(text_len+1u);
+  size_t buf_len = 0;
+  size_t dummy_len = 0;
+  /* encode */{
+    unsigned char const* text_p = text;
+    int res;
+    while (text_p < text+text_len) {
+      size_t exbuf_len = 0;
+      res = tcmplxA_brcvt_strrtozs(enc, &exbuf_len,
+        buf+buf_len, buf_cap-buf_len, &text_p, text+text_len);
+      munit_assert_int(res, >=, tcmplxA_Success);
+      buf_len += exbuf_len;
+      munit_assert_size(buf_len, <, buf_cap);
+    }
+    do {
+      size_t exbuf_len = 0;
+      res = tcmplxA_brcvt_delimrtozs(enc, &exbuf_len,
+        buf+buf_len, buf_cap-buf_len);
+      munit_assert_int(res, >=, tcmplxA_Success);
+      buf_len += exbuf_len;
+      munit_assert_size(buf_len, <, buf_cap);
+    } while (res != tcmplxA_EOF);
+  }
+  /* decode */{
+    unsigned char const* buf_ptr = buf;
+    while (buf_ptr < buf+buf_len) {
+      size_t exdummy_len = 0;
+      int const res = tcmplxA_brcvt_zsrtostr(dec, &exdummy_len,
+        dummy+dummy_len, text_len+1u-dummy_len, &buf_ptr, buf+buf_len);
+      munit_assert_int(res, >=, tcmplxA_Success);
+      dummy_len += exdummy_len;
+    }
+    munit_assert_size(dummy_len, ==, text_len);
+    munit_assert_memory_equal(text_len, dummy, text);
+  }
+  free(dummy);
+  free(buf);
+  return buf_len;
+}
+
+void* test_brcvt_count_allocate(void* userdata, size_t sz) {
+  void* const out = malloc(sz);
+  if (out != NULL)
+    *(long int*)userdata += 1;
+  return out;
+}
+
+void test_brcvt_count_deallocate(void* userdata, void* x) {
+  if (x != NULL)
+    *(long int*)userdata -= 1;
+  free(x);
+}
+
 MunitResult test_brcvt_item
   (const MunitParameter params[], void* data)
 {
@@ -255,6 +489,800 @@ MunitResult test_brcvt_flush
   return MUNIT_OK;
 }
 
+MunitResult test_brcvt_bypass_copy
+  (const MunitParameter params[], void* data)
+{
+  struct tcmplxA_brcvt* const p = (struct tcmplxA_brcvt*)data;
+  struct tcmplxA_brcvt* const q = tcmplxA_brcvt_new(4096,4096,4096);
+  struct tcmplxA_brcvt* const snapshot = tcmplxA_brcvt_new(4096,4096,4096);
+  unsigned char dict[64] = {0};
+  int const text_pos = munit_rand_int_range(0,32);
+  int const text_len = munit_rand_int_range(3,32);
+  unsigned char buf[256] = {0};
+  size_t buf_len = 0;
+  munit_rand_memory(sizeof(dict), &dict[0]);
+  if (p == NULL || q == NULL || snapshot == NULL) {
+    tcmplxA_brcvt_destroy(snapshot);
+    tcmplxA_brcvt_destroy(q);
+    return MUNIT_SKIP;
+  }
+  (void)params;
+  /* prime */
+  {
+    int res;
+    munit_assert_size(tcmplxA_brcvt_bypass(snapshot, dict, sizeof(dict)),
+      ==, sizeof(dict));
+    res = tcmplxA_brcvt_bypass_copy(p, snapshot);
+    munit_assert_int(res, ==, tcmplxA_Success);
+    munit_assert_size(tcmplxA_brcvt_bypass(q, dict, sizeof(dict)),
+      ==, sizeof(dict));
+  }
+  /* encode */
+  {
+    unsigned char const *text_p = dict+text_pos;
+    size_t exbuf_len = 0;
+    int res;
+    res = tcmplxA_brcvt_strrtozs(p, &buf_len, buf, sizeof(buf),
+      &text_p, dict+text_pos+text_len);
+    munit_assert(res == tcmplxA_ErrPartial);
+    munit_assert(buf_len <= sizeof(buf));
+    res = tcmplxA_brcvt_delimrtozs(p, &exbuf_len,
+      buf+buf_len, sizeof(buf)-buf_len);
+    munit_assert(res >= tcmplxA_Success);
+    munit_assert(exbuf_len <= sizeof(buf)-buf_len);
+    buf_len += exbuf_len;
+  }
+  /* the snapshot stays usable */
+  {
+    munit_assert_int(tcmplxA_brcvt_bypass_copy(q, snapshot), ==,
+      tcmplxA_Success);
+  }
+  /* decode */
+  {
+    unsigned char dummy[32] = {0};
+    size_t dummy_len = 0;
+    int res;
+    unsigned char const* buf_ptr = buf;
+    res = tcmplxA_brcvt_zsrtostr(q, &dummy_len, dummy, sizeof(dummy),
+      &buf_ptr, buf+buf_len);
+    munit_assert(res >= tcmplxA_Success);
+    munit_assert(dummy_len == (size_t)text_len);
+    munit_assert_memory_equal(text_len, dummy, dict+text_pos);
+  }
+  tcmplxA_brcvt_destroy(snapshot);
+  tcmplxA_brcvt_destroy(q);
+  return MUNIT_OK;
+}
+
+MunitResult test_brcvt_reset
+  (const MunitParameter params[], void* data)
+{
+  struct tcmplxA_brcvt* const p = (struct tcmplxA_brcvt*)data;
+  struct tcmplxA_brcvt* const q = tcmplxA_brcvt_new(4096,4096,4096);
+  unsigned char text[64] = {0};
+  int const text_len = munit_rand_int_range(1,64);
+  unsigned char buf[2][256] = {{0}};
+  size_t buf_len[2] = {0};
+  int k;
+  munit_rand_memory(sizeof(text)/2, &text[0]);
+  memcpy(text+sizeof(text)/2, text, sizeof(text)/2);
+  if (p == NULL || q == NULL) {
+    tcmplxA_brcvt_destroy(q);
+    return MUNIT_SKIP;
+  }
+  (void)params;
+  for (k = 0; k < 2; ++k) {
+    /* encode */{
+      unsigned char const *text_p = text;
+      size_t exbuf_len = 0;
+      int res;
+      res = tcmplxA_brcvt_strrtozs(p, &buf_len[k], buf[k], sizeof(buf[k]),
+        &text_p, text+text_len);
+      munit_assert(res == tcmplxA_ErrPartial);
+      res = tcmplxA_brcvt_delimrtozs(p, &exbuf_len,
+        buf[k]+buf_len[k], sizeof(buf[k])-buf_len[k]);
+      munit_assert(res >= tcmplxA_Success);
+      buf_len[k] += exbuf_len;
+    }
+    /* decode */{
+      unsigned char dummy[64] = {0};
+      size_t dummy_len = 0;
+      int res;
+      unsigned char const* buf_ptr = buf[k];
+      res = tcmplxA_brcvt_zsrtostr(q, &dummy_len, dummy, sizeof(dummy),
+        &buf_ptr, buf[k]+buf_len[k]);
+      munit_assert(res >= tcmplxA_Success);
+      munit_assert(dummy_len == (size_t)text_len);
+      munit_assert_memory_equal(text_len, dummy, text);
+    }
+    tcmplxA_brcvt_reset(p);
+    tcmplxA_brcvt_reset(q);
+  }
+  /* a reset state behaves as a new state */
+  munit_assert_size(buf_len[0], ==, buf_len[1]);
+  munit_assert_memory_equal(buf_len[0], buf[0], buf[1]);
+  tcmplxA_brcvt_destroy(q);
+  return MUNIT_OK;
+}
+
+MunitResult test_brcvt_quick
+  (const MunitParameter params[], void* data)
+{
+  struct tcmplxA_brcvt* const p = (struct tcmplxA_brcvt*)data;
+  struct tcmplxA_brcvt* const q = tcmplxA_brcvt_new(4096,4096,4096);
+  unsigned char text[96] = {0};
+  int const text_len = munit_rand_int_range(1,96);
+  unsigned char buf[256] = {0};
+  size_t buf_len = 0;
+  munit_rand_memory(sizeof(text)/3, &text[0]);
+  memcpy(text+sizeof(text)/3, text, sizeof(text)/3);
+  memcpy(text+2*sizeof(text)/3, text, sizeof(text)/3);
+  if (p == NULL || q == NULL) {
+    tcmplxA_brcvt_destroy(q);
+    return MUNIT_SKIP;
+  }
+  (void)params;
+  tcmplxA_brcvt_set_quick(p, 1);
+  /* encode */{
+    unsigned char const *text_p = text;
+    size_t exbuf_len = 0;
+    int res;
+    res = tcmplxA_brcvt_strrtozs(p, &buf_len, buf, sizeof(buf),
+      &text_p, text+text_len);
+    munit_assert(res == tcmplxA_ErrPartial);
+    res = tcmplxA_brcvt_delimrtozs(p, &exbuf_len,
+      buf+buf_len, sizeof(buf)-buf_len);
+    munit_assert(res >= tcmplxA_Success);
+    buf_len += exbuf_len;
+  }
+  /* decode */{
+    unsigned char dummy[96] = {0};
+    size_t dummy_len = 0;
+    int res;
+    unsigned char const* buf_ptr = buf;
+    res = tcmplxA_brcvt_zsrtostr(q, &dummy_len, dummy, sizeof(dummy),
+      &buf_ptr, buf+buf_len);
+    munit_assert(res >= tcmplxA_Success);
+    munit_assert(dummy_len == (size_t)text_len);
+    munit_assert_memory_equal(text_len, dummy, text);
+  }
+  tcmplxA_brcvt_destroy(q);
+  return MUNIT_OK;
+}
+
+MunitResult test_brcvt_quick_stream
+  (const MunitParameter params[], void* data)
+{
+  size_t const text_len = 65536;
+  struct tcmplxA_brcvt* const p = tcmplxA_brcvt_new(16384,32768,16);
+  struct tcmplxA_brcvt* const q = tcmplxA_brcvt_new(4096,32768,4096);
+  unsigned char* const text = (unsigned char*)munit_malloc(text_len);
+  size_t const buf_cap = text_len*2u + 1024u;
+  unsigned char* const buf = (unsigned char*)munit_malloc(buf_cap);
+  static char const* const words[8] = {
+    "stream ", "quick ", "block ", "tree ",
+    "match ", "count ", "code ", "bits "
+  };
+  size_t buf_len = 0;
+  size_t i = 0;
+  (void)params;
+  (void)data;
+  if (p == NULL || q == NULL) {
+    free(buf);
+    free(text);
+    tcmplxA_brcvt_destroy(q);
+    tcmplxA_brcvt_destroy(p);
+    return MUNIT_SKIP;
+  }
+  while (i < text_len) {
+    char const* const word = words[munit_rand_int_range(0,7)];
+    size_t j;
+    for (j = 0; word[j] != 0 && i < text_len; ++j, ++i)
+      text[i] = (unsigned char)word[j];
+  }
+  tcmplxA_brcvt_set_quick(p, 1);
+  /* write a few bytes at a time, so the search stops and starts */{
+    unsigned char const* text_p = text;
+    int res;
+    while (text_p < text+text_len) {
+      size_t exbuf_len = 0;
+      size_t const room = buf_cap-buf_len < 13u ? buf_cap-buf_len : 13u;
+      res = tcmplxA_brcvt_strrtozs(p, &exbuf_len,
+        buf+buf_len, room, &text_p, text+text_len);
+      munit_assert_int(res, >=, tcmplxA_Success);
+      buf_len += exbuf_len;
+      munit_assert_size(buf_len, <, buf_cap);
+    }
+    do {
+      size_t exbuf_len = 0;
+      size_t const room = buf_cap-buf_len < 13u ? buf_cap-buf_len : 13u;
+      res = tcmplxA_brcvt_delimrtozs(p, &exbuf_len, buf+buf_len, room);
+      munit_assert_int(res, >=, tcmplxA_Success);
+      buf_len += exbuf_len;
+      munit_assert_size(buf_len, <, buf_cap);
+    } while (res != tcmplxA_EOF);
+  }
+  /* trees from the block before still code under two bits a byte */
+  munit_assert_size(buf_len, <, text_len/4u);
+  test_brcvt_unpack(q, buf, buf_len, text, text_len, 4096u);
+  free(buf);
+  free(text);
+  tcmplxA_brcvt_destroy(q);
+  tcmplxA_brcvt_destroy(p);
+  return MUNIT_OK;
+}
+
+MunitResult test_brcvt_alloc
+  (const MunitParameter params[], void* data)
+{
+  long int live = 0;
+  struct tcmplxA_allocator const counter = {
+    test_brcvt_count_allocate, test_brcvt_count_deallocate, &live
+  };
+  struct tcmplxA_util_arena* const arena =
+    tcmplxA_util_arena_new(65536, &counter);
+  struct tcmplxA_brcvt* const p =
+    tcmplxA_brcvt_new_alloc(4096,4096,4096, &counter);
+  struct tcmplxA_brcvt* const q = (arena != NULL)
+    ? tcmplxA_brcvt_new_alloc(4096,4096,4096,
+        tcmplxA_util_arena_allocator(arena))
+    : NULL;
+  unsigned char text[64] = {0};
+  int const text_len = munit_rand_int_range(1,64);
+  unsigned char buf[256] = {0};
+  size_t buf_len = 0;
+  (void)params;
+  (void)data;
+  munit_rand_memory(sizeof(text)/2, &text[0]);
+  memcpy(text+sizeof(text)/2, text, sizeof(text)/2);
+  if (p == NULL || q == NULL) {
+    tcmplxA_brcvt_destroy(q);
+    tcmplxA_brcvt_destroy(p);
+    tcmplxA_util_arena_destroy(arena);
+    return MUNIT_SKIP;
+  }
+  munit_assert_long(live, >, 0);
+  /* encode */{
+    unsigned char const *text_p = text;
+    int res;
+    res = tcmplxA_brcvt_strrtozs(p, &buf_len, buf, sizeof(buf),
+      &text_p, text+text_len);
+    munit_assert(res == tcmplxA_ErrPartial);
+    do {
+      size_t exbuf_len = 0;
+      res = tcmplxA_brcvt_delimrtozs(p, &exbuf_len,
+        buf+buf_len, sizeof(buf)-buf_len);
+      buf_len += exbuf_len;
+    } while (res == tcmplxA_Success && buf_len < sizeof(buf));
+    munit_assert_int(res, ==, tcmplxA_EOF);
+  }
+  /* decode */{
+    unsigned char dummy[64] = {0};
+    size_t dummy_len = 0;
+    int res;
+    unsigned char const* buf_ptr = buf;
+    res = tcmplxA_brcvt_zsrtostr(q, &dummy_len, dummy, sizeof(dummy),
+      &buf_ptr, buf+buf_len);
+    munit_assert(res >= tcmplxA_Success);
+    munit_assert(dummy_len == (size_t)text_len);
+    munit_assert_memory_equal(text_len, dummy, text);
+  }
+  munit_assert_size(tcmplxA_util_arena_size(arena), >, 0);
+  tcmplxA_brcvt_destroy(q);
+  tcmplxA_brcvt_destroy(p);
+  tcmplxA_util_arena_destroy(arena);
+  /* every allocation went through the allocators and came back */
+  munit_assert_long(live, ==, 0);
+  return MUNIT_OK;
+}
+
+
+MunitResult test_brcvt_short_input
+  (const MunitParameter params[], void* data)
+{
+  size_t const text_len = 65536;
+  struct tcmplxA_brcvt* const p = tcmplxA_brcvt_new(4096,32768,16);
+  struct tcmplxA_brcvt* const q = tcmplxA_brcvt_new(4096,32768,4096);
+  unsigned char* const text = (unsigned char*)munit_malloc(text_len);
+  unsigned char* const dummy = (unsigned char*)munit_malloc(text_len);
+  unsigned char* buf = NULL;
+  size_t buf_len = 0;
+  size_t dummy_len = 0;
+  size_t i;
+  (void)params;
+  (void)data;
+  if (p == NULL || q == NULL) {
+    free(dummy);
+    free(text);
+    tcmplxA_brcvt_destroy(q);
+    tcmplxA_brcvt_destroy(p);
+    return MUNIT_SKIP;
+  }
+  /* skewed bytes give prefix codes of many lengths */
+  for (i = 0; i < text_len; ++i) {
+    int const r = munit_rand_int_range(0,255);
+    text[i] = (unsigned char)((r*r)>>8);
+  }
+  buf = test_brcvt_pack(p, text, text_len, &buf_len);
+  /* feed less than the fast path wants, so codes cross slice ends */{
+    unsigned char const* buf_ptr = buf;
+    int res;
+    do {
+      size_t const left = (size_t)(buf+buf_len - buf_ptr);
+      size_t const slice = (size_t)munit_rand_int_range(1,15);
+      size_t const room = text_len-dummy_len < 5u ? text_len-dummy_len : 5u;
+      size_t exdummy_len = 0;
+      munit_assert_size(left, >, 0u);
+      res = tcmplxA_brcvt_zsrtostr(q, &exdummy_len, dummy+dummy_len, room,
+        &buf_ptr, buf_ptr + (slice < left ? slice : left));
+      munit_assert_int(res, >=, tcmplxA_Success);
+      dummy_len += exdummy_len;
+      munit_assert_size(dummy_len, <=, text_len);
+    } while (res != tcmplxA_EOF);
+  }
+  munit_assert_size(dummy_len, ==, text_len);
+  munit_assert_memory_equal(text_len, dummy, text);
+  free(buf);
+  free(dummy);
+  free(text);
+  tcmplxA_brcvt_destroy(q);
+  tcmplxA_brcvt_destroy(p);
+  return MUNIT_OK;
+}
+
+MunitResult test_brcvt_memory
+  (const MunitParameter params[], void* data)
+{
+  struct tcmplxA_brcvt* const p = (struct tcmplxA_brcvt*)data;
+  struct tcmplxA_brcvt* const wide = tcmplxA_brcvt_new(64,16777200,16);
+  struct tcmplxA_brcvt* const q =
+    tcmplxA_brcvt_new_capped(4096,16777200,4096, 262144u, NULL);
+  unsigned char text[64] = {0};
+  int const text_len = munit_rand_int_range(1,64);
+  unsigned char buf[2][256] = {{0}};
+  size_t buf_len[2] = {0};
+  int k;
+  munit_rand_memory(sizeof(text)/2, &text[0]);
+  memcpy(text+sizeof(text)/2, text, sizeof(text)/2);
+  munit_assert_not_null(q);
+  if (p == NULL || wide == NULL) {
+    tcmplxA_brcvt_destroy(q);
+    tcmplxA_brcvt_destroy(wide);
+    return MUNIT_SKIP;
+  }
+  (void)params;
+  /* no state fits in a tiny cap */
+  munit_assert_null(tcmplxA_brcvt_new_capped(4096,16777200,4096, 256u, NULL));
+  munit_assert_size(tcmplxA_brcvt_memory_usage(q), <=, 262144u);
+  munit_assert_size(tcmplxA_brcvt_memory_usage(p), <=,
+    tcmplxA_brcvt_memory_bound(64,128,16));
+  for (k = 0; k < 2; ++k) {
+    struct tcmplxA_brcvt* const enc = (k ? wide : p);
+    unsigned char const *text_p = text;
+    int res;
+    res = tcmplxA_brcvt_strrtozs(enc, &buf_len[k], buf[k], sizeof(buf[k]),
+      &text_p, text+text_len);
+    munit_assert_int(res, >=, tcmplxA_Success);
+    do {
+      size_t exbuf_len = 0;
+      res = tcmplxA_brcvt_delimrtozs(enc, &exbuf_len,
+        buf[k]+buf_len[k], sizeof(buf[k])-buf_len[k]);
+      buf_len[k] += exbuf_len;
+    } while (res == tcmplxA_Success && buf_len[k] < sizeof(buf[k]));
+    munit_assert_int(res, ==, tcmplxA_EOF);
+  }
+  munit_assert_size(tcmplxA_brcvt_memory_usage(p), <=,
+    tcmplxA_brcvt_memory_bound(64,128,16));
+  /* decode */{
+    unsigned char dummy[64] = {0};
+    size_t dummy_len = 0;
+    int res;
+    unsigned char const* buf_ptr = buf[0];
+    res = tcmplxA_brcvt_zsrtostr(q, &dummy_len, dummy, sizeof(dummy),
+      &buf_ptr, buf[0]+buf_len[0]);
+    munit_assert_int(res, >=, tcmplxA_Success);
+    munit_assert_size(dummy_len, ==, (size_t)text_len);
+    munit_assert_memory_equal(text_len, dummy, text);
+    munit_assert_size(tcmplxA_brcvt_memory_usage(q), <=, 262144u);
+  }
+  tcmplxA_brcvt_reset(q);
+  /* the wide stream's window does not fit the cap */{
+    unsigned char dummy[64] = {0};
+    size_t dummy_len = 0;
+    int res;
+    unsigned char const* buf_ptr = buf[1];
+    res = tcmplxA_brcvt_zsrtostr(q, &dummy_len, dummy, sizeof(dummy),
+      &buf_ptr, buf[1]+buf_len[1]);
+    munit_assert_int(res, ==, tcmplxA_ErrMemoryCap);
+  }
+  tcmplxA_brcvt_destroy(q);
+  tcmplxA_brcvt_destroy(wide);
+  return MUNIT_OK;
+}
+
+MunitResult test_brcvt_no_literals
+  (const MunitParameter params[], void* data)
+{
+  struct tcmplxA_brcvt* const p = tcmplxA_brcvt_new(64,4096,16);
+  struct tcmplxA_brcvt* const q = tcmplxA_brcvt_new(4096,4096,4096);
+  unsigned char text[192];
+  (void)params;
+  (void)data;
+  if (p == NULL || q == NULL) {
+    tcmplxA_brcvt_destroy(q);
+    tcmplxA_brcvt_destroy(p);
+    return MUNIT_SKIP;
+  }
+  /* the later meta-blocks copy the first and need no literals */
+  munit_rand_memory(64, text);
+  memcpy(text+64, text, 64);
+  memcpy(text+128, text, 64);
+  test_brcvt_round_trip(p, q, text, sizeof(text));
+  tcmplxA_brcvt_destroy(q);
+  tcmplxA_brcvt_destroy(p);
+  return MUNIT_OK;
+}
+
+MunitResult test_brcvt_literal_types
+  (const MunitParameter params[], void* data)
+{
+  unsigned char text[512];
+  int k;
+  (void)params;
+  (void)data;
+  for (k = 0; k < 64; ++k) {
+    struct tcmplxA_brcvt* const p = tcmplxA_brcvt_new(4096,4096,16);
+    struct tcmplxA_brcvt* const q = tcmplxA_brcvt_new(4096,4096,4096);
+    size_t const text_len = (size_t)munit_rand_int_range(1,sizeof(text));
+    size_t i;
+    if (p == NULL || q == NULL) {
+      tcmplxA_brcvt_destroy(q);
+      tcmplxA_brcvt_destroy(p);
+      return MUNIT_SKIP;
+    }
+    /* alternate runs of text and noise so that the context modes differ */
+    for (i = 0; i < text_len; ) {
+      size_t const run = (size_t)munit_rand_int_range(1,64);
+      int const noisy = munit_rand_int_range(0,1);
+      size_t j;
+      for (j = 0; j < run && i < text_len; ++j, ++i) {
+        text[i] = (unsigned char)(noisy ? munit_rand_int_range(0,255)
+          : munit_rand_int_range('a','z'));
+      }
+    }
+    test_brcvt_round_trip(p, q, text, text_len);
+    tcmplxA_brcvt_destroy(q);
+    tcmplxA_brcvt_destroy(p);
+  }
+  return MUNIT_OK;
+}
+
+
+MunitResult test_brcvt_zero_bit_copy
+  (const MunitParameter params[], void* data)
+{
+  struct tcmplxA_brcvt* const p = (struct tcmplxA_brcvt*)data;
+  /* reference encoder output (quality 10) for 50 'a' then 48 'b' */
+  static unsigned char const buf[] = {
+    0x22, 0x0c, 0x00, 0xbf, 0x54, 0x98, 0x58, 0x98,
+    0x11, 0x00, 0x20, 0xd8, 0x03
+  };
+  unsigned char text[98];
+  if (p == NULL)
+    return MUNIT_SKIP;
+  (void)params;
+  memset(text, 'a', 50);
+  memset(text+50, 'b', 48);
+  /* the command after the first copy reads from zero-bit trees */
+  test_brcvt_unpack(p, buf, sizeof(buf), text, sizeof(text), sizeof(text));
+  return MUNIT_OK;
+}
+
+MunitResult test_brcvt_zero_bit_partial
+  (const MunitParameter params[], void* data)
+{
+  struct tcmplxA_brcvt* const p = (struct tcmplxA_brcvt*)data;
+  /* reference encoder output (quality 10) */
+  static unsigned char const buf[] = {
+    0x82, 0x02, 0x00, 0xbf, 0x91, 0x52, 0x75, 0x78,
+    0x17, 0x61, 0x05, 0xe2, 0x16, 0x40, 0x45, 0x01,
+    0x11, 0x01
+  };
+  static char const text[] = "a an a a an a an a an";
+  if (p == NULL)
+    return MUNIT_SKIP;
+  (void)params;
+  /* stop after every byte, so that decoding resumes on zero-bit trees */
+  test_brcvt_unpack(p, buf, sizeof(buf),
+    (unsigned char const*)text, sizeof(text)-1u, 1u);
+  return MUNIT_OK;
+}
+
+MunitResult test_brcvt_dict_word_end
+  (const MunitParameter params[], void* data)
+{
+  struct tcmplxA_brcvt* const p = (struct tcmplxA_brcvt*)data;
+  /* reference encoder output (quality 10) */
+  static unsigned char const buf[] = {
+    0x62, 0x02, 0x00, 0xbf, 0x91, 0xd2, 0xcd, 0x58,
+    0x54, 0x19, 0x36, 0x46, 0x57, 0x20, 0x6e, 0x91,
+    0x54, 0x84, 0x44, 0x65, 0x64, 0x35, 0x00
+  };
+  static char const text[] = "an cat a cat cat the";
+  if (p == NULL)
+    return MUNIT_SKIP;
+  (void)params;
+  /* the meta-block ends in the middle of a built-in dictionary word */
+  test_brcvt_unpack(p, buf, sizeof(buf),
+    (unsigned char const*)text, sizeof(text)-1u, 1u);
+  return MUNIT_OK;
+}
+
+MunitResult test_brcvt_single_clen
+  (const MunitParameter params[], void* data)
+{
+  struct tcmplxA_brcvt* const p = (struct tcmplxA_brcvt*)data;
+  unsigned char buf[64] = {0};
+  size_t pos = 0;
+  static unsigned char const text[4] = {0x01u, 0x80u, 0x7fu, 0xfeu};
+  int i;
+  if (p == NULL)
+    return MUNIT_SKIP;
+  (void)params;
+  /* WBITS, ISLAST, MLEN = 4, one block type each, no postfix or direct */
+  test_brcvt_put_bits(buf, &pos, 0u, 1);
+  test_brcvt_put_bits(buf, &pos, 1u, 1);
+  test_brcvt_put_bits(buf, &pos, 0u, 3);
+  test_brcvt_put_bits(buf, &pos, 3u, 16);
+  test_brcvt_put_bits(buf, &pos, 0u, 9);
+  /* context mode, NTREESL = NTREESD = 1 */
+  test_brcvt_put_bits(buf, &pos, 0u, 4);
+  /* literals: only code length code 16 is used, repeating length 8 */{
+    test_brcvt_put_bits(buf, &pos, 0u, 2);
+    for (i = 0; i < 8; ++i)
+      test_brcvt_put_bits(buf, &pos, 0u, 2);
+    test_brcvt_put_bits(buf, &pos, 7u, 4);
+    for (i = 9; i < 18; ++i)
+      test_brcvt_put_bits(buf, &pos, 0u, 2);
+    /* 5, 17, 65, then 256 repeats */
+    test_brcvt_put_bits(buf, &pos, 2u, 2);
+    test_brcvt_put_bits(buf, &pos, 2u, 2);
+    test_brcvt_put_bits(buf, &pos, 2u, 2);
+    test_brcvt_put_bits(buf, &pos, 1u, 2);
+  }
+  /* insert-and-copy: only 32 (insert 4, copy 2, last distance) */
+  test_brcvt_put_bits(buf, &pos, 1u, 2);
+  test_brcvt_put_bits(buf, &pos, 0u, 2);
+  test_brcvt_put_bits(buf, &pos, 32u, 10);
+  /* distance: only 0 */
+  test_brcvt_put_bits(buf, &pos, 1u, 2);
+  test_brcvt_put_bits(buf, &pos, 0u, 2);
+  test_brcvt_put_bits(buf, &pos, 0u, 6);
+  /* literal codes equal the literals, most significant bit first */
+  for (i = 0; i < 4; ++i) {
+    int b;
+    for (b = 7; b >= 0; --b)
+      test_brcvt_put_bits(buf, &pos, (text[i]>>b)&1u, 1);
+  }
+  test_brcvt_unpack(p, buf, (pos+7u)/8u, text, sizeof(text), sizeof(text));
+  return MUNIT_OK;
+}
+
+MunitResult test_brcvt_implicit_distance
+  (const MunitParameter params[], void* data)
+{
+  struct tcmplxA_brcvt* const p = (struct tcmplxA_brcvt*)data;
+  unsigned char buf[64] = {0};
+  size_t pos = 0;
+  static char const text[] = "aaabbbccc";
+  if (p == NULL)
+    return MUNIT_SKIP;
+  (void)params;
+  /* WBITS, ISLAST, MLEN = 9, one literal and one insert block type */
+  test_brcvt_put_bits(buf, &pos, 0u, 1);
+  test_brcvt_put_bits(buf, &pos, 1u, 1);
+  test_brcvt_put_bits(buf, &pos, 0u, 3);
+  test_brcvt_put_bits(buf, &pos, 8u, 16);
+  test_brcvt_put_bits(buf, &pos, 0u, 2);
+  /* two distance block types: type codes {0,1}, count code 0 */{
+    test_brcvt_put_bits(buf, &pos, 1u, 1);
+    test_brcvt_put_bits(buf, &pos, 0u, 3);
+    test_brcvt_put_bits(buf, &pos, 1u, 2);
+    test_brcvt_put_bits(buf, &pos, 1u, 2);
+    test_brcvt_put_bits(buf, &pos, 0u, 2);
+    test_brcvt_put_bits(buf, &pos, 1u, 2);
+    test_brcvt_put_bits(buf, &pos, 1u, 2);
+    test_brcvt_put_bits(buf, &pos, 0u, 2);
+    test_brcvt_put_bits(buf, &pos, 0u, 5);
+    /* first block holds one distance */
+    test_brcvt_put_bits(buf, &pos, 0u, 2);
+  }
+  /* no postfix or direct, context mode, NTREESL = NTREESD = 1 */
+  test_brcvt_put_bits(buf, &pos, 0u, 10);
+  /* literals: 'a' (0), 'b' (10), 'c' (11) */
+  test_brcvt_put_bits(buf, &pos, 1u, 2);
+  test_brcvt_put_bits(buf, &pos, 2u, 2);
+  test_brcvt_put_bits(buf, &pos, 'a', 8);
+  test_brcvt_put_bits(buf, &pos, 'b', 8);
+  test_brcvt_put_bits(buf, &pos, 'c', 8);
+  /* insert-and-copy: 8 (last distance) and 136, both insert 1, copy 2 */
+  test_brcvt_put_bits(buf, &pos, 1u, 2);
+  test_brcvt_put_bits(buf, &pos, 1u, 2);
+  test_brcvt_put_bits(buf, &pos, 8u, 10);
+  test_brcvt_put_bits(buf, &pos, 136u, 10);
+  /* distance: only 16, with one extra bit */
+  test_brcvt_put_bits(buf, &pos, 1u, 2);
+  test_brcvt_put_bits(buf, &pos, 0u, 2);
+  test_brcvt_put_bits(buf, &pos, 16u, 6);
+  /* "a" then copy at distance 1 */
+  test_brcvt_put_bits(buf, &pos, 1u, 1);
+  test_brcvt_put_bits(buf, &pos, 0u, 1);
+  test_brcvt_put_bits(buf, &pos, 0u, 1);
+  /* "b" then copy at the last distance, which must not switch blocks */
+  test_brcvt_put_bits(buf, &pos, 0u, 1);
+  test_brcvt_put_bits(buf, &pos, 1u, 1);
+  test_brcvt_put_bits(buf, &pos, 0u, 1);
+  /* "c" then switch to distance block type 1 for one distance */
+  test_brcvt_put_bits(buf, &pos, 1u, 1);
+  test_brcvt_put_bits(buf, &pos, 1u, 1);
+  test_brcvt_put_bits(buf, &pos, 1u, 1);
+  test_brcvt_put_bits(buf, &pos, 1u, 1);
+  test_brcvt_put_bits(buf, &pos, 0u, 2);
+  test_brcvt_put_bits(buf, &pos, 0u, 1);
+  test_brcvt_unpack(p, buf, (pos+7u)/8u,
+    (unsigned char const*)text, sizeof(text)-1u, sizeof(text));
+  return MUNIT_OK;
+}
+
+MunitResult test_brcvt_literal_split
+  (const MunitParameter params[], void* data)
+{
+  size_t const text_len = 16384;
+  struct tcmplxA_brcvt* const p = tcmplxA_brcvt_new(16384,32768,1);
+  struct tcmplxA_brcvt* const q = tcmplxA_brcvt_new(4096,32768,4096);
+  unsigned char* const text = (unsigned char*)munit_malloc(text_len);
+  static char const letters[] = "etaoin shrdlu";
+  unsigned char* buf;
+  size_t buf_len;
+  size_t pos = 0;
+  size_t i;
+  (void)params;
+  (void)data;
+  if (p == NULL || q == NULL) {
+    free(text);
+    tcmplxA_brcvt_destroy(q);
+    tcmplxA_brcvt_destroy(p);
+    return MUNIT_SKIP;
+  }
+  /* text, then noise, in one meta-block */
+  for (i = 0; i < text_len/2u; ++i)
+    text[i] = (unsigned char)letters[munit_rand_int_range(0,sizeof(letters)-2)];
+  munit_rand_memory(text_len/2u, text+text_len/2u);
+  buf = test_brcvt_pack(p, text, text_len, &buf_len);
+  /* more than one literal block type */{
+    test_brcvt_skip_header(buf, &pos);
+    munit_assert_ulong(test_brcvt_get_bits(buf, &pos, 1), ==, 1u);
+  }
+  test_brcvt_unpack(q, buf, buf_len, text, text_len, 4096u);
+  free(buf);
+  free(text);
+  tcmplxA_brcvt_destroy(q);
+  tcmplxA_brcvt_destroy(p);
+  return MUNIT_OK;
+}
+
+MunitResult test_brcvt_literal_contexts
+  (const MunitParameter params[], void* data)
+{
+  size_t const text_len = 16384;
+  struct tcmplxA_brcvt* const p = tcmplxA_brcvt_new(4096,32768,1);
+  struct tcmplxA_brcvt* const q = tcmplxA_brcvt_new(4096,32768,4096);
+  unsigned char* const text = (unsigned char*)munit_malloc(text_len);
+  static char const hex[] = "0123456789ABCDEF";
+  size_t buf_len;
+  size_t i;
+  (void)params;
+  (void)data;
+  if (p == NULL || q == NULL) {
+    free(text);
+    tcmplxA_brcvt_destroy(q);
+    tcmplxA_brcvt_destroy(p);
+    return MUNIT_SKIP;
+  }
+  /* letters and hexadecimal digits take turns, so the previous byte
+   * tells which sixteen literals come next */
+  for (i = 0; i < text_len; ++i) {
+    text[i] = (unsigned char)((i&1u) ? hex[munit_rand_int_range(0,15)]
+      : 'a' + munit_rand_int_range(0,15));
+  }
+  buf_len = test_brcvt_round_trip(p, q, text, text_len);
+  /* one tree for all 32 literals would cost five bits each */
+  munit_assert_size(buf_len, <, text_len/32u*19u);
+  free(text);
+  tcmplxA_brcvt_destroy(q);
+  tcmplxA_brcvt_destroy(p);
+  return MUNIT_OK;
+}
+
+MunitResult test_brcvt_distance_postfix
+  (const MunitParameter params[], void* data)
+{
+  size_t const text_len = 16384;
+  struct tcmplxA_brcvt* const p = tcmplxA_brcvt_new(16384,32768,16);
+  struct tcmplxA_brcvt* const q = tcmplxA_brcvt_new(4096,32768,4096);
+  unsigned char* const text = (unsigned char*)munit_malloc(text_len);
+  unsigned char* buf;
+  size_t buf_len;
+  size_t pos = 0;
+  size_t i;
+  (void)params;
+  (void)data;
+  if (p == NULL || q == NULL) {
+    free(text);
+    tcmplxA_brcvt_destroy(q);
+    tcmplxA_brcvt_destroy(p);
+    return MUNIT_SKIP;
+  }
+  /* eight-byte records: most keys repeat a recent record's key,
+   * so copy distances are multiples of eight */
+  for (i = 0; i < text_len; i += 8u) {
+    if (i >= 32u && munit_rand_int_range(0,9) > 0) {
+      int const records = (int)(i/8u < 200u ? i/8u : 200u);
+      size_t const back = (size_t)munit_rand_int_range(1,records)*8u;
+      memcpy(text+i, text+i-back, 4);
+    } else munit_rand_memory(4, text+i);
+    munit_rand_memory(4, text+i+4);
+  }
+  buf = test_brcvt_pack(p, text, text_len, &buf_len);
+  /* read NPOSTFIX */{
+    test_brcvt_skip_header(buf, &pos);
+    munit_assert_ulong(test_brcvt_get_bits(buf, &pos, 3), ==, 0u);
+    munit_assert_ulong(test_brcvt_get_bits(buf, &pos, 2), >, 0u);
+  }
+  test_brcvt_unpack(q, buf, buf_len, text, text_len, 4096u);
+  free(buf);
+  free(text);
+  tcmplxA_brcvt_destroy(q);
+  tcmplxA_brcvt_destroy(p);
+  return MUNIT_OK;
+}
+
+MunitResult test_brcvt_estimate
+  (const MunitParameter params[], void* data)
+{
+  size_t const pool_len = 4096;
+  size_t const text_len = 16384;
+  struct tcmplxA_brcvt* const p = tcmplxA_brcvt_new(16384,32768,16);
+  struct tcmplxA_brcvt* const q = tcmplxA_brcvt_new(4096,32768,4096);
+  unsigned char* const text = (unsigned char*)munit_malloc(text_len);
+  unsigned char* buf;
+  size_t buf_len;
+  size_t i;
+  (void)params;
+  (void)data;
+  if (p == NULL || q == NULL) {
+    free(text);
+    tcmplxA_brcvt_destroy(q);
+    tcmplxA_brcvt_destroy(p);
+    return MUNIT_SKIP;
+  }
+  /* random letters, then short pieces of them copied from far back */
+  for (i = 0; i < pool_len; ++i)
+    text[i] = (unsigned char)('a' + munit_rand_int_range(0,25));
+  for (; i < text_len; i += 16u) {
+    size_t const offset = (size_t)munit_rand_int_range(0,(int)pool_len-16);
+    memcpy(text+i, text+offset, 16u);
+  }
+  buf = test_brcvt_pack(p, text, text_len, &buf_len);
+  /* compressed, not an uncompressed meta-block */
+  munit_assert_size(buf_len, <, text_len/2u);
+  test_brcvt_unpack(q, buf, buf_len, text, text_len, 4096u);
+  free(buf);
+  free(text);
+  tcmplxA_brcvt_destroy(q);
+  tcmplxA_brcvt_destroy(p);
+  return MUNIT_OK;
+}
 
 int main(int argc, char **argv) {
   return munit_suite_main(&suite_brcvt, NULL, argc, argv);
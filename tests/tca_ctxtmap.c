@@ -17,6 +17,8 @@ static MunitResult test_ctxtmap_distcontext
   (const MunitParameter params[], void* data);
 static MunitResult test_ctxtmap_litcontext
   (const MunitParameter params[], void* data);
+static MunitResult test_ctxtmap_litlut
+  (const MunitParameter params[], void* data);
 static MunitResult test_ctxtmap_imtf
   (const MunitParameter params[], void* data);
 static MunitResult test_ctxtmap_mtf
@@ -39,6 +41,8 @@ static MunitTest tests_ctxtmap[] = {
     NULL,NULL,0,NULL},
   {"literal_context", test_ctxtmap_litcontext,
     NULL,NULL,0,NULL},
+  {"literal_lut", test_ctxtmap_litlut,
+    NULL,NULL,0,NULL},
   {"imtf", test_ctxtmap_imtf,
     test_ctxtmap_setup,test_ctxtmap_teardown,0,NULL},
   {"mtf", test_ctxtmap_mtf,
@@ -173,6 +177,38 @@ MunitResult test_ctxtmap_litcontext
   return MUNIT_OK;
 }
 
+MunitResult test_ctxtmap_litlut
+  (const MunitParameter params[], void* data)
+{
+  int m = munit_rand_int_range(0,4);
+  unsigned char const* const lut = tcmplxA_ctxtmap_literal_lut(m);
+  munit_uint8_t hist[2];
+  (void)params;
+  (void)data;
+  munit_rand_memory(sizeof(hist), hist);
+  if (m >= 4) {
+    munit_assert_ptr_null(lut);
+    return MUNIT_OK;
+  }
+  munit_assert_ptr_not_null(lut);
+  munit_assert_int(lut[hist[0]] | lut[256+hist[1]],==,
+    tcmplxA_ctxtmap_literal_context(m,hist[0],hist[1]));
+  /* spot checks from RFC 7932 section 7.1 */
+  switch (m) {
+  case tcmplxA_CtxtMap_UTF8:
+    munit_assert_int(tcmplxA_ctxtmap_literal_context(m,'a','a'),==,59);
+    munit_assert_int(tcmplxA_ctxtmap_literal_context(m,' ','0'),==,10);
+    break;
+  case tcmplxA_CtxtMap_Signed:
+    munit_assert_int(tcmplxA_ctxtmap_literal_context(m,255,255),==,63);
+    munit_assert_int(tcmplxA_ctxtmap_literal_context(m,0,1),==,1);
+    break;
+  default:
+    break;
+  }
+  return MUNIT_OK;
+}
+
 MunitResult test_ctxtmap_imtf
   (const MunitParameter params[], void* data)
 {
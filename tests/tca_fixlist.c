@@ -22,6 +22,8 @@ static MunitResult test_fixlist_gen_lengths
   (const MunitParameter params[], void* data);
 static MunitResult test_fixlist_preset
   (const MunitParameter params[], void* data);
+static MunitResult test_fixlist_match_empty
+  (const MunitParameter params[], void* data);
 static void* test_fixlist_setup
     (const MunitParameter params[], void* user_data);
 static void* test_fixlist_gen_setup
@@ -50,6 +52,8 @@ static MunitTest tests_fixlist[] = {
     test_fixlist_gen_setup,test_fixlist_teardown,0,test_fixlist_gen_params},
   {"preset", test_fixlist_preset,
     test_fixlist_setup,test_fixlist_teardown,0,NULL},
+  {"match_empty", test_fixlist_match_empty,
+    NULL,NULL,MUNIT_TEST_OPTION_SINGLE_ITERATION,NULL},
   {"gen_lengths", test_fixlist_gen_lengths,
     test_fixlist_len_setup,test_fixlist_teardown,0,test_fixlist_len_params},
   {"codesort", test_fixlist_codesort,
@@ -302,6 +306,30 @@ MunitResult test_fixlist_preset
 }
 
 
+MunitResult test_fixlist_match_empty
+  (const MunitParameter params[], void* data)
+{
+  struct tcmplxA_fixlist* const p = tcmplxA_fixlist_new(4);
+  size_t i;
+  (void)params;
+  (void)data;
+  if (p == NULL)
+    return MUNIT_SKIP;
+  for (i = 0; i < 4; ++i) {
+    struct tcmplxA_fixline* const line = tcmplxA_fixlist_at(p, i);
+    line->len = 0;
+    line->code = 0;
+    line->value = (unsigned long int)(i+2);
+  }
+  /* a list with no active leaves collapses to one forced code */
+  munit_assert_int(tcmplxA_fixlist_match_preset(p, 0),
+    ==, tcmplxA_FixList_BrotliSimple1);
+  munit_assert_size(tcmplxA_fixlist_size(p), ==, 1);
+  munit_assert_uint(tcmplxA_fixlist_at_c(p, 0)->len, ==, 0);
+  tcmplxA_fixlist_destroy(p);
+  return MUNIT_OK;
+}
+
 
 int main(int argc, char **argv) {
   return munit_suite_main(&suite_fixlist, NULL, argc, argv);
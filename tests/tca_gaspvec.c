@@ -3,6 +3,8 @@
  */
 #include "testfont.h"
 #include "text-complex/access/gaspvec.h"
+#include "text-complex/access/fixlist.h"
+#include "text-complex/access/api.h"
 #include "munit/munit.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -16,6 +18,8 @@ static MunitResult test_gaspvec_item
   (const MunitParameter params[], void* data);
 static MunitResult test_gaspvec_skip
   (const MunitParameter params[], void* data);
+static MunitResult test_gaspvec_decode
+  (const MunitParameter params[], void* data);
 static void* test_gaspvec_setup
     (const MunitParameter params[], void* user_data);
 static void test_gaspvec_teardown(void* fixture);
@@ -28,6 +32,8 @@ static MunitTest tests_gaspvec[] = {
     test_gaspvec_setup,test_gaspvec_teardown,0,NULL},
   {"skip", test_gaspvec_skip,
     test_gaspvec_setup,test_gaspvec_teardown,0,NULL},
+  {"decode", test_gaspvec_decode,
+    NULL,NULL,MUNIT_TEST_OPTION_SINGLE_ITERATION,NULL},
   {NULL, NULL, NULL,NULL,0,NULL}
 };
 
@@ -103,6 +109,62 @@ MunitResult test_gaspvec_skip
   return MUNIT_OK;
 }
 
+MunitResult test_gaspvec_decode
+  (const MunitParameter params[], void* data)
+{
+  struct tcmplxA_gaspvec* const p = tcmplxA_gaspvec_new(1);
+  struct tcmplxA_fixlist* const src = tcmplxA_fixlist_new(16);
+  int pass;
+  (void)params;
+  (void)data;
+  munit_assert(p != NULL);
+  munit_assert(src != NULL);
+  /* complete code with lengths 1, 2, ..., 15, 15 */
+  {
+    size_t i;
+    for (i = 0; i < 16; ++i) {
+      struct tcmplxA_fixline* const line = tcmplxA_fixlist_at(src, i);
+      line->len = (unsigned short)(i < 15 ? i+1 : 15);
+      line->value = (unsigned long)(i*3+1);
+    }
+  }
+  munit_assert_int(tcmplxA_fixlist_gen_codes(src), ==, tcmplxA_Success);
+  munit_assert_int(tcmplxA_fixlist_copy(tcmplxA_gaspvec_at(p, 0), src),
+    ==, tcmplxA_Success);
+  munit_assert_int(tcmplxA_gaspvec_compile(p), ==, tcmplxA_Success);
+  /* pass 0 uses the tables, pass 1 the fallback search */
+  for (pass = 0; pass < 2; ++pass) {
+    size_t i;
+    if (pass == 1)
+      (void)tcmplxA_gaspvec_at(p, 0);
+    for (i = 0; i < 16; ++i) {
+      struct tcmplxA_fixline const* const line =
+        tcmplxA_fixlist_at_c(src, i);
+      unsigned n;
+      for (n = 1; n < line->len; ++n) {
+        munit_assert_uint(tcmplxA_gaspvec_decode
+            (p, 0, n, line->code>>(line->len-n)), ==, UINT_MAX);
+      }
+      munit_assert_uint(tcmplxA_gaspvec_decode(p, 0, line->len, line->code),
+        ==, line->value);
+      if (pass == 0) {
+        unsigned len = 0;
+        unsigned const window = (unsigned)(line->code << (15-line->len))
+          | ((1u<<(15-line->len))-1u);
+        munit_assert_uint(tcmplxA_gaspvec_peek(p, 0, window, &len),
+          ==, line->value);
+        munit_assert_uint(len, ==, line->len);
+      } else {
+        unsigned len = 0;
+        munit_assert_uint(tcmplxA_gaspvec_peek(p, 0, 0u, &len), ==, UINT_MAX);
+      }
+    }
+  }
+  tcmplxA_fixlist_destroy(src);
+  tcmplxA_gaspvec_destroy(p);
+  return MUNIT_OK;
+}
+
 
 
 int main(int argc, char **argv) {
@@ -19,6 +19,10 @@ static MunitResult test_hashchain_addring
   (const MunitParameter params[], void* data);
 static MunitResult test_hashchain_find
   (const MunitParameter params[], void* data);
+static MunitResult test_hashchain_findwrap
+  (const MunitParameter params[], void* data);
+static MunitResult test_hashchain_copy
+  (const MunitParameter params[], void* data);
 static void* test_hashchain_setup
     (const MunitParameter params[], void* user_data);
 static void* test_hashchain_setupsmall
@@ -40,6 +44,10 @@ static MunitTest tests_hashchain[] = {
     test_hashchain_setupsmall,test_hashchain_teardown,0,NULL},
   {"find", test_hashchain_find,
     test_hashchain_setupsmall,test_hashchain_teardown,0,NULL},
+  {"find/wrap", test_hashchain_findwrap,
+    NULL,NULL,0,NULL},
+  {"copy", test_hashchain_copy,
+    test_hashchain_setupsmall,test_hashchain_teardown,0,NULL},
   {NULL, NULL, NULL,NULL,0,NULL}
 };
 
@@ -214,6 +222,92 @@ MunitResult test_hashchain_find
   return MUNIT_OK;
 }
 
+MunitResult test_hashchain_findwrap
+  (const MunitParameter params[], void* data)
+{
+  size_t const len = (size_t)munit_rand_int_range(1,16);
+  int const skip_count = munit_rand_int_range(0,140000);
+  int const gap = munit_rand_int_range(0,32000);
+  unsigned char const needle[3] = {120,121,122};
+  struct tcmplxA_hashchain* const p = tcmplxA_hashchain_new(32768, len);
+  (void)params;
+  (void)data;
+  if (p == NULL)
+    return MUNIT_SKIP;
+  /* pass the 16-bit counter wrap, if the links are that narrow */{
+    int i;
+    for (i = 0; i < skip_count; ++i) {
+      int const res = tcmplxA_hashchain_add(p, 97u);
+      munit_assert_int(res,==,tcmplxA_Success);
+    }
+    for (i = 0; i < 3; ++i) {
+      int const res = tcmplxA_hashchain_add(p, needle[i]);
+      munit_assert_int(res,==,tcmplxA_Success);
+    }
+    for (i = 0; i < gap; ++i) {
+      int const res = tcmplxA_hashchain_add(p, 97u);
+      munit_assert_int(res,==,tcmplxA_Success);
+    }
+  }
+  /* the needle's hash shares no bucket with its neighbors */{
+    uint32_t const k = tcmplxA_hashchain_find(p, needle, 0u);
+    munit_assert_uint32(k,==,(uint32_t)gap+2u);
+  }
+  tcmplxA_hashchain_destroy(p);
+  return MUNIT_OK;
+}
+
+MunitResult test_hashchain_copy
+  (const MunitParameter params[], void* data)
+{
+  struct tcmplxA_hashchain* const p = (struct tcmplxA_hashchain*)data;
+  struct tcmplxA_hashchain* q;
+  int const add_count = munit_rand_int_range(3,64);
+  unsigned char buf[64];
+  if (p == NULL)
+    return MUNIT_SKIP;
+  (void)params;
+  q = tcmplxA_hashchain_new(64, 1);
+  if (q == NULL)
+    return MUNIT_SKIP;
+  /* fill the buffer */{
+    munit_rand_memory(add_count, (munit_uint8_t*)buf);
+  }
+  /* add the items */{
+    int i;
+    for (i = 0; i < add_count; ++i) {
+      int const res = tcmplxA_hashchain_add(p, buf[i]);
+      munit_assert_int(res,==,tcmplxA_Success);
+    }
+  }
+  /* copy */{
+    int const res = tcmplxA_hashchain_copy(q, p);
+    munit_assert_int(res,==,tcmplxA_Success);
+    munit_assert_uint32(tcmplxA_hashchain_extent(q),==,
+      tcmplxA_hashchain_extent(p));
+    munit_assert_uint32(tcmplxA_hashchain_size(q),==,
+      tcmplxA_hashchain_size(p));
+  }
+  /* compare */{
+    int j;
+    for (j = 0; j < add_count; ++j) {
+      uint32_t const i = (uint32_t)(add_count-j-1);
+      munit_assert_uint(tcmplxA_hashchain_peek(q, i),==,buf[j]);
+    }
+    for (j = 0; j < add_count-2; ++j) {
+      munit_assert_uint32(tcmplxA_hashchain_find(q, buf+j, 0u),==,
+        tcmplxA_hashchain_find(p, buf+j, 0u));
+    }
+  }
+  /* the copy is independent of the source */{
+    int const res = tcmplxA_hashchain_add(q, 0u);
+    munit_assert_int(res,==,tcmplxA_Success);
+    munit_assert_uint(tcmplxA_hashchain_peek(p, 0u),==,buf[add_count-1]);
+  }
+  tcmplxA_hashchain_destroy(q);
+  return MUNIT_OK;
+}
+
 
 int main(int argc, char **argv) {
   return munit_suite_main(&suite_hashchain, NULL, argc, argv);
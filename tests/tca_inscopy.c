@@ -22,6 +22,10 @@ static MunitResult test_inscopy_codesort
   (const MunitParameter params[], void* data);
 static MunitResult test_inscopy_encode
   (const MunitParameter params[], void* data);
+static MunitResult test_inscopy_encode_direct
+  (const MunitParameter params[], void* data);
+static MunitResult test_inscopy_preset_c
+  (const MunitParameter params[], void* data);
 static void* test_inscopy_setup
     (const MunitParameter params[], void* user_data);
 static void test_inscopy_teardown(void* fixture);
@@ -40,6 +44,10 @@ static MunitTest tests_inscopy[] = {
     test_inscopy_setup,test_inscopy_teardown,0,NULL},
   {"encode", test_inscopy_encode,
     test_inscopy_setup,test_inscopy_teardown,0,NULL},
+  {"encode_direct", test_inscopy_encode_direct,
+    test_inscopy_setup,test_inscopy_teardown,0,NULL},
+  {"preset_c", test_inscopy_preset_c,
+    NULL,NULL,MUNIT_TEST_OPTION_SINGLE_ITERATION,NULL},
   {NULL, NULL, NULL,NULL,0,NULL}
 };
 
@@ -393,6 +401,75 @@ MunitResult test_inscopy_encode
   return MUNIT_OK;
 }
 
+MunitResult test_inscopy_encode_direct
+  (const MunitParameter params[], void* data)
+{
+  size_t const not_found = ((size_t)-1);
+  struct tcmplxA_inscopy* const p = (struct tcmplxA_inscopy*)data;
+  struct tcmplxA_inscopy* sorted;
+  unsigned long int i = 0u, c = 0u;
+  int z_tf = 0;
+  if (p == NULL)
+    return MUNIT_SKIP;
+  (void)params;
+  sorted = tcmplxA_inscopy_new(0u);
+  if (sorted == NULL)
+    return MUNIT_SKIP;
+  else if (tcmplxA_inscopy_copy(sorted, p) != tcmplxA_Success
+  ||  tcmplxA_inscopy_lengthsort(sorted) != tcmplxA_Success)
+  {
+    tcmplxA_inscopy_destroy(sorted);
+    return MUNIT_SKIP;
+  }
+  switch (tcmplxA_inscopy_size(p)) {
+  case 704: /* Brotli insert-copy pairs */
+    i = test_inscopy_rand_length25();
+    c = test_inscopy_rand_length25();
+    z_tf = (munit_rand_int_range(0,1) != 0);
+    break;
+  case 286: /* DEFLATE */
+    c = testfont_rand_uint_range(0u,260u);
+    break;
+  case 26: /* Brotli block counts */
+    i = test_inscopy_rand_length25();
+    break;
+  }
+  /* compare against a search of the length-sorted table */{
+    size_t const direct_index = tcmplxA_inscopy_encode(p, i, c, z_tf);
+    size_t const search_index = tcmplxA_inscopy_encode(sorted, i, c, z_tf);
+    munit_assert_size(direct_index == not_found, ==,
+      search_index == not_found);
+    if (direct_index != not_found) {
+      munit_assert_uint(tcmplxA_inscopy_at_c(p, direct_index)->code, ==,
+        tcmplxA_inscopy_at_c(sorted, search_index)->code);
+      munit_assert_size(direct_index, ==,
+        tcmplxA_inscopy_at_c(p, direct_index)->code);
+    }
+  }
+  tcmplxA_inscopy_destroy(sorted);
+  return MUNIT_OK;
+}
+
+MunitResult test_inscopy_preset_c
+  (const MunitParameter params[], void* data)
+{
+  int t;
+  (void)params;
+  (void)data;
+  munit_assert_null(tcmplxA_inscopy_preset_c(-1));
+  munit_assert_null(tcmplxA_inscopy_preset_c(3));
+  for (t = 0; t < 3; ++t) {
+    struct tcmplxA_inscopy const* const p = tcmplxA_inscopy_preset_c(t);
+    size_t i;
+    munit_assert_not_null(p);
+    munit_assert_ptr_equal(p, tcmplxA_inscopy_preset_c(t));
+    for (i = 0u; i < tcmplxA_inscopy_size(p); ++i) {
+      munit_assert_size(tcmplxA_inscopy_at_c(p, i)->code, ==, i);
+    }
+  }
+  return MUNIT_OK;
+}
+
 int main(int argc, char **argv) {
   return munit_suite_main(&suite_inscopy, NULL, argc, argv);
 }
@@ -17,9 +17,12 @@
 typedef int (*test_fn)(void);
 static MunitResult test_util_alloc
     (const MunitParameter params[], void* data);
+static MunitResult test_util_arena
+    (const MunitParameter params[], void* data);
 
 static MunitTest tests_util[] = {
   {"alloc", test_util_alloc, NULL,NULL,0,NULL},
+  {"arena", test_util_arena, NULL,NULL,0,NULL},
   {NULL, NULL, NULL,NULL,0,NULL}
 };
 
@@ -43,6 +46,50 @@ MunitResult test_util_alloc
   tcmplxA_util_free(ptr[0]);
   return MUNIT_OK;
 }
+MunitResult test_util_arena
+  (const MunitParameter params[], void* data)
+{
+  struct tcmplxA_util_arena* const arena = tcmplxA_util_arena_new(256u, NULL);
+  struct tcmplxA_allocator const* a;
+  unsigned char* ptr[3];
+  size_t pos[2];
+  size_t const sz = (size_t)munit_rand_int_range(1,32);
+  (void)params;
+  (void)data;
+  if (arena == NULL)
+    return MUNIT_SKIP;
+  a = tcmplxA_util_arena_allocator(arena);
+  munit_assert_size(tcmplxA_util_arena_capacity(arena), >=, 256u);
+  munit_assert_size(tcmplxA_util_arena_size(arena), ==, 0u);
+  ptr[0] = tcmplxA_util_allocate(a, sz);
+  munit_assert_not_null(ptr[0]);
+  memset(ptr[0], 0x5a, sz);
+  pos[0] = tcmplxA_util_arena_size(arena);
+  munit_assert_size(pos[0], >=, sz);
+  ptr[1] = tcmplxA_util_allocate(a, sz);
+  munit_assert_not_null(ptr[1]);
+  munit_assert_ptr_not_equal(ptr[0], ptr[1]);
+  memset(ptr[1], 0xa5, sz);
+  pos[1] = tcmplxA_util_arena_size(arena);
+  munit_assert_size(pos[1], >, pos[0]);
+  /* freeing the latest allocation returns its space */
+  tcmplxA_util_deallocate(a, ptr[1]);
+  munit_assert_size(tcmplxA_util_arena_size(arena), <, pos[1]);
+  munit_assert_ptr_equal(tcmplxA_util_allocate(a, sz), ptr[1]);
+  munit_assert_size(tcmplxA_util_arena_size(arena), ==, pos[1]);
+  /* too large for the slab: falls back to the backing allocator */
+  ptr[2] = tcmplxA_util_allocate(a, 1024u);
+  munit_assert_not_null(ptr[2]);
+  memset(ptr[2], 0, 1024u);
+  munit_assert_size(tcmplxA_util_arena_size(arena), ==, pos[1]);
+  tcmplxA_util_deallocate(a, ptr[2]);
+  tcmplxA_util_deallocate(a, ptr[1]);
+  munit_assert_uint8(ptr[0][sz-1], ==, 0x5a);
+  tcmplxA_util_deallocate(a, ptr[0]);
+  munit_assert_size(tcmplxA_util_arena_size(arena), ==, 0u);
+  tcmplxA_util_arena_destroy(arena);
+  return MUNIT_OK;
+}
 
 int main(int argc, char **argv) {
   return munit_suite_main(&suite_util, NULL, argc, argv);
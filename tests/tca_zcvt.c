@@ -4,6 +4,7 @@
 #include "testfont.h"
 #include "text-complex/access/zcvt.h"
 #include "text-complex/access/zutil.h"
+#include "text-complex/access/util.h"
 #include "munit/munit.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -16,9 +17,21 @@ static MunitResult test_zcvt_item
   (const MunitParameter params[], void* data);
 static MunitResult test_zcvt_zsrtostr_none
   (const MunitParameter params[], void* data);
+static MunitResult test_zcvt_reset
+  (const MunitParameter params[], void* data);
+static MunitResult test_zcvt_memory
+  (const MunitParameter params[], void* data);
+static MunitResult test_zcvt_suffix
+  (const MunitParameter params[], void* data);
+static MunitResult test_zcvt_estimate
+  (const MunitParameter params[], void* data);
+static MunitResult test_zcvt_suffix_cap
+  (const MunitParameter params[], void* data);
 static void* test_zcvt_setup
     (const MunitParameter params[], void* user_data);
 static void test_zcvt_teardown(void* fixture);
+static void* test_zcvt_peak_allocate(void* userdata, size_t sz);
+static void test_zcvt_peak_deallocate(void* userdata, void* x);
 
 static MunitParameterEnum test_zcvt_params[] = {
   { NULL, NULL },
@@ -31,6 +44,14 @@ static MunitTest tests_zcvt[] = {
     test_zcvt_setup,test_zcvt_teardown,0,test_zcvt_params},
   {"in/none", test_zcvt_zsrtostr_none,
     test_zcvt_setup,test_zcvt_teardown,0,NULL},
+  {"reset", test_zcvt_reset,
+    test_zcvt_setup,test_zcvt_teardown,0,NULL},
+  {"memory", test_zcvt_memory,
+    test_zcvt_setup,test_zcvt_teardown,0,NULL},
+  {"suffix", test_zcvt_suffix, NULL,NULL,0,NULL},
+  {"estimate", test_zcvt_estimate, NULL,NULL,0,NULL},
+  {"suffix/cap", test_zcvt_suffix_cap,
+    NULL,NULL,MUNIT_TEST_OPTION_SINGLE_ITERATION,NULL},
   {NULL, NULL, NULL,NULL,0,NULL}
 };
 
@@ -62,6 +83,28 @@ void test_zcvt_teardown(void* fixture) {
   return;
 }
 
+/* userdata holds the live byte count, then the peak */
+void* test_zcvt_peak_allocate(void* userdata, size_t sz) {
+  size_t* const bytes = (size_t*)userdata;
+  size_t* const out = (size_t*)malloc(sz + sizeof(size_t));
+  if (out == NULL)
+    return NULL;
+  out[0] = sz;
+  bytes[0] += sz;
+  if (bytes[0] > bytes[1])
+    bytes[1] = bytes[0];
+  return out+1;
+}
+
+void test_zcvt_peak_deallocate(void* userdata, void* x) {
+  size_t* const bytes = (size_t*)userdata;
+  size_t* const head = (size_t*)x - 1;
+  if (x == NULL)
+    return;
+  bytes[0] -= head[0];
+  free(head);
+}
+
 MunitResult test_zcvt_item
   (const MunitParameter params[], void* data)
 {
@@ -111,6 +154,330 @@ MunitResult test_zcvt_zsrtostr_none
   return MUNIT_OK;
 }
 
+MunitResult test_zcvt_reset
+  (const MunitParameter params[], void* data)
+{
+  struct tcmplxA_zcvt* const p = (struct tcmplxA_zcvt*)data;
+  struct tcmplxA_zcvt* const q = tcmplxA_zcvt_new(64,128,16);
+  unsigned char text[64] = {0};
+  int const text_len = munit_rand_int_range(1,64);
+  unsigned char buf[2][256] = {{0}};
+  size_t buf_len[2] = {0};
+  int k;
+  munit_rand_memory(sizeof(text)/2, &text[0]);
+  memcpy(text+sizeof(text)/2, text, sizeof(text)/2);
+  if (p == NULL || q == NULL) {
+    tcmplxA_zcvt_destroy(q);
+    return MUNIT_SKIP;
+  }
+  (void)params;
+  for (k = 0; k < 2; ++k) {
+    /* encode */{
+      unsigned char const *text_p = text;
+      int res;
+      res = tcmplxA_zcvt_strrtozs(p, &buf_len[k], buf[k], sizeof(buf[k]),
+        &text_p, text+text_len);
+      munit_assert_int(res, >=, tcmplxA_Success);
+      do {
+        size_t exbuf_len = 0;
+        res = tcmplxA_zcvt_delimrtozs(p, &exbuf_len,
+          buf[k]+buf_len[k], sizeof(buf[k])-buf_len[k]);
+        buf_len[k] += exbuf_len;
+      } while (res == tcmplxA_Success && buf_len[k] < sizeof(buf[k]));
+      munit_assert_int(res, ==, tcmplxA_EOF);
+    }
+    /* decode */{
+      unsigned char dummy[64] = {0};
+      size_t dummy_len = 0;
+      int res;
+      unsigned char const* buf_ptr = buf[k];
+      res = tcmplxA_zcvt_zsrtostr(q, &dummy_len, dummy, sizeof(dummy),
+        &buf_ptr, buf[k]+buf_len[k]);
+      munit_assert_int(res, >=, tcmplxA_Success);
+      munit_assert_size(dummy_len, ==, (size_t)text_len);
+      munit_assert_memory_equal(text_len, dummy, text);
+    }
+    tcmplxA_zcvt_reset(p);
+    tcmplxA_zcvt_reset(q);
+  }
+  /* a reset state behaves as a new state */
+  munit_assert_size(buf_len[0], ==, buf_len[1]);
+  munit_assert_memory_equal(buf_len[0], buf[0], buf[1]);
+  tcmplxA_zcvt_destroy(q);
+  return MUNIT_OK;
+}
+
+
+MunitResult test_zcvt_memory
+  (const MunitParameter params[], void* data)
+{
+  struct tcmplxA_zcvt* const p = (struct tcmplxA_zcvt*)data;
+  struct tcmplxA_zcvt* const wide = tcmplxA_zcvt_new(64,32768,16);
+  struct tcmplxA_zcvt* const q =
+    tcmplxA_zcvt_new_capped(4096,32768,4096, 65536u, NULL);
+  unsigned char text[64] = {0};
+  int const text_len = munit_rand_int_range(1,64);
+  unsigned char buf[2][256] = {{0}};
+  size_t buf_len[2] = {0};
+  int k;
+  munit_rand_memory(sizeof(text)/2, &text[0]);
+  memcpy(text+sizeof(text)/2, text, sizeof(text)/2);
+  if (p == NULL || wide == NULL || q == NULL) {
+    tcmplxA_zcvt_destroy(q);
+    tcmplxA_zcvt_destroy(wide);
+    return MUNIT_SKIP;
+  }
+  (void)params;
+  /* no state fits in a tiny cap */
+  munit_assert_null(tcmplxA_zcvt_new_capped(4096,32768,4096, 256u, NULL));
+  munit_assert_size(tcmplxA_zcvt_memory_usage(q), <=, 65536u);
+  munit_assert_size(tcmplxA_zcvt_memory_usage(p), <=,
+    tcmplxA_zcvt_memory_bound(64,128,16));
+  for (k = 0; k < 2; ++k) {
+    struct tcmplxA_zcvt* const enc = (k ? wide : p);
+    unsigned char const *text_p = text;
+    int res;
+    res = tcmplxA_zcvt_strrtozs(enc, &buf_len[k], buf[k], sizeof(buf[k]),
+      &text_p, text+text_len);
+    munit_assert_int(res, >=, tcmplxA_Success);
+    do {
+      size_t exbuf_len = 0;
+      res = tcmplxA_zcvt_delimrtozs(enc, &exbuf_len,
+        buf[k]+buf_len[k], sizeof(buf[k])-buf_len[k]);
+      buf_len[k] += exbuf_len;
+    } while (res == tcmplxA_Success && buf_len[k] < sizeof(buf[k]));
+    munit_assert_int(res, ==, tcmplxA_EOF);
+  }
+  munit_assert_size(tcmplxA_zcvt_memory_usage(p), <=,
+    tcmplxA_zcvt_memory_bound(64,128,16));
+  /* decode */{
+    unsigned char dummy[64] = {0};
+    size_t dummy_len = 0;
+    int res;
+    unsigned char const* buf_ptr = buf[0];
+    res = tcmplxA_zcvt_zsrtostr(q, &dummy_len, dummy, sizeof(dummy),
+      &buf_ptr, buf[0]+buf_len[0]);
+    munit_assert_int(res, >=, tcmplxA_Success);
+    munit_assert_size(dummy_len, ==, (size_t)text_len);
+    munit_assert_memory_equal(text_len, dummy, text);
+    munit_assert_size(tcmplxA_zcvt_memory_usage(q), <=, 65536u);
+  }
+  tcmplxA_zcvt_reset(q);
+  /* the wide stream's window does not fit the cap */{
+    unsigned char dummy[64] = {0};
+    size_t dummy_len = 0;
+    int res;
+    unsigned char const* buf_ptr = buf[1];
+    res = tcmplxA_zcvt_zsrtostr(q, &dummy_len, dummy, sizeof(dummy),
+      &buf_ptr, buf[1]+buf_len[1]);
+    munit_assert_int(res, ==, tcmplxA_ErrMemoryCap);
+  }
+  tcmplxA_zcvt_destroy(q);
+  tcmplxA_zcvt_destroy(wide);
+  return MUNIT_OK;
+}
+
+MunitResult test_zcvt_suffix
+  (const MunitParameter params[], void* data)
+{
+  static char const* const words[] = {
+    "alpha ", "beta ", "gamma ", "delta ", "epsilon ", "zeta ", "eta "
+  };
+  unsigned char text[4096];
+  unsigned char buf[4096+64];
+  unsigned char dummy[4096];
+  size_t text_len = 0;
+  size_t chain_len = 0;
+  int suffix_tf;
+  (void)params;
+  (void)data;
+  /* repeated words, then a run longer than a DEFLATE copy */{
+    while (text_len < sizeof(text)-1024u) {
+      char const* const word = words[munit_rand_int_range(0,6)];
+      size_t const word_len = strlen(word);
+      memcpy(text+text_len, word, word_len);
+      text_len += word_len;
+    }
+    memset(text+text_len, 'x', sizeof(text)-text_len);
+    text_len = sizeof(text);
+  }
+  /* the hash chain, then the suffix array */
+  for (suffix_tf = 0; suffix_tf < 2; ++suffix_tf) {
+    struct tcmplxA_zcvt* const p = tcmplxA_zcvt_new(4096,32768,16);
+    struct tcmplxA_zcvt* const q = tcmplxA_zcvt_new(4096,32768,16);
+    size_t buf_len = 0;
+    size_t dummy_len = 0;
+    if (p == NULL || q == NULL) {
+      tcmplxA_zcvt_destroy(q);
+      tcmplxA_zcvt_destroy(p);
+      return MUNIT_SKIP;
+    }
+    tcmplxA_zcvt_set_suffix(p, suffix_tf);
+    /* encode */{
+      unsigned char const *text_p = text;
+      int res;
+      res = tcmplxA_zcvt_strrtozs(p, &buf_len, buf, sizeof(buf),
+        &text_p, text+text_len);
+      munit_assert_int(res, >=, tcmplxA_Success);
+      do {
+        size_t exbuf_len = 0;
+        res = tcmplxA_zcvt_delimrtozs(p, &exbuf_len,
+          buf+buf_len, sizeof(buf)-buf_len);
+        buf_len += exbuf_len;
+      } while (res == tcmplxA_Success && buf_len < sizeof(buf));
+      munit_assert_int(res, ==, tcmplxA_EOF);
+    }
+    /* the matches pay for themselves */
+    munit_assert_size(buf_len, <, text_len);
+    /* and the parse over several candidates beats the hash chain */
+    if (suffix_tf)
+      munit_assert_size(buf_len, <, chain_len);
+    else chain_len = buf_len;
+    /* decode */{
+      unsigned char const* buf_ptr = buf;
+      int const res = tcmplxA_zcvt_zsrtostr(q, &dummy_len, dummy,
+        sizeof(dummy), &buf_ptr, buf+buf_len);
+      munit_assert_int(res, >=, tcmplxA_Success);
+      munit_assert_size(dummy_len, ==, text_len);
+      munit_assert_memory_equal(text_len, dummy, text);
+    }
+    tcmplxA_zcvt_destroy(q);
+    tcmplxA_zcvt_destroy(p);
+  }
+  return MUNIT_OK;
+}
+
+
+MunitResult test_zcvt_estimate
+  (const MunitParameter params[], void* data)
+{
+  size_t const pool_len = 4096;
+  size_t const text_len = 16384;
+  struct tcmplxA_zcvt* const p = tcmplxA_zcvt_new(16384,32768,16);
+  struct tcmplxA_zcvt* const q = tcmplxA_zcvt_new(4096,32768,16);
+  unsigned char* const text = (unsigned char*)munit_malloc(text_len);
+  unsigned char* const buf = (unsigned char*)munit_malloc(text_len+64u);
+  unsigned char* const dummy = (unsigned char*)munit_malloc(text_len);
+  size_t buf_len = 0;
+  size_t dummy_len = 0;
+  size_t i;
+  (void)params;
+  (void)data;
+  if (p == NULL || q == NULL) {
+    free(dummy);
+    free(buf);
+    free(text);
+    tcmplxA_zcvt_destroy(q);
+    tcmplxA_zcvt_destroy(p);
+    return MUNIT_SKIP;
+  }
+  /* random letters, then short pieces of them copied from far back */
+  for (i = 0; i < pool_len; ++i)
+    text[i] = (unsigned char)('a' + munit_rand_int_range(0,25));
+  for (; i < text_len; i += 16u) {
+    size_t const offset = (size_t)munit_rand_int_range(0,(int)pool_len-16);
+    memcpy(text+i, text+offset, 16u);
+  }
+  /* encode */{
+    unsigned char const *text_p = text;
+    int res;
+    res = tcmplxA_zcvt_strrtozs(p, &buf_len, buf, text_len+64u,
+      &text_p, text+text_len);
+    munit_assert_int(res, >=, tcmplxA_Success);
+    do {
+      size_t exbuf_len = 0;
+      res = tcmplxA_zcvt_delimrtozs(p, &exbuf_len,
+        buf+buf_len, text_len+64u-buf_len);
+      buf_len += exbuf_len;
+    } while (res == tcmplxA_Success && buf_len < text_len+64u);
+    munit_assert_int(res, ==, tcmplxA_EOF);
+  }
+  /* a compressed block, not a stored one */
+  munit_assert_size(buf_len, <, text_len/2u);
+  /* decode */{
+    unsigned char const* buf_ptr = buf;
+    int const res = tcmplxA_zcvt_zsrtostr(q, &dummy_len, dummy, text_len,
+      &buf_ptr, buf+buf_len);
+    munit_assert_int(res, >=, tcmplxA_Success);
+    munit_assert_size(dummy_len, ==, text_len);
+    munit_assert_memory_equal(text_len, dummy, text);
+  }
+  free(dummy);
+  free(buf);
+  free(text);
+  tcmplxA_zcvt_destroy(q);
+  tcmplxA_zcvt_destroy(p);
+  return MUNIT_OK;
+}
+
+MunitResult test_zcvt_suffix_cap
+  (const MunitParameter params[], void* data)
+{
+  size_t const memory_cap = 1000000u;
+  size_t const text_len = 262144u;
+  size_t bytes[2] = {0u, 0u};
+  struct tcmplxA_allocator const peak = {
+    test_zcvt_peak_allocate, test_zcvt_peak_deallocate, bytes
+  };
+  struct tcmplxA_zcvt* const p =
+    tcmplxA_zcvt_new_capped(65536,32768,16, memory_cap, &peak);
+  struct tcmplxA_zcvt* const q = tcmplxA_zcvt_new(4096,32768,16);
+  unsigned char* const text = (unsigned char*)munit_malloc(text_len);
+  unsigned char* const buf = (unsigned char*)munit_malloc(text_len+256u);
+  unsigned char* const dummy = (unsigned char*)munit_malloc(text_len);
+  size_t buf_len = 0;
+  size_t dummy_len = 0;
+  size_t i;
+  (void)params;
+  (void)data;
+  if (p == NULL || q == NULL) {
+    tcmplxA_zcvt_destroy(q);
+    tcmplxA_zcvt_destroy(p);
+    free(dummy);
+    free(buf);
+    free(text);
+    return MUNIT_SKIP;
+  }
+  /* letters with some repeats, so the search has work to do */
+  for (i = 0; i < text_len; ++i) {
+    text[i] = (i >= 64u && munit_rand_int_range(0,3) == 0)
+      ? text[i-(size_t)munit_rand_int_range(1,64)]
+      : (unsigned char)munit_rand_int_range('a','z');
+  }
+  tcmplxA_zcvt_set_suffix(p, 1);
+  /* encode */{
+    unsigned char const *text_p = text;
+    int res;
+    res = tcmplxA_zcvt_strrtozs(p, &buf_len, buf, text_len+256u,
+      &text_p, text+text_len);
+    munit_assert_int(res, >=, tcmplxA_Success);
+    do {
+      size_t exbuf_len = 0;
+      res = tcmplxA_zcvt_delimrtozs(p, &exbuf_len,
+        buf+buf_len, text_len+256u-buf_len);
+      buf_len += exbuf_len;
+    } while (res == tcmplxA_Success && buf_len < text_len+256u);
+    munit_assert_int(res, ==, tcmplxA_EOF);
+  }
+  /* the search scratch stayed under the cap */
+  munit_assert_size(bytes[1], <=, memory_cap);
+  munit_assert_size(buf_len, <, text_len);
+  /* decode */{
+    unsigned char const* buf_ptr = buf;
+    int const res = tcmplxA_zcvt_zsrtostr(q, &dummy_len, dummy,
+      text_len, &buf_ptr, buf+buf_len);
+    munit_assert_int(res, >=, tcmplxA_Success);
+    munit_assert_size(dummy_len, ==, text_len);
+    munit_assert_memory_equal(text_len, dummy, text);
+  }
+  tcmplxA_zcvt_destroy(q);
+  tcmplxA_zcvt_destroy(p);
+  munit_assert_size(bytes[0], ==, 0u);
+  free(dummy);
+  free(buf);
+  free(text);
+  return MUNIT_OK;
+}
 
 int main(int argc, char **argv) {
   return munit_suite_main(&suite_zcvt, NULL, argc, argv);